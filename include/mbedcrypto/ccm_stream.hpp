@@ -0,0 +1,101 @@
+/** @file ccm_stream.hpp
+ * streaming (chunked) CCM encryption and decryption of known-length messages.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_CCM_STREAM_HPP
+#define MBEDCRYPTO_CCM_STREAM_HPP
+
+#include "mbedcrypto/cipher.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** CCM (NIST SP 800-38C, RFC 3610) by chunks, in constant memory.
+ * to use this class you must build mbedcrypto with:
+ *  - MBEDCRYPTO_CCM
+ *
+ * CCM authenticates the message length before the payload, so the total size
+ * is declared by start(), then the payload is fed by any number of update()
+ * calls. the CBC-MAC and the CTR of each block are done in a single pass, the
+ * output of update() has exactly the size of its input.
+ *
+ * the output is compatible with cipher::encrypt_aead() of xxx_ccm types
+ * (with a 16 bytes tag).
+ *
+ * @code
+ * ccm_stream enc{cipher_t::aes_128_ccm};
+ * enc.key(key);
+ * enc.start(cipher::encrypt_mode, nonce, additional_data, image_size);
+ * while (...)
+ *     write(enc.update(read_chunk()));
+ * auto tag = enc.finish();
+ *
+ * ccm_stream dec{cipher_t::aes_128_ccm};
+ * dec.key(key);
+ * dec.start(cipher::decrypt_mode, nonce, additional_data, image_size);
+ * while (...)
+ *     stage(dec.update(read_chunk()));
+ * if (!dec.finish(tag))
+ *     discard_staged();
+ * @endcode
+ *
+ * @warning the decrypted chunks are not authenticated until finish(tag)
+ * returns true, they must not be used (ex: flashed) before.
+ */
+class ccm_stream
+{
+public:
+    /// type must be a ccm cipher (ex: cipher_t::aes_256_ccm)
+    explicit ccm_stream(cipher_t type);
+    ~ccm_stream();
+
+    /// sets the key, the key size depends on the cipher type
+    auto key(buffer_view_t key_data) -> ccm_stream&;
+
+    /** starts a new message.
+     * iv (the nonce) must be 7 to 13 bytes, the total_size must fit into the
+     * 15 - iv.size() bytes length field, tag_length must be an even number
+     * from 4 to 16.
+     */
+    void start(
+        cipher::mode  m,
+        buffer_view_t iv,
+        buffer_view_t additional_data,
+        size_t        total_size,
+        size_t        tag_length = 16);
+
+    /// processes the next chunk of the payload, returns the same size
+    auto update(buffer_view_t input) -> buffer_t;
+
+    /** low level overload, output must have room for input.size() bytes, it
+     * may also be the input itself (in place).
+     */
+    void update(buffer_view_t input, uint8_t* output);
+
+    /// finishes an encryption and returns the tag
+    auto finish() -> buffer_t;
+
+    /// finishes a decryption, returns true if the tag is authenticated
+    bool finish(buffer_view_t tag);
+
+    /// the size of the payload still expected by update()
+    size_t remaining() const noexcept;
+
+public: // move only
+    ccm_stream(const ccm_stream&) = delete;
+    ccm_stream(ccm_stream&&);
+    ccm_stream& operator=(const ccm_stream&) = delete;
+    ccm_stream& operator=(ccm_stream&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class ccm_stream
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_CCM_STREAM_HPP
@@ -8,6 +8,7 @@
 #ifndef MBEDCRYPTO_CIPHER_HPP
 #define MBEDCRYPTO_CIPHER_HPP
 
+#include "mbedcrypto/memory.hpp"
 #include "mbedcrypto/types.hpp"
 
 #include <tuple>
@@ -185,6 +186,8 @@ public: // properties
     size_t key_bitlen() const noexcept;
     size_t iv_size() const noexcept;
 
+    /// the memory of this object (includes the expanded key)
+    auto footprint() const noexcept -> memory::usage;
 
 public: // general encryption / decryption
     /// resets and makes cipher ready for update() iterations
@@ -258,6 +261,34 @@ public: // gcm features: requires MBEDCRYPTO_GCM
      */
     bool gcm_check_decryption_tag(buffer_view_t tag);
 
+public: // random access of ctr modes: requires MBEDCRYPTO_CTR
+    /** restarts a ctr cipher (as start()) at a byte offset of its stream,
+     * the next update() crypts the bytes from offset.
+     * the counter block is computed directly as iv + offset / block_size,
+     * so the cost does not depend on the offset.
+     * throws usage_error for the other block modes, or if no iv is set.
+     */
+    void ctr_seek(uint64_t offset);
+
+    /// a piece of a ctr stream, data starts at the offset of the stream
+    struct ctr_range {
+        uint64_t      offset;
+        buffer_view_t data;
+    };
+
+    /** crypts scattered (or overlapping) pieces of a ctr stream by a single
+     * call, the results are concatenated in the order of ranges.
+     * ex: serves the byte ranges of a large encrypted file, by reading and
+     * decrypting the requested ranges only.
+     * the cipher is left at the end of the last range.
+     */
+    auto ctr_crypt(const std::vector<ctr_range>& ranges) -> buffer_t;
+
+    /// overload, crypts a single piece at offset
+    auto ctr_crypt(uint64_t offset, buffer_view_t input) -> buffer_t {
+        return ctr_crypt({ctr_range{offset, input}});
+    }
+
 public:
     // move only
     cipher(const cipher&) = delete;
@@ -0,0 +1,103 @@
+/** @file ctr_keystream.hpp
+ * ctr encryption by a precomputed keystream, for low latency messages.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_CTR_KEYSTREAM_HPP
+#define MBEDCRYPTO_CTR_KEYSTREAM_HPP
+
+#include "mbedcrypto/cipher.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** a ctr cipher which generates its keystream ahead of the data.
+ * to use this class you must build mbedcrypto with:
+ *  - MBEDCRYPTO_CTR
+ *
+ * the keystream only depends on the key and the counter, so it is computed
+ * into a ring buffer before the messages exist, then update() is just a xor
+ * of the message by the ring.
+ * the ring is refilled:
+ *  - by the shared worker pool in the background (default), a refill is
+ *    posted when the ring is below the half.
+ *  - and/or by explicit refill() calls (ex: in the idle cycles of an event
+ *    loop).
+ * if the ring runs dry, update() generates the missing keystream inline, so
+ * the output is always the same as a cipher of the same type.
+ *
+ * the encryption and the decryption are the same operation in ctr mode.
+ *
+ * @code
+ * ctr_keystream enc{cipher_t::aes_128_ctr};
+ * enc.key(key).start(iv);
+ * while (...)
+ *     send(enc.update(next_message())); // a xor, if the ring is warm
+ * @endcode
+ *
+ * @warning a single thread must use the object at a time (the background
+ * refill is synchronized internally).
+ */
+class ctr_keystream
+{
+public:
+    static constexpr size_t default_ring_size = 64 * 1024;
+
+    /** type must be a ctr cipher (ex: cipher_t::aes_128_ctr).
+     * ring_size is the max precomputed keystream in bytes, if background is
+     * false the ring is only filled by refill().
+     */
+    explicit ctr_keystream(
+        cipher_t type,
+        size_t   ring_size  = default_ring_size,
+        bool     background = true);
+    ~ctr_keystream();
+
+    /// sets the key, the key size depends on the cipher type
+    auto key(buffer_view_t key_data) -> ctr_keystream&;
+
+    /** starts a new stream by the initial counter block (iv_size() bytes) and
+     * discards the precomputed keystream of the previous one.
+     */
+    auto start(buffer_view_t iv) -> ctr_keystream&;
+
+    /// crypts the next bytes of the stream
+    auto update(buffer_view_t input) -> buffer_t;
+
+    /** low level overload, output must have room for input.size() bytes, it
+     * may also be the input itself (in place).
+     */
+    void update(buffer_view_t input, uint8_t* output);
+
+    /** fills the ring by the future keystream, returns the number of
+     * generated bytes (0 if the ring is already full).
+     */
+    size_t refill();
+
+    /// the precomputed keystream ready for update(), in bytes
+    size_t available() const noexcept;
+
+    size_t ring_size() const noexcept;
+    size_t iv_size() const noexcept;
+
+    /// total bytes crypted by the ring, and by the inline fallback
+    uint64_t ring_bytes() const noexcept;
+    uint64_t inline_bytes() const noexcept;
+
+public: // move only
+    ctr_keystream(const ctr_keystream&) = delete;
+    ctr_keystream(ctr_keystream&&);
+    ctr_keystream& operator=(const ctr_keystream&) = delete;
+    ctr_keystream& operator=(ctr_keystream&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class ctr_keystream
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_CTR_KEYSTREAM_HPP
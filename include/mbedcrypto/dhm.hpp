@@ -0,0 +1,132 @@
+/** @file dhm.hpp
+ * finite field Diffie-Hellman (DHE) by RFC 7919 groups.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_DHM_HPP
+#define MBEDCRYPTO_DHM_HPP
+
+#include "mbedcrypto/types.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/// finite field Diffie-Hellman groups by RFC 7919
+enum class dh_group_t {
+    none,      ///< custom group parameters, @sa dhm::make_client_peer_key()
+    ffdhe2048,
+    ffdhe3072,
+    ffdhe4096,
+    ffdhe6144,
+    ffdhe8192,
+};
+
+/// returns true only by enabled MBEDCRYPTO_EC builds
+bool
+supports_dhm() noexcept;
+
+/** DHE TLS compatible implementation, similar to ecdh.
+ * to use this class you must build mbedcrypto with:
+ *  - MBEDCRYPTO_EC
+ *
+ * the generator powers of the RFC 7919 groups are precomputed once (per
+ * process) into fixed-base window tables, so making an ephemeral key costs
+ * a fraction of a generic modular exponentiation. the tables are shared by
+ * all the instances and threads, and are limited to 8MB each: the full size
+ * exponents of ffdhe6144 and ffdhe8192 use the generic exponentiation.
+ *
+ * when both ends know the group:
+ * @code
+ * dhm server;
+ * auto srv_pub = server.make_peer_key(dh_group_t::ffdhe2048);
+ *
+ * dhm client;
+ * auto cli_pub = client.make_peer_key(dh_group_t::ffdhe2048);
+ *
+ * auto sss = server.shared_secret(cli_pub);
+ * auto css = client.shared_secret(srv_pub);
+ * REQUIRE( (sss == css) );
+ * @endcode
+ *
+ * by RFC 5246 ServerDHParams (when the server defines the group):
+ * @code
+ * dhm server;
+ * auto skex = server.make_server_key_exchange(dh_group_t::ffdhe3072);
+ *
+ * dhm client;
+ * auto cli_pub = client.make_client_peer_key(skex);
+ * auto css     = client.shared_secret();
+ *
+ * auto sss     = server.shared_secret(cli_pub);
+ * REQUIRE( (sss == css) );
+ * @endcode
+ */
+class dhm
+{
+public:
+    /** by short_exponent the private exponents are limited to the sizes
+     * recommended by RFC 7919 section 5.2 (ex: 225 bits for ffdhe2048),
+     * otherwise the exponents are as large as the group prime.
+     * short exponents make both the key and the secret computation faster.
+     * the custom groups of make_client_peer_key() always use the full size
+     * exponents, as their primes are not known to be safe.
+     */
+    explicit dhm(bool short_exponent = false);
+    ~dhm();
+
+    /// resets and generates a new key pair, returns the public key
+    auto make_peer_key(dh_group_t) -> buffer_t;
+
+    /// the public key (big-endian, key_length() bytes) of the last key pair
+    auto peer_key() const -> buffer_t;
+
+    /** calculates the shared secret by the peer (other endpoint) public key.
+     * as TLS 1.2 the leading zero bytes of the secret are stripped.
+     */
+    auto shared_secret(buffer_view_t peer_key) -> buffer_t;
+
+    /** calculates the shared secret if peer's public has been loaded before.
+     * @sa make_client_peer_key()
+     */
+    auto shared_secret() -> buffer_t;
+
+    /// the group of the current key, none for custom parameters
+    auto group() const noexcept -> dh_group_t;
+
+    /// size of the group prime (and the public keys) in bytes
+    size_t key_length() const noexcept;
+
+    /// size of the private exponent in bits
+    size_t exponent_bitlen() const noexcept;
+
+public: // RFC 5246 ServerDHParams
+    /** server makes its own key pair and returns the ServerDHParams.
+     * both the group parameters (p, g) and the public key are returned.
+     */
+    auto make_server_key_exchange(dh_group_t) -> buffer_t;
+
+    /** client loads the group parameters and the server's public key.
+     * returns the client's public key.
+     * @warning custom (non RFC 7919) groups are accepted as is and computed
+     * without the precomputed tables, their primes are not validated.
+     * the primes larger than 8192 bits are rejected.
+     */
+    auto make_client_peer_key(buffer_view_t server_key_exchange) -> buffer_t;
+
+public: // move only
+    dhm(const dhm&) = delete;
+    dhm(dhm&&);
+    dhm& operator=(const dhm&) = delete;
+    dhm& operator=(dhm&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class dhm
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_DHM_HPP
@@ -0,0 +1,131 @@
+/** @file encrypted_file.hpp
+ * random access (pread like) reads of an encrypted file, by a cache of the
+ * decrypted pages.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_ENCRYPTED_FILE_HPP
+#define MBEDCRYPTO_ENCRYPTED_FILE_HPP
+
+#include "mbedcrypto/cipher.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** a read-only, seekable view of an encrypted file.
+ * the file is split into pages of the plain text, a read decrypts the pages
+ * it touches (once) into a shared LRU cache, so the following reads of the
+ * same region are just copies.
+ *
+ * the layout depends on the cipher type:
+ *  - ctr (requires MBEDCRYPTO_CTR): the file is a plain ctr stream of the
+ *    whole content (ex: cipher::encrypt() of cipher_t::aes_256_ctr), a page
+ *    is decrypted by a direct seek of the counter. not authenticated.
+ *  - gcm or ccm (requires MBEDCRYPTO_GCM or MBEDCRYPTO_CCM): every page is
+ *    sealed independently as [encrypted page | 16 bytes tag], the last page
+ *    may be shorter, an empty plain text is a single empty page. the nonce
+ *    of page i is the 12 bytes iv xor i (big endian, on the last 8 bytes),
+ *    the additional data is the page index and the plain size of the file,
+ *    so the reordered, truncated (even to nothing) or modified pages fail
+ *    the authentication.
+ *    this layout is made by encrypted_file::encrypt().
+ *
+ * the sequential reads are detected, and the next pages are decrypted ahead
+ * by the shared worker pool.
+ *
+ * @code
+ * encrypted_file ef{"column.bin", cipher_t::aes_256_gcm, key, iv};
+ * uint8_t row[64];
+ * ef.read(offset, row, sizeof(row)); // any offset, any thread
+ * @endcode
+ *
+ * all the methods are thread safe, the concurrent readers share the cache.
+ */
+class encrypted_file
+{
+public:
+    static constexpr size_t default_page_size = 64 * 1024;
+    static constexpr size_t tag_size          = 16; ///< of the aead pages
+
+    struct options {
+        /// plain text bytes per page, must be the same as encrypt()
+        size_t page_size = default_page_size;
+        /// max number of decrypted pages in the cache
+        size_t cache_pages = 256;
+        /// pages decrypted ahead of a sequential read, 0 disables
+        size_t read_ahead = 4;
+    }; // struct options
+
+    /// counters of the page cache
+    struct stats_t {
+        uint64_t hits       = 0; ///< page lookups served by the cache
+        uint64_t misses     = 0; ///< pages decrypted by a read
+        uint64_t read_ahead = 0; ///< pages decrypted ahead
+        uint64_t evictions  = 0;
+    }; // struct stats_t
+
+    /** seals a plain text into the paged aead layout (gcm or ccm types), or
+     * into a ctr stream for ctr types.
+     * iv must be 12 bytes for aead, or the iv size of the ctr cipher.
+     */
+    static auto encrypt(
+        cipher_t      type,
+        buffer_view_t key,
+        buffer_view_t iv,
+        buffer_view_t plain,
+        size_t        page_size = default_page_size) -> buffer_t;
+
+public:
+    /// opens an encrypted file, throws on error or on an invalid layout
+    encrypted_file(
+        const char*    file_path,
+        cipher_t       type,
+        buffer_view_t  key,
+        buffer_view_t  iv,
+        const options& opts);
+
+    encrypted_file(
+        const char*   file_path,
+        cipher_t      type,
+        buffer_view_t key,
+        buffer_view_t iv)
+        : encrypted_file(file_path, type, key, iv, options{}) {}
+
+    ~encrypted_file();
+
+    /// the plain text size in bytes
+    uint64_t size() const noexcept;
+    size_t   page_size() const noexcept;
+
+    /** copies up to length bytes of the plain text at offset into output,
+     * returns the copied size (less than length only at the end of file).
+     * throws usage_error (MBEDTLS_ERR_CIPHER_AUTH_FAILED) if an aead page
+     * fails the authentication.
+     */
+    size_t read(uint64_t offset, uint8_t* output, size_t length);
+
+    /// overload
+    auto read(uint64_t offset, size_t length) -> buffer_t;
+
+    /// drops the decrypted pages
+    void clear_cache();
+
+    auto stats() const -> stats_t;
+
+public: // move only
+    encrypted_file(const encrypted_file&) = delete;
+    encrypted_file(encrypted_file&&);
+    encrypted_file& operator=(const encrypted_file&) = delete;
+    encrypted_file& operator=(encrypted_file&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class encrypted_file
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_ENCRYPTED_FILE_HPP
@@ -0,0 +1,118 @@
+/** @file ff1.hpp
+ * FF1 format preserving encryption (NIST SP 800-38G), for tokenization.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_FF1_HPP
+#define MBEDCRYPTO_FF1_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** encrypts a numeral string into another one of the same length and radix
+ * (ex: a card number into a card number), by AES-128/192/256.
+ *
+ * the numerals are digits in [0, radix), or the characters of an alphabet:
+ * the radix constructor uses "0123456789abcdefghijklmnopqrstuvwxyz" if
+ * radix <= 36 (as the NIST samples).
+ *
+ * a token is 10 feistel rounds, each a CBC-MAC of the round input by the
+ * key. the key is expanded once by key(), the CBC-MAC state after the
+ * constant blocks (the header block P and the tweak) is cached by the
+ * length and the tweak, so a round of a short token (ex: 16 digits) is a
+ * single AES block. the numeral string math is in fixed size limbs, the
+ * low level apis do not allocate.
+ *
+ * the length of the input must be in [min_length(), max_length()]: the
+ * domain radix^length must be at least 1'000'000 (as the standard), and
+ * each half must fit in 256 bits (ex: 154 decimal digits).
+ *
+ * @code
+ * ff1 fpe{10};
+ * fpe.key(key);
+ * auto token = fpe.encrypt("4111111111111111");
+ * auto pan   = fpe.decrypt(token); // "4111111111111111"
+ *
+ * // with a tweak, ex: a merchant id
+ * auto token2 = fpe.encrypt("4111111111111111", merchant_id);
+ * @endcode
+ *
+ * throws usage_error for an invalid length or numeral, or if the key is not
+ * set.
+ * @warning a single thread must use the object at a time.
+ */
+class ff1
+{
+public:
+    static constexpr size_t max_radix     = 65536;
+    static constexpr size_t max_half_bits = 256;
+
+    /// radix must be in [2, 65536]
+    explicit ff1(size_t radix);
+    /// the radix is the size of alphabet (unique characters, at least 2)
+    explicit ff1(const char* alphabet);
+    ~ff1();
+
+    /// sets the AES key, 16, 24 or 32 bytes
+    auto key(buffer_view_t key_data) -> ff1&;
+
+    size_t radix() const noexcept;
+    size_t min_length() const noexcept;
+    size_t max_length() const noexcept;
+
+public: // by the alphabet
+    auto encrypt(
+        buffer_view_t input, buffer_view_t tweak = buffer_view_t{nullptr})
+        -> buffer_t;
+
+    auto decrypt(
+        buffer_view_t input, buffer_view_t tweak = buffer_view_t{nullptr})
+        -> buffer_t;
+
+    /** tokenizes many inputs by the same tweak, the results are in the order
+     * of inputs.
+     */
+    auto encrypt_many(
+        const std::vector<buffer_view_t>& inputs,
+        buffer_view_t tweak = buffer_view_t{nullptr})
+        -> std::vector<buffer_t>;
+
+    auto decrypt_many(
+        const std::vector<buffer_view_t>& inputs,
+        buffer_view_t tweak = buffer_view_t{nullptr})
+        -> std::vector<buffer_t>;
+
+public: // low level, by digits in [0, radix)
+    /// encrypts length digits in place
+    void encrypt(
+        uint16_t*     digits,
+        size_t        length,
+        buffer_view_t tweak = buffer_view_t{nullptr});
+
+    /// decrypts length digits in place
+    void decrypt(
+        uint16_t*     digits,
+        size_t        length,
+        buffer_view_t tweak = buffer_view_t{nullptr});
+
+public: // move only
+    ff1(const ff1&) = delete;
+    ff1(ff1&&);
+    ff1& operator=(const ff1&) = delete;
+    ff1& operator=(ff1&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class ff1
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_FF1_HPP
@@ -0,0 +1,134 @@
+/** @file gcm_key_store.hpp
+ * compact storage of very many AES-GCM keys (ex: one key per tenant).
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_GCM_KEY_STORE_HPP
+#define MBEDCRYPTO_GCM_KEY_STORE_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <tuple>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** keeps the raw AES keys (16, 24 or 32 bytes per key) and a memory bounded
+ * LRU cache of the expanded keys.
+ * to use this class you must build mbedcrypto with:
+ *  - MBEDCRYPTO_GCM
+ *
+ * an expanded key is the AES round keys and the GHASH key. on CPUs with
+ * PCLMULQDQ the GHASH is computed table-free (the GHASH key is 16 bytes),
+ * otherwise a 256 bytes multiplication table is also kept per expanded key.
+ * a fully set up mbedtls gcm context is about 1KB, so 1M keys fit in 32MB of
+ * raw keys plus the cache budget.
+ *
+ * the output is compatible with cipher::encrypt_aead() of aes_xxx_gcm.
+ * thread safe, the operations of different threads only share the cache
+ * lookups.
+ *
+ * @code
+ * gcm_key_store store{256, 16 * 1024 * 1024}; // aes-256, 16MB cache
+ * auto id = store.add(tenant_key);
+ *
+ * auto tag_and_ct = store.encrypt(id, iv, additional_data, plain);
+ * auto ok_and_pt  = store.decrypt(id, iv, additional_data, tag_and_ct);
+ * @endcode
+ */
+class gcm_key_store
+{
+public:
+    using key_id = size_t;
+
+    struct stats_t {
+        size_t keys      = 0; ///< number of stored keys
+        size_t expanded  = 0; ///< number of cached expanded keys
+        size_t hits      = 0;
+        size_t misses    = 0; ///< each miss expands a key
+        size_t evictions = 0;
+        size_t memory    = 0; ///< raw keys + cache, in bytes (estimated)
+    }; // struct stats_t
+
+    /** key_bitlen must be 128, 192 or 256.
+     * the cache of the expanded keys is sized by memory_budget bytes, but it
+     * keeps at least one expanded key per shard (16 keys) by a tiny budget.
+     * the raw keys are not limited by the budget.
+     */
+    explicit gcm_key_store(
+        size_t key_bitlen = 128, size_t memory_budget = 64 * 1024 * 1024);
+    ~gcm_key_store();
+
+    /// stores a copy of the key, returns its id (ids are sequential from 0)
+    key_id add(buffer_view_t key);
+
+    /// replaces a stored key, the expanded key is dropped from the cache
+    void replace(key_id, buffer_view_t key);
+
+    /// number of stored keys
+    size_t size() const;
+
+    /** encrypts and authenticates by additional data.
+     * returns the tag (16 bytes) as the first member of the tuple, the second
+     * one is the encrypted buffer.
+     * @sa cipher::encrypt_aead()
+     */
+    auto encrypt(
+        key_id,
+        buffer_view_t iv,
+        buffer_view_t additional_data,
+        buffer_view_t input) const -> std::tuple<buffer_t, buffer_t>;
+
+    /** authenticates and decrypts, the tag size must be in [4, 16] bytes.
+     * returns the authentication status as the first member of the tuple,
+     * the second one is the decrypted buffer (empty if not authenticated).
+     * @sa cipher::decrypt_aead()
+     */
+    auto decrypt(
+        key_id,
+        buffer_view_t iv,
+        buffer_view_t additional_data,
+        buffer_view_t tag,
+        buffer_view_t input) const -> std::tuple<bool, buffer_t>;
+
+    /// helper
+    template <class Tuple>
+    auto decrypt(
+        key_id        id,
+        buffer_view_t iv,
+        buffer_view_t additional_data,
+        const Tuple&  tuple_aead) const {
+        return decrypt(
+            id,
+            iv,
+            additional_data,
+            std::get<0>(tuple_aead),
+            std::get<1>(tuple_aead));
+    }
+
+    /// drops all the expanded keys, the raw keys are kept
+    void clear_cache();
+
+    auto stats() const -> stats_t;
+
+    /// bytes of a single expanded (cached) key, including the bookkeeping
+    size_t expanded_key_size() const noexcept;
+
+    /// true if GHASH is computed by PCLMULQDQ (table-free)
+    bool uses_clmul() const noexcept;
+
+public: // non-copyable
+    gcm_key_store(const gcm_key_store&) = delete;
+    gcm_key_store& operator=(const gcm_key_store&) = delete;
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class gcm_key_store
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_GCM_KEY_STORE_HPP
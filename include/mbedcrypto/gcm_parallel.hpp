@@ -0,0 +1,94 @@
+/** @file gcm_parallel.hpp
+ * AES-GCM and Camellia-GCM of a single large message by multiple cores.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_GCM_PARALLEL_HPP
+#define MBEDCRYPTO_GCM_PARALLEL_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <tuple>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace gcm {
+//-----------------------------------------------------------------------------
+
+/** the input is split into segments (tuning::current().segment_size), each
+ * segment is encrypted by CTR from its own counter and hashed into a partial
+ * GHASH by a thread of the shared pool. the partial hashes are combined by
+ * the powers of H:
+ *  S = (..(S0 * H^n1 ^ S1) * H^n2 ^ ..) * H^nk ^ Sk
+ * where S0 is the GHASH of the additional data and ni the blocks of segment i.
+ * a decryption hashes and decrypts each segment in a single pass.
+ *
+ * the output is byte-identical to cipher::encrypt_aead() and
+ * cipher::decrypt_aead(). inputs smaller than tuning::parallel_min_bytes are
+ * processed by the calling thread only.
+ * to use these functions you must build mbedcrypto with:
+ *  - MBEDCRYPTO_GCM
+ *  - MBEDCRYPTO_CAMELLIA for the camellia_xxx_gcm ciphers
+ *
+ * @code
+ * auto tag_and_ct = gcm::parallel_encrypt(
+ *     cipher_t::aes_256_gcm, iv, key, additional_data, huge_file);
+ * auto ok_and_pt  = gcm::parallel_decrypt(
+ *     cipher_t::aes_256_gcm, iv, key, additional_data, tag_and_ct);
+ * @endcode
+ */
+
+/** encrypts and authenticates by additional data, by at most max_threads
+ * (caller thread included, 0 means all the pool).
+ * type must be a gcm cipher, Camellia is by the byte-sliced AES-NI kernels
+ * if the CPU supports them.
+ * returns the tag (16 bytes) as the first member of the tuple, the second
+ * one is the encrypted buffer.
+ */
+auto parallel_encrypt(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t additional_data,
+    buffer_view_t input,
+    size_t        max_threads = 0) -> std::tuple<buffer_t, buffer_t>;
+
+/** authenticates and decrypts, the tag size must be in [4, 16] bytes.
+ * returns the authentication status as the first member of the tuple,
+ * the second one is the decrypted buffer (empty if not authenticated).
+ */
+auto parallel_decrypt(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t additional_data,
+    buffer_view_t tag,
+    buffer_view_t input,
+    size_t        max_threads = 0) -> std::tuple<bool, buffer_t>;
+
+/// helper
+template <class Tuple>
+auto
+parallel_decrypt(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t additional_data,
+    const Tuple&  tuple_aead,
+    size_t        max_threads = 0) {
+    return parallel_decrypt(
+        type,
+        iv,
+        key,
+        additional_data,
+        std::get<0>(tuple_aead),
+        std::get<1>(tuple_aead),
+        max_threads);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace gcm
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_GCM_PARALLEL_HPP
@@ -8,6 +8,7 @@
 #ifndef MBEDCRYPTO_HASH_HPP
 #define MBEDCRYPTO_HASH_HPP
 
+#include "mbedcrypto/memory.hpp"
 #include "mbedcrypto/types.hpp"
 //-----------------------------------------------------------------------------
 namespace mbedcrypto {
@@ -47,6 +48,13 @@ public: // single-shot hash computation
     /// makes the hash value of a file content
     static buffer_t of_file(hash_t type, const char* filePath);
 
+    /** makes the hash values of many independent messages.
+     * sha384 and sha512 are interleaved by 4 messages on avx2 CPUs (multi
+     * buffer), the other types are computed one by one.
+     */
+    static std::vector<buffer_t>
+    make_many(hash_t type, const std::vector<buffer_view_t>& sources);
+
 public: // iterative usage, reusing the instance
     explicit hash(hash_t type); ///< throws if type is not supported
     ~hash();
@@ -68,6 +76,9 @@ public: // iterative usage, reusing the instance
     /// returns the final digest of previous updates.
     buffer_t finish();
 
+    /// the memory of this object, @sa memory::usage
+    auto footprint() const noexcept -> memory::usage;
+
     // this class is move-only
     hash(const hash&) = delete;
     hash(hash&&)      = default;
@@ -111,6 +122,15 @@ public: // single-shot hamc computation
      */
     static buffer_t make(hash_t type, buffer_view_t key, buffer_view_t src);
 
+    /** makes the HMAC values of many independent messages by a single key.
+     * same as hash::make_many(), sha384 and sha512 use the multi buffer
+     * kernel on avx2 CPUs.
+     */
+    static std::vector<buffer_t> make_many(
+        hash_t                            type,
+        buffer_view_t                     key,
+        const std::vector<buffer_view_t>& sources);
+
 public: // iterative or reuse
     explicit hmac(hash_t type);
     ~hmac();
@@ -133,6 +153,9 @@ public: // iterative or reuse
     /// returns the final digest of previous updates.
     buffer_t finish();
 
+    /// the memory of this object, @sa memory::usage
+    auto footprint() const noexcept -> memory::usage;
+
     // this class is move-only
     hmac(const hmac&) = delete;
     hmac(hmac&&)      = default;
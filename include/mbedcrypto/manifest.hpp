@@ -0,0 +1,92 @@
+/** @file manifest.hpp
+ * parallel hashing of many files (ex: the manifest of a release).
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_MANIFEST_HPP
+#define MBEDCRYPTO_MANIFEST_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <functional>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace manifest {
+//-----------------------------------------------------------------------------
+
+/// the digest of a file
+struct entry {
+    std::string path;
+    int64_t     size = -1;    ///< file size in bytes, -1 on error
+    buffer_t    digest;       ///< empty on error
+    bool        tree = false; ///< true if digest is a tree hash
+    std::string error;        ///< readable error message, empty on success
+
+    bool ok() const noexcept {
+        return error.empty();
+    }
+}; // struct entry
+
+/// options of the manifest hashing
+struct options {
+    hash_t type = hash_t::sha256;
+
+    /// max number of threads (caller thread included), 0 means all the pool
+    size_t max_threads = 0;
+
+    /// files up to this size are read and hashed in batches by a single task
+    size_t small_file_size = 64 * 1024;
+    /// max number of files in a batch of small files
+    size_t batch_size = 64;
+
+    /** splits the files larger than leaf_size into leaves, the leaves are
+     * hashed in parallel. a tree digest is:
+     *  H(0x01 | H(0x00 | leaf_0) | H(0x00 | leaf_1) | ...)
+     * so it depends on leaf_size and differs from hash::of_file().
+     * if false (default) the digest of every file equals hash::of_file().
+     */
+    bool   tree_hash = false;
+    size_t leaf_size = 4 * 1024 * 1024;
+}; // struct options
+
+/// called in the order of the input paths, always by the calling thread
+using on_entry_t = std::function<void(const entry&)>;
+
+/** hashes the files concurrently and streams the results in the order of
+ * paths. the memory does not depend on the number nor the size of files, at
+ * most a few tasks per thread are in flight ahead of the next result.
+ * the failures (ex: missing file) are reported per entry.
+ * an exception of on_entry stops the hashing and is re-thrown.
+ */
+void
+hash_files(
+    const std::vector<std::string>& paths,
+    const on_entry_t&               on_entry,
+    const options&                  = options{});
+
+/** hashes the regular files of a directory tree (recursive, hidden files and
+ * directories are skipped), in the sorted order of their paths.
+ * throws if the directory could not be opened.
+ */
+void
+hash_tree(
+    const char*       dir_path,
+    const on_entry_t& on_entry,
+    const options&    = options{});
+
+/// helper, returns all the entries
+std::vector<entry>
+of_files(const std::vector<std::string>& paths, const options& = options{});
+
+/// helper, returns all the entries
+std::vector<entry>
+of_tree(const char* dir_path, const options& = options{});
+
+//-----------------------------------------------------------------------------
+} // namespace manifest
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_MANIFEST_HPP
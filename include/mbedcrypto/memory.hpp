@@ -0,0 +1,81 @@
+/** @file memory.hpp
+ * the memory accounting of the library objects and of the mbedtls heap.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_MEMORY_HPP
+#define MBEDCRYPTO_MEMORY_HPP
+
+#include <cstddef>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace memory {
+//-----------------------------------------------------------------------------
+
+/** the memory footprint of a single object, @sa hash::footprint(),
+ * cipher::footprint(), pk::footprint(), ...
+ */
+struct usage {
+    /// the object, its private implementation and the embedded contexts
+    size_t inline_bytes = 0;
+    /// the mbedtls allocations owned by the object (keys, digest states, ...)
+    size_t heap_bytes = 0;
+
+    size_t total() const noexcept {
+        return inline_bytes + heap_bytes;
+    }
+}; // struct usage
+
+/// the types of the objects which are counted while alive
+enum class kind {
+    cipher,
+    hash,
+    hmac,
+    pk,         ///< the contexts of rsa and ecp
+    public_key,
+    rnd_generator,
+};
+
+/// the totals of the live objects of a kind
+struct totals {
+    size_t objects      = 0;
+    size_t inline_bytes = 0; ///< sum of the inline bytes of the objects
+}; // struct totals
+
+/** returns the totals of the live objects of a kind.
+ * the heap of an object changes by its state (ex: a key is imported), so it
+ * is not counted per kind, multiply the footprint() of a typical object or
+ * watch the heap() instead.
+ * @note a rsa or an ecp owns a rnd_generator, which is also counted as a
+ * rnd_generator.
+ */
+totals live(kind) noexcept;
+
+/** the heap of mbedtls, all the allocations of the keys, the contexts and
+ * the big numbers by mbedtls_calloc() and mbedtls_free().
+ * the std allocations of the c++ side (buffers, caches, ...) are not
+ * included.
+ */
+struct heap_stats {
+    size_t bytes        = 0; ///< in use
+    size_t peak_bytes   = 0; ///< the highest bytes since start, or reset_peak()
+    size_t blocks       = 0; ///< in use
+    size_t total_blocks = 0; ///< ever allocated
+}; // struct heap_stats
+
+/** returns the mbedtls heap usage of the process.
+ * @warning the accounting allocator is installed at build time, replacing it
+ * by mbedtls_platform_set_calloc_free() is not supported.
+ */
+heap_stats heap() noexcept;
+
+/// restarts the peak_bytes from the current usage
+void reset_peak() noexcept;
+
+//-----------------------------------------------------------------------------
+} // namespace memory
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_MEMORY_HPP
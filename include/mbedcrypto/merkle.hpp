@@ -0,0 +1,129 @@
+/** @file merkle.hpp
+ * batch signing: a single pk signature of the root of a hash tree over many
+ * messages, and an inclusion proof per message.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_MERKLE_HPP
+#define MBEDCRYPTO_MERKLE_HPP
+
+#include "mbedcrypto/pk.hpp"
+
+#include <chrono>
+#include <future>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+class public_key;
+//-----------------------------------------------------------------------------
+namespace merkle {
+//-----------------------------------------------------------------------------
+
+/** the hash tree of a batch of count messages, by the hash type:
+ *  leaf = H(0x00 | H(message))
+ *  node = H(0x01 | left | right)
+ * the last node of a level with an odd number of nodes is moved up as is.
+ * the key signs (pk::sign()) the hash value:
+ *  H("mbedcrypto merkle batch" | count | root)
+ * so a root signature is never a signature of a single message.
+ *
+ * signing a batch costs a single pk signature plus about 2 * count hashes,
+ * verifying a message costs log2(count) hashes plus a pk verification.
+ */
+
+/// the signature of a message of a batch
+struct batch_signature {
+    hash_t                type  = hash_t::none;
+    uint32_t              index = 0; ///< of the message in the batch
+    uint32_t              count = 0; ///< messages of the batch
+    std::vector<buffer_t> path;      ///< the sibling digests, leaf to root
+    buffer_t              root_signature;
+
+    /** the binary form, all in big endian:
+     *  [version (1) | hash type (1) | index (4) | count (4) | path size (1)]
+     *  [path digests] [signature size (2) | root signature]
+     */
+    buffer_t dump() const;
+
+    /// parses a dump(), throws usage_error on malformed data
+    static batch_signature parse(buffer_view_t);
+}; // struct batch_signature
+
+/** signs all the messages by a single signature of key.
+ * key must be an rsa or an ecdsa capable private key.
+ */
+std::vector<batch_signature>
+sign_batch(
+    pk::pk_base&                      key,
+    const std::vector<buffer_view_t>& messages,
+    hash_t                            type = hash_t::sha256);
+
+/** returns the hash value of the root signature by the message and its
+ * proof, or an empty buffer if the proof is malformed.
+ */
+buffer_t
+signed_hash(buffer_view_t message, const batch_signature&);
+
+/// returns false if the proof or the root signature is invalid
+bool
+verify(pk::pk_base& key, buffer_view_t message, const batch_signature&);
+
+/// overload
+bool
+verify(const public_key&, buffer_view_t message, const batch_signature&);
+
+//-----------------------------------------------------------------------------
+
+/** collects the messages of many threads and signs them by batches (ex: the
+ * documents of a notarization service).
+ * a batch is signed by a background thread when it has max_messages, or
+ * when the window has passed since its first message, or by flush().
+ * the messages are hashed by the submitting threads.
+ *
+ * @code
+ * merkle::batch_signer signer{key, hash_t::sha256};
+ * auto f = signer.submit(document); // from any thread
+ * auto sig = f.get().dump();        // after at most a window
+ * @endcode
+ *
+ * @warning the key must not be used by others while the signer is alive.
+ */
+class batch_signer
+{
+public:
+    explicit batch_signer(
+        pk::pk_base&              key,
+        hash_t                    type         = hash_t::sha256,
+        size_t                    max_messages = 4096,
+        std::chrono::milliseconds window       = std::chrono::milliseconds{5});
+
+    /// signs the pending messages, then stops the thread
+    ~batch_signer();
+
+    /** queues a message, thread safe. the future throws the error of the
+     * signature (if any).
+     */
+    std::future<batch_signature> submit(buffer_view_t message);
+
+    /// signs the pending messages without waiting for the window
+    void flush();
+
+    /// number of the signed batches
+    size_t batches() const noexcept;
+
+public: // non-copyable, non-movable
+    batch_signer(const batch_signer&) = delete;
+    batch_signer& operator=(const batch_signer&) = delete;
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class batch_signer
+
+//-----------------------------------------------------------------------------
+} // namespace merkle
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_MERKLE_HPP
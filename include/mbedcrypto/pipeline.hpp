@@ -0,0 +1,119 @@
+/** @file pipeline.hpp
+ * fused single-pass processing of a buffer by several stages (ex: hash, then
+ * encrypt, then base64 encode).
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_PIPELINE_HPP
+#define MBEDCRYPTO_PIPELINE_HPP
+
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/hash.hpp"
+
+#include <functional>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** runs the input through a chain of stages, block by block.
+ * each block of the input flows through all the stages before the next block
+ * is read, so a block (and its transformed forms) stays in the L2 cache
+ * instead of being streamed through the memory once per operation.
+ * the transforming stages write into their own buffers, allocated once and
+ * reused by all the blocks.
+ *
+ * stages:
+ *  - add_hash(), add_hmac(): observe the data, the digest is written at
+ *    finish().
+ *  - add_cipher(): encrypts or decrypts the data by a keyed cipher, padding
+ *    and gcm tags are handled by the cipher object itself.
+ *  - add_base64(), add_hex(): encode the data.
+ *  - add_sink(): observes the data by a callback or appends it to a buffer.
+ * all the stages pass their (transformed) data to the next one, so a hash
+ * may be added after the cipher to digest the ciphertext, or a sink in the
+ * middle to tap an intermediate form.
+ *
+ * the hash, hmac and cipher objects are owned by the caller and must outlive
+ * the pipeline. they are (re)started by start(), an hmac must have been keyed
+ * before by hmac::start(key).
+ *
+ * @code
+ * hash     sha{hash_t::sha256};
+ * cipher   aes{cipher_t::aes_256_cbc};
+ * aes.key(key, cipher::encrypt_mode).iv(iv).padding(padding_t::pkcs7);
+ * buffer_t digest, encoded;
+ *
+ * pipeline p;
+ * p.add_hash(sha, digest).add_cipher(aes).add_base64().add_sink(encoded);
+ * p.run(plain_text); // or start(), update() by chunks, and finish()
+ * @endcode
+ *
+ * @warning a cipher in ecb mode must receive multiples of its block size, as
+ * by cipher::update().
+ */
+class pipeline
+{
+public:
+    /// the default size of the blocks, a few buffers of it fit into the L2
+    static constexpr size_t default_block_size = 64 * 1024;
+
+    using sink_t = std::function<void(const uint8_t* data, size_t size)>;
+
+    /// block_size = 0 means the default_block_size
+    explicit pipeline(size_t block_size = 0);
+    ~pipeline();
+
+    /// computes the hash of the data reaching this stage into digest
+    auto add_hash(hash&, buffer_t& digest) -> pipeline&;
+    /// computes the hmac of the data reaching this stage into digest
+    auto add_hmac(hmac&, buffer_t& digest) -> pipeline&;
+    /// crypts the data by a keyed cipher, the mode is set by cipher::key()
+    auto add_cipher(cipher&) -> pipeline&;
+    /// encodes the data into base64 (no line breaks nor null terminator)
+    auto add_base64() -> pipeline&;
+    /// encodes the data into hex (lower case)
+    auto add_hex() -> pipeline&;
+    /// passes the data reaching this stage to a callback
+    auto add_sink(sink_t) -> pipeline&;
+    /// appends the data reaching this stage to output
+    auto add_sink(buffer_t& output) -> pipeline&;
+
+    /// number of stages
+    size_t size() const noexcept;
+    size_t block_size() const noexcept;
+
+    /** resets all the stages for a new input.
+     * throws usage_error if there is no stage.
+     */
+    void start();
+
+    /// feeds a chunk of input (any size) between start() and finish()
+    void update(const uint8_t* chunk, size_t chunk_size);
+
+    void update(buffer_view_t chunk) {
+        update(chunk.data(), chunk.size());
+    }
+
+    /// flushes the stages (ex: the cipher padding) and writes the digests
+    void finish();
+
+    /// helper, runs start() / update() / finish() on a single input
+    void run(buffer_view_t input);
+
+    // move only
+    pipeline(const pipeline&) = delete;
+    pipeline(pipeline&&);
+    pipeline& operator=(const pipeline&) = delete;
+    pipeline& operator=(pipeline&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class pipeline
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_PIPELINE_HPP
@@ -97,6 +97,12 @@ max_crypt_size(const context&);
 bool
 has_private_key(const context&) noexcept;
 
+/** the memory of a context: the heap has the key (the big numbers of rsa,
+ * the tables of an ec group), the inline bytes include the rnd_generator.
+ */
+memory::usage
+footprint(const context&) noexcept;
+
 /// returns true if the current context can do specific operation
 bool
 can_do(const context&, pk_t other_type);
@@ -158,6 +164,8 @@ supports_ec_keygen() noexcept;
  * @sa supports_rsa_keygen()
  * exponent rsa public exponent. only change the default exponent value if you
  *  know exactly what you're doing.
+ * the keys of 4096bit and more are generated by Montgomery exponentiations of
+ *  sub-quadratic products (much faster than mbedtls_rsa_gen_key()).
  * @warning requires the MBEDCRYPTO_RSA_KEYGEN option (see cmake file)
  */
 void
@@ -171,7 +179,9 @@ void
 generate_ec_key(context&, curve_t);
 
 /** signs a hash value (of a message) by the private key.
- * @note for RSA keys, the signature is padded by PKCS#1 v1.5
+ * @note for RSA keys, the signature is padded by PKCS#1 v1.5. the keys of
+ * 4096bit and more are signed by Montgomery exponentiations of sub-quadratic
+ * products (the same signatures as mbedtls).
  * @sa what_can_do()
  */
 buffer_t
@@ -248,6 +258,10 @@ struct pk_base {
         return pk::has_private_key(context());
     }
 
+    auto footprint() const noexcept {
+        return pk::footprint(context());
+    }
+
     bool can_do(pk_t ptype) const {
         return pk::can_do(context(), ptype);
     }
@@ -0,0 +1,70 @@
+/** @file pk_cache.hpp
+ * a compact binary format to cache (save and reload) rsa and ec keys fast.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_PK_CACHE_HPP
+#define MBEDCRYPTO_PK_CACHE_HPP
+
+#include "mbedcrypto/pk.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace pk {
+//-----------------------------------------------------------------------------
+
+/** serializes a key (public or private) into the binary cache format.
+ * unlike pem and der, the cache also keeps the precomputed values:
+ *  - rsa: the CRT parameters (DP, DQ, QP). the montgomery constants are
+ *    not kept, they are computed by the first operation of a loaded key.
+ *  - ec: the curve id and the decompressed (x, y) public point.
+ *
+ * the big numbers are stored as raw limbs, so a cache loads by a single copy
+ * pass without base64 nor ASN.1, and only by the cheap checks of the values
+ * (ranges and sizes, the ec public point on its curve).
+ * the format has a version and a CRC-32 checksum (against corruption, it is
+ * not an authentication).
+ *
+ * @warning the cache of a private key holds the secrets in clear, store it
+ * as you store the private key (ex: encrypted).
+ * @warning the pairing of the private and the public values is not checked,
+ * load the caches of private keys from trusted (integrity protected) sources
+ * only.
+ * @warning the cache depends on the limb size and byte order of the
+ * platform, from_cache() rejects a cache of another platform (reload the pem
+ * or der key then).
+ */
+buffer_t
+to_cache(const context&);
+
+/** (re)initializes a key by a cache made by to_cache().
+ * throws if the cache is invalid (corrupted, other version or platform) or
+ * the key type does not match the context (ex: an ec cache into an rsa).
+ */
+void
+from_cache(context&, buffer_view_t cache);
+
+/// returns true if the data looks like a (valid) cache of this platform
+bool
+is_cache(buffer_view_t data) noexcept;
+
+//-----------------------------------------------------------------------------
+
+/// helper, @sa to_cache()
+inline auto
+to_cache(const pk_base& key) {
+    return to_cache(key.context());
+}
+
+/// helper, @sa from_cache()
+inline void
+from_cache(pk_base& key, buffer_view_t cache) {
+    from_cache(key.context(), cache);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace pk
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_PK_CACHE_HPP
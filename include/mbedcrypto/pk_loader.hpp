@@ -0,0 +1,80 @@
+/** @file pk_loader.hpp
+ * bulk (parallel) import of many keys at once.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_PK_LOADER_HPP
+#define MBEDCRYPTO_PK_LOADER_HPP
+
+#include "mbedcrypto/pk.hpp"
+
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace pk {
+//-----------------------------------------------------------------------------
+
+/** a key imported by the bulk loader.
+ * on success key is an instance of mbedcrypto::rsa or mbedcrypto::ecp
+ * (depends on the key type), otherwise key is nullptr and error/error_string
+ * describe the failure.
+ */
+struct loaded_key {
+    std::unique_ptr<pk_base> key; ///< rsa or ecp, nullptr on error
+    std::string source;       ///< file path and/or entry index, ex: "a.pem#2"
+    int         error = 0;    ///< mbedtls error code, 0 on success
+    std::string error_string; ///< readable error message, empty on success
+
+    bool ok() const noexcept {
+        return key != nullptr;
+    }
+}; // struct loaded_key
+
+using loaded_keys = std::vector<loaded_key>;
+
+/// options of the bulk loader
+struct bulk_options {
+    /** password of encrypted private keys, both legacy pem encryption
+     * (DEK-Info) and PKCS#8 (ENCRYPTED PRIVATE KEY, PBES2) are supported.
+     * ignored for plain keys. */
+    buffer_t password;
+    /// max number of threads (caller thread included), 0 means all the cores
+    size_t max_threads = 0;
+}; // struct bulk_options
+
+/** parses all the keys in a multi-pem bundle in parallel.
+ * the entries are split from the bundle without copy, public keys
+ * (PUBLIC KEY, RSA PUBLIC KEY) and private keys (PRIVATE KEY,
+ * RSA PRIVATE KEY, EC PRIVATE KEY, ENCRYPTED PRIVATE KEY) are imported,
+ * other pem blocks (certificates, ec parameters, ...) are skipped.
+ * the order of the results is the order of entries in the bundle.
+ * @note if the bundle is not null terminated, it will be copied once.
+ */
+loaded_keys
+load_bundle(buffer_view_t pem_bundle, const bulk_options& = bulk_options{});
+
+/** parses a list of keys in parallel.
+ * each buffer could be a pem (single key or a bundle) or a der key (private
+ * or public). a pem bundle yields one result per key.
+ */
+loaded_keys
+load_buffers(
+    const std::vector<buffer_view_t>& keys,
+    const bulk_options&               = bulk_options{});
+
+/** reads and parses all the key files of a directory in parallel.
+ * every regular (non hidden) file is read as a pem (or pem bundle) or a der
+ * key, files are processed in the sorted order of their names.
+ * throws if the directory could not be opened, other failures are
+ * reported per entry.
+ */
+loaded_keys
+load_directory(const char* dir_path, const bulk_options& = bulk_options{});
+
+//-----------------------------------------------------------------------------
+} // namespace pk
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_PK_LOADER_HPP
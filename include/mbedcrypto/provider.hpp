@@ -0,0 +1,258 @@
+/** @file provider.hpp
+ * pluggable providers of the cipher, hash and pk operations, and an offload
+ * provider standing in for accelerator cards.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_PROVIDER_HPP
+#define MBEDCRYPTO_PROVIDER_HPP
+
+#include "mbedcrypto/pk.hpp"
+
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** a single operation, as a value: the algorithm, the inputs and the keys.
+ * the buffers are owned by the operation, so it may run later in another
+ * thread. make it by the helpers:
+ * @code
+ * auto op = operation::hash(hash_t::sha256, message);
+ * @endcode
+ */
+struct operation {
+    enum class kind_t {
+        hash,         ///< output = hash of input
+        hmac,         ///< output = hmac of input by key
+        encrypt,      ///< output = cipher::encrypt()
+        decrypt,      ///< output = cipher::decrypt()
+        encrypt_aead, ///< output and tag = cipher::encrypt_aead()
+        decrypt_aead, ///< ok and output = cipher::decrypt_aead()
+        sign,         ///< output = pk::sign() of the hash value input
+        verify,       ///< ok = pk::verify() of the signature (tag)
+    };
+
+    kind_t    kind        = kind_t::hash;
+    hash_t    hash_type   = hash_t::none;
+    cipher_t  cipher_type = cipher_t::none;
+    padding_t padding     = padding_t::none;
+    buffer_t  input;
+    buffer_t  key;
+    buffer_t  iv;
+    buffer_t  ad;  ///< additional data of aead
+    buffer_t  tag; ///< the tag of decrypt_aead, or the signature of verify
+    /// the key of sign and verify, owned by the caller. it must outlive the
+    /// operation and must not be used by other operations at the same time
+    pk::context* pk_key = nullptr;
+
+    operation() = default;
+    /// wipes the key, also the inline buffer of a moved-from short key
+    ~operation();
+    operation(const operation&) = default;
+    operation(operation&&)      = default;
+    operation& operator=(const operation&) = default;
+    operation& operator=(operation&&) = default;
+
+    static operation hash(hash_t, buffer_view_t input);
+    static operation hmac(hash_t, buffer_view_t key, buffer_view_t input);
+    static operation encrypt(
+        cipher_t, padding_t, buffer_view_t iv, buffer_view_t key,
+        buffer_view_t input);
+    static operation decrypt(
+        cipher_t, padding_t, buffer_view_t iv, buffer_view_t key,
+        buffer_view_t input);
+    static operation encrypt_aead(
+        cipher_t, buffer_view_t iv, buffer_view_t key, buffer_view_t ad,
+        buffer_view_t input);
+    static operation decrypt_aead(
+        cipher_t, buffer_view_t iv, buffer_view_t key, buffer_view_t ad,
+        buffer_view_t tag, buffer_view_t input);
+    static operation sign(pk::context&, buffer_view_t hash_value, hash_t);
+    static operation verify(
+        pk::context&, buffer_view_t signature, buffer_view_t hash_value,
+        hash_t);
+}; // struct operation
+
+/// the outcome of an operation
+struct op_result {
+    /// false if decrypt_aead is not authenticated or verify fails
+    bool     ok = true;
+    buffer_t output;
+    buffer_t tag; ///< the tag of encrypt_aead
+    /// the exception of a failed operation (ex: bad key size), or null
+    std::exception_ptr error;
+    /// the name of the provider which ran the operation
+    const char* provider = nullptr;
+
+    /// throws the error if any
+    void rethrow() const {
+        if (error)
+            std::rethrow_exception(error);
+    }
+}; // struct op_result
+
+//-----------------------------------------------------------------------------
+
+/** the interface of the implementations of the operations.
+ * run() computes an operation in the calling thread, submit() queues it and
+ * reports the result later by a completion callback. the default submit()
+ * runs the operation inline.
+ */
+class provider
+{
+public:
+    using completion_t = std::function<void(op_result&&)>;
+
+    virtual ~provider() = default;
+
+    virtual const char* name() const noexcept = 0;
+
+    /// true if the provider implements the kind and the algorithm of op
+    virtual bool supports(const operation& op) const noexcept = 0;
+
+    /// computes op in the calling thread, the errors are in the result
+    virtual op_result run(const operation& op) = 0;
+
+    /** queues op, done is called once with its result (maybe by another
+     * thread). returns false and leaves op untouched if the provider is
+     * saturated, the caller should fall back to another provider then.
+     */
+    virtual bool submit(operation& op, completion_t done) {
+        done(run(op));
+        return true;
+    }
+}; // class provider
+
+/// the in-process mbedtls implementation of all the operations, a singleton
+std::shared_ptr<provider>
+builtin_provider();
+
+//-----------------------------------------------------------------------------
+
+/** runs the operations of a backend provider (builtin by default) by its own
+ * worker threads, as an accelerator card does by its engines.
+ * the submissions go to a bounded ring of slots shared by the submitters and
+ * the workers. a worker takes up to batch_size operations per wake up and
+ * reports their completions together after the batch, so the lock and the
+ * wake ups are per batch and not per operation.
+ * submit() returns false if the ring is full (saturated).
+ *
+ * the destructor runs the queued operations before joining the workers.
+ */
+class offload_provider : public provider
+{
+public:
+    struct options {
+        size_t workers    = 2;   ///< 0 means hardware_concurrency()
+        size_t queue_size = 256; ///< slots of the submission ring
+        size_t batch_size = 16;  ///< max operations per worker wake up
+        /// the implementation run by the workers, null means the builtin
+        std::shared_ptr<provider> backend;
+    };
+
+    struct counters {
+        size_t submitted = 0; ///< accepted by submit()
+        size_t rejected  = 0; ///< refused by submit() (saturated)
+        size_t completed = 0;
+        size_t batches   = 0; ///< worker wake ups with some work
+    };
+
+    offload_provider(); ///< by the default options
+    explicit offload_provider(options);
+    ~offload_provider();
+
+    const char* name() const noexcept override;
+    bool        supports(const operation&) const noexcept override;
+    op_result   run(const operation&) override;
+    bool        submit(operation&, completion_t done) override;
+
+    /// the queued (not yet started) operations
+    size_t pending() const;
+    size_t capacity() const noexcept;
+    auto   stats() const -> counters;
+
+    // non-copyable, non-movable: the workers refer to this object
+    offload_provider(const offload_provider&) = delete;
+    offload_provider& operator=(const offload_provider&) = delete;
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class offload_provider
+
+//-----------------------------------------------------------------------------
+
+/** resolves the operations to the providers.
+ * the providers are tried by the order of add() (latest first), the first
+ * one supporting an operation receives it. if it is saturated, the next ones
+ * are tried, and the builtin provider runs the operation in the calling
+ * thread as the last resort.
+ *
+ * @code
+ * auto card = std::make_shared<offload_provider>();
+ * dispatcher d;
+ * d.add(card);
+ * auto digest = d.async(operation::hash(hash_t::sha256, data));
+ * auto results = d.run_many(std::move(operations)); // waits once
+ * @endcode
+ *
+ * thread safe, but add() must not race with the submissions.
+ */
+class dispatcher
+{
+public:
+    struct counters {
+        size_t submitted   = 0; ///< accepted by a supporting provider
+        size_t fallbacks   = 0; ///< refused by a saturated provider
+        size_t inline_runs = 0; ///< run by the builtin in the caller thread
+    };
+
+    dispatcher();
+    ~dispatcher();
+
+    /// the new provider is tried before the ones added earlier
+    auto add(std::shared_ptr<provider>) -> dispatcher&;
+
+    /// the first provider supporting op (the builtin if none)
+    auto resolve(const operation& op) const -> provider&;
+
+    /** submits op, done is called once with its result.
+     * the results by a provider carry its name in op_result::provider.
+     */
+    void submit(operation op, provider::completion_t done);
+
+    /// submits op, the future throws the error of the operation if any
+    auto async(operation op) -> std::future<op_result>;
+
+    /// runs op and waits for it, throws the error of the operation if any
+    auto run(operation op) -> op_result;
+
+    /** submits all the operations and blocks until all are completed. the
+     * waiting thread is woken up once, by the last completion. the errors
+     * are not thrown, they are in the results (by the order of ops).
+     */
+    auto run_many(std::vector<operation> ops) -> std::vector<op_result>;
+
+    auto stats() const -> counters;
+
+    // move only
+    dispatcher(const dispatcher&) = delete;
+    dispatcher(dispatcher&&);
+    dispatcher& operator=(const dispatcher&) = delete;
+    dispatcher& operator=(dispatcher&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class dispatcher
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_PROVIDER_HPP
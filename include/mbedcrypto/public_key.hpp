@@ -0,0 +1,116 @@
+/** @file public_key.hpp
+ * slim (verify and encrypt only) public keys.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_PUBLIC_KEY_HPP
+#define MBEDCRYPTO_PUBLIC_KEY_HPP
+
+#include "mbedcrypto/pk.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** a public key (rsa or ec) that holds only the parsed key material.
+ * rsa and ecp instances embed a rnd_generator (an entropy context and a
+ * CTR_DRBG) which is never used by verify(), so each cached key carries
+ * kilobytes of unused state. this class is meant for large caches of
+ * public keys (ex: verifying keys of many peers).
+ *
+ * the results are identical to pk::verify() and pk::encrypt().
+ *
+ * @code
+ * public_key pub{pem_or_der_data};
+ * if (pub.verify_message(signature, message, hash_t::sha256))
+ *     accept();
+ *
+ * // the public part of a full key
+ * public_key slim{my_rsa};
+ * @endcode
+ */
+class public_key
+{
+public:
+    /// an empty key, @sa import()
+    public_key();
+    /// parses a public key, @sa import()
+    explicit public_key(buffer_view_t public_key_data);
+    /// copies the public part of an rsa or ecp key, @sa assign()
+    explicit public_key(const pk::pk_base&);
+    ~public_key();
+
+    /** (re)initializes by public key data (pem or der).
+     * a pem key must include the null terminating byte.
+     */
+    void import(buffer_view_t public_key_data);
+
+    /// (re)initializes by loading a public key file
+    void load(const char* file_path);
+
+    /** (re)initializes by a deep copy of the public part of an rsa or ecp
+     * key, the private part (if any) is not copied.
+     */
+    void assign(const pk::pk_base&);
+
+    /// true if no key has been imported
+    bool empty() const noexcept;
+
+    pk_t type() const;
+
+    auto name() const noexcept -> const char*;
+
+    /// size of underlying key in bits, or 0 if empty
+    size_t key_bitlen() const noexcept;
+
+    /// size of underlying key in bytes, or 0 if empty
+    size_t key_length() const noexcept;
+
+    /// @sa pk::max_crypt_size()
+    size_t max_crypt_size() const;
+
+    /// the memory of this object, a fraction of a pk::footprint()
+    auto footprint() const noexcept -> memory::usage;
+
+    bool can_do(pk_t) const;
+
+    /// verifies a signature of a hash value, @sa pk::verify()
+    bool verify(
+        buffer_view_t signature,
+        buffer_view_t hash_value,
+        hash_t        hash_type) const;
+
+    /// verify helper, message could be in any size
+    bool verify_message(
+        buffer_view_t signature,
+        buffer_view_t message,
+        hash_t        hash_type) const {
+        return verify(signature, hash::make(hash_type, message), hash_type);
+    }
+
+    /** encrypts (rsa only, PKCS#1 v1.5 padding) by the random bytes of rnd.
+     * @sa pk::encrypt()
+     */
+    buffer_t encrypt(buffer_view_t source, rnd_generator& rnd) const;
+
+    /** overload, the random bytes come from a generator shared by all the
+     * keys of the calling thread (created on the first use).
+     */
+    buffer_t encrypt(buffer_view_t source) const;
+
+public: // move only
+    public_key(const public_key&) = delete;
+    public_key(public_key&&);
+    public_key& operator=(const public_key&) = delete;
+    public_key& operator=(public_key&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class public_key
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_PUBLIC_KEY_HPP
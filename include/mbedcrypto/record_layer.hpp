@@ -0,0 +1,140 @@
+/** @file record_layer.hpp
+ * TLS like protection of records by an aead cipher, with sequence number
+ * nonces and a replay window.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_RECORD_LAYER_HPP
+#define MBEDCRYPTO_RECORD_LAYER_HPP
+
+#include "mbedcrypto/cipher.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** seals and opens the records of a single direction of a connection (a
+ * connection has a record_layer per direction, each by its own key).
+ * to use this class you must build mbedcrypto with:
+ *  - MBEDCRYPTO_GCM or MBEDCRYPTO_CCM
+ *
+ * a record on the wire is:
+ *  [type (1) | version (2) | sequence (8) | length (2)] [cipher text | tag]
+ * all in big endian, length is the size of cipher text + tag (16 bytes).
+ * the 13 bytes header is the additional data of the record, the nonce is the
+ * 12 bytes iv xor the sequence number (right aligned, as TLS 1.3).
+ *
+ * the key is expanded once by key(), the sealing and the opening write into
+ * the caller buffers and do not allocate.
+ * the sequence numbers of the sealed records start from 0, the opened ones
+ * are checked against a sliding window (as DTLS / IPsec): the replayed and
+ * the too old records are rejected, the reordered ones inside the window
+ * are accepted once.
+ *
+ * @code
+ * record_layer tx{cipher_t::aes_128_gcm};
+ * tx.key(key, iv);
+ * buffer_t wire(record_layer::sealed_size(payload.size()), '\0');
+ * tx.seal(23, payload, to_ptr(wire)); // 23: application data
+ *
+ * record_layer rx{cipher_t::aes_128_gcm};
+ * rx.key(key, iv);
+ * auto r = rx.open(wire, to_ptr(plain)); // r.size bytes into plain
+ * if (r.result != record_layer::status::ok) ...
+ * @endcode
+ *
+ * @warning a single thread must use the object at a time.
+ */
+class record_layer
+{
+public:
+    static constexpr size_t header_size    = 13;
+    static constexpr size_t tag_size       = 16;
+    static constexpr size_t iv_size        = 12;
+    static constexpr size_t overhead       = header_size + tag_size;
+    static constexpr size_t max_payload    = 0xffff - tag_size;
+    static constexpr size_t default_window = 64; ///< in records
+
+    /// the result of open()
+    enum class status {
+        ok,
+        malformed, ///< invalid header, length or version
+        replayed,  ///< seen before, or older than the window
+        forged,    ///< failed the authentication
+    };
+
+    struct opened {
+        status   result   = status::malformed;
+        uint8_t  type     = 0;
+        uint64_t sequence = 0;
+        size_t   size     = 0; ///< of the payload
+    }; // struct opened
+
+    /// the size of a record on the wire
+    static constexpr size_t sealed_size(size_t payload_size) noexcept {
+        return payload_size + overhead;
+    }
+
+    /** returns the full size of the first record in data, or 0 if data has
+     * less than a header. useful to split a stream into records.
+     */
+    static size_t record_size(buffer_view_t data) noexcept;
+
+public:
+    /** type must be a gcm or ccm cipher, version is written into (and
+     * checked from) the headers, window is the replay window in records
+     * (rounded up to 64).
+     */
+    explicit record_layer(
+        cipher_t type,
+        uint16_t version = 0x0303,
+        size_t   window  = default_window);
+    ~record_layer();
+
+    /** sets the key (by the key size of the cipher) and the 12 bytes iv,
+     * resets the sequence numbers and the replay window.
+     */
+    auto key(buffer_view_t key_data, buffer_view_t iv) -> record_layer&;
+
+    /** seals a payload as the next record into output, which must have room
+     * for sealed_size(payload.size()) bytes. returns the record size.
+     */
+    size_t seal(uint8_t type, buffer_view_t payload, uint8_t* output);
+
+    /// overload
+    auto seal(uint8_t type, buffer_view_t payload) -> buffer_t;
+
+    /** seals many payloads as consecutive records into output, which must
+     * have room for the sum of their sealed_size(). returns the total size.
+     */
+    size_t seal_many(
+        uint8_t                           type,
+        const std::vector<buffer_view_t>& payloads,
+        uint8_t*                          output);
+
+    /** opens a single (whole) record, the payload is written into output
+     * which must have room for record.size() - overhead bytes. output may
+     * also be record.data() + header_size (in place).
+     * on any failure the output is wiped and the window is not changed.
+     */
+    auto open(buffer_view_t record, uint8_t* output) -> opened;
+
+    /// the sequence number of the next sealed record
+    uint64_t next_sequence() const noexcept;
+
+public: // move only
+    record_layer(const record_layer&) = delete;
+    record_layer(record_layer&&);
+    record_layer& operator=(const record_layer&) = delete;
+    record_layer& operator=(record_layer&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class record_layer
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_RECORD_LAYER_HPP
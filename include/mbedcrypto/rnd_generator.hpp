@@ -8,6 +8,7 @@
 #ifndef MBEDCRYPTO_RND_GENERATOR_HPP
 #define MBEDCRYPTO_RND_GENERATOR_HPP
 
+#include "mbedcrypto/memory.hpp"
 #include "mbedcrypto/types.hpp"
 //-----------------------------------------------------------------------------
 namespace mbedcrypto {
@@ -107,6 +108,11 @@ public: // auxiliary methods
     /// low level overload
     void update(const uint8_t* additional, size_t length) noexcept;
 
+    /** the memory of this object, the entropy and the drbg contexts are
+     * inline (no heap).
+     */
+    auto footprint() const noexcept -> memory::usage;
+
     // move only
     rnd_generator(const rnd_generator&) = delete;
     rnd_generator(rnd_generator&&)      = default;
@@ -0,0 +1,92 @@
+/** @file secp256k1.hpp
+ * a fast secp256k1 backend: ECDSA verify and BIP340 Schnorr signatures.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_SECP256K1_HPP
+#define MBEDCRYPTO_SECP256K1_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+class rnd_generator;
+//-----------------------------------------------------------------------------
+namespace secp256k1 {
+//-----------------------------------------------------------------------------
+
+/** the verifiers of this backend do not use the generic ec code of mbedtls,
+ * they use the efficient endomorphism of the curve (GLV):
+ *  k * P = k1 * P + k2 * lambda(P), lambda(x, y) = (beta * x, y)
+ * where k1 and k2 are about 128 bits, so a scalar multiplication needs half
+ * of the point doublings. the products of a verification (ex: u1 * G + u2 *
+ * Q) are computed together (Strauss) by wNAF digits, the odd multiples of G
+ * and lambda(G) are precomputed once (window 8), and the field is reduced
+ * by the special form of p = 2^256 - 2^32 - 977.
+ *
+ * ecdsa::verify() of a secp256k1 key uses this backend automatically.
+ */
+
+/** verifies an ECDSA signature (ASN.1 DER, as ecdsa::sign()) of a hash
+ * value by a public key, a SEC1 point of 33 (compressed) or 65 bytes.
+ * a hash value longer than 32 bytes is truncated as the standard.
+ * returns false for an invalid signature, public key or encoding.
+ */
+bool
+ecdsa_verify(
+    buffer_view_t public_key,
+    buffer_view_t hash_value,
+    buffer_view_t signature);
+
+//-----------------------------------------------------------------------------
+// BIP340 Schnorr signatures, x-only public keys of 32 bytes and signatures of
+// 64 bytes. the messages are of any size (ex: 32 bytes of a hash).
+
+/// the x-only public key of a 32 bytes secret key
+buffer_t
+schnorr_public_key(buffer_view_t secret_key);
+
+/** signs a message by a 32 bytes secret key, aux_random must be 32 fresh
+ * random bytes (or zeros, as the deterministic samples of BIP340).
+ * the products of the secret key and the nonce are in constant time (a
+ * fixed window by complete formulas), and the secrets are wiped.
+ * throws usage_error for an invalid secret key or aux_random.
+ */
+buffer_t
+schnorr_sign(
+    buffer_view_t secret_key,
+    buffer_view_t message,
+    buffer_view_t aux_random);
+
+/// returns false for an invalid signature, public key or size
+bool
+schnorr_verify(
+    buffer_view_t public_key, buffer_view_t message, buffer_view_t signature);
+
+struct schnorr_item {
+    buffer_view_t public_key;
+    buffer_view_t message;
+    buffer_view_t signature;
+}; // struct schnorr_item
+
+/** verifies many signatures at once (ex: the signatures of a block), returns
+ * true only if all of them are valid.
+ *
+ * the batch is a single multi-scalar multiplication per chunk of items:
+ *  (sum a_i * s_i) * G == sum a_i * R_i + sum (a_i * e_i) * P_i
+ * by 128-bit random weights a_i drawn from rnd, so the doublings are shared
+ * by the whole chunk and the precomputed points are affine (a single field
+ * inversion per chunk). if false, verify the items one by one to find the
+ * invalid ones.
+ */
+bool
+schnorr_verify_batch(const std::vector<schnorr_item>& items, rnd_generator&);
+
+//-----------------------------------------------------------------------------
+} // namespace secp256k1
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_SECP256K1_HPP
@@ -0,0 +1,79 @@
+/** @file shamir.hpp
+ * Shamir secret sharing over GF(2^8).
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_SHAMIR_HPP
+#define MBEDCRYPTO_SHAMIR_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+class rnd_generator;
+//-----------------------------------------------------------------------------
+namespace shamir {
+//-----------------------------------------------------------------------------
+
+/** splits a secret (ex: a master key) into count shares, any threshold of
+ * them recover the secret, fewer reveal nothing about it.
+ *
+ * each byte of the secret is the constant term of a random polynomial of
+ * degree threshold - 1 over GF(2^8) (the AES field), a share is the values
+ * of the polynomials at a distinct point x:
+ *  [x (1 byte, 1 ... 255)] [y (a byte per secret byte)]
+ *
+ * the random coefficients are drawn from rnd by a single call, and the
+ * polynomials of all the bytes are evaluated together by the SSSE3 / AVX2
+ * kernels (if available on the CPU).
+ *
+ * @code
+ * rnd_generator rnd;
+ * auto shares = shamir::split(master_key, 3, 5, rnd); // 3 out of 5
+ * ...
+ * auto key = shamir::combine({shares[4], shares[0], shares[2]});
+ * @endcode
+ *
+ * throws usage_error if threshold < 2, count < threshold, count > 255 or the
+ * secret is empty.
+ */
+std::vector<buffer_t>
+split(buffer_view_t secret, size_t threshold, size_t count, rnd_generator&);
+
+/** recovers the secret by threshold (or more) shares of a split().
+ * throws usage_error if the shares have different sizes, or the same x.
+ * @warning the shares are not authenticated: by fewer than threshold (or
+ * modified) shares the result is a wrong secret, verify it by other means
+ * (ex: a known digest or an aead tag).
+ */
+buffer_t
+combine(const std::vector<buffer_t>& shares);
+
+/** splits many secrets at once (ex: the keys of many tenants), with the
+ * same threshold and count. returns the shares of each secret, in the order
+ * of secrets (the secrets may have different sizes).
+ * all the secrets are evaluated as a single long vector by each x, and the
+ * randomness of all of them is drawn by a single call.
+ */
+std::vector<std::vector<buffer_t>>
+split_many(
+    const std::vector<buffer_view_t>& secrets,
+    size_t                            threshold,
+    size_t                            count,
+    rnd_generator&);
+
+/** recovers many secrets, each by its own set of shares.
+ * the consecutive sets at the same x coordinates (ex: the same custodians)
+ * share the lagrange coefficients.
+ */
+std::vector<buffer_t>
+combine_many(const std::vector<std::vector<buffer_t>>& share_sets);
+
+//-----------------------------------------------------------------------------
+} // namespace shamir
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_SHAMIR_HPP
@@ -0,0 +1,108 @@
+/** @file tuning.hpp
+ * host dependent thresholds of the parallel and batched operations, found
+ * by micro-benchmarks on the current machine.
+ *
+ * the thresholds start from static defaults. only an explicit calibrate()
+ * runs the benchmarks, and persists the results into a small versioned cache
+ * file which the next processes on the same host read on first use.
+ * the cache file is:
+ *  - $MBEDCRYPTO_TUNING_FILE if defined (an empty value disables the cache)
+ *  - or $XDG_CACHE_HOME/mbedcrypto_tuning.cache
+ *  - or $HOME/.cache/mbedcrypto_tuning.cache
+ *  - or %LOCALAPPDATA%\\mbedcrypto_tuning.cache (windows)
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_TUNING_HPP
+#define MBEDCRYPTO_TUNING_HPP
+
+#include "mbedcrypto/types.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace tuning {
+//-----------------------------------------------------------------------------
+
+/// the tuned values, the defaults are used before any calibration
+struct thresholds {
+    /// min size of a buffer to be processed by multiple cores
+    size_t parallel_min_bytes = 1024 * 1024;
+    /// size of the segments of a buffer processed in parallel
+    size_t segment_size = 256 * 1024;
+    /// number of independent blocks (buffers) processed together by the
+    /// multi-buffer (interleaved) primitives
+    size_t lanes = 4;
+    /// number of threads of the shared worker pool, the hardware threads by
+    /// the defaults of current()
+    size_t pool_threads = 1;
+    /// min size (in 64bit limbs) of the big number products by Karatsuba
+    /// (ex: RSA 4096bit and larger keys), and by Toom-3. larger than 256
+    /// (16384bit) means never
+    size_t karatsuba_limbs = 64;
+    size_t toom3_limbs     = 256;
+
+    bool operator==(const thresholds& o) const noexcept {
+        return parallel_min_bytes == o.parallel_min_bytes &&
+               segment_size == o.segment_size && lanes == o.lanes &&
+               pool_threads == o.pool_threads &&
+               karatsuba_limbs == o.karatsuba_limbs &&
+               toom3_limbs == o.toom3_limbs;
+    }
+}; // struct thresholds
+
+/// where the current thresholds come from
+enum class origin_t {
+    defaults,    ///< not calibrated, no cache file
+    cache,       ///< loaded from the cache file
+    calibration, ///< measured by this process
+    user,        ///< set by set_thresholds()
+};
+
+/** returns the thresholds of this host.
+ * on the first call loads the cache file if it exists and is valid for this
+ * version and host, otherwise uses the defaults. never runs the benchmarks
+ * nor writes the cache. thread safe.
+ */
+thresholds
+current();
+
+/// the origin of current() values
+origin_t
+origin();
+
+/** runs the micro-benchmarks now (takes tens of milliseconds) and makes the
+ * results the current thresholds. if persist is true, the results are also
+ * written into the cache file.
+ */
+thresholds
+calibrate(bool persist = true);
+
+/// overrides the current thresholds, and writes them to the cache if persist
+void
+set_thresholds(const thresholds&, bool persist = false);
+
+/// path of the cache file, empty if the cache is disabled
+std::string
+cache_path();
+
+/// changes the path of the cache file, an empty path disables the cache
+void
+set_cache_path(const std::string& path);
+
+/// writes thresholds as a versioned cache file, throws on error
+void
+save(const char* file_path, const thresholds&);
+
+/** reads a cache file written by save().
+ * returns false if the file is missing or invalid, or if it has been written
+ * by another cache version or on another host.
+ */
+bool
+load(const char* file_path, thresholds&);
+
+//-----------------------------------------------------------------------------
+} // namespace tuning
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_TUNING_HPP
@@ -187,6 +187,8 @@ enum class features {
                 /// pk::supports_key_export()
     rsa_keygen, ///< RSA key generator. @sa pk::supports_rsa_keygen()
     ec_keygen,  ///< EC key generator. @sa pk::supports_ec_keygen()
+    x509,       ///< X.509 certificates. @sa supports_x509()
+    dhm,        ///< finite field Diffie-Hellman. @sa supports_dhm()
 };
 
 //-----------------------------------------------------------------------------
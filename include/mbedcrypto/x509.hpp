@@ -0,0 +1,185 @@
+/** @file x509.hpp
+ * X.509 certificate parsing, chain verification and a cache of verified
+ * chains.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_X509_HPP
+#define MBEDCRYPTO_X509_HPP
+
+#include "mbedcrypto/pk.hpp"
+
+#include <chrono>
+#include <ctime>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+class public_key;
+//-----------------------------------------------------------------------------
+
+/// returns true only by enabled MBEDCRYPTO_X509 builds
+bool
+supports_x509() noexcept;
+
+/** a certificate, or a chain of certificates (leaf first, then the
+ * intermediates) as sent by a peer.
+ * to use this class you must build mbedcrypto with:
+ *  - MBEDCRYPTO_X509
+ * @sa cmake options
+ */
+class x509_cert
+{
+public:
+    /// information of a certificate
+    struct info_t {
+        int         version = 0;     ///< 1, 2 or 3
+        std::string serial;          ///< hex string, ex: 01:A3:...
+        std::string subject;         ///< distinguished name, ex: CN=...
+        std::string issuer;          ///< distinguished name of the issuer
+        std::time_t not_before = 0;  ///< validity start (utc)
+        std::time_t not_after  = 0;  ///< validity end (utc)
+        bool        is_ca      = false;
+        int         path_length = -1; ///< ca path constraint, -1: unlimited
+        pk_t        key_type    = pk_t::none;
+        size_t      key_bitlen  = 0;
+        hash_t      signature_hash = hash_t::none;
+    }; // struct info_t
+
+public:
+    explicit x509_cert();
+    ~x509_cert();
+
+    /** parses and appends certificates to this chain.
+     * accepts a pem (one or more certificates) or a single der certificate.
+     * a pem data is copied once if it is not null terminated.
+     */
+    void import(buffer_view_t pem_or_der);
+
+    /// loads and appends certificates from a pem or der file
+    void load(const char* file_path);
+
+    /// number of certificates in this chain
+    size_t size() const noexcept;
+
+    bool empty() const noexcept {
+        return size() == 0;
+    }
+
+    /// information of a certificate, index 0 is the leaf
+    auto info(size_t index = 0) const -> info_t;
+
+    /// the raw (der) data of a certificate
+    buffer_t der(size_t index = 0) const;
+
+    /// the fingerprint (hash of the der data) of a certificate
+    buffer_t fingerprint(size_t index = 0, hash_t = hash_t::sha256) const;
+
+    /** (re)initializes a pk by the subject public key of a certificate.
+     * throws if the type of pk does not match the key type.
+     */
+    void public_key(pk::pk_base&, size_t index = 0) const;
+
+    /// returns the subject public key as a new rsa or ecp instance
+    auto public_key(size_t index = 0) const -> std::unique_ptr<pk::pk_base>;
+
+    /// (re)initializes a slim public key by the subject public key
+    void public_key(mbedcrypto::public_key&, size_t index = 0) const;
+
+    /// a multi-line human readable description of a certificate
+    std::string dump(size_t index = 0) const;
+
+public: // move only
+    x509_cert(const x509_cert&) = delete;
+    x509_cert(x509_cert&&);
+    x509_cert& operator=(const x509_cert&) = delete;
+    x509_cert& operator=(x509_cert&&);
+
+protected:
+    friend class x509_verifier;
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class x509_cert
+
+//-----------------------------------------------------------------------------
+
+/** verifies certificate chains against a set of trusted (root) certificates.
+ * successfully verified chains are cached by the fingerprints of the chain
+ * (and the expected name), so the repeated verification of the same peer
+ * skips the RSA/ECDSA signature checks of the whole chain.
+ * a cached result expires by its time to live, or by the earliest not_after
+ * of the verified chain (trusted root included), whichever comes first.
+ *
+ * all the methods are thread safe.
+ */
+class x509_verifier
+{
+public:
+    /// result of a verification
+    struct result_t {
+        bool        ok         = false;
+        uint32_t    flags      = 0;     ///< mbedtls verification flags
+        bool        from_cache = false; ///< true on a cache hit
+        std::time_t expires    = 0;     ///< cache expiry, 0 if not cached
+
+        /// human readable reason(s) of a failure
+        std::string reason() const;
+
+        explicit operator bool() const noexcept {
+            return ok;
+        }
+    }; // struct result_t
+
+    /// statistics of the verified-chain cache
+    struct stats_t {
+        size_t hits      = 0;
+        size_t misses    = 0;
+        size_t evictions = 0; ///< expired or dropped by capacity
+        size_t size      = 0; ///< current number of cached chains
+    }; // struct stats_t
+
+public:
+    /** capacity: max number of cached chains, 0 disables the cache.
+     * ttl: max lifetime of a cached result.
+     */
+    explicit x509_verifier(
+        size_t               capacity = 1024,
+        std::chrono::seconds ttl      = std::chrono::seconds{3600});
+    ~x509_verifier();
+
+    /// adds trusted (root) certificates, pem (one or more) or der
+    void add_trusted(buffer_view_t pem_or_der);
+
+    /// adds trusted (root) certificates from a chain
+    void add_trusted(const x509_cert&);
+
+    /// number of trusted certificates
+    size_t trusted_size() const;
+
+    /** verifies a chain (leaf first, then intermediates).
+     * if expected_name is not null, the leaf must match it (by CN or a
+     * subjectAltName dns entry).
+     */
+    auto verify(const x509_cert& chain, const char* expected_name = nullptr)
+        -> result_t;
+
+    /// drops all the cached results
+    void clear_cache();
+
+    auto stats() const -> stats_t;
+
+public: // move only
+    x509_verifier(const x509_verifier&) = delete;
+    x509_verifier(x509_verifier&&);
+    x509_verifier& operator=(const x509_verifier&) = delete;
+    x509_verifier& operator=(x509_verifier&&);
+
+protected:
+    struct impl;
+    std::unique_ptr<impl> pimpl;
+}; // class x509_verifier
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_X509_HPP
@@ -0,0 +1,696 @@
+#include "./camellia_kernels.hpp"
+#include "./conversions.hpp"
+
+#if defined(MBEDTLS_CAMELLIA_C)
+#include "./cpu_features.hpp"
+
+#include <mbedtls/cipher_internal.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#include <immintrin.h>
+#endif
+#endif // MBEDTLS_CAMELLIA_C
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace camellia {
+//-----------------------------------------------------------------------------
+#if defined(MBEDTLS_CAMELLIA_C)
+namespace {
+//-----------------------------------------------------------------------------
+
+enum sizes : size_t {
+    block_size = 16,
+    max_keys   = 68 * 4, ///< bytes of the round keys
+    batch      = 32,     ///< blocks of the cbc and ctr steps
+};
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+
+/// the round keys as bytes, in the order of mbedtls_camellia_crypt_ecb()
+void
+key_bytes(const mbedtls_camellia_context& ctx, uint8_t kb[max_keys]) noexcept {
+    for (size_t i = 0; i < max_keys / 4; ++i) {
+        const uint32_t w = ctx.rk[i];
+        kb[4 * i]        = static_cast<uint8_t>(w >> 24);
+        kb[4 * i + 1]    = static_cast<uint8_t>(w >> 16);
+        kb[4 * i + 2]    = static_cast<uint8_t>(w >> 8);
+        kb[4 * i + 3]    = static_cast<uint8_t>(w);
+    }
+}
+
+/** the affine filters by nibbles: f(x) = lo[x & 0x0f] ^ hi[x >> 4].
+ * found by solving s1(x) = post(aes_sbox(pre(x))) for the affine maps, pre is
+ * linear after the input constant 0xc5 of s1.
+ * s4 rotates the input of s1, s2 and s3 rotate the output.
+ */
+alignas(16) constexpr uint8_t PreS1[2][16] = {
+    {0x08, 0x09, 0x11, 0x10, 0xb9, 0xb8, 0xa0, 0xa1,
+     0xa3, 0xa2, 0xba, 0xbb, 0x12, 0x13, 0x0b, 0x0a},
+    {0x00, 0xa7, 0x93, 0x34, 0x61, 0xc6, 0xf2, 0x55,
+     0xd9, 0x7e, 0x4a, 0xed, 0xb8, 0x1f, 0x2b, 0x8c}};
+alignas(16) constexpr uint8_t PreS4[2][16] = {
+    {0x08, 0x11, 0xb9, 0xa0, 0xa3, 0xba, 0x12, 0x0b,
+     0xaf, 0xb6, 0x1e, 0x07, 0x04, 0x1d, 0xb5, 0xac},
+    {0x00, 0x93, 0x61, 0xf2, 0xd9, 0x4a, 0xb8, 0x2b,
+     0x01, 0x92, 0x60, 0xf3, 0xd8, 0x4b, 0xb9, 0x2a}};
+alignas(16) constexpr uint8_t PostS1[2][16] = {
+    {0x11, 0x82, 0x84, 0x17, 0x3e, 0xad, 0xab, 0x38,
+     0x71, 0xe2, 0xe4, 0x77, 0x5e, 0xcd, 0xcb, 0x58},
+    {0x00, 0xb8, 0xd9, 0x61, 0xa0, 0x18, 0x79, 0xc1,
+     0xa8, 0x10, 0x71, 0xc9, 0x08, 0xb0, 0xd1, 0x69}};
+alignas(16) constexpr uint8_t PostS2[2][16] = {
+    {0x22, 0x05, 0x09, 0x2e, 0x7c, 0x5b, 0x57, 0x70,
+     0xe2, 0xc5, 0xc9, 0xee, 0xbc, 0x9b, 0x97, 0xb0},
+    {0x00, 0x71, 0xb3, 0xc2, 0x41, 0x30, 0xf2, 0x83,
+     0x51, 0x20, 0xe2, 0x93, 0x10, 0x61, 0xa3, 0xd2}};
+alignas(16) constexpr uint8_t PostS3[2][16] = {
+    {0x88, 0x41, 0x42, 0x8b, 0x1f, 0xd6, 0xd5, 0x1c,
+     0xb8, 0x71, 0x72, 0xbb, 0x2f, 0xe6, 0xe5, 0x2c},
+    {0x00, 0x5c, 0xec, 0xb0, 0x50, 0x0c, 0xbc, 0xe0,
+     0x54, 0x08, 0xb8, 0xe4, 0x04, 0x58, 0xe8, 0xb4}};
+
+/// cancels the ShiftRows of AESENCLAST
+alignas(16) constexpr uint8_t InvShiftRows[16] = {
+    0, 13, 10, 7, 4, 1, 14, 11, 8, 5, 2, 15, 12, 9, 6, 3};
+
+/// transposes the 4x4 bytes of each dword group
+alignas(16) constexpr uint8_t Transpose4x4[16] = {
+    0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+
+/// 16 blocks, a block per xmm register before the transposition
+struct x16 {
+    using reg                      = __m128i;
+    static constexpr size_t blocks = 16;
+
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg table(const uint8_t* t) {
+        return _mm_load_si128(reinterpret_cast<const __m128i*>(t));
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg splat(uint8_t b) {
+        return _mm_set1_epi8(static_cast<char>(b));
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg xor_(reg a, reg b) {
+        return _mm_xor_si128(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg and_(reg a, reg b) {
+        return _mm_and_si128(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg or_(reg a, reg b) {
+        return _mm_or_si128(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg add8(reg a, reg b) {
+        return _mm_add_epi8(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg srl16(reg a, int n) {
+        return _mm_srli_epi16(a, n);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg shuffle(reg t, reg i) {
+        return _mm_shuffle_epi8(t, i);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg sub_bytes(reg a, reg inv_sr) {
+        return _mm_aesenclast_si128(
+            _mm_shuffle_epi8(a, inv_sr), _mm_setzero_si128());
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg lo32(reg a, reg b) {
+        return _mm_unpacklo_epi32(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg hi32(reg a, reg b) {
+        return _mm_unpackhi_epi32(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg lo64(reg a, reg b) {
+        return _mm_unpacklo_epi64(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg hi64(reg a, reg b) {
+        return _mm_unpackhi_epi64(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static reg load(const uint8_t* p, size_t i) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+    }
+    MBEDCRYPTO_TARGET("aes,ssse3") static void
+    store(uint8_t* p, size_t i, reg a) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 16 * i), a);
+    }
+}; // struct x16
+
+/// 32 blocks, the blocks i and i + 16 in the lanes of a ymm register
+struct x32 {
+    using reg                      = __m256i;
+    static constexpr size_t blocks = 32;
+
+    MBEDCRYPTO_TARGET("aes,avx2") static reg table(const uint8_t* t) {
+        return _mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i*>(t)));
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg splat(uint8_t b) {
+        return _mm256_set1_epi8(static_cast<char>(b));
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg xor_(reg a, reg b) {
+        return _mm256_xor_si256(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg and_(reg a, reg b) {
+        return _mm256_and_si256(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg or_(reg a, reg b) {
+        return _mm256_or_si256(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg add8(reg a, reg b) {
+        return _mm256_add_epi8(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg srl16(reg a, int n) {
+        return _mm256_srli_epi16(a, n);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg shuffle(reg t, reg i) {
+        return _mm256_shuffle_epi8(t, i);
+    }
+    /// AESENCLAST of ymm requires VAES, so by the lanes
+    MBEDCRYPTO_TARGET("aes,avx2") static reg sub_bytes(reg a, reg inv_sr) {
+        const auto s  = _mm256_shuffle_epi8(a, inv_sr);
+        const auto lo = _mm_aesenclast_si128(
+            _mm256_castsi256_si128(s), _mm_setzero_si128());
+        const auto hi = _mm_aesenclast_si128(
+            _mm256_extracti128_si256(s, 1), _mm_setzero_si128());
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg lo32(reg a, reg b) {
+        return _mm256_unpacklo_epi32(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg hi32(reg a, reg b) {
+        return _mm256_unpackhi_epi32(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg lo64(reg a, reg b) {
+        return _mm256_unpacklo_epi64(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg hi64(reg a, reg b) {
+        return _mm256_unpackhi_epi64(a, b);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static reg load(const uint8_t* p, size_t i) {
+        const auto lo =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * i));
+        const auto hi = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(p + 16 * (i + 16)));
+        return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+    }
+    MBEDCRYPTO_TARGET("aes,avx2") static void
+    store(uint8_t* p, size_t i, reg a) {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(p + 16 * i), _mm256_castsi256_si128(a));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(p + 16 * (i + 16)),
+            _mm256_extracti128_si256(a, 1));
+    }
+}; // struct x32
+
+#if defined(__GNUC__) && !defined(__clang__)
+// the ymm registers of sliced<x32> never cross a call, it is always inlined
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+/// the generic byte-sliced rounds, always inlined into the kernels of V
+template <class V>
+struct sliced {
+    using reg = typename V::reg;
+
+    reg pre1_[2], pre4_[2], post1_[2], post2_[2], post3_[2];
+    reg mask_, low1_, inv_sr_, t4x4_;
+
+    MBEDCRYPTO_ALWAYS_INLINE sliced()
+        : mask_{V::splat(0x0f)},
+          low1_{V::splat(0x01)},
+          inv_sr_{V::table(InvShiftRows)},
+          t4x4_{V::table(Transpose4x4)} {
+        for (size_t i = 0; i < 2; ++i) {
+            pre1_[i]  = V::table(PreS1[i]);
+            pre4_[i]  = V::table(PreS4[i]);
+            post1_[i] = V::table(PostS1[i]);
+            post2_[i] = V::table(PostS2[i]);
+            post3_[i] = V::table(PostS3[i]);
+        }
+    }
+
+    MBEDCRYPTO_ALWAYS_INLINE reg filter(reg x, const reg t[2]) const {
+        const auto lo = V::and_(x, mask_);
+        const auto hi = V::and_(V::srl16(x, 4), mask_);
+        return V::xor_(V::shuffle(t[0], lo), V::shuffle(t[1], hi));
+    }
+
+    MBEDCRYPTO_ALWAYS_INLINE reg
+    sbox(reg x, const reg pre[2], const reg post[2]) const {
+        return filter(V::sub_bytes(filter(x, pre), inv_sr_), post);
+    }
+
+    /// the 4x4 transposition of the dwords of a, b, c and d
+    MBEDCRYPTO_ALWAYS_INLINE static void
+    transpose4(reg& a, reg& b, reg& c, reg& d) {
+        const auto t0 = V::lo32(a, b);
+        const auto t1 = V::hi32(a, b);
+        const auto t2 = V::lo32(c, d);
+        const auto t3 = V::hi32(c, d);
+        a             = V::lo64(t0, t2);
+        b             = V::hi64(t0, t2);
+        c             = V::lo64(t1, t3);
+        d             = V::hi64(t1, t3);
+    }
+
+    /// x[j] byte i <-> x[i] byte j, by the lanes of the registers
+    MBEDCRYPTO_ALWAYS_INLINE void transpose(reg x[16]) const {
+        reg y[16];
+        for (size_t i = 0; i < 16; ++i)
+            y[i] = V::shuffle(x[i], t4x4_);
+        // dword d of group g: bytes d, d + 4, d + 8, d + 12 of its 4 blocks
+        for (size_t g = 0; g < 4; ++g)
+            transpose4(y[4 * g], y[4 * g + 1], y[4 * g + 2], y[4 * g + 3]);
+        for (size_t i = 0; i < 16; ++i)
+            y[i] = V::shuffle(y[i], t4x4_);
+        for (size_t d = 0; d < 4; ++d)
+            transpose4(y[d], y[4 + d], y[8 + d], y[12 + d]);
+        // y[4 * g + d] holds the byte d + 4 * g
+        for (size_t d = 0; d < 4; ++d) {
+            for (size_t e = 0; e < 4; ++e)
+                x[d + 4 * e] = y[4 * e + d];
+        }
+    }
+
+    /// out ^= F(in, k), the bytes are big endian
+    MBEDCRYPTO_ALWAYS_INLINE void
+    feistel(const reg in[8], reg out[8], const uint8_t* k) const {
+        reg t[8];
+        for (size_t i = 0; i < 8; ++i)
+            t[i] = V::xor_(in[i], V::splat(k[i]));
+        t[0] = sbox(t[0], pre1_, post1_);
+        t[1] = sbox(t[1], pre1_, post2_);
+        t[2] = sbox(t[2], pre1_, post3_);
+        t[3] = sbox(t[3], pre4_, post1_);
+        t[4] = sbox(t[4], pre1_, post2_);
+        t[5] = sbox(t[5], pre1_, post3_);
+        t[6] = sbox(t[6], pre4_, post1_);
+        t[7] = sbox(t[7], pre1_, post1_);
+
+        // the P function
+        const auto t05 = V::xor_(t[0], t[5]);
+        const auto t14 = V::xor_(t[1], t[4]);
+        const auto t27 = V::xor_(t[2], t[7]);
+        const auto t36 = V::xor_(t[3], t[6]);
+        const auto t45 = V::xor_(t[4], t[5]);
+        const auto t67 = V::xor_(t[6], t[7]);
+        reg        y[8];
+        y[0] = V::xor_(V::xor_(t05, t27), t36);
+        y[1] = V::xor_(V::xor_(t[0], t14), V::xor_(t36, t[7]));
+        y[2] = V::xor_(V::xor_(t05, t14), t27);
+        y[3] = V::xor_(V::xor_(t14, t36), V::xor_(t[2], t[5]));
+        y[4] = V::xor_(V::xor_(t05, t[1]), t67);
+        y[5] = V::xor_(V::xor_(t27, t14), t[6]);
+        y[6] = V::xor_(V::xor_(t27, t[3]), t45);
+        y[7] = V::xor_(V::xor_(t[0], t[3]), V::xor_(t45, t[6]));
+        for (size_t i = 0; i < 8; ++i)
+            out[i] = V::xor_(out[i], y[i]);
+    }
+
+    /// the 32bit big endian word x[0..3] rotated left by 1 bit
+    MBEDCRYPTO_ALWAYS_INLINE void rotl1(reg x[4]) const {
+        reg msb[4];
+        for (size_t i = 0; i < 4; ++i)
+            msb[i] = V::and_(V::srl16(x[i], 7), low1_);
+        for (size_t i = 0; i < 4; ++i)
+            x[i] = V::or_(V::add8(x[i], x[i]), msb[(i + 1) % 4]);
+    }
+
+    /// FL on x[0..7] and FL^-1 on x[8..15]
+    MBEDCRYPTO_ALWAYS_INLINE void fl_layer(reg x[16], const uint8_t* k) const {
+        reg a[4];
+        for (size_t i = 0; i < 4; ++i)
+            a[i] = V::and_(x[i], V::splat(k[i]));
+        rotl1(a);
+        for (size_t i = 0; i < 4; ++i) {
+            x[4 + i] = V::xor_(x[4 + i], a[i]);
+            x[i] = V::xor_(x[i], V::or_(x[4 + i], V::splat(k[4 + i])));
+        }
+
+        for (size_t i = 0; i < 4; ++i)
+            x[8 + i] =
+                V::xor_(x[8 + i], V::or_(x[12 + i], V::splat(k[12 + i])));
+        for (size_t i = 0; i < 4; ++i)
+            a[i] = V::and_(x[8 + i], V::splat(k[8 + i]));
+        rotl1(a);
+        for (size_t i = 0; i < 4; ++i)
+            x[12 + i] = V::xor_(x[12 + i], a[i]);
+    }
+
+    /// as mbedtls_camellia_crypt_ecb(), nr is 3 or 4
+    MBEDCRYPTO_ALWAYS_INLINE void
+    crypt(const uint8_t* kb, int nr, const uint8_t* in, uint8_t* out) const {
+        reg x[16];
+        for (size_t i = 0; i < 16; ++i)
+            x[i] = V::load(in, i);
+        transpose(x);
+
+        for (size_t i = 0; i < 16; ++i)
+            x[i] = V::xor_(x[i], V::splat(kb[i]));
+        kb += 16;
+        for (int n = nr; n-- > 0;) {
+            for (int r = 0; r < 3; ++r, kb += 16) {
+                feistel(x, x + 8, kb);
+                feistel(x + 8, x, kb + 8);
+            }
+            if (n > 0) {
+                fl_layer(x, kb);
+                kb += 16;
+            }
+        }
+
+        // the output is x[8..15] | x[0..7]
+        reg y[16];
+        for (size_t i = 0; i < 8; ++i) {
+            y[i]     = V::xor_(x[8 + i], V::splat(kb[i]));
+            y[8 + i] = V::xor_(x[i], V::splat(kb[8 + i]));
+        }
+        transpose(y);
+        for (size_t i = 0; i < 16; ++i)
+            V::store(out, i, y[i]);
+    }
+}; // struct sliced
+
+MBEDCRYPTO_TARGET("aes,ssse3") void
+batch_x16(const uint8_t* kb, int nr, const uint8_t* in, uint8_t* out) {
+    const sliced<x16> s;
+    s.crypt(kb, nr, in, out);
+}
+
+MBEDCRYPTO_TARGET("aes,avx2") void
+batch_x32(const uint8_t* kb, int nr, const uint8_t* in, uint8_t* out) {
+    const sliced<x32> s;
+    s.crypt(kb, nr, in, out);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+using batch_t = void (*)(const uint8_t*, int, const uint8_t*, uint8_t*);
+
+/// full batches by the kernel, a tail of a quarter batch or more is padded
+void
+ecb_batches(
+    batch_t                         fn,
+    size_t                          width,
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    uint8_t kb[max_keys];
+    key_bytes(ctx, kb);
+
+    size_t i = 0;
+    for (; i + width <= blocks; i += width)
+        fn(kb, ctx.nr, in + i * block_size, out + i * block_size);
+
+    const size_t tail = blocks - i;
+    if (tail >= width / 4) {
+        uint8_t buf[32 * block_size] = {0};
+        std::memcpy(buf, in + i * block_size, tail * block_size);
+        fn(kb, ctx.nr, buf, buf);
+        std::memcpy(out + i * block_size, buf, tail * block_size);
+        mbedtls_platform_zeroize(buf, sizeof(buf));
+    } else if (tail > 0) {
+        ecb_portable(ctx, in + i * block_size, out + i * block_size, tail);
+    }
+    mbedtls_platform_zeroize(kb, sizeof(kb));
+}
+
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+//-----------------------------------------------------------------------------
+
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+int
+cbc_func(
+    void*                ctx,
+    mbedtls_operation_t  mode,
+    size_t               length,
+    unsigned char*       iv,
+    const unsigned char* input,
+    unsigned char*       output) {
+    auto* c = static_cast<mbedtls_camellia_context*>(ctx);
+    if (mode == MBEDTLS_ENCRYPT || length % block_size != 0) {
+        const int m = mode == MBEDTLS_ENCRYPT ? MBEDTLS_CAMELLIA_ENCRYPT
+                                              : MBEDTLS_CAMELLIA_DECRYPT;
+        return mbedtls_camellia_crypt_cbc(c, m, length, iv, input, output);
+    }
+
+    // P = D(C) ^ previous C, by batches (input may be output)
+    const auto ecb = best_ecb();
+    uint8_t     cipher_text[batch * block_size];
+    for (size_t offset = 0; offset < length;) {
+        const size_t size =
+            std::min<size_t>(batch * block_size, length - offset);
+        std::memcpy(cipher_text, input + offset, size);
+        ecb(*c, cipher_text, output + offset, size / block_size);
+        for (size_t i = 0; i < size; ++i) {
+            output[offset + i] ^=
+                i < block_size ? iv[i] : cipher_text[i - block_size];
+        }
+        std::memcpy(iv, cipher_text + size - block_size, block_size);
+        offset += size;
+    }
+    mbedtls_platform_zeroize(cipher_text, sizeof(cipher_text));
+    return 0;
+}
+#endif // MBEDTLS_CIPHER_MODE_CBC
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+/// increments the whole block as a big endian integer, as mbedtls
+inline void
+increment(uint8_t counter[16]) noexcept {
+    for (int i = 15; i >= 0; --i) {
+        if (++counter[i] != 0)
+            break;
+    }
+}
+
+int
+ctr_func(
+    void*                ctx,
+    size_t               length,
+    size_t*              nc_off,
+    unsigned char*       nonce_counter,
+    unsigned char*       stream_block,
+    const unsigned char* input,
+    unsigned char*       output) {
+    const auto& c = *static_cast<const mbedtls_camellia_context*>(ctx);
+    size_t      n = *nc_off;
+    if (n > 15)
+        return MBEDTLS_ERR_CAMELLIA_BAD_INPUT_DATA;
+
+    // the rest of the current stream block
+    for (; n != 0 && length != 0; --length, n = (n + 1) & 0x0f)
+        *output++ = *input++ ^ stream_block[n];
+
+    const auto ecb = best_ecb();
+    uint8_t    stream[batch * block_size];
+    while (length >= block_size) {
+        const size_t blocks = std::min<size_t>(batch, length / block_size);
+        for (size_t i = 0; i < blocks; ++i) {
+            std::memcpy(stream + i * block_size, nonce_counter, block_size);
+            increment(nonce_counter);
+        }
+        ecb(c, stream, stream, blocks);
+        for (size_t i = 0; i < blocks * block_size; ++i)
+            output[i] = input[i] ^ stream[i];
+        input += blocks * block_size;
+        output += blocks * block_size;
+        length -= blocks * block_size;
+    }
+    mbedtls_platform_zeroize(stream, sizeof(stream));
+
+    if (length > 0) {
+        ecb_portable(c, nonce_counter, stream_block, 1);
+        increment(nonce_counter);
+        for (; n < length; ++n)
+            output[n] = input[n] ^ stream_block[n];
+    }
+    *nc_off = n;
+    return 0;
+}
+#endif // MBEDTLS_CIPHER_MODE_CTR
+
+/// a copy of an mbedtls info, by the accelerated functions
+struct accelerated_t {
+    mbedtls_cipher_base_t base;
+    mbedtls_cipher_info_t info;
+
+    explicit accelerated_t(const mbedtls_cipher_info_t& original)
+        : base{*original.base}, info{original} {
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+        base.cbc_func = cbc_func;
+#endif
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+        base.ctr_func = ctr_func;
+#endif
+        info.base = &base;
+    }
+}; // struct accelerated_t
+
+template <mbedtls_cipher_type_t T>
+const mbedtls_cipher_info_t*
+accelerated_of() {
+    static const accelerated_t a{*mbedtls_cipher_info_from_type(T)};
+    return &a.info;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+void
+ecb_portable(
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    // mbedtls does not modify the context
+    auto* c = const_cast<mbedtls_camellia_context*>(&ctx);
+    for (size_t i = 0; i < blocks; ++i) {
+        mbedtls_camellia_crypt_ecb(
+            c,
+            MBEDTLS_CAMELLIA_ENCRYPT,
+            in + i * block_size,
+            out + i * block_size);
+    }
+}
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+
+void
+ecb_x16(
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    ecb_batches(batch_x16, x16::blocks, ctx, in, out, blocks);
+}
+
+void
+ecb_x32(
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    ecb_batches(batch_x32, x32::blocks, ctx, in, out, blocks);
+}
+
+#else // MBEDCRYPTO_X86_64_INTRINSICS
+
+void
+ecb_x16(
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    ecb_portable(ctx, in, out, blocks);
+}
+
+void
+ecb_x32(
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    ecb_portable(ctx, in, out, blocks);
+}
+
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+ecb_t
+best_ecb() noexcept {
+    if (!cpu::has_aesni())
+        return ecb_portable;
+    if (cpu::has_avx2())
+        return ecb_x32;
+    if (cpu::has_ssse3())
+        return ecb_x16;
+    return ecb_portable;
+}
+
+bool
+accelerated() noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+    return best_ecb() != ecb_portable;
+#else
+    return false;
+#endif
+}
+
+const mbedtls_cipher_info_t*
+accelerated_info(const mbedtls_cipher_info_t* info) noexcept {
+    if (info == nullptr || !accelerated())
+        return info;
+
+    switch (info->type) {
+#if defined(MBEDTLS_CIPHER_MODE_CBC)
+    case MBEDTLS_CIPHER_CAMELLIA_128_CBC:
+        return accelerated_of<MBEDTLS_CIPHER_CAMELLIA_128_CBC>();
+    case MBEDTLS_CIPHER_CAMELLIA_192_CBC:
+        return accelerated_of<MBEDTLS_CIPHER_CAMELLIA_192_CBC>();
+    case MBEDTLS_CIPHER_CAMELLIA_256_CBC:
+        return accelerated_of<MBEDTLS_CIPHER_CAMELLIA_256_CBC>();
+#endif // MBEDTLS_CIPHER_MODE_CBC
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    case MBEDTLS_CIPHER_CAMELLIA_128_CTR:
+        return accelerated_of<MBEDTLS_CIPHER_CAMELLIA_128_CTR>();
+    case MBEDTLS_CIPHER_CAMELLIA_192_CTR:
+        return accelerated_of<MBEDTLS_CIPHER_CAMELLIA_192_CTR>();
+    case MBEDTLS_CIPHER_CAMELLIA_256_CTR:
+        return accelerated_of<MBEDTLS_CIPHER_CAMELLIA_256_CTR>();
+#endif // MBEDTLS_CIPHER_MODE_CTR
+    default:
+        return info;
+    }
+}
+
+bool
+ecb_blocks(
+    const mbedtls_cipher_context_t& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks) {
+    const auto* info = ctx.cipher_info;
+    if (info == nullptr || info->mode != MBEDTLS_MODE_ECB ||
+        info->base->cipher != MBEDTLS_CIPHER_ID_CAMELLIA ||
+        ctx.cipher_ctx == nullptr)
+        return false;
+
+    best_ecb()(
+        *static_cast<const mbedtls_camellia_context*>(ctx.cipher_ctx),
+        in,
+        out,
+        blocks);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+#else  // MBEDTLS_CAMELLIA_C
+
+bool
+accelerated() noexcept {
+    return false;
+}
+
+const mbedtls_cipher_info_t*
+accelerated_info(const mbedtls_cipher_info_t* info) noexcept {
+    return info;
+}
+
+bool
+ecb_blocks(
+    const mbedtls_cipher_context_t&, const uint8_t*, uint8_t*, size_t) {
+    return false;
+}
+
+#endif // MBEDTLS_CAMELLIA_C
+//-----------------------------------------------------------------------------
+} // namespace camellia
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,83 @@
+/** @file camellia_kernels.hpp
+ * Camellia of many blocks at once by byte-sliced AES-NI kernels.
+ *
+ * the kernels transpose 16 (or 32) blocks into 16 registers, one register per
+ * byte position, so a byte of all the blocks is processed by a single
+ * instruction. the Camellia S-box is affine equivalent to the inversion in
+ * GF(2^8), as the AES S-box is:
+ *  s1(x) = post(aes_sbox(pre(x)))
+ * where pre and post are affine maps over the bits, looked up by nibbles by
+ * PSHUFB, and aes_sbox is AESENCLAST by a zero round key (after the inverse
+ * ShiftRows). s2, s3 and s4 fold their rotations into the filters.
+ * neither kernel indexes memory by the data bytes.
+ *
+ * the round keys are those of mbedtls_camellia_context, so a kernel decrypts
+ * by a decryption key schedule (mbedtls_camellia_setkey_dec()).
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_CAMELLIA_KERNELS_HPP
+#define MBEDCRYPTO_CAMELLIA_KERNELS_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <mbedtls/camellia.h>
+#include <mbedtls/cipher.h>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace camellia {
+//-----------------------------------------------------------------------------
+
+/** crypts blocks of 16 bytes by the round keys of ctx.
+ * in may be out (in place), the ranges must not partially overlap.
+ */
+using ecb_t = void (*)(
+    const mbedtls_camellia_context& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks);
+
+/// the portable kernel, mbedtls_camellia_crypt_ecb() per block
+void ecb_portable(
+    const mbedtls_camellia_context&, const uint8_t*, uint8_t*, size_t);
+
+/// 16 blocks per step, only callable if cpu::has_aesni() and has_ssse3()
+void ecb_x16(
+    const mbedtls_camellia_context&, const uint8_t*, uint8_t*, size_t);
+
+/// 32 blocks per step, only callable if cpu::has_aesni() and has_avx2()
+void ecb_x32(
+    const mbedtls_camellia_context&, const uint8_t*, uint8_t*, size_t);
+
+/// the best kernel of this CPU
+ecb_t
+best_ecb() noexcept;
+
+/// true if best_ecb() is a byte-sliced kernel
+bool
+accelerated() noexcept;
+
+/** returns the mbedtls info of a camellia cbc or ctr cipher whose cbc
+ * decryption and ctr run by best_ecb(), or info itself for the other ciphers
+ * or if not accelerated(). the output is as mbedtls.
+ */
+const mbedtls_cipher_info_t*
+accelerated_info(const mbedtls_cipher_info_t* info) noexcept;
+
+/** crypts blocks by a cipher context of a camellia ecb info, returns false
+ * (and does nothing) for other contexts.
+ */
+bool
+ecb_blocks(
+    const mbedtls_cipher_context_t& ctx,
+    const uint8_t*                  in,
+    uint8_t*                        out,
+    size_t                          blocks);
+
+//-----------------------------------------------------------------------------
+} // namespace camellia
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_CAMELLIA_KERNELS_HPP
@@ -0,0 +1,374 @@
+#include "mbedcrypto/ccm_stream.hpp"
+#include "./conversions.hpp"
+
+#if defined(MBEDTLS_CCM_C)
+#include <mbedtls/platform_util.h>
+#endif // MBEDTLS_CCM_C
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+#if defined(MBEDTLS_CCM_C)
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<ccm_stream>::value == false, "");
+static_assert(std::is_move_constructible<ccm_stream>::value == true, "");
+
+enum K {
+    block_size = 16,
+    min_nonce  = 7,
+    max_nonce  = 13,
+};
+
+/// the block cipher (in ecb mode) of a ccm type
+cipher_t
+ecb_of(cipher_t type) {
+    switch (type) {
+    case cipher_t::aes_128_ccm:
+        return cipher_t::aes_128_ecb;
+    case cipher_t::aes_192_ccm:
+        return cipher_t::aes_192_ecb;
+    case cipher_t::aes_256_ccm:
+        return cipher_t::aes_256_ecb;
+    case cipher_t::camellia_128_ccm:
+        return cipher_t::camellia_128_ecb;
+    case cipher_t::camellia_192_ccm:
+        return cipher_t::camellia_192_ecb;
+    case cipher_t::camellia_256_ccm:
+        return cipher_t::camellia_256_ecb;
+    default:
+        throw exceptions::usage_error{"ccm_stream requires a ccm cipher"};
+    }
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct ccm_stream::impl {
+    mbedtls_cipher_context_t ctx_;
+    bool                     has_key_ = false;
+
+    // the state of the current message
+    bool         started_    = false;
+    cipher::mode mode_       = cipher::encrypt_mode;
+    size_t       length_len_ = 0; ///< L, size of the length field
+    size_t       tag_length_ = 0;
+    size_t       remaining_  = 0;
+    size_t       pos_        = 0; ///< position in the current block
+    uint8_t      mac_[block_size];    ///< CBC-MAC chaining value
+    uint8_t      ctr_[block_size];    ///< counter block A_i
+    uint8_t      stream_[block_size]; ///< E(A_i)
+    uint8_t      s0_[block_size];     ///< E(A_0), masks the tag
+
+    explicit impl(cipher_t type) {
+        mbedtls_cipher_init(&ctx_);
+        const auto* info =
+            mbedtls_cipher_info_from_type(to_native(ecb_of(type)));
+        if (info == nullptr)
+            throw exceptions::unknown_cipher{};
+        mbedcrypto_c_call(mbedtls_cipher_setup, &ctx_, info);
+    }
+
+    ~impl() {
+        mbedtls_cipher_free(&ctx_);
+        wipe();
+    }
+
+    void wipe() noexcept {
+        mbedtls_platform_zeroize(mac_, block_size);
+        mbedtls_platform_zeroize(stream_, block_size);
+        mbedtls_platform_zeroize(s0_, block_size);
+        started_ = false;
+    }
+
+    void encrypt_block(const uint8_t* in, uint8_t* out) {
+        size_t olen = 0;
+        mbedcrypto_c_call(
+            mbedtls_cipher_update, &ctx_, in, block_size, out, &olen);
+    }
+
+    /// A_i += 1, the counter is the L bytes length field
+    void next_counter() noexcept {
+        for (size_t i = block_size - 1; i >= block_size - length_len_; --i) {
+            if (++ctr_[i] != 0)
+                break;
+        }
+    }
+
+    /// feeds the CBC-MAC by the formatted additional data
+    void absorb(const uint8_t* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            mac_[pos_] ^= data[i];
+            if (++pos_ == block_size) {
+                encrypt_block(mac_, mac_);
+                pos_ = 0;
+            }
+        }
+    }
+
+    void start(
+        cipher::mode  m,
+        buffer_view_t iv,
+        buffer_view_t ad,
+        size_t        total_size,
+        size_t        tag_length) {
+        if (!has_key_)
+            throw exceptions::usage_error{"ccm_stream has no key"};
+        if (iv.size() < min_nonce || iv.size() > max_nonce)
+            throw exceptions::usage_error{"ccm nonce must be 7 to 13 bytes"};
+        if (tag_length < 4 || tag_length > 16 || (tag_length & 1) != 0)
+            throw exceptions::usage_error{"invalid ccm tag length"};
+
+        const size_t L = block_size - 1 - iv.size();
+        if (L < sizeof(uint64_t) &&
+            static_cast<uint64_t>(total_size) >> (8 * L) != 0)
+            throw exceptions::usage_error{"ccm total size is too large"};
+
+        mode_       = m;
+        length_len_ = L;
+        tag_length_ = tag_length;
+        remaining_  = total_size;
+        pos_        = 0;
+
+        // B0: flags | nonce | total size
+        uint8_t b0[block_size] = {0};
+        b0[0] = static_cast<uint8_t>(
+            (ad.size() > 0 ? 0x40 : 0) | (((tag_length - 2) / 2) << 3) |
+            (L - 1));
+        std::memcpy(b0 + 1, iv.data(), iv.size());
+        uint64_t len = total_size;
+        for (size_t i = 0; i < L; ++i, len >>= 8)
+            b0[block_size - 1 - i] = static_cast<uint8_t>(len);
+        encrypt_block(b0, mac_);
+
+        if (ad.size() > 0) {
+            // the size of additional data by RFC 3610 section 2.2
+            uint8_t        header[10];
+            size_t         hsize = 0;
+            const uint64_t asize = ad.size();
+            if (asize < 0xff00) {
+                hsize = 2;
+            } else if (asize <= 0xffffffff) {
+                header[0] = 0xff;
+                header[1] = 0xfe;
+                hsize     = 6;
+            } else {
+                header[0] = 0xff;
+                header[1] = 0xff;
+                hsize     = 10;
+            }
+            uint64_t v = asize;
+            for (size_t i = 0; i < (hsize == 2 ? 2 : hsize - 2); ++i, v >>= 8)
+                header[hsize - 1 - i] = static_cast<uint8_t>(v);
+
+            absorb(header, hsize);
+            absorb(ad.data(), ad.size());
+            if (pos_ != 0) { // zero padding
+                encrypt_block(mac_, mac_);
+                pos_ = 0;
+            }
+        }
+
+        // A0: flags | nonce | 0
+        std::memset(ctr_, 0, block_size);
+        ctr_[0] = static_cast<uint8_t>(L - 1);
+        std::memcpy(ctr_ + 1, iv.data(), iv.size());
+        encrypt_block(ctr_, s0_);
+
+        started_ = true;
+    }
+
+    void update(const uint8_t* in, uint8_t* out, size_t size) {
+        if (!started_)
+            throw exceptions::usage_error{"ccm_stream is not started"};
+        if (size > remaining_)
+            throw exceptions::usage_error{"ccm input exceeds the total size"};
+        remaining_ -= size;
+
+        const bool encrypt = mode_ == cipher::encrypt_mode;
+        size_t     i       = 0;
+        while (i < size) {
+            if (pos_ == 0) {
+                next_counter();
+                encrypt_block(ctr_, stream_);
+            }
+
+            if (pos_ == 0 && size - i >= block_size) {
+                // a full block: CTR and CBC-MAC in a single pass
+                for (size_t j = 0; j < block_size; ++j) {
+                    const uint8_t c = in[i + j];
+                    const uint8_t o = c ^ stream_[j];
+                    mac_[j] ^= encrypt ? c : o;
+                    out[i + j] = o;
+                }
+                encrypt_block(mac_, mac_);
+                i += block_size;
+                continue;
+            }
+
+            // a partial block, keeps the position for the next chunk
+            const uint8_t c = in[i];
+            const uint8_t o = c ^ stream_[pos_];
+            mac_[pos_] ^= encrypt ? c : o;
+            out[i] = o;
+            ++i;
+            if (++pos_ == block_size) {
+                encrypt_block(mac_, mac_);
+                pos_ = 0;
+            }
+        }
+    }
+
+    /// the final tag, the message must be complete
+    void tag(uint8_t* out) {
+        if (!started_)
+            throw exceptions::usage_error{"ccm_stream is not started"};
+        if (remaining_ != 0)
+            throw exceptions::usage_error{"ccm input is shorter than declared"};
+
+        if (pos_ != 0)
+            encrypt_block(mac_, mac_);
+        for (size_t i = 0; i < tag_length_; ++i)
+            out[i] = mac_[i] ^ s0_[i];
+    }
+}; // struct ccm_stream::impl
+
+//-----------------------------------------------------------------------------
+
+ccm_stream::ccm_stream(cipher_t type) : pimpl{std::make_unique<impl>(type)} {}
+
+ccm_stream::~ccm_stream() = default;
+
+ccm_stream::ccm_stream(ccm_stream&&) = default;
+
+ccm_stream& ccm_stream::operator=(ccm_stream&&) = default;
+
+ccm_stream&
+ccm_stream::key(buffer_view_t key_data) {
+    auto& d = *pimpl;
+    // CCM only uses the forward direction of the block cipher
+    mbedcrypto_c_call(
+        mbedtls_cipher_setkey,
+        &d.ctx_,
+        key_data.data(),
+        static_cast<int>(key_data.size() << 3),
+        MBEDTLS_ENCRYPT);
+    d.has_key_ = true;
+    d.wipe();
+    return *this;
+}
+
+void
+ccm_stream::start(
+    cipher::mode  m,
+    buffer_view_t iv,
+    buffer_view_t ad,
+    size_t        total_size,
+    size_t        tag_length) {
+    pimpl->start(m, iv, ad, total_size, tag_length);
+}
+
+buffer_t
+ccm_stream::update(buffer_view_t input) {
+    buffer_t output(input.size(), '\0');
+    pimpl->update(input.data(), to_ptr(output), input.size());
+    return output;
+}
+
+void
+ccm_stream::update(buffer_view_t input, uint8_t* output) {
+    pimpl->update(input.data(), output, input.size());
+}
+
+buffer_t
+ccm_stream::finish() {
+    auto& d = *pimpl;
+    if (d.started_ && d.mode_ != cipher::encrypt_mode)
+        throw exceptions::usage_error{"finish(tag) checks a decryption"};
+
+    buffer_t tag(d.tag_length_, '\0');
+    d.tag(to_ptr(tag));
+    d.wipe();
+    return tag;
+}
+
+bool
+ccm_stream::finish(buffer_view_t tag) {
+    auto& d = *pimpl;
+    if (d.started_ && d.mode_ != cipher::decrypt_mode)
+        throw exceptions::usage_error{"finish() returns an encryption tag"};
+    if (tag.size() != d.tag_length_)
+        throw exceptions::usage_error{"invalid ccm tag length"};
+
+    uint8_t computed[block_size];
+    d.tag(computed);
+    d.wipe();
+
+    // constant time comparison
+    uint8_t diff = 0;
+    for (size_t i = 0; i < tag.size(); ++i)
+        diff |= computed[i] ^ tag.data()[i];
+    mbedtls_platform_zeroize(computed, sizeof(computed));
+    return diff == 0;
+}
+
+size_t
+ccm_stream::remaining() const noexcept {
+    return pimpl->started_ ? pimpl->remaining_ : 0;
+}
+
+//-----------------------------------------------------------------------------
+#else  // MBEDTLS_CCM_C
+
+struct ccm_stream::impl {};
+
+ccm_stream::ccm_stream(cipher_t) {
+    throw exceptions::aead_error{};
+}
+
+ccm_stream::~ccm_stream() = default;
+
+ccm_stream::ccm_stream(ccm_stream&&) = default;
+
+ccm_stream& ccm_stream::operator=(ccm_stream&&) = default;
+
+ccm_stream&
+ccm_stream::key(buffer_view_t) {
+    throw exceptions::aead_error{};
+}
+
+void
+ccm_stream::start(cipher::mode, buffer_view_t, buffer_view_t, size_t, size_t) {
+    throw exceptions::aead_error{};
+}
+
+buffer_t
+ccm_stream::update(buffer_view_t) {
+    throw exceptions::aead_error{};
+}
+
+void
+ccm_stream::update(buffer_view_t, uint8_t*) {
+    throw exceptions::aead_error{};
+}
+
+buffer_t
+ccm_stream::finish() {
+    throw exceptions::aead_error{};
+}
+
+bool
+ccm_stream::finish(buffer_view_t) {
+    throw exceptions::aead_error{};
+}
+
+size_t
+ccm_stream::remaining() const noexcept {
+    return 0;
+}
+
+#endif // MBEDTLS_CCM_C
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -1,8 +1,20 @@
 #include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/gcm_parallel.hpp"
+#include "./camellia_kernels.hpp"
 #include "./conversions.hpp"
+#include "./memory_private.hpp"
 
 #include <mbedtls/aesni.h>
 #include <mbedtls/cipher.h>
+#include <mbedtls/platform_util.h>
+#if defined(MBEDTLS_GCM_C)
+#include <mbedtls/gcm.h>
+#endif
+#if defined(MBEDTLS_CCM_C)
+#include <mbedtls/ccm.h>
+#endif
+
+#include <cstring>
 //-----------------------------------------------------------------------------
 namespace mbedcrypto {
 namespace {
@@ -11,6 +23,20 @@ namespace {
 static_assert(std::is_copy_constructible<cipher>::value == false, "");
 static_assert(std::is_move_constructible<cipher>::value == true, "");
 
+/// camellia gcm by the byte-sliced kernels, mbedtls_gcm_context is opaque
+bool
+is_accelerated_gcm(cipher_t type) noexcept {
+#if defined(MBEDTLS_GCM_C) && defined(MBEDTLS_CAMELLIA_C)
+    return (type == cipher_t::camellia_128_gcm ||
+            type == cipher_t::camellia_192_gcm ||
+            type == cipher_t::camellia_256_gcm) &&
+           camellia::accelerated();
+#else
+    (void)type;
+    return false;
+#endif
+}
+
 const mbedtls_cipher_info_t*
 native_info(cipher_t type) {
     auto        ntype  = to_native(type);
@@ -37,7 +63,8 @@ struct cipher_impl {
     }
 
     auto& setup(cipher_t type) {
-        const auto* cinfot = native_info(type);
+        // camellia cbc and ctr by the byte-sliced kernels if possible
+        const auto* cinfot = camellia::accelerated_info(native_info(type));
         mbedcrypto_c_call(mbedtls_cipher_setup, &ctx_, cinfot);
         return *this;
     }
@@ -58,6 +85,31 @@ struct cipher_impl {
         return from_native(ctx_.cipher_info->mode);
     }
 
+    /// the cipher context, and the block cipher context of gcm and ccm
+    size_t heap_size() const noexcept {
+        size_t size = memory::block_size(ctx_.cipher_ctx);
+        if (ctx_.cipher_ctx == nullptr)
+            return size;
+#if defined(MBEDTLS_GCM_C)
+        if (ctx_.cipher_info->mode == MBEDTLS_MODE_GCM) {
+            const auto* gcm =
+                static_cast<const mbedtls_gcm_context*>(ctx_.cipher_ctx);
+            size += memory::block_size(gcm->cipher_ctx.cipher_ctx);
+        }
+#endif // MBEDTLS_GCM_C
+#if defined(MBEDTLS_CCM_C)
+        if (ctx_.cipher_info->mode == MBEDTLS_MODE_CCM) {
+            const auto* ccm =
+                static_cast<const mbedtls_ccm_context*>(ctx_.cipher_ctx);
+            size += memory::block_size(ccm->cipher_ctx.cipher_ctx);
+        }
+#endif // MBEDTLS_CCM_C
+#if defined(MBEDTLS_CMAC_C)
+        size += memory::block_size(ctx_.cmac_ctx);
+#endif // MBEDTLS_CMAC_C
+        return size;
+    }
+
     const auto& iv() const noexcept {
         return iv_data_;
     }
@@ -104,6 +156,10 @@ struct cipher_impl {
         size_t i_index = 0;
         size_t o_index = 0;
         size_t chunks  = achunk.size() / bsize;
+        if (camellia::ecb_blocks(ctx_, achunk.data(), poutput, chunks)) {
+            osize = achunk.size();
+            return 0;
+        }
 
         for (size_t i = 0; i < chunks; ++i) {
             size_t usize = 0;
@@ -186,6 +242,9 @@ class crypt_engine
                 pDes,
                 &final_size);
 
+        } else if (camellia::ecb_blocks(cim_.ctx_, pSrc, pDes, chunks_)) {
+            final_size = input_.size();
+
         } else {
             final_size = 0;
 
@@ -279,7 +338,10 @@ public:
 } // namespace anon
 //-----------------------------------------------------------------------------
 
-struct cipher::impl : public cipher_impl {};
+struct cipher::impl : public cipher_impl {
+    memory::counter counter_{
+        memory::kind::cipher, sizeof(cipher) + sizeof(impl)};
+};
 
 cipher::cipher(cipher_t type) : pimpl(std::make_unique<impl>()) {
     pimpl->setup(type);
@@ -325,6 +387,14 @@ cipher::block_size() const noexcept {
     return pimpl->block_size();
 }
 
+memory::usage
+cipher::footprint() const noexcept {
+    memory::usage u;
+    u.inline_bytes = sizeof(cipher) + sizeof(impl);
+    u.heap_bytes   = pimpl->heap_size();
+    return u;
+}
+
 size_t
 cipher::iv_size() const noexcept {
     return pimpl->iv_size();
@@ -430,6 +500,8 @@ cipher::encrypt_aead(
     buffer_view_t ad,
     buffer_view_t input) {
 #if defined(MBEDTLS_CIPHER_MODE_AEAD)
+    if (is_accelerated_gcm(type))
+        return gcm::parallel_encrypt(type, iv, key, ad, input, 1);
 
     cipher::impl cip;
     cip.setup(type);
@@ -470,6 +542,13 @@ cipher::decrypt_aead(
     buffer_view_t tag,
     buffer_view_t input) {
 #if defined(MBEDTLS_CIPHER_MODE_AEAD)
+    if (is_accelerated_gcm(type)) {
+        auto result = gcm::parallel_decrypt(type, iv, key, ad, tag, input, 1);
+        // as mbedtls: a zeroed output of the input size if not authenticated
+        if (!std::get<0>(result))
+            std::get<1>(result) = buffer_t(input.size(), '\0');
+        return result;
+    }
 
     cipher::impl cip;
     cip.setup(type);
@@ -693,6 +772,69 @@ cipher::gcm_check_decryption_tag(buffer_view_t tag) {
 #endif // MBEDTLS_GCM_C
 }
 
+void
+cipher::ctr_seek(uint64_t offset) {
+    if (block_mode() != cipher_bm::ctr)
+        throw exceptions::usage_error{"ctr_seek() requires a ctr cipher"};
+
+    const auto&  iv    = pimpl->iv();
+    const size_t bsize = pimpl->block_size();
+    if (iv.size() != bsize || bsize > MBEDTLS_MAX_BLOCK_LENGTH)
+        throw exceptions::usage_error{"the ctr iv has not been set"};
+
+    // the counter is the whole block as a big endian integer, as mbedtls
+    // increments it
+    uint8_t  counter[MBEDTLS_MAX_BLOCK_LENGTH];
+    uint64_t blocks = offset / bsize;
+    uint32_t carry  = 0;
+    std::memcpy(counter, iv.data(), bsize);
+    for (size_t i = bsize; i-- > 0 && (blocks != 0 || carry != 0);) {
+        carry += counter[i] + static_cast<uint32_t>(blocks & 0xff);
+        counter[i] = static_cast<uint8_t>(carry);
+        carry >>= 8;
+        blocks >>= 8;
+    }
+
+    auto* ctx = &pimpl->ctx_;
+    mbedcrypto_c_call(mbedtls_cipher_set_iv, ctx, counter, bsize);
+    mbedcrypto_c_call(mbedtls_cipher_reset, ctx);
+
+    // skips the head of the first block by its keystream
+    if (const size_t skip = offset % bsize) {
+        uint8_t zeros[MBEDTLS_MAX_BLOCK_LENGTH] = {0};
+        uint8_t stream[MBEDTLS_MAX_BLOCK_LENGTH];
+        size_t  olen = 0;
+        mbedcrypto_c_call(
+            mbedtls_cipher_update, ctx, zeros, skip, stream, &olen);
+        mbedtls_platform_zeroize(stream, sizeof(stream));
+    }
+}
+
+buffer_t
+cipher::ctr_crypt(const std::vector<ctr_range>& ranges) {
+    size_t total = 0;
+    for (const auto& r : ranges)
+        total += r.data.size();
+
+    buffer_t output(total, '\0');
+    size_t   o_index = 0;
+    for (const auto& r : ranges) {
+        ctr_seek(r.offset);
+        size_t usize = 0;
+        mbedcrypto_c_call(
+            mbedtls_cipher_update,
+            &pimpl->ctx_,
+            r.data.data(),
+            r.data.size(),
+            to_ptr(output) + o_index,
+            &usize);
+        o_index += usize;
+    }
+
+    output.resize(o_index);
+    return output;
+}
+
 //-----------------------------------------------------------------------------
 } // namespace mbedcrypto
 //-----------------------------------------------------------------------------
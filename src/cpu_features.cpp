@@ -0,0 +1,136 @@
+#include "./cpu_features.hpp"
+
+#include <cstdint>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace cpu {
+namespace {
+//-----------------------------------------------------------------------------
+
+enum ecx_bits : uint32_t {
+    pclmul_bit  = 1u << 1,
+    ssse3_bit   = 1u << 9,
+    aesni_bit   = 1u << 25,
+    osxsave_bit = 1u << 27,
+    avx_bit     = 1u << 28,
+};
+
+enum leaf7_ebx_bits : uint32_t {
+    avx2_bit = 1u << 5,
+};
+
+enum xcr0_bits : uint64_t {
+    xmm_state = 1u << 1,
+    ymm_state = 1u << 2,
+};
+
+/// ecx of cpuid leaf 1, or zero
+uint32_t
+leaf1_ecx() noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#if defined(_MSC_VER)
+    int regs[4] = {0};
+    __cpuid(regs, 1);
+    return static_cast<uint32_t>(regs[2]);
+#else
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+        return 0;
+    return ecx;
+#endif
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+    return 0;
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+}
+
+/// ebx of cpuid leaf 7 (sub-leaf 0), or zero
+uint32_t
+leaf7_ebx() noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#if defined(_MSC_VER)
+    int regs[4] = {0};
+    __cpuid(regs, 0);
+    if (regs[0] < 7)
+        return 0;
+    __cpuidex(regs, 7, 0);
+    return static_cast<uint32_t>(regs[1]);
+#else
+    if (__get_cpuid_max(0, nullptr) < 7)
+        return 0;
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx;
+#endif
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+    return 0;
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+}
+
+/// the register states enabled by the os, must be called if osxsave is set
+uint64_t
+xcr0() noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (uint64_t{edx} << 32) | eax;
+#endif
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+    return 0;
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+}
+
+uint32_t
+features() noexcept {
+    static const uint32_t ecx = leaf1_ecx();
+    return ecx;
+}
+
+bool
+detect_avx2() noexcept {
+    const uint32_t avx = osxsave_bit | avx_bit;
+    if ((features() & avx) != avx || (leaf7_ebx() & avx2_bit) == 0)
+        return false;
+    const uint64_t states = xmm_state | ymm_state;
+    return (xcr0() & states) == states;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+bool
+has_ssse3() noexcept {
+    return (features() & ssse3_bit) != 0;
+}
+
+bool
+has_aesni() noexcept {
+    return (features() & aesni_bit) != 0;
+}
+
+bool
+has_pclmul() noexcept {
+    return (features() & pclmul_bit) != 0;
+}
+
+bool
+has_avx2() noexcept {
+    static const bool avx2 = detect_avx2();
+    return avx2;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace cpu
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
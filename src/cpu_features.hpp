@@ -0,0 +1,45 @@
+/** @file cpu_features.hpp
+ * runtime detection of the x86 instruction set extensions used by the
+ * internal accelerated code paths.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_CPU_FEATURES_HPP
+#define MBEDCRYPTO_CPU_FEATURES_HPP
+
+#if (defined(__GNUC__) && defined(__x86_64__)) || \
+    (defined(_MSC_VER) && defined(_M_X64))
+/// the accelerated x86-64 code paths can be compiled
+#define MBEDCRYPTO_X86_64_INTRINSICS
+#endif
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS) && defined(__GNUC__)
+/// enables an instruction set for a single function, as:
+/// MBEDCRYPTO_TARGET("pclmul,ssse3")
+#define MBEDCRYPTO_TARGET(isa) __attribute__((target(isa)))
+/// inlines generic (template) code into the target specific kernels calling
+/// it, so the code is compiled by the instruction set of the kernel
+#define MBEDCRYPTO_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define MBEDCRYPTO_TARGET(isa)
+#define MBEDCRYPTO_ALWAYS_INLINE inline
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace cpu {
+//-----------------------------------------------------------------------------
+
+/// checked once per process, always false on non x86-64 builds
+bool has_ssse3() noexcept;
+bool has_aesni() noexcept;
+bool has_pclmul() noexcept;
+/// avx2, with the ymm registers enabled by the os (xgetbv)
+bool has_avx2() noexcept;
+
+//-----------------------------------------------------------------------------
+} // namespace cpu
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_CPU_FEATURES_HPP
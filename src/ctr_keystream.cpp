@@ -0,0 +1,286 @@
+#include "mbedcrypto/ctr_keystream.hpp"
+#include "./conversions.hpp"
+#include "./worker_pool.hpp"
+
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<ctr_keystream>::value == false, "");
+static_assert(std::is_move_constructible<ctr_keystream>::value == true, "");
+
+enum K : size_t {
+    chunk_size    = 4096, ///< keystream generated per lock
+    min_ring_size = 1024,
+};
+
+const uint8_t Zeros[chunk_size] = {0};
+
+/// out = in ^ stream, by 8-byte words (vectorized by the compilers)
+void
+xor_into(const uint8_t* in, const uint8_t* stream, uint8_t* out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t a, b;
+        std::memcpy(&a, in + i, 8);
+        std::memcpy(&b, stream + i, 8);
+        a ^= b;
+        std::memcpy(out + i, &a, 8);
+    }
+    for (; i < n; ++i)
+        out[i] = in[i] ^ stream[i];
+}
+
+/** the keystream ring, shared with the background refills.
+ * a single producer (under gen_mutex) writes [produced, consumed + size)
+ * and a single consumer reads [consumed, produced) of the stream, the
+ * positions are mapped into the ring by modulo.
+ */
+struct state_t {
+    mbedtls_cipher_context_t ctx; ///< at the stream position of produced
+    std::mutex               gen_mutex;
+    buffer_t                 ring;
+    std::atomic<uint64_t>    produced{0};
+    std::atomic<uint64_t>    consumed{0};
+    std::atomic<bool>        posted{false};
+    std::atomic<bool>        stopped{false};
+
+    explicit state_t(cipher_t type, size_t ring_size)
+        : ring(std::max<size_t>(ring_size, min_ring_size), '\0') {
+        mbedtls_cipher_init(&ctx);
+        const auto* info = mbedtls_cipher_info_from_type(to_native(type));
+        if (info == nullptr)
+            throw exceptions::unknown_cipher{};
+        mbedcrypto_c_call(mbedtls_cipher_setup, &ctx, info);
+    }
+
+    ~state_t() {
+        mbedtls_platform_zeroize(to_ptr(ring), ring.size());
+        mbedtls_cipher_free(&ctx);
+    }
+
+    /// generates a chunk into the ring, returns 0 if the ring is full
+    size_t fill_chunk() {
+        std::lock_guard<std::mutex> lock{gen_mutex};
+        const auto p    = produced.load(std::memory_order_relaxed);
+        const auto c    = consumed.load(std::memory_order_acquire);
+        const auto size = ring.size();
+        if (p - c >= size)
+            return 0;
+
+        const size_t pos = p % size;
+        size_t       n   = std::min<size_t>(size - (p - c), size - pos);
+        n                = std::min<size_t>(n, chunk_size);
+        size_t olen      = 0;
+        mbedcrypto_c_call(
+            mbedtls_cipher_update, &ctx, Zeros, n, to_ptr(ring) + pos, &olen);
+        produced.store(p + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t fill() {
+        size_t total = 0;
+        while (!stopped.load(std::memory_order_relaxed)) {
+            const auto n = fill_chunk();
+            if (n == 0)
+                break;
+            total += n;
+        }
+        return total;
+    }
+
+    /// xors by the ready keystream, returns the number of crypted bytes
+    size_t drain(const uint8_t* in, uint8_t* out, size_t n) noexcept {
+        const auto size = ring.size();
+        size_t     done = 0;
+        while (done < n) {
+            const auto c     = consumed.load(std::memory_order_relaxed);
+            const auto p     = produced.load(std::memory_order_acquire);
+            const auto ready = static_cast<size_t>(p - c);
+            if (ready == 0)
+                break;
+            const size_t pos = c % size;
+            const size_t k   = std::min({ready, n - done, size - pos});
+            xor_into(in + done, to_const_ptr(ring) + pos, out + done, k);
+            consumed.store(c + k, std::memory_order_release);
+            done += k;
+        }
+        return done;
+    }
+
+    /// crypts by the context itself, the ring must be empty
+    void crypt_inline(const uint8_t* in, uint8_t* out, size_t n) {
+        size_t olen = 0;
+        mbedcrypto_c_call(mbedtls_cipher_update, &ctx, in, n, out, &olen);
+        produced.fetch_add(n, std::memory_order_release);
+        consumed.fetch_add(n, std::memory_order_release);
+    }
+}; // struct state_t
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct ctr_keystream::impl {
+    std::shared_ptr<state_t> st;
+    bool                     background   = true;
+    bool                     has_key      = false;
+    bool                     started      = false;
+    uint64_t                 ring_bytes   = 0;
+    uint64_t                 inline_bytes = 0;
+
+    impl(cipher_t type, size_t ring_size, bool bg)
+        : st{std::make_shared<state_t>(type, ring_size)}, background{bg} {}
+
+    ~impl() {
+        st->stopped = true; // a queued refill becomes a no-op
+    }
+
+    void post_refill() {
+        const auto p = st->produced.load(std::memory_order_relaxed);
+        const auto c = st->consumed.load(std::memory_order_relaxed);
+        if (!background || p - c >= st->ring.size() / 2 ||
+            st->posted.exchange(true))
+            return;
+
+        auto s = st; // the task keeps the state alive
+        worker_pool::shared().post([s]() {
+            try {
+                s->fill();
+            } catch (...) {
+                // the consumer falls back to the inline generation
+            }
+            s->posted = false;
+        });
+    }
+
+    void update(const uint8_t* in, uint8_t* out, size_t n) {
+        if (!started)
+            throw exceptions::usage_error{"the keystream is not started"};
+
+        size_t done = st->drain(in, out, n);
+        if (done < n) {
+            // waits for at most a chunk being generated, then takes over
+            std::lock_guard<std::mutex> lock{st->gen_mutex};
+            done += st->drain(in + done, out + done, n - done);
+            if (done < n) {
+                st->crypt_inline(in + done, out + done, n - done);
+                inline_bytes += n - done;
+            }
+        }
+        ring_bytes += done;
+        post_refill();
+    }
+}; // struct ctr_keystream::impl
+
+//-----------------------------------------------------------------------------
+
+constexpr size_t ctr_keystream::default_ring_size;
+
+ctr_keystream::ctr_keystream(
+    cipher_t type, size_t ring_size, bool background) {
+    if (cipher::block_mode(type) != cipher_bm::ctr)
+        throw exceptions::usage_error{"ctr_keystream requires a ctr cipher"};
+    pimpl = std::make_unique<impl>(type, ring_size, background);
+}
+
+ctr_keystream::~ctr_keystream() = default;
+
+ctr_keystream::ctr_keystream(ctr_keystream&&) = default;
+
+ctr_keystream& ctr_keystream::operator=(ctr_keystream&&) = default;
+
+ctr_keystream&
+ctr_keystream::key(buffer_view_t key_data) {
+    auto&                       st = *pimpl->st;
+    std::lock_guard<std::mutex> lock{st.gen_mutex};
+    // ctr only uses the forward direction of the block cipher
+    mbedcrypto_c_call(
+        mbedtls_cipher_setkey,
+        &st.ctx,
+        key_data.data(),
+        static_cast<int>(key_data.size() << 3),
+        MBEDTLS_ENCRYPT);
+    pimpl->has_key = true;
+    pimpl->started = false;
+    return *this;
+}
+
+ctr_keystream&
+ctr_keystream::start(buffer_view_t iv) {
+    if (!pimpl->has_key)
+        throw exceptions::usage_error{"the key of keystream is not set"};
+    if (iv.size() != iv_size())
+        throw exceptions::usage_error{"invalid iv size"};
+
+    auto& st = *pimpl->st;
+    {
+        std::lock_guard<std::mutex> lock{st.gen_mutex};
+        mbedcrypto_c_call(mbedtls_cipher_set_iv, &st.ctx, iv.data(), iv.size());
+        mbedcrypto_c_call(mbedtls_cipher_reset, &st.ctx);
+        mbedtls_platform_zeroize(to_ptr(st.ring), st.ring.size());
+        st.produced = 0;
+        st.consumed = 0;
+    }
+    pimpl->started = true;
+    pimpl->post_refill();
+    return *this;
+}
+
+buffer_t
+ctr_keystream::update(buffer_view_t input) {
+    buffer_t output(input.size(), '\0');
+    pimpl->update(input.data(), to_ptr(output), input.size());
+    return output;
+}
+
+void
+ctr_keystream::update(buffer_view_t input, uint8_t* output) {
+    pimpl->update(input.data(), output, input.size());
+}
+
+size_t
+ctr_keystream::refill() {
+    if (!pimpl->started)
+        throw exceptions::usage_error{"the keystream is not started"};
+    return pimpl->st->fill();
+}
+
+size_t
+ctr_keystream::available() const noexcept {
+    const auto& st = *pimpl->st;
+    return static_cast<size_t>(
+        st.produced.load(std::memory_order_acquire) -
+        st.consumed.load(std::memory_order_relaxed));
+}
+
+size_t
+ctr_keystream::ring_size() const noexcept {
+    return pimpl->st->ring.size();
+}
+
+size_t
+ctr_keystream::iv_size() const noexcept {
+    return pimpl->st->ctx.cipher_info->iv_size;
+}
+
+uint64_t
+ctr_keystream::ring_bytes() const noexcept {
+    return pimpl->ring_bytes;
+}
+
+uint64_t
+ctr_keystream::inline_bytes() const noexcept {
+    return pimpl->inline_bytes;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
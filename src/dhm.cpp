@@ -0,0 +1,366 @@
+#include "mbedcrypto/dhm.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "./conversions.hpp"
+
+#if defined(MBEDTLS_DHM_C)
+#include "./fixed_base.hpp"
+
+#include <mbedtls/dhm.h>
+#include <mbedtls/platform_util.h>
+
+#include <mutex>
+#endif // MBEDTLS_DHM_C
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+bool
+supports_dhm() noexcept {
+#if defined(MBEDTLS_DHM_C)
+    return true;
+#else  // MBEDTLS_DHM_C
+    return false;
+#endif // MBEDTLS_DHM_C
+}
+
+#if defined(MBEDTLS_DHM_C)
+//-----------------------------------------------------------------------------
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<dhm>::value == false, "");
+static_assert(std::is_move_constructible<dhm>::value == true,  "");
+
+enum K {
+    group_count     = 5,
+    max_table_bytes = 8 * 1024 * 1024, ///< larger tables are not built
+    /// the largest custom prime of a server, as the largest RFC 7919 group
+    max_custom_prime_bits = 8192,
+};
+
+// clang-format off
+const uint8_t Ffdhe2048P[] = MBEDTLS_DHM_RFC7919_FFDHE2048_P_BIN;
+const uint8_t Ffdhe3072P[] = MBEDTLS_DHM_RFC7919_FFDHE3072_P_BIN;
+const uint8_t Ffdhe4096P[] = MBEDTLS_DHM_RFC7919_FFDHE4096_P_BIN;
+const uint8_t Ffdhe6144P[] = MBEDTLS_DHM_RFC7919_FFDHE6144_P_BIN;
+const uint8_t Ffdhe8192P[] = MBEDTLS_DHM_RFC7919_FFDHE8192_P_BIN;
+const uint8_t FfdheG[]     = MBEDTLS_DHM_RFC7919_FFDHE2048_G_BIN;
+
+struct group_info {
+    dh_group_t     type;
+    buffer_view_t  prime;
+    size_t         short_exponent; ///< bits, RFC 7919 section 5.2
+};
+
+const group_info Groups[group_count] = {
+    {dh_group_t::ffdhe2048, {Ffdhe2048P, sizeof(Ffdhe2048P)}, 225},
+    {dh_group_t::ffdhe3072, {Ffdhe3072P, sizeof(Ffdhe3072P)}, 275},
+    {dh_group_t::ffdhe4096, {Ffdhe4096P, sizeof(Ffdhe4096P)}, 325},
+    {dh_group_t::ffdhe6144, {Ffdhe6144P, sizeof(Ffdhe6144P)}, 375},
+    {dh_group_t::ffdhe8192, {Ffdhe8192P, sizeof(Ffdhe8192P)}, 400},
+};
+// clang-format on
+
+const group_info&
+info_of(dh_group_t type) {
+    for (const auto& g : Groups) {
+        if (g.type == type)
+            return g;
+    }
+    throw exceptions::usage_error{"invalid or unsupported dh group"};
+}
+
+size_t
+exponent_bits_of(size_t prime_bits, bool short_exponent) {
+    if (!short_exponent)
+        return prime_bits - 1;
+
+    // custom primes follow the size of the nearest larger RFC 7919 group
+    for (const auto& g : Groups) {
+        if (prime_bits <= g.prime.size() * 8)
+            return g.short_exponent;
+    }
+    return Groups[group_count - 1].short_exponent;
+}
+
+/** returns the shared table of a group generator, or nullptr if the table
+ * would be larger than max_table_bytes.
+ * the tables are built on the first use.
+ */
+const fixed_base_table*
+table_of(dh_group_t type, bool short_exponent) {
+    static std::once_flag                    flags[group_count][2];
+    static std::unique_ptr<fixed_base_table> tables[group_count][2];
+
+    const auto&  g     = info_of(type);
+    const size_t index = static_cast<size_t>(&g - Groups);
+    const size_t bits  = exponent_bits_of(g.prime.size() * 8, short_exponent);
+
+    // windows * entries * prime size
+    const size_t memory = ((bits + fixed_base_table::window_bits - 1) /
+                           fixed_base_table::window_bits) *
+                          fixed_base_table::window_size * g.prime.size();
+    if (memory > max_table_bytes)
+        return nullptr;
+
+    auto& table = tables[index][short_exponent];
+    std::call_once(flags[index][short_exponent], [&]() {
+        table = std::make_unique<fixed_base_table>(
+            g.prime,
+            buffer_view_t{FfdheG, sizeof(FfdheG)},
+            bits,
+            tuned_crossover());
+    });
+    return table.get();
+}
+
+struct mpi_holder {
+    mbedtls_mpi ctx_;
+    mpi_holder() {
+        mbedtls_mpi_init(&ctx_);
+    }
+    ~mpi_holder() {
+        mbedtls_mpi_free(&ctx_);
+    }
+};
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct dhm::impl {
+    const bool              short_exponent_;
+    dh_group_t              group_ = dh_group_t::none;
+    size_t                  exponent_bits_ = 0;
+    const fixed_base_table* table_ = nullptr;
+    rnd_generator           rnd_{"mbedcrypto dhm implementation"};
+    mbedtls_dhm_context     ctx_;
+
+    explicit impl(bool short_exponent) : short_exponent_{short_exponent} {
+        mbedtls_dhm_init(&ctx_);
+    }
+
+    ~impl() {
+        mbedtls_dhm_free(&ctx_);
+    }
+
+    void load_group(dh_group_t type) {
+        const auto& g = info_of(type);
+
+        mpi_holder p, gen;
+        mbedcrypto_c_call(
+            mbedtls_mpi_read_binary, &p.ctx_, g.prime.data(), g.prime.size());
+        mbedcrypto_c_call(
+            mbedtls_mpi_read_binary, &gen.ctx_, FfdheG, sizeof(FfdheG));
+
+        mbedtls_dhm_free(&ctx_);
+        mbedtls_dhm_init(&ctx_);
+        mbedcrypto_c_call(mbedtls_dhm_set_group, &ctx_, &p.ctx_, &gen.ctx_);
+
+        group_         = type;
+        exponent_bits_ = exponent_bits_of(g.prime.size() * 8, short_exponent_);
+        table_         = table_of(type, short_exponent_);
+    }
+
+    /// finds the group of the loaded parameters (p, g)
+    void detect_group() {
+        group_ = dh_group_t::none;
+        table_ = nullptr;
+
+        mpi_holder p, gen;
+        mbedcrypto_c_call(
+            mbedtls_mpi_read_binary, &gen.ctx_, FfdheG, sizeof(FfdheG));
+        if (mbedtls_mpi_cmp_mpi(&ctx_.G, &gen.ctx_) == 0) {
+            for (const auto& g : Groups) {
+                mbedcrypto_c_call(
+                    mbedtls_mpi_read_binary,
+                    &p.ctx_,
+                    g.prime.data(),
+                    g.prime.size());
+                if (mbedtls_mpi_cmp_mpi(&ctx_.P, &p.ctx_) == 0) {
+                    group_ = g.type;
+                    table_ = table_of(g.type, short_exponent_);
+                    break;
+                }
+            }
+        }
+
+        // a short exponent is only safe in a known safe prime group, the
+        // custom primes are not validated (too costly) and the small factors
+        // of p - 1 would reveal a short exponent (van Oorschot-Wiener)
+        exponent_bits_ = exponent_bits_of(
+            mbedtls_mpi_bitlen(&ctx_.P),
+            short_exponent_ && group_ != dh_group_t::none);
+    }
+
+    /// makes a new private exponent X and the public key GX = G^X mod P
+    void gen_public() {
+        const size_t bits  = exponent_bits_;
+        const size_t bytes = (bits + 7) / 8;
+
+        // a random exponent of exactly bits size: 2^(bits-1) <= X < 2^bits
+        auto  x  = rnd_.make(bytes);
+        auto* px = to_ptr(x);
+        px[0] &= static_cast<uint8_t>(0xff >> (bytes * 8 - bits));
+        px[0] |= static_cast<uint8_t>(0x80 >> (bytes * 8 - bits));
+
+        try {
+            mbedcrypto_c_call(mbedtls_mpi_read_binary, &ctx_.X, px, bytes);
+
+            if (table_ != nullptr) {
+                buffer_t gx(table_->size(), '\0');
+                table_->power(to_ptr(gx), x);
+                mbedcrypto_c_call(
+                    mbedtls_mpi_read_binary,
+                    &ctx_.GX,
+                    to_const_ptr(gx),
+                    gx.size());
+            } else {
+                mbedcrypto_c_call(
+                    mbedtls_mpi_exp_mod,
+                    &ctx_.GX,
+                    &ctx_.G,
+                    &ctx_.X,
+                    &ctx_.P,
+                    &ctx_.RP);
+            }
+        } catch (...) {
+            mbedtls_platform_zeroize(px, bytes);
+            throw;
+        }
+        mbedtls_platform_zeroize(px, bytes);
+    }
+
+    buffer_t public_key() const {
+        if (ctx_.len == 0 || mbedtls_mpi_cmp_int(&ctx_.GX, 0) == 0)
+            throw exceptions::usage_error{"dhm has no key"};
+
+        buffer_t pub(ctx_.len, '\0');
+        mbedcrypto_c_call(
+            mbedtls_mpi_write_binary, &ctx_.GX, to_ptr(pub), pub.size());
+        return pub;
+    }
+
+    buffer_t server_params() const {
+        buffer_t skex;
+        for (const auto* v : {&ctx_.P, &ctx_.G, &ctx_.GX}) {
+            const size_t len = mbedtls_mpi_size(v);
+            skex.push_back(static_cast<char>(len >> 8));
+            skex.push_back(static_cast<char>(len & 0xff));
+
+            const size_t offset = skex.size();
+            skex.resize(offset + len);
+            mbedcrypto_c_call(
+                mbedtls_mpi_write_binary, v, to_ptr(skex) + offset, len);
+        }
+        return skex;
+    }
+
+    // the peer's public key is already loaded
+    buffer_t calc_secret() {
+        buffer_t secret(ctx_.len, '\0');
+        size_t   olen = 0;
+        mbedcrypto_c_call(
+            mbedtls_dhm_calc_secret,
+            &ctx_,
+            to_ptr(secret),
+            secret.size(),
+            &olen,
+            rnd_generator::maker,
+            &rnd_);
+
+        secret.resize(olen);
+        return secret;
+    }
+
+    buffer_t calc_secret(buffer_view_t otherpub) {
+        mbedcrypto_c_call(
+            mbedtls_dhm_read_public, &ctx_, otherpub.data(), otherpub.size());
+
+        return calc_secret();
+    }
+}; // struct dhm::impl
+
+//-----------------------------------------------------------------------------
+
+dhm::dhm(bool short_exponent)
+    : pimpl{std::make_unique<impl>(short_exponent)} {}
+
+dhm::~dhm() = default;
+
+dhm::dhm(dhm&&) = default;
+
+dhm& dhm::operator=(dhm&&) = default;
+
+buffer_t
+dhm::make_peer_key(dh_group_t type) {
+    pimpl->load_group(type);
+    pimpl->gen_public();
+    return pimpl->public_key();
+}
+
+buffer_t
+dhm::peer_key() const {
+    return pimpl->public_key();
+}
+
+buffer_t
+dhm::shared_secret(buffer_view_t peer_pub) {
+    return pimpl->calc_secret(peer_pub);
+}
+
+buffer_t
+dhm::shared_secret() {
+    return pimpl->calc_secret();
+}
+
+dh_group_t
+dhm::group() const noexcept {
+    return pimpl->group_;
+}
+
+size_t
+dhm::key_length() const noexcept {
+    return pimpl->ctx_.len;
+}
+
+size_t
+dhm::exponent_bitlen() const noexcept {
+    return pimpl->exponent_bits_;
+}
+
+buffer_t
+dhm::make_server_key_exchange(dh_group_t type) {
+    pimpl->load_group(type);
+    pimpl->gen_public();
+    return pimpl->server_params();
+}
+
+buffer_t
+dhm::make_client_peer_key(buffer_view_t server_key_exchange) {
+    auto& d = *pimpl;
+    mbedtls_dhm_free(&d.ctx_);
+    mbedtls_dhm_init(&d.ctx_);
+
+    // mbedtls_dhm_read_params() does not modify the input
+    auto* p = const_cast<uint8_t*>(server_key_exchange.data());
+    mbedcrypto_c_call(
+        mbedtls_dhm_read_params,
+        &d.ctx_,
+        &p,
+        p + server_key_exchange.size());
+    if (mbedtls_mpi_bitlen(&d.ctx_.P) > max_custom_prime_bits) {
+        throw exception{
+            MBEDTLS_ERR_DHM_BAD_INPUT_DATA, "the dh prime is too large"};
+    }
+
+    d.detect_group();
+    d.gen_public();
+    return d.public_key();
+}
+
+//-----------------------------------------------------------------------------
+#endif // MBEDTLS_DHM_C
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -127,6 +127,9 @@ struct ecp::impl : public pk::context {
         const auto* p = skex.data();
         mbedcrypto_c_call(
             mbedtls_ecdh_read_params, ecdh_.get(), &p, p + skex.size());
+        // an invalid server point fails before the key generation
+        mbedcrypto_c_call(
+            mbedtls_ecp_check_pubkey, &ecdh_->grp, &ecdh_->Qp);
 
         ecdh_gen_public();
     }
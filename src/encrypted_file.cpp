@@ -0,0 +1,404 @@
+#include "mbedcrypto/encrypted_file.hpp"
+#include "./conversions.hpp"
+#include "./fs_utils.hpp"
+#include "./worker_pool.hpp"
+
+#include <mbedtls/cipher.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<encrypted_file>::value == false, "");
+static_assert(std::is_move_constructible<encrypted_file>::value == true, "");
+
+enum K : size_t {
+    aead_iv_size = 12,
+};
+
+using page_t = std::shared_ptr<const buffer_t>;
+
+void
+put_be64(uint8_t* p, uint64_t v) noexcept {
+    for (int i = 7; i >= 0; --i, v >>= 8)
+        p[i] = static_cast<uint8_t>(v);
+}
+
+bool
+is_aead(cipher_t type) {
+    const auto bm = cipher::block_mode(type);
+    return bm == cipher_bm::gcm || bm == cipher_bm::ccm;
+}
+
+void
+check_params(cipher_t type, buffer_view_t iv, size_t page_size) {
+    if (page_size == 0)
+        throw exceptions::usage_error{"invalid page size"};
+    if (is_aead(type)) {
+        if (iv.size() != aead_iv_size)
+            throw exceptions::usage_error{"the aead pages need a 12 bytes iv"};
+    } else if (cipher::block_mode(type) == cipher_bm::ctr) {
+        if (iv.size() != cipher::iv_size(type))
+            throw exceptions::usage_error{"invalid iv size"};
+    } else {
+        throw exceptions::usage_error{
+            "encrypted_file requires a ctr, gcm or ccm cipher"};
+    }
+}
+
+/// the nonce and the additional data of an aead page
+struct page_params {
+    uint8_t nonce[aead_iv_size];
+    uint8_t additional[16];
+
+    page_params(buffer_view_t iv, uint64_t index, uint64_t plain_size) {
+        std::copy(iv.data(), iv.data() + aead_iv_size, nonce);
+        uint8_t counter[8];
+        put_be64(counter, index);
+        for (size_t i = 0; i < 8; ++i)
+            nonce[aead_iv_size - 8 + i] ^= counter[i];
+        put_be64(additional, index);
+        put_be64(additional + 8, plain_size);
+    }
+}; // struct page_params
+
+/** the cache and the file, shared with the read-ahead tasks.
+ * a page is inserted (as a future) by the first reader which misses it, the
+ * concurrent readers of the same page wait for that single decryption.
+ */
+struct state_t {
+    struct entry_t {
+        std::shared_future<page_t>    page;
+        std::list<uint64_t>::iterator lru;
+        uint64_t                      serial = 0;
+    }; // struct entry_t
+
+    cipher_t type;
+    bool     aead;
+    buffer_t key;
+    buffer_t iv;
+    size_t   page_size;
+    size_t   cache_pages;
+    size_t   read_ahead;
+    uint64_t plain_size = 0;
+    uint64_t page_count = 0;
+
+    std::mutex     io_mutex;
+    fs::input_file file;
+
+    std::mutex                            mutex;
+    std::list<uint64_t>                   lru; ///< the most recent first
+    std::unordered_map<uint64_t, entry_t> pages;
+    encrypted_file::stats_t               stats;
+    uint64_t                              serial      = 0;
+    uint64_t                              last_end    = 0;
+    uint64_t                              ahead_until = 0;
+    size_t                                streak      = 0;
+    std::atomic<bool>                     stopped{false};
+
+    state_t(
+        const char*                    path,
+        cipher_t                       t,
+        buffer_view_t                  k,
+        buffer_view_t                  i,
+        const encrypted_file::options& opts)
+        : type{t},
+          aead{is_aead(t)},
+          key{reinterpret_cast<const char*>(k.data()), k.size()},
+          iv{reinterpret_cast<const char*>(i.data()), i.size()},
+          page_size{opts.page_size},
+          cache_pages{std::max<size_t>(opts.cache_pages, 1)},
+          read_ahead{opts.read_ahead},
+          file{path} {
+        const auto fsize = fs::file_size(path);
+        if (fsize < 0)
+            throw exceptions::usage_error{"failed to open the file"};
+
+        const auto stored = static_cast<uint64_t>(fsize);
+        if (aead && stored == encrypted_file::tag_size) {
+            // an empty plain text, its single page is authenticated now as
+            // the reads of an empty file never load a page
+            load(0);
+        } else if (aead) {
+            const uint64_t stride = page_size + encrypted_file::tag_size;
+            const uint64_t rest   = stored % stride;
+            // even an empty plain text has a sealed page
+            if (stored == 0 || (rest != 0 && rest <= encrypted_file::tag_size))
+                throw exceptions::usage_error{"invalid encrypted file size"};
+            plain_size = (stored / stride) * page_size +
+                         (rest == 0 ? 0 : rest - encrypted_file::tag_size);
+        } else {
+            plain_size = stored;
+        }
+        page_count = (plain_size + page_size - 1) / page_size;
+    }
+
+    ~state_t() {
+        mbedtls_platform_zeroize(to_ptr(key), key.size());
+    }
+
+    /// reads and decrypts a page
+    page_t load(uint64_t index) {
+        const uint64_t offset = index * page_size;
+        const size_t   length = static_cast<size_t>(
+            std::min<uint64_t>(page_size, plain_size - offset));
+        const size_t   extra = aead ? size_t{encrypted_file::tag_size} : 0;
+        const uint64_t stored = index * (page_size + extra);
+
+        buffer_t input(length + extra, '\0');
+        size_t   n = 0;
+        {
+            std::lock_guard<std::mutex> lock{io_mutex};
+            file.seek(static_cast<int64_t>(stored));
+            n = file.read(to_ptr(input), input.size());
+        }
+        if (n != input.size())
+            throw exceptions::usage_error{"the encrypted file is truncated"};
+
+        if (!aead) {
+            cipher ctr{type};
+            ctr.iv(iv).key(key, cipher::decrypt_mode);
+            return std::make_shared<const buffer_t>(
+                ctr.ctr_crypt(offset, input));
+        }
+
+        const page_params pp{iv, index, plain_size};
+        auto              result = cipher::decrypt_aead(
+            type,
+            buffer_view_t{pp.nonce, sizeof(pp.nonce)},
+            key,
+            buffer_view_t{pp.additional, sizeof(pp.additional)},
+            buffer_view_t{to_const_ptr(input) + length, extra},
+            buffer_view_t{to_const_ptr(input), length});
+        if (!std::get<0>(result)) {
+            throw exceptions::usage_error{
+                MBEDTLS_ERR_CIPHER_AUTH_FAILED,
+                "a page of the encrypted file failed the authentication"};
+        }
+        return std::make_shared<const buffer_t>(
+            std::move(std::get<1>(result)));
+    }
+
+    /// must be called under the lock
+    void evict() {
+        while (pages.size() > cache_pages) {
+            pages.erase(lru.back());
+            lru.pop_back();
+            ++stats.evictions;
+        }
+    }
+
+    /** returns a page from the cache or decrypts it. if ahead, does not wait
+     * for a page already in the cache (or being loaded) and returns null.
+     */
+    page_t get(uint64_t index, bool ahead) {
+        std::unique_lock<std::mutex> lock{mutex};
+        auto                         it = pages.find(index);
+        if (it != pages.end()) {
+            if (ahead)
+                return nullptr;
+            ++stats.hits;
+            lru.splice(lru.begin(), lru, it->second.lru);
+            auto page = it->second.page;
+            lock.unlock();
+            return page.get();
+        }
+
+        if (ahead)
+            ++stats.read_ahead;
+        else
+            ++stats.misses;
+        std::promise<page_t> promise;
+        const auto           id = ++serial;
+        lru.push_front(index);
+        pages[index] = entry_t{promise.get_future().share(), lru.begin(), id};
+        evict();
+        lock.unlock();
+
+        try {
+            auto page = load(index);
+            promise.set_value(page);
+            return page;
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+            lock.lock();
+            it = pages.find(index);
+            if (it != pages.end() && it->second.serial == id) {
+                lru.erase(it->second.lru);
+                pages.erase(it);
+            }
+            throw;
+        }
+    }
+
+    /// returns the pages to be decrypted ahead, by the sequential reads
+    std::pair<uint64_t, uint64_t> plan_read_ahead(
+        uint64_t offset, uint64_t end, uint64_t last_page) {
+        std::lock_guard<std::mutex> lock{mutex};
+        streak   = offset == last_end ? streak + 1 : 0;
+        last_end = end;
+        if (read_ahead == 0 || streak == 0)
+            return {0, 0};
+
+        const auto from   = std::max(last_page + 1, ahead_until);
+        const auto target = std::min(last_page + 1 + read_ahead, page_count);
+        if (from >= target)
+            return {0, 0};
+        ahead_until = target;
+        return {from, target};
+    }
+}; // struct state_t
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct encrypted_file::impl {
+    std::shared_ptr<state_t> st;
+
+    ~impl() {
+        if (st)
+            st->stopped = true; // the queued read-aheads become no-ops
+    }
+
+    void post_read_ahead(uint64_t from, uint64_t to) {
+        auto s = st; // the task keeps the state alive
+        worker_pool::shared().post([s, from, to]() {
+            for (auto i = from; i < to && !s->stopped; ++i) {
+                try {
+                    s->get(i, true);
+                } catch (...) {
+                    // the error is reported to the next read of the page
+                }
+            }
+        });
+    }
+}; // struct encrypted_file::impl
+
+//-----------------------------------------------------------------------------
+
+constexpr size_t encrypted_file::default_page_size;
+constexpr size_t encrypted_file::tag_size;
+
+buffer_t
+encrypted_file::encrypt(
+    cipher_t      type,
+    buffer_view_t key,
+    buffer_view_t iv,
+    buffer_view_t plain,
+    size_t        page_size) {
+    check_params(type, iv, page_size);
+    if (!is_aead(type))
+        return cipher::encrypt(type, padding_t::none, iv, key, plain);
+
+    // an empty plain text still has a (sealed empty) page
+    const uint64_t pages =
+        std::max<uint64_t>(1, (plain.size() + page_size - 1) / page_size);
+    buffer_t       output;
+    output.reserve(plain.size() + pages * tag_size);
+    for (uint64_t i = 0; i < pages; ++i) {
+        const size_t offset = static_cast<size_t>(i * page_size);
+        const size_t length = std::min(page_size, plain.size() - offset);
+
+        const page_params pp{iv, i, plain.size()};
+        auto              sealed = cipher::encrypt_aead(
+            type,
+            buffer_view_t{pp.nonce, sizeof(pp.nonce)},
+            key,
+            buffer_view_t{pp.additional, sizeof(pp.additional)},
+            buffer_view_t{plain.data() + offset, length});
+        output += std::get<1>(sealed);
+        output += std::get<0>(sealed);
+    }
+    return output;
+}
+
+encrypted_file::encrypted_file(
+    const char*    file_path,
+    cipher_t       type,
+    buffer_view_t  key,
+    buffer_view_t  iv,
+    const options& opts) {
+    check_params(type, iv, opts.page_size);
+    pimpl     = std::make_unique<impl>();
+    pimpl->st = std::make_shared<state_t>(file_path, type, key, iv, opts);
+}
+
+encrypted_file::~encrypted_file() = default;
+
+encrypted_file::encrypted_file(encrypted_file&&) = default;
+
+encrypted_file& encrypted_file::operator=(encrypted_file&&) = default;
+
+uint64_t
+encrypted_file::size() const noexcept {
+    return pimpl->st->plain_size;
+}
+
+size_t
+encrypted_file::page_size() const noexcept {
+    return pimpl->st->page_size;
+}
+
+size_t
+encrypted_file::read(uint64_t offset, uint8_t* output, size_t length) {
+    auto& st = *pimpl->st;
+    if (length == 0 || offset >= st.plain_size)
+        return 0;
+
+    length = static_cast<size_t>(
+        std::min<uint64_t>(length, st.plain_size - offset));
+    const uint64_t end   = offset + length;
+    const uint64_t first = offset / st.page_size;
+    const uint64_t last  = (end - 1) / st.page_size;
+
+    const auto ahead = st.plan_read_ahead(offset, end, last);
+    if (ahead.first < ahead.second)
+        pimpl->post_read_ahead(ahead.first, ahead.second);
+
+    size_t done = 0;
+    for (auto i = first; i <= last; ++i) {
+        const auto     page  = st.get(i, false);
+        const uint64_t start = i * st.page_size;
+        const size_t   from  = static_cast<size_t>(offset + done - start);
+        const size_t   n     = std::min(page->size() - from, length - done);
+        std::copy_n(to_const_ptr(*page) + from, n, output + done);
+        done += n;
+    }
+    return done;
+}
+
+buffer_t
+encrypted_file::read(uint64_t offset, size_t length) {
+    buffer_t output(length, '\0');
+    output.resize(read(offset, to_ptr(output), length));
+    return output;
+}
+
+void
+encrypted_file::clear_cache() {
+    auto&                       st = *pimpl->st;
+    std::lock_guard<std::mutex> lock{st.mutex};
+    st.pages.clear();
+    st.lru.clear();
+    st.ahead_until = 0;
+}
+
+auto
+encrypted_file::stats() const -> stats_t {
+    auto&                       st = *pimpl->st;
+    std::lock_guard<std::mutex> lock{st.mutex};
+    return st.stats;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,507 @@
+#include "mbedcrypto/ff1.hpp"
+#include "./conversions.hpp"
+
+#include <mbedtls/aes.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<ff1>::value == false, "");
+static_assert(std::is_move_constructible<ff1>::value == true, "");
+
+enum K : size_t {
+    block_size   = 16,
+    rounds       = 10,
+    limbs        = 10,  ///< 320 bits: a half (256) or the d bytes of y (36)
+    max_digits   = 256, ///< of a half, by radix 2
+    max_half     = ff1::max_half_bits / 8,
+    prefix_slots = 4,
+};
+
+const char DefaultAlphabet[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/// a fixed size unsigned number, little endian 32-bit limbs
+struct fixed_num {
+    uint32_t w[limbs] = {0};
+    size_t   used     = limbs; ///< an upper bound of the non zero limbs
+
+    /// w = w * m + a, returns false on overflow
+    bool mul_add(uint32_t m, uint32_t a) noexcept {
+        uint64_t carry = a;
+        for (size_t i = 0; i < limbs; ++i) {
+            const uint64_t t = uint64_t{w[i]} * m + carry;
+            w[i]             = static_cast<uint32_t>(t);
+            carry            = t >> 32;
+        }
+        return carry == 0;
+    }
+
+    /// w = w / d, returns the remainder
+    uint32_t div_small(uint32_t d) noexcept {
+        uint64_t rem = 0;
+        for (size_t i = used; i-- > 0;) {
+            const uint64_t cur = (rem << 32) | w[i];
+            w[i]               = static_cast<uint32_t>(cur / d);
+            rem                = cur % d;
+        }
+        return static_cast<uint32_t>(rem);
+    }
+
+    /// from n big endian bytes
+    void from_bytes(const uint8_t* p, size_t n) noexcept {
+        std::memset(w, 0, sizeof(w));
+        used = (n + 3) / 4;
+        for (size_t i = 0; i < n; ++i) {
+            const size_t bit = (n - 1 - i) * 8;
+            w[bit / 32] |= uint32_t{p[i]} << (bit % 32);
+        }
+    }
+
+    /// the low n bytes as big endian
+    void to_bytes(uint8_t* p, size_t n) const noexcept {
+        for (size_t i = 0; i < n; ++i) {
+            const size_t bit = (n - 1 - i) * 8;
+            p[i]             = static_cast<uint8_t>(w[bit / 32] >> (bit % 32));
+        }
+    }
+
+    size_t bit_length() const noexcept {
+        for (size_t i = limbs; i-- > 0;) {
+            if (w[i] == 0)
+                continue;
+            size_t bits = i * 32;
+            for (uint32_t v = w[i]; v != 0; v >>= 1)
+                ++bits;
+            return bits;
+        }
+        return 0;
+    }
+}; // struct fixed_num
+
+bool
+same(const buffer_t& a, buffer_view_t b) noexcept {
+    return a.size() == b.size() &&
+           (b.empty() || std::memcmp(a.data(), b.data(), b.size()) == 0);
+}
+
+void
+put_be32(uint8_t* p, uint32_t v) noexcept {
+    for (int i = 3; i >= 0; --i, v >>= 8)
+        p[i] = static_cast<uint8_t>(v);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct ff1::impl {
+    /** the constant head of the CBC-MAC of a length and a tweak: the state
+     * after P and the full blocks of the tweak, and the rest of the tweak
+     * (and its zero padding) as the start of the variable blocks.
+     */
+    struct prefix {
+        bool     valid  = false;
+        size_t   length = 0;
+        buffer_t tweak;
+        size_t   u = 0, v = 0;
+        size_t   b = 0; ///< the bytes of NUM(half)
+        size_t   d = 0; ///< the bytes of y
+        size_t   tail_size = 0;
+        uint8_t  state[block_size];
+        uint8_t  tail[block_size];
+    }; // struct prefix
+
+    mbedtls_aes_context aes_;
+    bool                has_key_ = false;
+    uint32_t            radix_   = 0;
+    size_t              min_len_ = 0;
+    size_t              max_len_ = 0;
+    uint32_t            chunk_   = 0; ///< the largest radix^k in 32 bits
+    size_t              chunk_digits_ = 0; ///< k
+    buffer_t            alphabet_;
+    int32_t             digit_of_[256];
+    prefix              slots_[prefix_slots];
+    size_t              next_slot_ = 0;
+    // the halves of the feistel network
+    uint16_t halves_[2][max_digits];
+
+    explicit impl(size_t radix) {
+        if (radix < 2 || radix > max_radix)
+            throw exceptions::usage_error{"the radix of ff1 is out of range"};
+        radix_ = static_cast<uint32_t>(radix);
+        if (radix <= sizeof(DefaultAlphabet) - 1)
+            alphabet_.assign(DefaultAlphabet, radix);
+        setup();
+    }
+
+    explicit impl(const char* alphabet) {
+        alphabet_ = alphabet == nullptr ? buffer_t{} : buffer_t{alphabet};
+        if (alphabet_.size() < 2)
+            throw exceptions::usage_error{"the ff1 alphabet is too small"};
+        radix_ = static_cast<uint32_t>(alphabet_.size());
+        setup();
+    }
+
+    ~impl() {
+        mbedtls_aes_free(&aes_);
+        clear_slots();
+    }
+
+    void setup() {
+        mbedtls_aes_init(&aes_);
+        std::fill(std::begin(digit_of_), std::end(digit_of_), -1);
+        for (size_t i = 0; i < alphabet_.size(); ++i) {
+            const auto c = static_cast<uint8_t>(alphabet_[i]);
+            if (digit_of_[c] != -1)
+                throw exceptions::usage_error{"repeated ff1 alphabet char"};
+            digit_of_[c] = static_cast<int32_t>(i);
+        }
+
+        // radix^min_len >= 1'000'000 (SP 800-38G), radix^v fits max_half
+        uint64_t domain = 1;
+        for (min_len_ = 0; domain < 1000000; ++min_len_)
+            domain *= radix_;
+        min_len_ = std::max<size_t>(min_len_, 2);
+        uint64_t chunk = radix_;
+        for (chunk_digits_ = 1; chunk * radix_ <= UINT32_MAX; ++chunk_digits_)
+            chunk *= radix_;
+        chunk_ = static_cast<uint32_t>(chunk);
+        size_t max_v = 1;
+        while (max_v < max_digits && half_bytes(max_v + 1) != 0)
+            ++max_v;
+        max_len_ = 2 * max_v;
+    }
+
+    /** the bytes of NUM(a half of v digits): ceil(ceil(v * log2(radix)) / 8)
+     * or 0 if larger than max_half.
+     */
+    size_t half_bytes(size_t v) const noexcept {
+        fixed_num p;
+        p.mul_add(1, 1);
+        for (size_t i = 0; i < v; ++i) {
+            if (!p.mul_add(radix_, 0))
+                return 0;
+        }
+        // the bit length of radix^v, minus 1 if it is a power of 2
+        const bool pow2  = (radix_ & (radix_ - 1)) == 0;
+        const auto bits  = p.bit_length() - (pow2 ? 1 : 0);
+        const auto bytes = (bits + 7) / 8;
+        return bytes <= max_half ? bytes : 0;
+    }
+
+    void block(const uint8_t in[block_size], uint8_t out[block_size]) {
+        mbedtls_aes_crypt_ecb(&aes_, MBEDTLS_AES_ENCRYPT, in, out);
+    }
+
+    /// state = E(state ^ data), a step of the CBC-MAC
+    void mac_block(uint8_t state[block_size], const uint8_t* data) {
+        for (size_t i = 0; i < block_size; ++i)
+            state[i] ^= data[i];
+        block(state, state);
+    }
+
+    void clear_slots() noexcept {
+        for (auto& s : slots_) {
+            mbedtls_platform_zeroize(s.state, sizeof(s.state));
+            mbedtls_platform_zeroize(s.tail, sizeof(s.tail));
+            s.valid = false;
+        }
+    }
+
+    const prefix& prefix_of(size_t n, buffer_view_t tweak) {
+        for (const auto& s : slots_) {
+            if (s.valid && s.length == n && same(s.tweak, tweak))
+                return s;
+        }
+
+        auto& s     = slots_[next_slot_];
+        next_slot_  = (next_slot_ + 1) % prefix_slots;
+        s.valid     = false;
+        s.length    = n;
+        s.tweak     = tweak.to<buffer_t>();
+        s.u         = n / 2;
+        s.v         = n - s.u;
+        s.b         = half_bytes(s.v);
+        s.d         = 4 * ((s.b + 3) / 4) + 4;
+
+        const auto t = tweak.size();
+        uint8_t    p[block_size] = {1, 2, 1};
+        p[3] = static_cast<uint8_t>(radix_ >> 16);
+        p[4] = static_cast<uint8_t>(radix_ >> 8);
+        p[5] = static_cast<uint8_t>(radix_);
+        p[6] = 10;
+        p[7] = static_cast<uint8_t>(s.u);
+        put_be32(p + 8, static_cast<uint32_t>(n));
+        put_be32(p + 12, static_cast<uint32_t>(t));
+        block(p, s.state);
+
+        // Q = T | [0]^pad | [i] | NUM(half), the constant part is T | pad
+        const size_t pad      = (block_size - (t + s.b + 1) % block_size) %
+                           block_size;
+        const size_t constant = t + pad;
+        const size_t full     = constant / block_size;
+        for (size_t i = 0; i < full; ++i) {
+            uint8_t blk[block_size] = {0};
+            const size_t offset     = i * block_size;
+            if (offset < t)
+                std::memcpy(
+                    blk,
+                    tweak.data() + offset,
+                    std::min<size_t>(block_size, t - offset));
+            mac_block(s.state, blk);
+        }
+        s.tail_size = constant % block_size;
+        std::memset(s.tail, 0, sizeof(s.tail));
+        const size_t offset = full * block_size;
+        if (offset < t)
+            std::memcpy(s.tail, tweak.data() + offset, t - offset);
+
+        s.valid = true;
+        return s;
+    }
+
+    /** y = NUM(S) of the round i, S by the CBC-MAC of [i] | NUM(half), the
+     * half has v digits in the even rounds and u digits in the odd ones.
+     */
+    void round_value(
+        const prefix& pf, size_t i, const uint16_t* half, fixed_num& y) {
+        const size_t h = (i % 2 == 0) ? pf.v : pf.u;
+        fixed_num    num;
+        for (size_t k = 0; k < h; ++k)
+            num.mul_add(radix_, half[k]);
+
+        uint8_t q[3 * block_size];
+        std::memcpy(q, pf.tail, pf.tail_size);
+        q[pf.tail_size] = static_cast<uint8_t>(i);
+        num.to_bytes(q + pf.tail_size + 1, pf.b);
+        const size_t qsize = pf.tail_size + 1 + pf.b;
+
+        uint8_t r[block_size];
+        std::memcpy(r, pf.state, block_size);
+        for (size_t offset = 0; offset < qsize; offset += block_size)
+            mac_block(r, q + offset);
+
+        // S = R | E(R ^ [1]) | E(R ^ [2]) ..., the first d bytes
+        uint8_t s[3 * block_size];
+        std::memcpy(s, r, block_size);
+        for (size_t j = 1; j * block_size < pf.d; ++j) {
+            uint8_t x[block_size];
+            std::memcpy(x, r, block_size);
+            x[block_size - 1] ^= static_cast<uint8_t>(j);
+            block(x, s + j * block_size);
+        }
+        y.from_bytes(s, pf.d);
+
+        mbedtls_platform_zeroize(q, sizeof(q));
+        mbedtls_platform_zeroize(r, sizeof(r));
+        mbedtls_platform_zeroize(s, sizeof(s));
+    }
+
+    void check(const uint16_t* digits, size_t n) const {
+        if (!has_key_)
+            throw exceptions::usage_error{"the key of ff1 is not set"};
+        if (n < min_len_ || n > max_len_)
+            throw exceptions::usage_error{"invalid ff1 input length"};
+        for (size_t i = 0; i < n; ++i) {
+            if (digits[i] >= radix_)
+                throw exceptions::usage_error{"invalid ff1 numeral"};
+        }
+    }
+
+    void crypt(uint16_t* digits, size_t n, buffer_view_t tweak, bool enc) {
+        check(digits, n);
+        const auto& pf = prefix_of(n, tweak);
+        const auto  u  = pf.u;
+        const auto  v  = pf.v;
+
+        uint16_t* a = halves_[0];
+        uint16_t* b = halves_[1];
+        std::copy(digits, digits + u, a);
+        std::copy(digits + u, digits + n, b);
+
+        fixed_num y;
+        for (size_t r = 0; r < rounds; ++r) {
+            const size_t i = enc ? r : rounds - 1 - r;
+            const size_t m = (i % 2 == 0) ? u : v;
+            if (enc) {
+                // C = NUM(A) + y mod radix^m, into A, then A = B, B = C
+                round_value(pf, i, b, y);
+                add_digits(a, m, y);
+                std::swap(a, b);
+            } else {
+                // C = NUM(B) - y mod radix^m, into B, then B = A, A = C
+                round_value(pf, i, a, y);
+                sub_digits(b, m, y);
+                std::swap(a, b);
+            }
+        }
+
+        std::copy(a, a + u, digits);
+        std::copy(b, b + v, digits + u);
+        mbedtls_platform_zeroize(halves_[0], v * sizeof(uint16_t));
+        mbedtls_platform_zeroize(halves_[1], v * sizeof(uint16_t));
+        mbedtls_platform_zeroize(y.w, sizeof(y.w));
+    }
+
+    /** the digits of y from the least significant, a division of y by
+     * radix^chunk_digits_ gives many digits (ex: 9 decimal digits).
+     */
+    struct digit_reader {
+        const impl& d;
+        fixed_num&  y;
+        uint32_t    part = 0;
+        size_t      left = 0;
+
+        uint32_t next() noexcept {
+            if (left == 0) {
+                part = y.div_small(d.chunk_);
+                left = d.chunk_digits_;
+            }
+            --left;
+            const uint32_t digit = part % d.radix_;
+            part /= d.radix_;
+            return digit;
+        }
+    }; // struct digit_reader
+
+    /// x = x + (y mod radix^m), digit by digit, the carry out is dropped
+    void add_digits(uint16_t* x, size_t m, fixed_num& y) const noexcept {
+        digit_reader digits{*this, y};
+        uint32_t     carry = 0;
+        for (size_t k = m; k-- > 0;) {
+            uint32_t s = uint32_t{x[k]} + digits.next() + carry;
+            carry      = s >= radix_ ? 1 : 0;
+            x[k]       = static_cast<uint16_t>(s - carry * radix_);
+        }
+    }
+
+    /// x = x - (y mod radix^m), digit by digit, the borrow out is dropped
+    void sub_digits(uint16_t* x, size_t m, fixed_num& y) const noexcept {
+        digit_reader digits{*this, y};
+        uint32_t     borrow = 0;
+        for (size_t k = m; k-- > 0;) {
+            const uint32_t sub = digits.next() + borrow;
+            borrow             = x[k] < sub ? 1 : 0;
+            x[k] = static_cast<uint16_t>(x[k] + borrow * radix_ - sub);
+        }
+    }
+
+    /// the characters to digits, by the alphabet
+    size_t to_digits(buffer_view_t input, uint16_t* digits) const {
+        if (alphabet_.empty())
+            throw exceptions::usage_error{"the ff1 has no alphabet"};
+        if (input.size() > max_len_)
+            throw exceptions::usage_error{"invalid ff1 input length"};
+        for (size_t i = 0; i < input.size(); ++i) {
+            const auto d = digit_of_[input.data()[i]];
+            if (d < 0)
+                throw exceptions::usage_error{"invalid ff1 numeral"};
+            digits[i] = static_cast<uint16_t>(d);
+        }
+        return input.size();
+    }
+
+    buffer_t crypt(buffer_view_t input, buffer_view_t tweak, bool enc) {
+        uint16_t   digits[2 * max_digits];
+        const auto n = to_digits(input, digits);
+        crypt(digits, n, tweak, enc);
+
+        buffer_t output(n, '\0');
+        for (size_t i = 0; i < n; ++i)
+            output[i] = alphabet_[digits[i]];
+        mbedtls_platform_zeroize(digits, n * sizeof(uint16_t));
+        return output;
+    }
+}; // struct ff1::impl
+
+//-----------------------------------------------------------------------------
+
+constexpr size_t ff1::max_radix;
+constexpr size_t ff1::max_half_bits;
+
+ff1::ff1(size_t radix) : pimpl{std::make_unique<impl>(radix)} {}
+
+ff1::ff1(const char* alphabet) : pimpl{std::make_unique<impl>(alphabet)} {}
+
+ff1::~ff1() = default;
+
+ff1::ff1(ff1&&) = default;
+
+ff1& ff1::operator=(ff1&&) = default;
+
+ff1&
+ff1::key(buffer_view_t key_data) {
+    auto& d = *pimpl;
+    mbedcrypto_c_call(
+        mbedtls_aes_setkey_enc,
+        &d.aes_,
+        key_data.data(),
+        static_cast<unsigned int>(key_data.size() << 3));
+    d.has_key_ = true;
+    d.clear_slots();
+    return *this;
+}
+
+size_t
+ff1::radix() const noexcept {
+    return pimpl->radix_;
+}
+
+size_t
+ff1::min_length() const noexcept {
+    return pimpl->min_len_;
+}
+
+size_t
+ff1::max_length() const noexcept {
+    return pimpl->max_len_;
+}
+
+buffer_t
+ff1::encrypt(buffer_view_t input, buffer_view_t tweak) {
+    return pimpl->crypt(input, tweak, true);
+}
+
+buffer_t
+ff1::decrypt(buffer_view_t input, buffer_view_t tweak) {
+    return pimpl->crypt(input, tweak, false);
+}
+
+std::vector<buffer_t>
+ff1::encrypt_many(
+    const std::vector<buffer_view_t>& inputs, buffer_view_t tweak) {
+    std::vector<buffer_t> outputs;
+    outputs.reserve(inputs.size());
+    for (const auto& in : inputs)
+        outputs.push_back(pimpl->crypt(in, tweak, true));
+    return outputs;
+}
+
+std::vector<buffer_t>
+ff1::decrypt_many(
+    const std::vector<buffer_view_t>& inputs, buffer_view_t tweak) {
+    std::vector<buffer_t> outputs;
+    outputs.reserve(inputs.size());
+    for (const auto& in : inputs)
+        outputs.push_back(pimpl->crypt(in, tweak, false));
+    return outputs;
+}
+
+void
+ff1::encrypt(uint16_t* digits, size_t length, buffer_view_t tweak) {
+    pimpl->crypt(digits, length, tweak, true);
+}
+
+void
+ff1::decrypt(uint16_t* digits, size_t length, buffer_view_t tweak) {
+    pimpl->crypt(digits, length, tweak, false);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
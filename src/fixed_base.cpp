@@ -0,0 +1,849 @@
+#include "./fixed_base.hpp"
+#include "mbedcrypto/tuning.hpp"
+
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+using limb_t = mont_modulus::limb_t;
+
+enum K {
+    limb_bytes = sizeof(limb_t),
+    limb_bits  = limb_bytes * 8,
+    max_limbs  = 256, ///< 16384bit modulus
+    work_limbs = 12 * max_limbs, ///< scratch of the sub-quadratic products
+};
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 dlimb_t;
+#endif
+
+/// returns the low limb of a * b + c + carry, carry is updated by the high limb
+inline limb_t
+mac(limb_t a, limb_t b, limb_t c, limb_t& carry) noexcept {
+#if defined(__SIZEOF_INT128__)
+    dlimb_t t = static_cast<dlimb_t>(a) * b + c + carry;
+    carry     = static_cast<limb_t>(t >> limb_bits);
+    return static_cast<limb_t>(t);
+#else // __SIZEOF_INT128__
+    limb_t hi = 0;
+#if defined(_MSC_VER) && defined(_M_X64)
+    limb_t lo = _umul128(a, b, &hi);
+#else  // portable
+    const limb_t al = a & 0xffffffff, ah = a >> 32;
+    const limb_t bl = b & 0xffffffff, bh = b >> 32;
+    const limb_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    const limb_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    limb_t       lo  = (mid << 32) | (ll & 0xffffffff);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+    lo += c;
+    hi += lo < c;
+    lo += carry;
+    hi += lo < carry;
+    carry = hi;
+    return lo;
+#endif // __SIZEOF_INT128__
+}
+
+/// r = a + b, returns the carry (0 or 1)
+inline limb_t
+add_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n) noexcept {
+    limb_t carry = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t s = a[i] + carry;
+        limb_t o = s < carry;
+        r[i]     = s + b[i];
+        carry    = o | (r[i] < s);
+    }
+    return carry;
+}
+
+/// r = a - b, returns the borrow (0 or 1)
+inline limb_t
+sub_n(limb_t* r, const limb_t* a, const limb_t* b, size_t n) noexcept {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t d = a[i] - b[i];
+        limb_t o = a[i] < b[i];
+        r[i]     = d - borrow;
+        borrow   = o | (d < borrow);
+    }
+    return borrow;
+}
+
+/// r[0, n) += a[0, m), m <= n, returns the carry out of r
+inline limb_t
+add_into(limb_t* r, size_t n, const limb_t* a, size_t m) noexcept {
+    limb_t carry = add_n(r, r, a, m);
+    for (size_t i = m; i < n; ++i) {
+        r[i] += carry;
+        carry = r[i] < carry;
+    }
+    return carry;
+}
+
+/// r[0, n) -= a[0, m), m <= n, returns the borrow out of r
+inline limb_t
+sub_from(limb_t* r, size_t n, const limb_t* a, size_t m) noexcept {
+    limb_t borrow = sub_n(r, r, a, m);
+    for (size_t i = m; i < n; ++i) {
+        limb_t o = r[i] < borrow;
+        r[i] -= borrow;
+        borrow = o;
+    }
+    return borrow;
+}
+
+/// r = mask ? -r : r (two's complement), mask is all ones or zero
+inline void
+negate_if(limb_t* r, size_t n, limb_t mask) noexcept {
+    limb_t carry = mask & 1;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t x = (r[i] ^ mask) + carry;
+        carry    = x < carry;
+        r[i]     = x;
+    }
+}
+
+/** r = |a - b|, a: n limbs, b: m <= n limbs, r: n limbs.
+ * returns all ones if a < b, zero otherwise.
+ */
+inline limb_t
+abs_diff(
+    limb_t* r, const limb_t* a, size_t n, const limb_t* b, size_t m) noexcept {
+    std::copy(a, a + n, r);
+    const limb_t mask = 0 - sub_from(r, n, b, m);
+    negate_if(r, n, mask);
+    return mask;
+}
+
+/// r <<= bits, 0 < bits < 64, the high bits are dropped
+inline void
+shift_left(limb_t* r, size_t n, unsigned bits) noexcept {
+    for (size_t i = n - 1; i > 0; --i)
+        r[i] = (r[i] << bits) | (r[i - 1] >> (limb_bits - bits));
+    r[0] <<= bits;
+}
+
+/// r >>= 1
+inline void
+shift_right1(limb_t* r, size_t n) noexcept {
+    for (size_t i = 0; i + 1 < n; ++i)
+        r[i] = (r[i] >> 1) | (r[i + 1] << (limb_bits - 1));
+    r[n - 1] >>= 1;
+}
+
+/// r /= 3, r must be an exact multiple of 3 (modulo 2^(64n))
+inline void
+divide_exact3(limb_t* r, size_t n) noexcept {
+    const limb_t Inverse3 = 0xaaaaaaaaaaaaaaab; // 3^-1 mod 2^64
+    limb_t       borrow   = 0;
+    for (size_t i = 0; i < n; ++i) {
+        limb_t x = r[i] - borrow;
+        limb_t o = r[i] < borrow;
+        limb_t q = x * Inverse3;
+        r[i]     = q;
+        // q * 3 = x + high * 2^64, high in [0, 2]
+        borrow = o + (q >= 0x5555555555555556) + (q >= 0xaaaaaaaaaaaaaaab);
+    }
+}
+
+/// r = mask ? a : r, mask is all ones or zero
+inline void
+select(limb_t* r, const limb_t* a, limb_t mask, size_t n) noexcept {
+    for (size_t i = 0; i < n; ++i)
+        r[i] = (a[i] & mask) | (r[i] & ~mask);
+}
+
+/// all ones if a == b, zero otherwise, in constant time
+inline limb_t
+equal_mask(limb_t a, limb_t b) noexcept {
+    limb_t x = a ^ b;
+    return ((x | (0 - x)) >> (limb_bits - 1)) - 1;
+}
+
+//-----------------------------------------------------------------------------
+// products, r has 2n limbs and does not alias a or b, w is the scratch.
+// squares are detected by a == b.
+
+/// the 3 limbs accumulator of a column of products (product scanning)
+struct column {
+#if defined(__SIZEOF_INT128__)
+    dlimb_t acc = 0;
+    limb_t  top = 0;
+
+    void add(limb_t a, limb_t b) noexcept {
+        dlimb_t p = static_cast<dlimb_t>(a) * b;
+        acc += p;
+        top += acc < p;
+    }
+
+    void add(limb_t a) noexcept {
+        acc += a;
+        top += acc < a;
+    }
+
+    void add(const column& o) noexcept {
+        acc += o.acc;
+        top += o.top + (acc < o.acc);
+    }
+
+    void twice() noexcept {
+        top = (top << 1) | static_cast<limb_t>(acc >> (2 * limb_bits - 1));
+        acc <<= 1;
+    }
+
+    limb_t low() const noexcept {
+        return static_cast<limb_t>(acc);
+    }
+
+    /// returns the low limb and moves to the next column
+    limb_t shift() noexcept {
+        limb_t low = static_cast<limb_t>(acc);
+        acc = (acc >> limb_bits) | (static_cast<dlimb_t>(top) << limb_bits);
+        top = 0;
+        return low;
+    }
+#else  // __SIZEOF_INT128__
+    limb_t c0 = 0, c1 = 0, c2 = 0;
+
+    void add(limb_t a, limb_t b) noexcept {
+        limb_t hi = 0;
+        limb_t lo = mac(a, b, 0, hi);
+        c0 += lo;
+        hi += c0 < lo; // hi < 2^64 - 1
+        c1 += hi;
+        c2 += c1 < hi;
+    }
+
+    void add(limb_t a) noexcept {
+        c0 += a;
+        limb_t k = c0 < a;
+        c1 += k;
+        c2 += c1 < k;
+    }
+
+    void add(const column& o) noexcept {
+        add(o.c0);
+        c1 += o.c1;
+        c2 += o.c2 + (c1 < o.c1);
+    }
+
+    void twice() noexcept {
+        c2 = (c2 << 1) | (c1 >> (limb_bits - 1));
+        c1 = (c1 << 1) | (c0 >> (limb_bits - 1));
+        c0 <<= 1;
+    }
+
+    limb_t low() const noexcept {
+        return c0;
+    }
+
+    limb_t shift() noexcept {
+        limb_t low = c0;
+        c0         = c1;
+        c1         = c2;
+        c2         = 0;
+        return low;
+    }
+#endif // __SIZEOF_INT128__
+}; // struct column
+
+/// r = a * b by columns
+void
+mul_basecase(limb_t* r, const limb_t* a, const limb_t* b, size_t n) noexcept {
+    column c;
+    for (size_t k = 0; k + 1 < 2 * n; ++k) {
+        const size_t last = std::min(k, n - 1);
+        for (size_t i = k < n ? 0 : k - n + 1; i <= last; ++i)
+            c.add(a[i], b[k - i]);
+        r[k] = c.shift();
+    }
+    r[2 * n - 1] = c.shift();
+}
+
+/// r = a * a, the cross products of a column are computed once and doubled
+void
+sqr_basecase(limb_t* r, const limb_t* a, size_t n) noexcept {
+    column c;
+    for (size_t k = 0; k + 1 < 2 * n; ++k) {
+        column cross;
+        for (size_t i = k < n ? 0 : k - n + 1; i < k - i; ++i)
+            cross.add(a[i], a[k - i]);
+        cross.twice();
+        if ((k & 1) == 0)
+            cross.add(a[k / 2], a[k / 2]);
+        c.add(cross);
+        r[k] = c.shift();
+    }
+    r[2 * n - 1] = c.shift();
+}
+
+/** r = t / R mod m (Montgomery reduction by columns), t: 2n limbs and less
+ * than m * R, q: n limbs of scratch.
+ */
+void
+redc_basecase(
+    limb_t*       r,
+    const limb_t* t,
+    const limb_t* m,
+    size_t        n,
+    limb_t        m0_inv,
+    limb_t*       q) noexcept {
+    column c;
+    for (size_t k = 0; k < n; ++k) {
+        c.add(t[k]);
+        for (size_t i = 0; i < k; ++i)
+            c.add(q[i], m[k - i]);
+        q[k] = c.low() * m0_inv;
+        c.add(q[k], m[0]);
+        c.shift(); // zero by definition of q[k]
+    }
+    for (size_t k = n; k < 2 * n; ++k) {
+        c.add(t[k]);
+        for (size_t i = k - n + 1; i < n; ++i)
+            c.add(q[i], m[k - i]);
+        r[k - n] = c.shift();
+    }
+
+    // r < 2m, subtracts m if r >= m
+    const limb_t top    = c.shift();
+    const limb_t borrow = sub_n(q, r, m, n);
+    select(r, q, 0 - (top | (borrow ^ 1)), n);
+}
+
+void
+product(
+    limb_t*,
+    const limb_t*,
+    const limb_t*,
+    size_t,
+    limb_t*,
+    const mul_crossover&) noexcept;
+
+/** Karatsuba, by a = a0 + a1 X, b = b0 + b1 X:
+ *  a * b = a0 b0 + (a0 b0 + a1 b1 - (a0 - a1)(b0 - b1)) X + a1 b1 X^2
+ * the signs of the differences are applied by masks.
+ */
+void
+mul_karatsuba(
+    limb_t*              r,
+    const limb_t*        a,
+    const limb_t*        b,
+    size_t               n,
+    limb_t*              w,
+    const mul_crossover& x) noexcept {
+    const bool   square = a == b;
+    const size_t h      = (n + 1) / 2;
+    const size_t l      = n - h;
+    limb_t*      da     = w;
+    limb_t*      db     = da + h;
+    limb_t*      p      = db + h;
+    limb_t*      t      = p + 2 * h;
+    limb_t*      next   = t + 2 * h + 1;
+
+    const limb_t sa = abs_diff(da, a, h, a + h, l);
+    const limb_t sb = square ? sa : abs_diff(db, b, h, b + h, l);
+    if (square)
+        db = da;
+
+    product(r, a, square ? a : b, h, next, x);                  // a0 b0
+    product(r + 2 * h, a + h, square ? a + h : b + h, l, next, x); // a1 b1
+    product(p, da, db, h, next, x);
+
+    // t = a0 b0 + a1 b1 -/+ p in a single pass, p is subtracted as ~p + 1
+    const limb_t  mask  = ~(sa ^ sb);
+    const limb_t* lo    = r;
+    const limb_t* hi    = r + 2 * h;
+    limb_t        carry = 0, pcarry = mask & 1;
+    for (size_t i = 0; i < 2 * h; ++i) {
+        limb_t s = lo[i] + carry;
+        carry    = s < carry;
+        if (i < 2 * l) {
+            s += hi[i];
+            carry += s < hi[i];
+        }
+        limb_t q = (p[i] ^ mask) + pcarry;
+        pcarry   = q < pcarry;
+        t[i]     = s + q;
+        pcarry += t[i] < q;
+    }
+    t[2 * h] = carry + pcarry + mask; // 0 or 1, the sign extension of ~p
+
+    add_into(r + h, 2 * n - h, t, std::min(2 * h + 1, 2 * n - h));
+}
+
+/** Toom-3, by a = a0 + a1 X + a2 X^2: evaluates at 0, 1, -1, 2 and infinity
+ * and interpolates (exact divisions by 2 and 3) in two's complement.
+ */
+void
+mul_toom3(
+    limb_t*              r,
+    const limb_t*        a,
+    const limb_t*        b,
+    size_t               n,
+    limb_t*              w,
+    const mul_crossover& x) noexcept {
+    const bool   square = a == b;
+    const size_t k      = (n + 2) / 3;
+    const size_t l      = n - 2 * k;
+    const size_t wide   = 2 * k + 2;
+    limb_t*      a1     = w; // a(1), |a(-1)|, a(2) of k + 1 limbs
+    limb_t*      am     = a1 + (k + 1);
+    limb_t*      a2     = am + (k + 1);
+    limb_t*      b1     = a2 + (k + 1);
+    limb_t*      bm     = b1 + (k + 1);
+    limb_t*      b2     = bm + (k + 1);
+    limb_t*      w1     = b2 + (k + 1);
+    limb_t*      wm     = w1 + wide;
+    limb_t*      w2     = wm + wide;
+    limb_t*      r2     = w2 + wide;
+    limb_t*      next   = r2 + wide;
+
+    auto evaluate = [k, l](
+                        const limb_t* v,
+                        limb_t*       v1,
+                        limb_t*       vm,
+                        limb_t*       v2) -> limb_t {
+        // v1 = v0 + v2, vm = |v0 + v2 - v1|, v1 += v1
+        std::copy(v, v + k, v1);
+        v1[k] = 0;
+        add_into(v1, k + 1, v + 2 * k, l);
+        const limb_t mask = abs_diff(vm, v1, k + 1, v + k, k);
+        add_into(v1, k + 1, v + k, k);
+        // v2 = v0 + 2 (v1 + 2 v2)
+        std::fill(v2, v2 + k + 1, 0);
+        std::copy(v + 2 * k, v + 2 * k + l, v2);
+        shift_left(v2, k + 1, 1);
+        add_into(v2, k + 1, v + k, k);
+        shift_left(v2, k + 1, 1);
+        add_into(v2, k + 1, v, k);
+        return mask;
+    };
+
+    const limb_t sa = evaluate(a, a1, am, a2);
+    const limb_t sb = square ? sa : evaluate(b, b1, bm, b2);
+    if (square) {
+        b1 = a1;
+        bm = am;
+        b2 = a2;
+    }
+
+    product(r, a, square ? a : b, k, next, x); // r0
+    product(r + 4 * k, a + 2 * k, square ? a + 2 * k : b + 2 * k, l, next, x);
+    std::fill(r + 2 * k, r + 4 * k, 0);
+    product(w1, a1, b1, k + 1, next, x);
+    product(wm, am, bm, k + 1, next, x);
+    product(w2, a2, b2, k + 1, next, x);
+    negate_if(wm, wide, sa ^ sb);
+
+    // r2 = (w(1) + w(-1)) / 2 - r0 - r4
+    std::copy(w1, w1 + wide, r2);
+    add_into(r2, wide, wm, wide);
+    shift_right1(r2, wide);
+    sub_from(r2, wide, r, 2 * k);
+    sub_from(r2, wide, r + 4 * k, 2 * l);
+    // w1 = (w(1) - w(-1)) / 2 = r1 + r3
+    sub_from(w1, wide, wm, wide);
+    shift_right1(w1, wide);
+    // w2 = (w(2) - r0 - 4 r2 - 16 r4) / 2 = r1 + 4 r3
+    sub_from(w2, wide, r, 2 * k);
+    std::copy(r2, r2 + wide, wm);
+    shift_left(wm, wide, 2);
+    sub_from(w2, wide, wm, wide);
+    std::fill(wm, wm + wide, 0);
+    std::copy(r + 4 * k, r + 4 * k + 2 * l, wm);
+    shift_left(wm, wide, 4);
+    sub_from(w2, wide, wm, wide);
+    shift_right1(w2, wide);
+    // r3 = (w2 - w1) / 3, r1 = w1 - r3
+    sub_from(w2, wide, w1, wide);
+    divide_exact3(w2, wide);
+    sub_from(w1, wide, w2, wide);
+
+    const size_t rn = 2 * n;
+    add_into(r + k, rn - k, w1, std::min(wide, rn - k));
+    add_into(r + 2 * k, rn - 2 * k, r2, std::min(wide, rn - 2 * k));
+    add_into(r + 3 * k, rn - 3 * k, w2, std::min(wide, rn - 3 * k));
+}
+
+void
+product(
+    limb_t*              r,
+    const limb_t*        a,
+    const limb_t*        b,
+    size_t               n,
+    limb_t*              w,
+    const mul_crossover& x) noexcept {
+    if (n >= x.toom3)
+        mul_toom3(r, a, b, n, w, x);
+    else if (n >= x.karatsuba)
+        mul_karatsuba(r, a, b, n, w, x);
+    else if (a == b)
+        sqr_basecase(r, a, n);
+    else
+        mul_basecase(r, a, b, n);
+}
+
+/// reads a big-endian number into n limbs, throws if it does not fit
+void
+read_be(limb_t* x, size_t n, buffer_view_t src) {
+    std::fill(x, x + n, 0);
+    const auto* p = src.data();
+    for (size_t k = 0; k < src.size(); ++k) {
+        limb_t byte = p[src.size() - 1 - k];
+        if (k >= n * limb_bytes) {
+            if (byte != 0)
+                throw exceptions::usage_error{"number is larger than modulus"};
+            continue;
+        }
+        x[k / limb_bytes] |= byte << (8 * (k % limb_bytes));
+    }
+}
+
+/// r = r * 2^times mod m by modular doublings, r < m
+void
+double_mod(limb_t* r, const limb_t* m, size_t n, size_t times) noexcept {
+    limb_t d[max_limbs];
+    for (size_t i = 0; i < times; ++i) {
+        limb_t carry = r[n - 1] >> (limb_bits - 1);
+        shift_left(r, n, 1);
+        limb_t borrow = sub_n(d, r, m, n);
+        select(r, d, 0 - (carry | (borrow ^ 1)), n);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// micro-benchmarks of the crossovers
+
+using clock_type = std::chrono::steady_clock;
+
+/** the best time of 5 squares and a product of n limbs by x (as in the
+ * windows of an exponentiation), in seconds.
+ */
+double
+product_time(size_t n, const mul_crossover& x) {
+    std::vector<limb_t> v(4 * n + work_limbs);
+    limb_t              seed = 0x9e3779b97f4a7c15;
+    for (auto& l : v) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        l = seed;
+    }
+    limb_t* a = v.data();
+    limb_t* b = a + n;
+    limb_t* r = b + n;
+
+    const size_t loops = std::max<size_t>(1, 40000 / (n * n));
+    double       best  = 1e9;
+    for (int round = 0; round < 5; ++round) {
+        auto start = clock_type::now();
+        for (size_t i = 0; i < loops; ++i) {
+            for (int s = 0; s < 5; ++s) {
+                product(r, a, a, n, r + 2 * n, x);
+                a[0] ^= r[n];
+            }
+            product(r, a, b, n, r + 2 * n, x);
+            a[0] ^= r[n];
+        }
+        const std::chrono::duration<double> elapsed =
+            clock_type::now() - start;
+        best = std::min(best, elapsed.count() / loops);
+    }
+    return best;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+mont_modulus::mont_modulus(buffer_view_t modulus, const mul_crossover& x)
+    : crossover_{x} {
+    const auto* p   = modulus.data();
+    size_t      len = modulus.size();
+    while (len > 0 && *p == 0) { // skips the leading zeros
+        ++p;
+        --len;
+    }
+
+    if (len == 0 || (p[len - 1] & 1) == 0 || (len == 1 && p[0] == 1))
+        throw exceptions::usage_error{"modulus must be odd and greater than 1"};
+    if (len > max_limbs * limb_bytes)
+        throw exceptions::usage_error{"modulus is too large"};
+
+    size_       = len;
+    const auto n = (len + limb_bytes - 1) / limb_bytes;
+    n_.resize(n);
+    read_be(n_.data(), n, buffer_view_t{p, len});
+
+    // Newton iteration, each step doubles the correct low bits
+    limb_t inv = n_[0];
+    for (int i = 0; i < 6; ++i)
+        inv *= 2 - n_[0] * inv;
+    n0_inv_ = 0 - inv;
+
+    // R and R^2 by doublings, R^3 = R^2 * R^2 / R
+    one_.assign(n, 0);
+    one_[0] = 1;
+    double_mod(one_.data(), n_.data(), n, n * limb_bits);
+    rr_ = one_;
+    double_mod(rr_.data(), n_.data(), n, n * limb_bits);
+    rrr_.resize(n);
+    mul(rrr_.data(), rr_.data(), rr_.data());
+}
+
+void
+mont_modulus::mul(limb_t* r, const limb_t* a, const limb_t* b) const noexcept {
+    // the product by columns, Karatsuba or Toom-3, then the reduction
+    const size_t n = limbs();
+    limb_t       t[2 * max_limbs];
+    limb_t       q[max_limbs];
+    limb_t       w[work_limbs];
+    product(t, a, b, n, w, crossover_);
+    redc_basecase(r, t, n_.data(), n, n0_inv_, q);
+}
+
+void
+mont_modulus::add(limb_t* r, const limb_t* a, const limb_t* b) const noexcept {
+    const size_t n = limbs();
+    limb_t       d[max_limbs];
+    limb_t       carry  = add_n(r, a, b, n);
+    limb_t       borrow = sub_n(d, r, n_.data(), n);
+    select(r, d, 0 - (carry | (borrow ^ 1)), n);
+}
+
+void
+mont_modulus::sub(limb_t* r, const limb_t* a, const limb_t* b) const noexcept {
+    const size_t n = limbs();
+    limb_t       d[max_limbs];
+    limb_t       borrow = sub_n(r, a, b, n);
+    add_n(d, r, n_.data(), n);
+    select(r, d, 0 - borrow, n);
+}
+
+void
+mont_modulus::to_mont(limb_t* r, buffer_view_t a) const {
+    const size_t n = limbs();
+    read_be(r, n, a);
+
+    limb_t d[max_limbs];
+    if (sub_n(d, r, n_.data(), n) == 0)
+        throw exceptions::usage_error{"number is larger than modulus"};
+
+    mul(r, r, rr_.data());
+}
+
+void
+mont_modulus::reduce(limb_t* r, buffer_view_t a) const {
+    const size_t  n = limbs();
+    const limb_t* m = n_.data();
+    limb_t        t[2 * max_limbs];
+    read_be(t, 2 * n, a);
+
+    limb_t d[max_limbs];
+    if (sub_n(d, t + n, m, n) == 0)
+        throw exceptions::usage_error{"number is larger than modulus * R"};
+
+    // t / R, then * R^3 / R
+    redc_basecase(t, t, m, n, n0_inv_, d);
+    mul(r, t, rrr_.data());
+    mbedtls_platform_zeroize(t, 2 * n * limb_bytes);
+}
+
+void
+mont_modulus::from_mont(uint8_t* out, const limb_t* a) const noexcept {
+    const size_t n = limbs();
+
+    limb_t unit[max_limbs] = {1};
+    std::fill(unit + 1, unit + n, 0);
+
+    limb_t x[max_limbs];
+    mul(x, a, unit);
+    for (size_t k = 0; k < size_; ++k)
+        out[size_ - 1 - k] =
+            static_cast<uint8_t>(x[k / limb_bytes] >> (8 * (k % limb_bytes)));
+
+    mbedtls_platform_zeroize(x, n * limb_bytes);
+}
+
+void
+mont_modulus::power(limb_t* r, const limb_t* a, buffer_view_t exponent) const {
+    const size_t n     = limbs();
+    const auto*  e     = exponent.data();
+    const size_t ebits = exponent.size() * 8;
+    const size_t wbits = ebits > 768 ? 5 : 4;
+    const size_t count = size_t{1} << wbits;
+
+    // a^0 ... a^(2^wbits - 1)
+    std::vector<limb_t> table(count * n);
+    std::copy(one(), one() + n, table.begin());
+    std::copy(a, a + n, table.begin() + n);
+    for (size_t j = 2; j < count; ++j)
+        mul(&table[j * n], &table[(j - 1) * n], a);
+
+    auto digit_of = [e, ebits, wbits](size_t i) -> limb_t {
+        limb_t d = 0;
+        for (size_t b = i * wbits + wbits; b-- > i * wbits;) {
+            const limb_t bit =
+                b < ebits ? (e[(ebits - 1 - b) / 8] >> (b % 8)) & 1 : 0;
+            d = (d << 1) | bit;
+        }
+        return d;
+    };
+
+    limb_t       acc[max_limbs];
+    limb_t       sel[max_limbs];
+    const size_t windows = (ebits + wbits - 1) / wbits;
+    std::copy(one(), one() + n, acc);
+    for (size_t i = windows; i-- > 0;) {
+        if (i + 1 < windows) {
+            for (size_t s = 0; s < wbits; ++s)
+                mul(acc, acc, acc);
+        }
+
+        // constant time lookup, touches all the entries
+        const limb_t d = digit_of(i);
+        std::fill(sel, sel + n, 0);
+        for (size_t j = 0; j < count; ++j)
+            select(sel, &table[j * n], equal_mask(j, d), n);
+        mul(acc, acc, sel);
+    }
+
+    std::copy(acc, acc + n, r);
+    mbedtls_platform_zeroize(acc, n * limb_bytes);
+    mbedtls_platform_zeroize(sel, n * limb_bytes);
+    mbedtls_platform_zeroize(table.data(), table.size() * limb_bytes);
+}
+
+//-----------------------------------------------------------------------------
+
+mul_crossover
+measure_mul_crossover() {
+    // a level must win by a margin, the timings of a busy host are noisy
+    const size_t  Never  = max_limbs + 1;
+    const double  Margin = 0.97;
+    mul_crossover x;
+    x.karatsuba = Never;
+    x.toom3     = Never;
+
+    // the first size where one Karatsuba level beats the schoolbook
+    for (size_t n : {16, 24, 32, 48, 64, 96, 128, 192, 256}) {
+        const double basecase = product_time(n, mul_crossover{Never, Never});
+        const double one_step = product_time(n, mul_crossover{n, Never});
+        if (one_step < basecase * Margin) {
+            x.karatsuba = n;
+            break;
+        }
+    }
+    if (x.karatsuba == Never)
+        return x;
+
+    // the first size where one Toom-3 level beats Karatsuba
+    for (size_t n : {64, 96, 128, 192, 256}) {
+        if (n < x.karatsuba * 2)
+            continue;
+        const double karatsuba =
+            product_time(n, mul_crossover{x.karatsuba, Never});
+        const double one_step = product_time(n, mul_crossover{x.karatsuba, n});
+        if (one_step < karatsuba * Margin) {
+            x.toom3 = n;
+            break;
+        }
+    }
+    return x;
+}
+
+mul_crossover
+tuned_crossover() {
+    const auto    t = tuning::current();
+    mul_crossover x;
+    x.karatsuba = t.karatsuba_limbs;
+    x.toom3     = t.toom3_limbs;
+    return x;
+}
+
+//-----------------------------------------------------------------------------
+
+fixed_base_table::fixed_base_table(
+    buffer_view_t        modulus,
+    buffer_view_t        base,
+    size_t               exponent_bits,
+    const mul_crossover& x)
+    : mod_{modulus, x},
+      windows_{(exponent_bits + window_bits - 1) / window_bits} {
+    if (windows_ == 0)
+        throw exceptions::usage_error{"invalid exponent size"};
+
+    const size_t n = mod_.limbs();
+    table_.resize(windows_ * window_size * n);
+
+    // g = base ^ (2 ^ (4i)) for window i
+    std::vector<limb_t> g(n);
+    mod_.to_mont(g.data(), base);
+
+    for (size_t i = 0; i < windows_; ++i) {
+        auto* row = table_.data() + i * window_size * n;
+        std::copy(mod_.one(), mod_.one() + n, row);
+        std::copy(g.begin(), g.end(), row + n);
+        for (size_t j = 2; j < window_size; ++j)
+            mod_.mul(row + j * n, row + (j - 1) * n, g.data());
+
+        mod_.mul(g.data(), row + (window_size - 1) * n, g.data());
+    }
+}
+
+void
+fixed_base_table::power(uint8_t* out, buffer_view_t exponent) const {
+    const auto*  e     = exponent.data();
+    const size_t esize = exponent.size();
+
+    auto digit_of = [e, esize](size_t i) -> limb_t {
+        if (i / 2 >= esize)
+            return 0;
+        return (e[esize - 1 - i / 2] >> ((i & 1) * window_bits)) & 0x0f;
+    };
+
+    limb_t excess = 0;
+    for (size_t i = windows_; i < esize * 2; ++i)
+        excess |= digit_of(i);
+    if (excess != 0)
+        throw exceptions::usage_error{"exponent is larger than the table"};
+
+    const size_t n = mod_.limbs();
+    limb_t       acc[max_limbs];
+    limb_t       sel[max_limbs];
+
+    for (size_t i = 0; i < windows_; ++i) {
+        // constant time lookup, touches all the entries of the window
+        const limb_t d   = digit_of(i);
+        const auto*  row = table_.data() + i * window_size * n;
+        std::fill(sel, sel + n, 0);
+        for (size_t j = 0; j < window_size; ++j)
+            select(sel, row + j * n, equal_mask(j, d), n);
+
+        if (i == 0)
+            std::copy(sel, sel + n, acc);
+        else
+            mod_.mul(acc, acc, sel);
+    }
+
+    mod_.from_mont(out, acc);
+    mbedtls_platform_zeroize(acc, n * limb_bytes);
+    mbedtls_platform_zeroize(sel, n * limb_bytes);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
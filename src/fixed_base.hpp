@@ -0,0 +1,160 @@
+/** @file fixed_base.hpp
+ * Montgomery arithmetic of large moduli and modular exponentiation of a
+ * fixed base by a precomputed window table.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_FIXED_BASE_HPP
+#define MBEDCRYPTO_FIXED_BASE_HPP
+
+#include "mbedcrypto/exception.hpp"
+
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** the limb counts from which the products of mont_modulus switch from the
+ * schoolbook (quadratic) method to Karatsuba and then to Toom-3.
+ * the defaults are overridden by the tuned values of tuning::current().
+ */
+struct mul_crossover {
+    size_t karatsuba = 64;
+    size_t toom3     = 256;
+};
+
+/** Montgomery arithmetic over an odd modulus, in 64bit limbs.
+ * numbers are little-endian arrays of limbs(), all in [0, modulus).
+ *
+ * a multiplication is a product then a Montgomery reduction, both by
+ * columns (product scanning). above the crossovers the product is by
+ * Karatsuba or Toom-3, so the products of large moduli (ex: the primes of
+ * 8192bit and larger RSA keys) cost about n^1.58 limb products instead of
+ * n^2. the squares are detected (a == b) and cost about half. all the paths
+ * are branch-free on the values.
+ */
+class mont_modulus
+{
+public:
+    using limb_t = uint64_t;
+
+    /// modulus: big-endian, must be odd and greater than 1
+    explicit mont_modulus(
+        buffer_view_t modulus, const mul_crossover& = mul_crossover{});
+
+    size_t limbs() const noexcept {
+        return n_.size();
+    }
+
+    /// size of the modulus in bytes
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    /// r = a * b / R mod n, r may alias a or b
+    void mul(limb_t* r, const limb_t* a, const limb_t* b) const noexcept;
+
+    /// r = a + b mod n, r may alias a or b
+    void add(limb_t* r, const limb_t* a, const limb_t* b) const noexcept;
+
+    /// r = a - b mod n, r may alias a or b
+    void sub(limb_t* r, const limb_t* a, const limb_t* b) const noexcept;
+
+    /// r = a * R mod n, a: big-endian, shorter than size()
+    void to_mont(limb_t* r, buffer_view_t a) const;
+
+    /** r = a * R mod n, a: big-endian, less than n * R (ex: a number twice
+     * the size of the modulus, as a RSA message modulo a prime)
+     */
+    void reduce(limb_t* r, buffer_view_t a) const;
+
+    /// out = a / R mod n, out: big-endian of size() bytes
+    void from_mont(uint8_t* out, const limb_t* a) const noexcept;
+
+    /** r = a ^ exponent, a and r in Montgomery form, r may alias a.
+     * exponent: big-endian. fixed windows, the table entries are selected in
+     * constant time, so the timing depends only on the exponent size.
+     */
+    void power(limb_t* r, const limb_t* a, buffer_view_t exponent) const;
+
+    /// 1 in Montgomery form (R mod n)
+    const limb_t* one() const noexcept {
+        return one_.data();
+    }
+
+protected:
+    std::vector<limb_t> n_;
+    std::vector<limb_t> one_;
+    std::vector<limb_t> rr_;  ///< R^2 mod n
+    std::vector<limb_t> rrr_; ///< R^3 mod n
+    limb_t              n0_inv_ = 0; ///< -n^-1 mod 2^64
+    size_t              size_   = 0;
+    mul_crossover       crossover_;
+}; // class mont_modulus
+
+/** finds the Karatsuba and Toom-3 crossovers of this host by timing the
+ * products (takes a few milliseconds). a crossover larger than the largest
+ * modulus (16384bit) means never.
+ * @sa tuning::thresholds
+ */
+mul_crossover
+measure_mul_crossover();
+
+/// the crossovers of tuning::current()
+mul_crossover
+tuned_crossover();
+
+//-----------------------------------------------------------------------------
+
+/** precomputed powers of a fixed base (ex: the generator of a DH group) for
+ * exponents up to exponent_bits().
+ * the table holds base^(j * 2^(4i)) for every 4bit window i and digit j, so
+ * an exponentiation needs only exponent_bits()/4 Montgomery multiplications
+ * and no squaring. the table entries are selected in constant time.
+ * the table is immutable after construction and safe to share between
+ * threads.
+ */
+class fixed_base_table
+{
+public:
+    enum { window_bits = 4, window_size = 1 << window_bits };
+
+    /// modulus, base: big-endian
+    explicit fixed_base_table(
+        buffer_view_t        modulus,
+        buffer_view_t        base,
+        size_t               exponent_bits,
+        const mul_crossover& = mul_crossover{});
+
+    size_t exponent_bits() const noexcept {
+        return windows_ * window_bits;
+    }
+
+    /// size of the modulus (and the results) in bytes
+    size_t size() const noexcept {
+        return mod_.size();
+    }
+
+    /// memory footprint of the table in bytes
+    size_t memory() const noexcept {
+        return table_.size() * sizeof(mont_modulus::limb_t);
+    }
+
+    /** out = base ^ exponent mod modulus.
+     * exponent: big-endian, at most exponent_bits() bits.
+     * out: big-endian of size() bytes.
+     */
+    void power(uint8_t* out, buffer_view_t exponent) const;
+
+protected:
+    mont_modulus                      mod_;
+    size_t                            windows_ = 0;
+    std::vector<mont_modulus::limb_t> table_; ///< windows_ * window_size
+}; // class fixed_base_table
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_FIXED_BASE_HPP
@@ -0,0 +1,225 @@
+#include "./fs_utils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace fs {
+//-----------------------------------------------------------------------------
+namespace {
+//-----------------------------------------------------------------------------
+
+struct file_closer {
+    void operator()(std::FILE* fp) const {
+        std::fclose(fp);
+    }
+};
+
+std::string
+join(const char* dir, const char* name) {
+    std::string path{dir};
+    if (!path.empty() && path.back() != '/' && path.back() != '\\')
+        path.push_back('/');
+    return path.append(name);
+}
+
+void
+walk(const std::string& dir, std::vector<std::string>& files, bool top) {
+#if defined(_WIN32)
+    WIN32_FIND_DATAA fd;
+    auto   pattern = join(dir.c_str(), "*");
+    HANDLE h       = FindFirstFileA(pattern.c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE) {
+        if (top)
+            throw exceptions::usage_error{"failed to open the directory"};
+        return;
+    }
+
+    do {
+        if (fd.cFileName[0] == '.')
+            continue;
+        auto path = join(dir.c_str(), fd.cFileName);
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            walk(path, files, false);
+        else
+            files.emplace_back(std::move(path));
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+
+#else  // _WIN32
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr) {
+        if (top)
+            throw exceptions::usage_error{"failed to open the directory"};
+        return;
+    }
+
+    std::vector<std::string> dirs;
+    while (const auto* entry = readdir(d)) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        auto        path = join(dir.c_str(), entry->d_name);
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0)
+            continue;
+        if (S_ISREG(st.st_mode))
+            files.emplace_back(std::move(path));
+        else if (S_ISDIR(st.st_mode))
+            dirs.emplace_back(std::move(path));
+    }
+    closedir(d);
+
+    for (const auto& sub : dirs)
+        walk(sub, files, false);
+#endif // _WIN32
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+std::vector<std::string>
+list_files(const char* dir_path) {
+    std::vector<std::string> files;
+
+#if defined(_WIN32)
+    WIN32_FIND_DATAA fd;
+    auto   pattern = join(dir_path, "*");
+    HANDLE h       = FindFirstFileA(pattern.c_str(), &fd);
+    if (h == INVALID_HANDLE_VALUE)
+        throw exceptions::usage_error{"failed to open the directory"};
+
+    do {
+        if (fd.cFileName[0] == '.')
+            continue;
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+            continue;
+        files.emplace_back(join(dir_path, fd.cFileName));
+    } while (FindNextFileA(h, &fd));
+    FindClose(h);
+
+#else  // _WIN32
+    DIR* dir = opendir(dir_path);
+    if (dir == nullptr)
+        throw exceptions::usage_error{"failed to open the directory"};
+
+    while (const auto* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.')
+            continue;
+
+        auto        path = join(dir_path, entry->d_name);
+        struct stat st;
+        if (stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode))
+            files.emplace_back(std::move(path));
+    }
+    closedir(dir);
+#endif // _WIN32
+
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+std::vector<std::string>
+list_tree(const char* dir_path) {
+    std::vector<std::string> files;
+    walk(dir_path, files, true);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+buffer_t
+read_file(const char* file_path) {
+    std::unique_ptr<std::FILE, file_closer> fp{std::fopen(file_path, "rb")};
+    if (!fp)
+        throw exceptions::usage_error{"failed to open the file"};
+
+    buffer_t content;
+    auto     size = file_size(file_path);
+    if (size > 0)
+        content.reserve(static_cast<size_t>(size));
+
+    char chunk[16 * 1024];
+    for (;;) {
+        auto n = std::fread(chunk, 1, sizeof(chunk), fp.get());
+        content.append(chunk, n);
+        if (n < sizeof(chunk))
+            break;
+    }
+
+    if (std::ferror(fp.get()))
+        throw exceptions::usage_error{"failed to read the file"};
+
+    return content;
+}
+
+void
+write_file(const char* file_path, buffer_view_t content) {
+    std::unique_ptr<std::FILE, file_closer> fp{std::fopen(file_path, "wb")};
+    if (!fp)
+        throw exceptions::usage_error{"failed to create the file"};
+
+    if (std::fwrite(content.data(), 1, content.size(), fp.get()) !=
+            content.size() ||
+        std::fflush(fp.get()) != 0)
+        throw exceptions::usage_error{"failed to write the file"};
+}
+
+int64_t
+file_size(const char* file_path) noexcept {
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA fad;
+    if (!GetFileAttributesExA(file_path, GetFileExInfoStandard, &fad))
+        return -1;
+    return (static_cast<int64_t>(fad.nFileSizeHigh) << 32) | fad.nFileSizeLow;
+#else  // _WIN32
+    struct stat st;
+    if (stat(file_path, &st) != 0 || !S_ISREG(st.st_mode))
+        return -1;
+    return static_cast<int64_t>(st.st_size);
+#endif // _WIN32
+}
+
+//-----------------------------------------------------------------------------
+
+input_file::input_file(const char* file_path)
+    : fp_{std::fopen(file_path, "rb")} {
+    if (fp_ == nullptr)
+        throw exceptions::usage_error{"failed to open the file"};
+}
+
+input_file::~input_file() {
+    std::fclose(fp_);
+}
+
+void
+input_file::seek(int64_t offset) {
+#if defined(_WIN32)
+    int ret = _fseeki64(fp_, offset, SEEK_SET);
+#else  // _WIN32
+    int ret = fseeko(fp_, static_cast<off_t>(offset), SEEK_SET);
+#endif // _WIN32
+    if (ret != 0)
+        throw exceptions::usage_error{"failed to seek the file"};
+}
+
+size_t
+input_file::read(uint8_t* buffer, size_t size) {
+    auto n = std::fread(buffer, 1, size, fp_);
+    if (n < size && std::ferror(fp_))
+        throw exceptions::usage_error{"failed to read the file"};
+    return n;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace fs
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
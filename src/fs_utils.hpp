@@ -0,0 +1,70 @@
+/** @file fs_utils.hpp
+ * minimal, portable file system helpers used internally.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_FS_UTILS_HPP
+#define MBEDCRYPTO_FS_UTILS_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <cstdio>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace fs {
+//-----------------------------------------------------------------------------
+
+/** returns the full path of the regular files inside a directory (not
+ * recursive), sorted by name. hidden files (dot files) are skipped.
+ * throws if the directory can not be opened.
+ */
+std::vector<std::string>
+list_files(const char* dir_path);
+
+/** returns the full path of the regular files of a directory tree
+ * (recursive), sorted by path. hidden files and directories are skipped.
+ * throws if the top directory can not be opened.
+ */
+std::vector<std::string>
+list_tree(const char* dir_path);
+
+/// reads the whole content of a file, throws on error.
+buffer_t
+read_file(const char* file_path);
+
+/// writes (replaces) the whole content of a file, throws on error.
+void
+write_file(const char* file_path, buffer_view_t content);
+
+/// returns the size of a regular file, or -1 on error
+int64_t
+file_size(const char* file_path) noexcept;
+
+/// a read-only binary file, throws on error
+class input_file
+{
+public:
+    explicit input_file(const char* file_path);
+    ~input_file();
+
+    /// moves to an absolute offset from the beginning of the file
+    void seek(int64_t offset);
+
+    /// reads up to size bytes, returns 0 at the end of the file
+    size_t read(uint8_t* buffer, size_t size);
+
+public: // non-copyable
+    input_file(const input_file&) = delete;
+    input_file& operator=(const input_file&) = delete;
+
+protected:
+    std::FILE* fp_ = nullptr;
+}; // class input_file
+
+//-----------------------------------------------------------------------------
+} // namespace fs
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_FS_UTILS_HPP
@@ -0,0 +1,327 @@
+#include "mbedcrypto/gcm_key_store.hpp"
+#include "./conversions.hpp"
+
+#if defined(MBEDTLS_GCM_C)
+#include "./gcm_private.hpp"
+
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#endif // MBEDTLS_GCM_C
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+#if defined(MBEDTLS_GCM_C)
+namespace {
+//-----------------------------------------------------------------------------
+
+enum K {
+    shard_count = 16,
+    /// raw keys per chunk, the chunks never move so no stale copy is left
+    chunk_keys = 1024,
+    /// list + hash map nodes and the shared_ptr control block of an entry
+    bookkeeping = 96,
+};
+
+using gcm::check_inputs;
+using gcm::expanded_key;
+using gcm::max_tag;
+using gcm::min_tag;
+
+using entry_t = std::shared_ptr<const expanded_key>;
+
+/// a part of the LRU cache, by key_id % shard_count
+struct shard_t {
+    using list_t = std::list<std::pair<size_t, entry_t>>;
+
+    std::mutex                                   mutex;
+    list_t                                       lru; ///< most recent first
+    std::unordered_map<size_t, list_t::iterator> index;
+    size_t capacity   = 1;
+    size_t generation = 0; ///< changed by every replace()
+    size_t hits       = 0;
+    size_t misses     = 0;
+    size_t evictions  = 0;
+};
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct gcm_key_store::impl {
+    const size_t key_size_;
+    const size_t entry_size_;
+
+    mutable std::shared_timed_mutex keys_mutex_;
+    /// key_size_ bytes per key, chunk_keys keys per chunk
+    std::vector<std::unique_ptr<uint8_t[]>> chunks_;
+    size_t                                  count_ = 0;
+
+    mutable shard_t shards_[shard_count];
+
+    impl(size_t key_bitlen, size_t memory_budget)
+        : key_size_{key_bitlen / 8},
+          entry_size_{sizeof(expanded_key) + bookkeeping +
+                      (ghash_key::supports_clmul() ? 0 : 256)} {
+        if (key_bitlen != 128 && key_bitlen != 192 && key_bitlen != 256)
+            throw exceptions::usage_error{"invalid aes key size"};
+
+        const size_t capacity = memory_budget / entry_size_ / shard_count;
+        for (auto& s : shards_)
+            s.capacity = std::max<size_t>(1, capacity);
+    }
+
+    ~impl() {
+        for (auto& c : chunks_)
+            mbedtls_platform_zeroize(c.get(), chunk_keys * key_size_);
+    }
+
+    /// the raw key of a valid id, keys_mutex_ must be held
+    uint8_t* raw_key(key_id id) const noexcept {
+        return chunks_[id / chunk_keys].get() + (id % chunk_keys) * key_size_;
+    }
+
+    void check_key(buffer_view_t key) const {
+        if (key.size() != key_size_)
+            throw exceptions::usage_error{"invalid aes key size"};
+    }
+
+    entry_t expanded(key_id id) const {
+        auto&  s          = shards_[id % shard_count];
+        size_t generation = 0;
+        {
+            std::lock_guard<std::mutex> lock(s.mutex);
+            auto it = s.index.find(id);
+            if (it != s.index.end()) {
+                ++s.hits;
+                s.lru.splice(s.lru.begin(), s.lru, it->second);
+                return it->second->second;
+            }
+            ++s.misses;
+            generation = s.generation;
+        }
+
+        // expands out of the locks
+        uint8_t raw[32];
+        {
+            std::shared_lock<std::shared_timed_mutex> lock(keys_mutex_);
+            if (id >= count_)
+                throw exceptions::usage_error{"invalid gcm key id"};
+            std::memcpy(raw, raw_key(id), key_size_);
+        }
+        entry_t entry;
+        try {
+            entry = std::make_shared<const expanded_key>(raw, key_size_ * 8);
+        } catch (...) {
+            mbedtls_platform_zeroize(raw, sizeof(raw));
+            throw;
+        }
+        mbedtls_platform_zeroize(raw, sizeof(raw));
+
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (generation != s.generation) // replaced meanwhile, do not cache
+            return entry;
+
+        auto it = s.index.find(id);
+        if (it != s.index.end()) // expanded by another thread
+            return it->second->second;
+
+        s.lru.emplace_front(id, entry);
+        s.index.emplace(id, s.lru.begin());
+        while (s.lru.size() > s.capacity) {
+            s.index.erase(s.lru.back().first);
+            s.lru.pop_back();
+            ++s.evictions;
+        }
+        return entry;
+    }
+}; // struct gcm_key_store::impl
+
+//-----------------------------------------------------------------------------
+
+gcm_key_store::gcm_key_store(size_t key_bitlen, size_t memory_budget)
+    : pimpl{std::make_unique<impl>(key_bitlen, memory_budget)} {}
+
+gcm_key_store::~gcm_key_store() = default;
+
+gcm_key_store::key_id
+gcm_key_store::add(buffer_view_t key) {
+    pimpl->check_key(key);
+
+    auto&                                     d = *pimpl;
+    std::unique_lock<std::shared_timed_mutex> lock(d.keys_mutex_);
+    const key_id id = d.count_;
+    if (id % chunk_keys == 0)
+        d.chunks_.emplace_back(new uint8_t[chunk_keys * d.key_size_]);
+    std::memcpy(d.raw_key(id), key.data(), key.size());
+    ++d.count_;
+    return id;
+}
+
+void
+gcm_key_store::replace(key_id id, buffer_view_t key) {
+    pimpl->check_key(key);
+
+    auto& d = *pimpl;
+    {
+        std::unique_lock<std::shared_timed_mutex> lock(d.keys_mutex_);
+        if (id >= d.count_)
+            throw exceptions::usage_error{"invalid gcm key id"};
+        std::memcpy(d.raw_key(id), key.data(), key.size());
+    }
+
+    auto&                       s = d.shards_[id % shard_count];
+    std::lock_guard<std::mutex> lock(s.mutex);
+    ++s.generation;
+    auto it = s.index.find(id);
+    if (it != s.index.end()) {
+        s.lru.erase(it->second);
+        s.index.erase(it);
+    }
+}
+
+size_t
+gcm_key_store::size() const {
+    std::shared_lock<std::shared_timed_mutex> lock(pimpl->keys_mutex_);
+    return pimpl->count_;
+}
+
+std::tuple<buffer_t, buffer_t>
+gcm_key_store::encrypt(
+    key_id        id,
+    buffer_view_t iv,
+    buffer_view_t ad,
+    buffer_view_t input) const {
+    check_inputs(iv, input);
+    auto key = pimpl->expanded(id);
+
+    uint8_t j0[16];
+    key->pre_counter(iv, j0);
+
+    buffer_t output(input.size(), '\0');
+    key->ctr(j0, input.data(), to_ptr(output), input.size());
+
+    buffer_t tag(max_tag, '\0');
+    key->tag(j0, ad, to_const_ptr(output), output.size(), to_ptr(tag));
+    return std::make_tuple(tag, output);
+}
+
+std::tuple<bool, buffer_t>
+gcm_key_store::decrypt(
+    key_id        id,
+    buffer_view_t iv,
+    buffer_view_t ad,
+    buffer_view_t tag,
+    buffer_view_t input) const {
+    check_inputs(iv, input);
+    if (tag.size() < min_tag || tag.size() > max_tag)
+        throw exceptions::usage_error{"invalid gcm tag size"};
+    auto key = pimpl->expanded(id);
+
+    uint8_t j0[16], computed[16];
+    key->pre_counter(iv, j0);
+    key->tag(j0, ad, input.data(), input.size(), computed);
+
+    if (!gcm::equal_tags(computed, tag))
+        return std::make_tuple(false, buffer_t{});
+
+    buffer_t output(input.size(), '\0');
+    key->ctr(j0, input.data(), to_ptr(output), input.size());
+    return std::make_tuple(true, output);
+}
+
+void
+gcm_key_store::clear_cache() {
+    for (auto& s : pimpl->shards_) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        s.index.clear();
+        s.lru.clear();
+    }
+}
+
+gcm_key_store::stats_t
+gcm_key_store::stats() const {
+    stats_t st;
+    st.keys = size();
+    for (auto& s : pimpl->shards_) {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        st.expanded += s.lru.size();
+        st.hits += s.hits;
+        st.misses += s.misses;
+        st.evictions += s.evictions;
+    }
+    st.memory = st.keys * pimpl->key_size_ + st.expanded * pimpl->entry_size_;
+    return st;
+}
+
+size_t
+gcm_key_store::expanded_key_size() const noexcept {
+    return pimpl->entry_size_;
+}
+
+bool
+gcm_key_store::uses_clmul() const noexcept {
+    return ghash_key::supports_clmul();
+}
+
+//-----------------------------------------------------------------------------
+#else  // MBEDTLS_GCM_C
+
+struct gcm_key_store::impl {};
+
+gcm_key_store::gcm_key_store(size_t, size_t) {
+    throw exceptions::gcm_error{};
+}
+
+gcm_key_store::~gcm_key_store() = default;
+
+gcm_key_store::key_id
+gcm_key_store::add(buffer_view_t) {
+    throw exceptions::gcm_error{};
+}
+
+void
+gcm_key_store::replace(key_id, buffer_view_t) {
+    throw exceptions::gcm_error{};
+}
+
+size_t
+gcm_key_store::size() const {
+    return 0;
+}
+
+std::tuple<buffer_t, buffer_t>
+gcm_key_store::encrypt(
+    key_id, buffer_view_t, buffer_view_t, buffer_view_t) const {
+    throw exceptions::gcm_error{};
+}
+
+std::tuple<bool, buffer_t>
+gcm_key_store::decrypt(
+    key_id, buffer_view_t, buffer_view_t, buffer_view_t, buffer_view_t) const {
+    throw exceptions::gcm_error{};
+}
+
+void
+gcm_key_store::clear_cache() {}
+
+gcm_key_store::stats_t
+gcm_key_store::stats() const {
+    return stats_t{};
+}
+
+size_t
+gcm_key_store::expanded_key_size() const noexcept {
+    return 0;
+}
+
+bool
+gcm_key_store::uses_clmul() const noexcept {
+    return false;
+}
+
+#endif // MBEDTLS_GCM_C
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,294 @@
+#include "mbedcrypto/gcm_parallel.hpp"
+#include "mbedcrypto/cipher.hpp"
+#include "./conversions.hpp"
+
+#if defined(MBEDTLS_GCM_C)
+#include "mbedcrypto/tuning.hpp"
+#include "./gcm_private.hpp"
+#include "./worker_pool.hpp"
+
+#include <array>
+#include <vector>
+#endif // MBEDTLS_GCM_C
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace gcm {
+//-----------------------------------------------------------------------------
+#if defined(MBEDTLS_GCM_C)
+namespace {
+//-----------------------------------------------------------------------------
+
+/// CTR and GHASH are interleaved by chunks, so GHASH reads from the L1
+constexpr size_t Chunk = 4096;
+
+using block_t = std::array<uint8_t, 16>;
+
+bool
+is_aes(cipher_t type) noexcept {
+    return type == cipher_t::aes_128_gcm || type == cipher_t::aes_192_gcm ||
+           type == cipher_t::aes_256_gcm;
+}
+
+#if defined(MBEDTLS_CAMELLIA_C)
+using camellia_key = basic_key<camellia_cipher>;
+
+bool
+is_camellia(cipher_t type) noexcept {
+    return type == cipher_t::camellia_128_gcm ||
+           type == cipher_t::camellia_192_gcm ||
+           type == cipher_t::camellia_256_gcm;
+}
+#endif // MBEDTLS_CAMELLIA_C
+
+/// out = a * b in GF(2^128), out may alias a or b
+void
+multiply(const uint8_t a[16], const uint8_t b[16], uint8_t out[16]) {
+    ghash_key k;
+    k.setup(b);
+    uint8_t y[16] = {0};
+    k.update(y, a, 16);
+    std::memcpy(out, y, 16);
+    mbedtls_platform_zeroize(y, sizeof(y));
+}
+
+/// out = h^n, n > 0
+void
+power(const uint8_t h[16], uint64_t n, uint8_t out[16]) {
+    int top = 63;
+    while ((n >> top) == 0)
+        --top;
+    std::memcpy(out, h, 16);
+    for (int i = top - 1; i >= 0; --i) {
+        multiply(out, out, out);
+        if ((n >> i) & 1)
+            multiply(out, h, out);
+    }
+}
+
+/** CTR and GHASH of size bytes by segments, writes the tag.
+ * the GHASH is over the output if encrypting, or over the input otherwise.
+ */
+template <class Key>
+void
+crypt(
+    const Key&     key,
+    const uint8_t  j0[16],
+    buffer_view_t  ad,
+    const uint8_t* input,
+    uint8_t*       output,
+    size_t         size,
+    bool           encrypting,
+    size_t         max_threads,
+    uint8_t        tag[16]) {
+    const auto   t       = tuning::current();
+    const size_t segment = std::max(t.segment_size / Chunk * Chunk, Chunk);
+    const size_t count   = (size + segment - 1) / segment;
+
+    std::vector<block_t> partial(count, block_t{});
+
+    auto fn = [&](size_t i) {
+        const size_t offset = i * segment;
+        const size_t n      = std::min(segment, size - offset);
+        uint8_t      counter[16];
+        std::memcpy(counter, j0, 16);
+        add32(counter, offset / 16);
+
+        for (size_t pos = offset; pos < offset + n; pos += Chunk) {
+            const size_t m = std::min(Chunk, offset + n - pos);
+            if (encrypting) {
+                key.ctr(counter, input + pos, output + pos, m);
+                key.ghash_.update(partial[i].data(), output + pos, m);
+            } else {
+                key.ghash_.update(partial[i].data(), input + pos, m);
+                key.ctr(counter, input + pos, output + pos, m);
+            }
+            add32(counter, Chunk / 16);
+        }
+    };
+
+    if (count < 2 || size < t.parallel_min_bytes || max_threads == 1) {
+        for (size_t i = 0; i < count; ++i)
+            fn(i);
+    } else {
+        worker_pool::shared().parallel_for(count, fn, max_threads);
+    }
+
+    // S = S * H^ni ^ Si, all the segments but the last one have equal sizes
+    uint8_t s[16] = {0}, h[16] = {0}, hn[16];
+    key.ghash_.update(s, ad.data(), ad.size());
+    key.block(h, h);
+    ghash_key full, last;
+    if (count > 1) {
+        power(h, segment / 16, hn);
+        full.setup(hn);
+    }
+    if (count > 0) {
+        power(h, (size - (count - 1) * segment + 15) / 16, hn);
+        last.setup(hn);
+    }
+
+    const uint8_t zero[16] = {0};
+    for (size_t i = 0; i < count; ++i) {
+        (i + 1 < count ? full : last).update(s, zero, 16);
+        for (size_t j = 0; j < 16; ++j)
+            s[j] ^= partial[i][j];
+    }
+    key.finish(j0, s, ad.size(), size, tag);
+
+    mbedtls_platform_zeroize(h, sizeof(h));
+    mbedtls_platform_zeroize(hn, sizeof(hn));
+    for (auto& p : partial)
+        mbedtls_platform_zeroize(p.data(), p.size());
+}
+
+void
+check_key(cipher_t type, buffer_view_t key) {
+    if (key.size() * 8 != cipher::key_bitlen(type))
+        throw exceptions::usage_error{"invalid gcm key size"};
+}
+
+template <class Key>
+std::tuple<buffer_t, buffer_t>
+encrypt_by(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t ad,
+    buffer_view_t input,
+    size_t        max_threads) {
+    check_inputs(iv, input);
+    check_key(type, key);
+
+    const Key k{key.data(), key.size() * 8};
+    uint8_t   j0[16];
+    k.pre_counter(iv, j0);
+
+    buffer_t output(input.size(), '\0');
+    buffer_t tag(max_tag, '\0');
+    crypt(
+        k,
+        j0,
+        ad,
+        input.data(),
+        to_ptr(output),
+        input.size(),
+        true,
+        max_threads,
+        to_ptr(tag));
+    return std::make_tuple(tag, output);
+}
+
+template <class Key>
+std::tuple<bool, buffer_t>
+decrypt_by(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t ad,
+    buffer_view_t tag,
+    buffer_view_t input,
+    size_t        max_threads) {
+    check_inputs(iv, input);
+    check_key(type, key);
+    if (tag.size() < min_tag || tag.size() > max_tag)
+        throw exceptions::usage_error{"invalid gcm tag size"};
+
+    const Key k{key.data(), key.size() * 8};
+    uint8_t   j0[16], computed[16];
+    k.pre_counter(iv, j0);
+
+    buffer_t output(input.size(), '\0');
+    crypt(
+        k,
+        j0,
+        ad,
+        input.data(),
+        to_ptr(output),
+        input.size(),
+        false,
+        max_threads,
+        computed);
+
+    const bool ok = equal_tags(computed, tag);
+    mbedtls_platform_zeroize(computed, sizeof(computed));
+    if (!ok) {
+        mbedtls_platform_zeroize(to_ptr(output), output.size());
+        return std::make_tuple(false, buffer_t{});
+    }
+    return std::make_tuple(true, output);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+std::tuple<buffer_t, buffer_t>
+parallel_encrypt(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t ad,
+    buffer_view_t input,
+    size_t        max_threads) {
+    if (is_aes(type))
+        return encrypt_by<expanded_key>(type, iv, key, ad, input, max_threads);
+#if defined(MBEDTLS_CAMELLIA_C)
+    if (is_camellia(type))
+        return encrypt_by<camellia_key>(type, iv, key, ad, input, max_threads);
+#endif // MBEDTLS_CAMELLIA_C
+    return cipher::encrypt_aead(type, iv, key, ad, input);
+}
+
+std::tuple<bool, buffer_t>
+parallel_decrypt(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t ad,
+    buffer_view_t tag,
+    buffer_view_t input,
+    size_t        max_threads) {
+    if (is_aes(type)) {
+        return decrypt_by<expanded_key>(
+            type, iv, key, ad, tag, input, max_threads);
+    }
+#if defined(MBEDTLS_CAMELLIA_C)
+    if (is_camellia(type)) {
+        return decrypt_by<camellia_key>(
+            type, iv, key, ad, tag, input, max_threads);
+    }
+#endif // MBEDTLS_CAMELLIA_C
+    return cipher::decrypt_aead(type, iv, key, ad, tag, input);
+}
+
+//-----------------------------------------------------------------------------
+#else  // MBEDTLS_GCM_C
+
+std::tuple<buffer_t, buffer_t>
+parallel_encrypt(
+    cipher_t,
+    buffer_view_t,
+    buffer_view_t,
+    buffer_view_t,
+    buffer_view_t,
+    size_t) {
+    throw exceptions::gcm_error{};
+}
+
+std::tuple<bool, buffer_t>
+parallel_decrypt(
+    cipher_t,
+    buffer_view_t,
+    buffer_view_t,
+    buffer_view_t,
+    buffer_view_t,
+    buffer_view_t,
+    size_t) {
+    throw exceptions::gcm_error{};
+}
+
+#endif // MBEDTLS_GCM_C
+//-----------------------------------------------------------------------------
+} // namespace gcm
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
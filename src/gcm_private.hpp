@@ -0,0 +1,231 @@
+/** @file gcm_private.hpp
+ * the GCM internals shared by gcm_key_store and the parallel gcm.
+ * include only if MBEDTLS_GCM_C is defined.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_GCM_PRIVATE_HPP
+#define MBEDCRYPTO_GCM_PRIVATE_HPP
+
+#include "./conversions.hpp"
+#include "./ghash.hpp"
+
+#if defined(MBEDTLS_CAMELLIA_C)
+#include "./camellia_kernels.hpp"
+#endif
+
+#include <mbedtls/aes.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace gcm {
+//-----------------------------------------------------------------------------
+
+enum tag_size : size_t {
+    max_tag = 16,
+    min_tag = 4,
+};
+
+/// NIST SP 800-38D: 2^39 - 256 bits of plain text
+constexpr uint64_t MaxInput = (uint64_t{1} << 36) - 32;
+
+inline void
+put_be64(uint8_t* p, uint64_t v) noexcept {
+    for (int i = 7; i >= 0; --i, v >>= 8)
+        p[i] = static_cast<uint8_t>(v);
+}
+
+/// increments the last 32 bits of a counter block
+inline void
+inc32(uint8_t counter[16]) noexcept {
+    for (int i = 15; i >= 12; --i) {
+        if (++counter[i] != 0)
+            break;
+    }
+}
+
+/// adds n to the last 32 bits of a counter block (mod 2^32)
+inline void
+add32(uint8_t counter[16], uint64_t n) noexcept {
+    uint32_t c = uint32_t{counter[12]} << 24 | uint32_t{counter[13]} << 16 |
+                 uint32_t{counter[14]} << 8 | uint32_t{counter[15]};
+    c += static_cast<uint32_t>(n);
+    for (int i = 15; i >= 12; --i, c >>= 8)
+        counter[i] = static_cast<uint8_t>(c);
+}
+
+inline void
+check_inputs(buffer_view_t iv, buffer_view_t input) {
+    if (iv.size() == 0)
+        throw exceptions::usage_error{"gcm requires a non empty iv"};
+    if (static_cast<uint64_t>(input.size()) > MaxInput)
+        throw exceptions::usage_error{"gcm input is too large"};
+}
+
+/// AES by mbedtls, a block per call
+struct aes_cipher {
+    static constexpr size_t batch = 1;
+
+    mutable mbedtls_aes_context ctx_;
+
+    aes_cipher(const uint8_t* key, size_t key_bitlen) {
+        mbedtls_aes_init(&ctx_);
+        mbedcrypto_c_call(
+            mbedtls_aes_setkey_enc,
+            &ctx_,
+            key,
+            static_cast<unsigned int>(key_bitlen));
+    }
+
+    ~aes_cipher() {
+        mbedtls_aes_free(&ctx_);
+    }
+
+    void encrypt(const uint8_t* in, uint8_t* out, size_t blocks) const
+        noexcept {
+        for (size_t i = 0; i < blocks; ++i) {
+            mbedtls_aes_crypt_ecb(
+                &ctx_, MBEDTLS_AES_ENCRYPT, in + 16 * i, out + 16 * i);
+        }
+    }
+}; // struct aes_cipher
+
+#if defined(MBEDTLS_CAMELLIA_C)
+/// Camellia by the best byte-sliced kernel, by batches of counters
+struct camellia_cipher {
+    static constexpr size_t batch = 32;
+
+    mbedtls_camellia_context ctx_;
+    camellia::ecb_t          ecb_ = camellia::best_ecb();
+
+    camellia_cipher(const uint8_t* key, size_t key_bitlen) {
+        mbedtls_camellia_init(&ctx_);
+        mbedcrypto_c_call(
+            mbedtls_camellia_setkey_enc,
+            &ctx_,
+            key,
+            static_cast<unsigned int>(key_bitlen));
+    }
+
+    ~camellia_cipher() {
+        mbedtls_camellia_free(&ctx_);
+    }
+
+    void encrypt(const uint8_t* in, uint8_t* out, size_t blocks) const
+        noexcept {
+        ecb_(ctx_, in, out, blocks);
+    }
+}; // struct camellia_cipher
+#endif // MBEDTLS_CAMELLIA_C
+
+/// the round keys and the GHASH key of a single key
+template <class Cipher>
+struct basic_key {
+    Cipher    cipher_;
+    ghash_key ghash_;
+
+    basic_key(const uint8_t* key, size_t key_bitlen)
+        : cipher_{key, key_bitlen} {
+        uint8_t h[16] = {0};
+        block(h, h);
+        ghash_.setup(h);
+        mbedtls_platform_zeroize(h, sizeof(h));
+    }
+
+    void block(const uint8_t in[16], uint8_t out[16]) const noexcept {
+        cipher_.encrypt(in, out, 1);
+    }
+
+    /// the pre-counter block J0 of an iv
+    void pre_counter(buffer_view_t iv, uint8_t j0[16]) const noexcept {
+        std::memset(j0, 0, 16);
+        if (iv.size() == 12) {
+            std::memcpy(j0, iv.data(), 12);
+            j0[15] = 1;
+            return;
+        }
+
+        uint8_t lengths[16] = {0};
+        put_be64(lengths + 8, static_cast<uint64_t>(iv.size()) * 8);
+        ghash_.update(j0, iv.data(), iv.size());
+        ghash_.update(j0, lengths, 16);
+    }
+
+    /// CTR mode from inc32(j0), by batches of Cipher::batch counters
+    void ctr(
+        const uint8_t  j0[16],
+        const uint8_t* in,
+        uint8_t*       out,
+        size_t         size) const noexcept {
+        constexpr size_t Batch = Cipher::batch * 16;
+
+        uint8_t counter[16], stream[Batch];
+        std::memcpy(counter, j0, 16);
+        for (size_t offset = 0; offset < size; offset += Batch) {
+            const size_t n      = std::min(Batch, size - offset);
+            const size_t blocks = (n + 15) / 16;
+            for (size_t i = 0; i < blocks; ++i) {
+                inc32(counter);
+                std::memcpy(stream + 16 * i, counter, 16);
+            }
+            cipher_.encrypt(stream, stream, blocks);
+
+            for (size_t i = 0; i < n; ++i)
+                out[offset + i] = in[offset + i] ^ stream[i];
+        }
+        mbedtls_platform_zeroize(stream, sizeof(stream));
+    }
+
+    /// the tag by the GHASH s of the additional data and the cipher text
+    void finish(
+        const uint8_t j0[16],
+        uint8_t       s[16],
+        uint64_t      ad_size,
+        uint64_t      size,
+        uint8_t       out[16]) const noexcept {
+        uint8_t lengths[16];
+        put_be64(lengths, ad_size * 8);
+        put_be64(lengths + 8, size * 8);
+        ghash_.update(s, lengths, 16);
+
+        uint8_t ej0[16];
+        block(j0, ej0);
+        for (size_t i = 0; i < 16; ++i)
+            out[i] = s[i] ^ ej0[i];
+        mbedtls_platform_zeroize(ej0, sizeof(ej0));
+    }
+
+    void tag(
+        const uint8_t  j0[16],
+        buffer_view_t  ad,
+        const uint8_t* cipher_text,
+        size_t         size,
+        uint8_t        out[16]) const noexcept {
+        uint8_t s[16] = {0};
+        ghash_.update(s, ad.data(), ad.size());
+        ghash_.update(s, cipher_text, size);
+        finish(j0, s, ad.size(), size, out);
+    }
+}; // struct basic_key
+
+using expanded_key = basic_key<aes_cipher>;
+
+/// constant time comparison of the first tag.size() bytes of computed
+inline bool
+equal_tags(const uint8_t computed[16], buffer_view_t tag) noexcept {
+    uint8_t diff = 0;
+    for (size_t i = 0; i < tag.size(); ++i)
+        diff |= computed[i] ^ tag.data()[i];
+    return diff == 0;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace gcm
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_GCM_PRIVATE_HPP
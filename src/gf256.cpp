@@ -0,0 +1,194 @@
+#include "./gf256.hpp"
+#include "./cpu_features.hpp"
+
+#include <cstring>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#include <immintrin.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace gf256 {
+namespace {
+//-----------------------------------------------------------------------------
+
+constexpr uint64_t Low7  = 0x7f7f7f7f7f7f7f7f;
+constexpr uint64_t High1 = 0x0101010101010101;
+
+/// multiplies 8 packed elements by x
+inline uint64_t
+xtime8(uint64_t v) noexcept {
+    return ((v & Low7) << 1) ^ (((v >> 7) & High1) * 0x1b);
+}
+
+/// multiplies 8 packed elements by c, in constant time by the elements
+inline uint64_t
+mul8(uint64_t v, uint8_t c) noexcept {
+    uint64_t r = 0;
+    for (int bit = 0; bit < 8; ++bit) {
+        r ^= v & (uint64_t{0} - ((c >> bit) & 1));
+        v = xtime8(v);
+    }
+    return r;
+}
+
+/// the products of c by the low and by the high nibbles
+void
+nibble_tables(uint8_t c, uint8_t lo[16], uint8_t hi[16]) noexcept {
+    for (uint8_t i = 0; i < 16; ++i) {
+        lo[i] = mul(c, i);
+        hi[i] = mul(c, static_cast<uint8_t>(i << 4));
+    }
+}
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+MBEDCRYPTO_TARGET("ssse3") inline __m128i
+mul16(__m128i v, __m128i tlo, __m128i thi, __m128i mask) noexcept {
+    const auto l = _mm_shuffle_epi8(tlo, _mm_and_si128(v, mask));
+    const auto h =
+        _mm_shuffle_epi8(thi, _mm_and_si128(_mm_srli_epi64(v, 4), mask));
+    return _mm_xor_si128(l, h);
+}
+
+MBEDCRYPTO_TARGET("avx2") inline __m256i
+mul32(__m256i v, __m256i tlo, __m256i thi, __m256i mask) noexcept {
+    const auto l = _mm256_shuffle_epi8(tlo, _mm256_and_si256(v, mask));
+    const auto h = _mm256_shuffle_epi8(
+        thi, _mm256_and_si256(_mm256_srli_epi64(v, 4), mask));
+    return _mm256_xor_si256(l, h);
+}
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+uint8_t
+mul(uint8_t a, uint8_t b) noexcept {
+    return static_cast<uint8_t>(mul8(a, b));
+}
+
+uint8_t
+inverse(uint8_t a) noexcept {
+    // a^254, as the multiplicative group has 255 elements
+    uint8_t r = 1;
+    uint8_t p = a;
+    for (int e = 254; e != 0; e >>= 1) {
+        if (e & 1)
+            r = mul(r, p);
+        p = mul(p, p);
+    }
+    return r;
+}
+
+void
+mul_xor_portable(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t va, vb;
+        std::memcpy(&va, a + i, 8);
+        std::memcpy(&vb, b + i, 8);
+        const uint64_t r = mul8(va, c) ^ vb;
+        std::memcpy(out + i, &r, 8);
+    }
+    if (i < n) {
+        uint64_t va = 0, vb = 0;
+        std::memcpy(&va, a + i, n - i);
+        std::memcpy(&vb, b + i, n - i);
+        const uint64_t r = mul8(va, c) ^ vb;
+        std::memcpy(out + i, &r, n - i);
+    }
+}
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+
+MBEDCRYPTO_TARGET("ssse3") void
+mul_xor_ssse3(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n) {
+    alignas(16) uint8_t lo[16], hi[16];
+    nibble_tables(c, lo, hi);
+    const auto tlo  = _mm_load_si128(reinterpret_cast<const __m128i*>(lo));
+    const auto thi  = _mm_load_si128(reinterpret_cast<const __m128i*>(hi));
+    const auto mask = _mm_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const auto va =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        const auto vb =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(out + i),
+            _mm_xor_si128(mul16(va, tlo, thi, mask), vb));
+    }
+    mul_xor_portable(out + i, a + i, c, b + i, n - i);
+}
+
+MBEDCRYPTO_TARGET("avx2") void
+mul_xor_avx2(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n) {
+    alignas(16) uint8_t lo[16], hi[16];
+    nibble_tables(c, lo, hi);
+    // the same tables in both lanes, vpshufb looks up per 128-bit lane
+    const auto tlo = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(lo)));
+    const auto thi = _mm256_broadcastsi128_si256(
+        _mm_load_si128(reinterpret_cast<const __m128i*>(hi)));
+    const auto mask = _mm256_set1_epi8(0x0f);
+
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) {
+        const auto* pa = reinterpret_cast<const __m256i*>(a + i);
+        const auto* pb = reinterpret_cast<const __m256i*>(b + i);
+        auto*       po = reinterpret_cast<__m256i*>(out + i);
+        const auto  a0 = _mm256_loadu_si256(pa);
+        const auto  a1 = _mm256_loadu_si256(pa + 1);
+        const auto  b0 = _mm256_loadu_si256(pb);
+        const auto  b1 = _mm256_loadu_si256(pb + 1);
+        _mm256_storeu_si256(
+            po, _mm256_xor_si256(mul32(a0, tlo, thi, mask), b0));
+        _mm256_storeu_si256(
+            po + 1, _mm256_xor_si256(mul32(a1, tlo, thi, mask), b1));
+    }
+    for (; i + 32 <= n; i += 32) {
+        const auto va =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+        const auto vb =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(out + i),
+            _mm256_xor_si256(mul32(va, tlo, thi, mask), vb));
+    }
+    mul_xor_portable(out + i, a + i, c, b + i, n - i);
+}
+
+#else // MBEDCRYPTO_X86_64_INTRINSICS
+
+void
+mul_xor_ssse3(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n) {
+    mul_xor_portable(out, a, c, b, n);
+}
+
+void
+mul_xor_avx2(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n) {
+    mul_xor_portable(out, a, c, b, n);
+}
+
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+mul_xor_t
+best_mul_xor() noexcept {
+    if (cpu::has_avx2())
+        return mul_xor_avx2;
+    if (cpu::has_ssse3())
+        return mul_xor_ssse3;
+    return mul_xor_portable;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace gf256
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
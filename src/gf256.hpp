@@ -0,0 +1,56 @@
+/** @file gf256.hpp
+ * the arithmetic of GF(2^8) by the AES polynomial (x^8 + x^4 + x^3 + x + 1),
+ * with vectorized kernels which multiply a byte array by a constant.
+ *
+ * the kernels split each byte into two nibbles and look up the products of
+ * the constant in two 16 entries tables by PSHUFB (SSSE3 / AVX2), the
+ * portable kernel multiplies 8 bytes per step by shifts and masks. neither
+ * indexes memory by the data bytes (no cache timing by the secrets).
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_GF256_HPP
+#define MBEDCRYPTO_GF256_HPP
+
+#include <cstddef>
+#include <cstdint>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace gf256 {
+//-----------------------------------------------------------------------------
+
+/** out[i] = c * a[i] ^ b[i] for i in [0, n).
+ * out may be a or b (in place), the ranges must not partially overlap.
+ */
+using mul_xor_t = void (*)(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n);
+
+/// the product of two elements
+uint8_t mul(uint8_t a, uint8_t b) noexcept;
+
+/// the multiplicative inverse, a must not be 0
+uint8_t inverse(uint8_t a) noexcept;
+
+/// the portable kernel
+void mul_xor_portable(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n);
+
+/// 16 bytes per step, only callable if cpu::has_ssse3()
+void mul_xor_ssse3(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n);
+
+/// 32 bytes per step, only callable if cpu::has_avx2()
+void mul_xor_avx2(
+    uint8_t* out, const uint8_t* a, uint8_t c, const uint8_t* b, size_t n);
+
+/// the best kernel of this CPU
+mul_xor_t
+best_mul_xor() noexcept;
+
+//-----------------------------------------------------------------------------
+} // namespace gf256
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_GF256_HPP
@@ -0,0 +1,240 @@
+#include "./ghash.hpp"
+#include "./cpu_features.hpp"
+
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#include <emmintrin.h>
+#include <tmmintrin.h>
+#include <wmmintrin.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+inline uint64_t
+get_be64(const uint8_t* p) noexcept {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+inline void
+put_be64(uint8_t* p, uint64_t v) noexcept {
+    for (int i = 7; i >= 0; --i, v >>= 8)
+        p[i] = static_cast<uint8_t>(v);
+}
+
+// reduction of the 4-bit shifts, as mbedtls gcm.c
+const uint64_t Last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0};
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+/** carry-less multiplication and reduction of byte reflected operands, by
+ * the Intel white paper: "Intel Carry-Less Multiplication Instruction and
+ * its Usage for Computing the GCM Mode", algorithm 5.
+ */
+MBEDCRYPTO_TARGET("pclmul,ssse3") inline __m128i
+gfmul(__m128i a, __m128i b) noexcept {
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t4 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t5 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t6 = _mm_clmulepi64_si128(a, b, 0x11);
+
+    t4 = _mm_xor_si128(t4, t5);
+    t5 = _mm_slli_si128(t4, 8);
+    t4 = _mm_srli_si128(t4, 8);
+    t3 = _mm_xor_si128(t3, t5);
+    t6 = _mm_xor_si128(t6, t4); // <t6:t3> = a * b
+
+    // shifts the 256bit product left by one (bit reflection)
+    __m128i t7 = _mm_srli_epi32(t3, 31);
+    __m128i t8 = _mm_srli_epi32(t6, 31);
+    t3         = _mm_slli_epi32(t3, 1);
+    t6         = _mm_slli_epi32(t6, 1);
+    __m128i t9 = _mm_srli_si128(t7, 12);
+    t8         = _mm_slli_si128(t8, 4);
+    t7         = _mm_slli_si128(t7, 4);
+    t3         = _mm_or_si128(t3, t7);
+    t6         = _mm_or_si128(t6, t8);
+    t6         = _mm_or_si128(t6, t9);
+
+    // reduction modulo x^128 + x^7 + x^2 + x + 1
+    t7 = _mm_slli_epi32(t3, 31);
+    t8 = _mm_slli_epi32(t3, 30);
+    t9 = _mm_slli_epi32(t3, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    t3 = _mm_xor_si128(t3, t7);
+
+    __m128i t2 = _mm_srli_epi32(t3, 1);
+    t4         = _mm_srli_epi32(t3, 2);
+    t5         = _mm_srli_epi32(t3, 7);
+    t2         = _mm_xor_si128(t2, t4);
+    t2         = _mm_xor_si128(t2, t5);
+    t2         = _mm_xor_si128(t2, t8);
+    t3         = _mm_xor_si128(t3, t2);
+    return _mm_xor_si128(t6, t3);
+}
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct ghash_key::table {
+    uint64_t hl[16];
+    uint64_t hh[16];
+};
+
+bool
+ghash_key::supports_clmul() noexcept {
+    return cpu::has_pclmul() && cpu::has_ssse3();
+}
+
+ghash_key::ghash_key() = default;
+
+ghash_key::~ghash_key() {
+    mbedtls_platform_zeroize(h_, sizeof(h_));
+    if (table_)
+        mbedtls_platform_zeroize(table_.get(), sizeof(table));
+}
+
+void
+ghash_key::setup(const uint8_t h[16]) {
+    std::memcpy(h_, h, sizeof(h_));
+    if (supports_clmul()) {
+        table_.reset();
+        return;
+    }
+
+    if (!table_)
+        table_ = std::make_unique<table>();
+    auto& t = *table_;
+
+    // precomputes the multiples of H by the 4-bit values, as mbedtls
+    uint64_t vh = get_be64(h);
+    uint64_t vl = get_be64(h + 8);
+
+    t.hl[8] = vl;
+    t.hh[8] = vh;
+    t.hl[0] = 0;
+    t.hh[0] = 0;
+    for (size_t i = 4; i > 0; i >>= 1) {
+        uint64_t T = (vl & 1) * 0xe1000000u;
+        vl         = (vh << 63) | (vl >> 1);
+        vh         = (vh >> 1) ^ (T << 32);
+        t.hl[i]    = vl;
+        t.hh[i]    = vh;
+    }
+    for (size_t i = 2; i <= 8; i *= 2) {
+        vh = t.hh[i];
+        vl = t.hl[i];
+        for (size_t j = 1; j < i; ++j) {
+            t.hh[i + j] = vh ^ t.hh[j];
+            t.hl[i + j] = vl ^ t.hl[j];
+        }
+    }
+}
+
+void
+ghash_key::update(uint8_t y[16], const uint8_t* data, size_t size) const
+    noexcept {
+    if (table_)
+        update_table(y, data, size);
+    else
+        update_clmul(y, data, size);
+}
+
+size_t
+ghash_key::heap_size() const noexcept {
+    return table_ ? sizeof(table) : 0;
+}
+
+void
+ghash_key::update_table(uint8_t y[16], const uint8_t* data, size_t size) const
+    noexcept {
+    const auto& t = *table_;
+
+    uint8_t x[16];
+    for (size_t offset = 0; offset < size; offset += 16) {
+        const size_t n = std::min<size_t>(16, size - offset);
+        std::memcpy(x, y, 16);
+        for (size_t i = 0; i < n; ++i)
+            x[i] ^= data[offset + i];
+
+        uint8_t  lo = x[15] & 0x0f;
+        uint64_t zh = t.hh[lo];
+        uint64_t zl = t.hl[lo];
+        for (int i = 15; i >= 0; --i) {
+            lo         = x[i] & 0x0f;
+            uint8_t hi = (x[i] >> 4) & 0x0f;
+
+            if (i != 15) {
+                uint8_t rem = zl & 0x0f;
+                zl          = (zh << 60) | (zl >> 4);
+                zh          = (zh >> 4) ^ (Last4[rem] << 48);
+                zh ^= t.hh[lo];
+                zl ^= t.hl[lo];
+            }
+
+            uint8_t rem = zl & 0x0f;
+            zl          = (zh << 60) | (zl >> 4);
+            zh          = (zh >> 4) ^ (Last4[rem] << 48);
+            zh ^= t.hh[hi];
+            zl ^= t.hl[hi];
+        }
+
+        put_be64(y, zh);
+        put_be64(y + 8, zl);
+    }
+    mbedtls_platform_zeroize(x, sizeof(x));
+}
+
+MBEDCRYPTO_TARGET("pclmul,ssse3") void
+ghash_key::update_clmul(uint8_t y[16], const uint8_t* data, size_t size) const
+    noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+    const __m128i swap = _mm_set_epi8(
+        0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i h = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(h_)), swap);
+    __m128i acc = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y)), swap);
+
+    size_t offset = 0;
+    for (; offset + 16 <= size; offset += 16) {
+        __m128i x = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset)),
+            swap);
+        acc = gfmul(_mm_xor_si128(acc, x), h);
+    }
+    if (offset < size) { // zero padded
+        uint8_t last[16] = {0};
+        std::memcpy(last, data + offset, size - offset);
+        __m128i x = _mm_shuffle_epi8(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(last)), swap);
+        acc = gfmul(_mm_xor_si128(acc, x), h);
+    }
+
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(y), _mm_shuffle_epi8(acc, swap));
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+    // never selected by setup()
+    (void)y;
+    (void)data;
+    (void)size;
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,61 @@
+/** @file ghash.hpp
+ * GHASH (the authenticator of GCM, NIST SP 800-38D) by a hash key H.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_GHASH_HPP
+#define MBEDCRYPTO_GHASH_HPP
+
+#include "mbedcrypto/types.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** the multiplication by H in GF(2^128).
+ * table-free by PCLMULQDQ if the CPU supports it, otherwise by 4-bit tables
+ * (256 bytes, as mbedtls) which are allocated only in that case.
+ */
+class ghash_key
+{
+public:
+    /// true if the CPU has PCLMULQDQ (and SSSE3)
+    static bool supports_clmul() noexcept;
+
+    ghash_key();
+    ~ghash_key();
+
+    /// h = E(K, 0^128)
+    void setup(const uint8_t h[16]);
+
+    /** absorbs the data into y: y = (y ^ block) * H for each 16 bytes block,
+     * a partial last block is zero padded.
+     */
+    void update(uint8_t y[16], const uint8_t* data, size_t size) const noexcept;
+
+    bool uses_clmul() const noexcept {
+        return table_ == nullptr;
+    }
+
+    /// heap bytes used by this key (the table if any)
+    size_t heap_size() const noexcept;
+
+public: // non-copyable
+    ghash_key(const ghash_key&) = delete;
+    ghash_key& operator=(const ghash_key&) = delete;
+
+protected:
+    struct table;
+
+    void update_table(uint8_t y[16], const uint8_t*, size_t) const noexcept;
+    void update_clmul(uint8_t y[16], const uint8_t*, size_t) const noexcept;
+
+    uint8_t                h_[16] = {0};
+    std::unique_ptr<table> table_;
+}; // class ghash_key
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_GHASH_HPP
@@ -1,7 +1,10 @@
 #include "mbedcrypto/hash.hpp"
 #include "./conversions.hpp"
+#include "./memory_private.hpp"
+#include "./sha512_kernels.hpp"
 
 #include <mbedtls/md.h>
+#include <mbedtls/platform_util.h>
 #include <tuple>
 #include <type_traits>
 //-----------------------------------------------------------------------------
@@ -68,6 +71,28 @@ _make(hash_t type, buffer_view_t key, buffer_view_t src) {
     return buf;
 }
 
+/// sha384 and sha512 are computed by sha512_kernels
+bool
+is_sha512_family(hash_t type) noexcept {
+    return type == hash_t::sha384 || type == hash_t::sha512;
+}
+
+/// the state after a single block of key ^ pad
+void
+hmac_pad_state(
+    uint64_t       state[8],
+    const uint8_t* key,
+    size_t         size,
+    uint8_t        pad,
+    bool           is384) {
+    uint8_t block[sha512::block_size];
+    for (size_t i = 0; i < sha512::block_size; ++i)
+        block[i] = static_cast<uint8_t>((i < size ? key[i] : 0) ^ pad);
+    sha512::initial_state(state, is384);
+    sha512::process_portable(state, block);
+    mbedtls_platform_zeroize(block, sizeof(block));
+}
+
 //-----------------------------------------------------------------------------
 
 struct impl_base {
@@ -93,14 +118,26 @@ struct impl_base {
         return mbedtls_md_get_size(ctx_.md_info);
     }
 
+    size_t heap_size() const noexcept {
+        return memory::block_size(ctx_.md_ctx) +
+               memory::block_size(ctx_.hmac_ctx);
+    }
+
 }; // struct impl_base
 
 //-----------------------------------------------------------------------------
 } // namespace anon
 //-----------------------------------------------------------------------------
 
-struct hash::impl : public impl_base {};
-struct hmac::impl : public impl_base {};
+struct hash::impl : public impl_base {
+    memory::counter counter_{
+        memory::kind::hash, sizeof(hash) + sizeof(impl)};
+};
+
+struct hmac::impl : public impl_base {
+    memory::counter counter_{
+        memory::kind::hmac, sizeof(hmac) + sizeof(impl)};
+};
 
 //-----------------------------------------------------------------------------
 
@@ -116,6 +153,22 @@ hmac::hmac(hash_t type) : pimpl(new hmac::impl) {
 
 hmac::~hmac() {}
 
+memory::usage
+hash::footprint() const noexcept {
+    memory::usage u;
+    u.inline_bytes = sizeof(hash) + sizeof(impl);
+    u.heap_bytes   = pimpl->heap_size();
+    return u;
+}
+
+memory::usage
+hmac::footprint() const noexcept {
+    memory::usage u;
+    u.inline_bytes = sizeof(hmac) + sizeof(impl);
+    u.heap_bytes   = pimpl->heap_size();
+    return u;
+}
+
 size_t
 hash::length(hash_t type) {
     const auto* cinfot = native_type(type);
@@ -152,11 +205,67 @@ hash::of_file(hash_t type, const char* filePath) {
 #endif
 }
 
+std::vector<buffer_t>
+hash::make_many(hash_t type, const std::vector<buffer_view_t>& sources) {
+    if (!is_sha512_family(type)) {
+        std::vector<buffer_t> digests;
+        digests.reserve(sources.size());
+        for (const auto& src : sources)
+            digests.push_back(make(type, src));
+        return digests;
+    }
+
+    const bool is384 = type == hash_t::sha384;
+    uint64_t   init[8];
+    sha512::initial_state(init, is384);
+    return sha512::digest_many(init, 0, is384, sources);
+}
+
 buffer_t
 hmac::make(hash_t type, buffer_view_t key, buffer_view_t src) {
     return _make<buffer_t>(type, key, src);
 }
 
+std::vector<buffer_t>
+hmac::make_many(
+    hash_t                            type,
+    buffer_view_t                     key,
+    const std::vector<buffer_view_t>& sources) {
+    if (!is_sha512_family(type)) {
+        std::vector<buffer_t> macs;
+        macs.reserve(sources.size());
+        for (const auto& src : sources)
+            macs.push_back(make(type, key, src));
+        return macs;
+    }
+
+    const bool is384 = type == hash_t::sha384;
+    // a long key is replaced by its digest (RFC 2104)
+    buffer_t long_key;
+    if (key.size() > sha512::block_size) {
+        long_key = hash::make(type, key);
+        key      = long_key;
+    }
+
+    uint64_t ipad[8], opad[8];
+    hmac_pad_state(ipad, key.data(), key.size(), 0x36, is384);
+    hmac_pad_state(opad, key.data(), key.size(), 0x5c, is384);
+    mbedtls_platform_zeroize(to_ptr(long_key), long_key.size());
+
+    // both passes start after the single pad block
+    const auto inner =
+        sha512::digest_many(ipad, sha512::block_size, is384, sources);
+    std::vector<buffer_view_t> views;
+    views.reserve(inner.size());
+    for (const auto& d : inner)
+        views.emplace_back(d);
+    auto macs = sha512::digest_many(opad, sha512::block_size, is384, views);
+
+    mbedtls_platform_zeroize(ipad, sizeof(ipad));
+    mbedtls_platform_zeroize(opad, sizeof(opad));
+    return macs;
+}
+
 void
 hash::start() {
     mbedcrypto_c_call(mbedtls_md_starts, &pimpl->ctx_);
@@ -0,0 +1,308 @@
+#include "mbedcrypto/manifest.hpp"
+#include "mbedcrypto/hash.hpp"
+#include "./fs_utils.hpp"
+#include "./worker_pool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace manifest {
+namespace {
+//-----------------------------------------------------------------------------
+
+enum K {
+    chunk_size        = 64 * 1024,
+    window_per_thread = 4, ///< max tasks in flight per thread
+};
+
+struct file_t {
+    entry                 e;
+    size_t                pending = 0; ///< unfinished jobs
+    std::vector<buffer_t> leaves;      ///< the leaf digests of a tree hash
+}; // struct file_t
+
+/// a whole file, a batch of small files or a leaf of a file
+struct job_t {
+    size_t first = 0; ///< the first file
+    size_t last  = 0; ///< one past the last file
+    size_t leaf  = 0; ///< the leaf index, if the file is tree hashed
+}; // struct job_t
+
+/// feeds h by up to size bytes of in, returns the number of read bytes
+size_t
+feed(hash& h, fs::input_file& in, size_t size, buffer_t& chunk) {
+    size_t total = 0;
+    while (total < size) {
+        auto n = in.read(to_ptr(chunk), std::min(chunk.size(), size - total));
+        if (n == 0)
+            break;
+        h.update(to_const_ptr(chunk), n);
+        total += n;
+    }
+    return total;
+}
+
+/** shared state of a hashing, outlives the caller if a helper task is
+ * dequeued after the hashing has been finished (or stopped).
+ */
+struct state_t {
+    const options       opts;
+    std::vector<file_t> files;
+    std::vector<job_t>  jobs;
+    std::vector<size_t> first_job; ///< the first job of each file
+    std::vector<size_t> end_job;   ///< one past the last job of each file
+    size_t              window = 0;
+
+    std::mutex              mutex;
+    std::condition_variable cv;
+    size_t                  next_job = 0; ///< guarded by mutex
+    size_t                  emitted  = 0; ///< guarded by mutex
+    bool                    stop     = false;
+
+    explicit state_t(const options& o) : opts(o) {}
+
+    void build(const std::vector<std::string>& paths) {
+        files.resize(paths.size());
+        first_job.resize(paths.size());
+        end_job.resize(paths.size());
+        bool batching = false;
+
+        for (size_t i = 0; i < paths.size(); ++i) {
+            auto& f      = files[i];
+            f.e.path     = paths[i];
+            f.e.size     = fs::file_size(paths[i].c_str());
+            first_job[i] = jobs.size();
+            const auto size = static_cast<uint64_t>(f.e.size);
+
+            if (f.e.size < 0) {
+                f.e.error = "failed to open the file";
+                batching  = false;
+            } else if (size <= opts.small_file_size) {
+                if (batching &&
+                    jobs.back().last - jobs.back().first < opts.batch_size) {
+                    jobs.back().last = i + 1;
+                    first_job[i]     = jobs.size() - 1;
+                } else {
+                    jobs.push_back(job_t{i, i + 1, 0});
+                    batching = true;
+                }
+                f.pending = 1;
+            } else if (opts.tree_hash && size > opts.leaf_size) {
+                const auto leaves = static_cast<size_t>(
+                    (size + opts.leaf_size - 1) / opts.leaf_size);
+                f.leaves.resize(leaves);
+                f.pending = leaves;
+                for (size_t k = 0; k < leaves; ++k)
+                    jobs.push_back(job_t{i, i + 1, k});
+                batching = false;
+            } else {
+                jobs.push_back(job_t{i, i + 1, 0});
+                f.pending = 1;
+                batching  = false;
+            }
+            end_job[i] = f.pending > 0 ? jobs.size() : first_job[i];
+        }
+    }
+
+    /** the jobs before this index may run, must be called under the lock.
+     * all the leaves of the next file to emit may run, whatever the window.
+     */
+    size_t limit() const noexcept {
+        if (emitted >= files.size())
+            return jobs.size();
+        return std::max(
+            end_job[emitted],
+            std::min(jobs.size(), first_job[emitted] + window));
+    }
+
+    bool can_claim() const noexcept {
+        return !stop && next_job < limit();
+    }
+
+    /// runs a job without the lock, returns the error of a leaf
+    std::string run(size_t j) noexcept {
+        const auto& job = jobs[j];
+        try {
+            hash     h{opts.type};
+            buffer_t chunk(chunk_size, '\0');
+
+            auto& first = files[job.first];
+            if (!first.leaves.empty()) {
+                const auto offset = uint64_t{job.leaf} * opts.leaf_size;
+                const auto size   = static_cast<size_t>(std::min<uint64_t>(
+                    opts.leaf_size, first.e.size - offset));
+
+                fs::input_file in{first.e.path.c_str()};
+                in.seek(static_cast<int64_t>(offset));
+                const uint8_t prefix = 0x00;
+                h.start();
+                h.update(&prefix, 1);
+                if (feed(h, in, size, chunk) != size)
+                    return "the file has been changed while hashing";
+                first.leaves[job.leaf] = h.finish();
+                return std::string{};
+            }
+
+            // a whole file or a batch of small files
+            for (size_t i = job.first; i < job.last; ++i) {
+                auto& e = files[i].e;
+                try {
+                    fs::input_file in{e.path.c_str()};
+                    h.start();
+                    feed(h, in, static_cast<size_t>(-1), chunk);
+                    e.digest = h.finish();
+                } catch (const std::exception& err) {
+                    e.error = err.what();
+                }
+            }
+        } catch (const std::exception& err) {
+            return err.what();
+        }
+        return std::string{};
+    }
+
+    /// marks a job as finished, must be called under the lock
+    void done(size_t j, std::string&& error) {
+        const auto& job = jobs[j];
+        for (size_t i = job.first; i < job.last; ++i) {
+            auto& f = files[i];
+            --f.pending;
+            if (!error.empty() && f.e.error.empty())
+                f.e.error = std::move(error);
+        }
+        cv.notify_all();
+    }
+
+    /// the root digest of a tree hashed file
+    void finalize(file_t& f) noexcept {
+        if (f.e.error.empty()) {
+            try {
+                hash          h{opts.type};
+                const uint8_t prefix = 0x01;
+                h.start();
+                h.update(&prefix, 1);
+                for (const auto& leaf : f.leaves)
+                    h.update(leaf);
+                f.e.digest = h.finish();
+                f.e.tree   = true;
+            } catch (const std::exception& err) {
+                f.e.error = err.what();
+            }
+        }
+        f.leaves.clear();
+        f.leaves.shrink_to_fit();
+    }
+
+    /// the loop of a pool thread
+    void help() {
+        std::unique_lock<std::mutex> lock{mutex};
+        for (;;) {
+            cv.wait(lock, [this]() {
+                return stop || next_job >= jobs.size() || can_claim();
+            });
+            if (!can_claim())
+                return;
+
+            const auto j = next_job++;
+            lock.unlock();
+            auto error = run(j);
+            lock.lock();
+            done(j, std::move(error));
+        }
+    }
+}; // struct state_t
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+void
+hash_files(
+    const std::vector<std::string>& paths,
+    const on_entry_t&               on_entry,
+    const options&                  opts) {
+    if (!on_entry)
+        throw exceptions::usage_error{"the manifest callback is empty"};
+    if (opts.leaf_size == 0 || opts.batch_size == 0)
+        throw exceptions::usage_error{"invalid manifest options"};
+    hash{opts.type}; // throws if the hash type is not supported
+
+    auto st = std::make_shared<state_t>(opts);
+    st->build(paths);
+
+    auto&  pool    = worker_pool::shared();
+    size_t threads = pool.size() + 1; // the caller thread works too
+    if (opts.max_threads > 0)
+        threads = std::min(threads, opts.max_threads);
+    threads    = std::min(threads, st->jobs.size());
+    st->window = window_per_thread * std::max(threads, size_t{1});
+    for (size_t t = 1; t < threads; ++t)
+        pool.post([st]() { st->help(); });
+
+    // the caller emits the entries in order, and runs the jobs meanwhile
+    std::unique_lock<std::mutex> lock{st->mutex};
+    while (st->emitted < st->files.size()) {
+        auto& f = st->files[st->emitted];
+        if (f.pending == 0) {
+            ++st->emitted;
+            st->cv.notify_all(); // moves the limit
+            lock.unlock();
+
+            if (!f.leaves.empty())
+                st->finalize(f);
+            try {
+                on_entry(f.e);
+            } catch (...) {
+                lock.lock();
+                st->stop = true;
+                st->cv.notify_all();
+                throw;
+            }
+            f.e = entry{};
+
+            lock.lock();
+        } else if (st->can_claim()) {
+            const auto j = st->next_job++;
+            lock.unlock();
+            auto error = st->run(j);
+            lock.lock();
+            st->done(j, std::move(error));
+        } else {
+            st->cv.wait(lock);
+        }
+    }
+
+    st->stop = true;
+    st->cv.notify_all();
+}
+
+void
+hash_tree(
+    const char*       dir_path,
+    const on_entry_t& on_entry,
+    const options&    opts) {
+    hash_files(fs::list_tree(dir_path), on_entry, opts);
+}
+
+std::vector<entry>
+of_files(const std::vector<std::string>& paths, const options& opts) {
+    std::vector<entry> entries;
+    entries.reserve(paths.size());
+    hash_files(
+        paths, [&entries](const entry& e) { entries.push_back(e); }, opts);
+    return entries;
+}
+
+std::vector<entry>
+of_tree(const char* dir_path, const options& opts) {
+    return of_files(fs::list_tree(dir_path), opts);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace manifest
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
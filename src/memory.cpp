@@ -0,0 +1,144 @@
+#include "./memory_private.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace memory {
+namespace {
+//-----------------------------------------------------------------------------
+
+enum K : size_t {
+    /// the size of a block is kept before it, by the max alignment
+    header_size = alignof(std::max_align_t),
+    kind_count  = static_cast<size_t>(kind::rnd_generator) + 1,
+};
+
+static_assert(header_size >= sizeof(size_t), "");
+
+struct heap_counters {
+    std::atomic<size_t> bytes{0};
+    std::atomic<size_t> peak_bytes{0};
+    std::atomic<size_t> blocks{0};
+    std::atomic<size_t> total_blocks{0};
+
+    void allocated(size_t size) noexcept {
+        const auto now =
+            bytes.fetch_add(size, std::memory_order_relaxed) + size;
+        blocks.fetch_add(1, std::memory_order_relaxed);
+        total_blocks.fetch_add(1, std::memory_order_relaxed);
+
+        auto peak = peak_bytes.load(std::memory_order_relaxed);
+        while (now > peak &&
+               !peak_bytes.compare_exchange_weak(
+                   peak, now, std::memory_order_relaxed)) {
+        }
+    }
+
+    void freed(size_t size) noexcept {
+        bytes.fetch_sub(size, std::memory_order_relaxed);
+        blocks.fetch_sub(1, std::memory_order_relaxed);
+    }
+}; // struct heap_counters
+
+struct kind_counters {
+    std::atomic<size_t> objects{0};
+    std::atomic<size_t> inline_bytes{0};
+}; // struct kind_counters
+
+// constant initialized, the allocator may run before any dynamic initializer
+heap_counters gheap;
+kind_counters gkinds[kind_count];
+
+size_t
+read_header(const uint8_t* block) noexcept {
+    size_t size = 0;
+    std::memcpy(&size, block, sizeof(size));
+    return size;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+size_t
+block_size(const void* p) noexcept {
+    if (p == nullptr)
+        return 0;
+    return read_header(static_cast<const uint8_t*>(p) - header_size);
+}
+
+counter::counter(kind k, size_t inline_size) noexcept
+    : kind_{k}, size_{inline_size} {
+    auto& c = gkinds[static_cast<size_t>(kind_)];
+    c.objects.fetch_add(1, std::memory_order_relaxed);
+    c.inline_bytes.fetch_add(size_, std::memory_order_relaxed);
+}
+
+counter::~counter() {
+    auto& c = gkinds[static_cast<size_t>(kind_)];
+    c.objects.fetch_sub(1, std::memory_order_relaxed);
+    c.inline_bytes.fetch_sub(size_, std::memory_order_relaxed);
+}
+
+totals
+live(kind k) noexcept {
+    const auto& c = gkinds[static_cast<size_t>(k)];
+    totals      t;
+    t.objects      = c.objects.load(std::memory_order_relaxed);
+    t.inline_bytes = c.inline_bytes.load(std::memory_order_relaxed);
+    return t;
+}
+
+heap_stats
+heap() noexcept {
+    heap_stats s;
+    s.bytes        = gheap.bytes.load(std::memory_order_relaxed);
+    s.peak_bytes   = gheap.peak_bytes.load(std::memory_order_relaxed);
+    s.blocks       = gheap.blocks.load(std::memory_order_relaxed);
+    s.total_blocks = gheap.total_blocks.load(std::memory_order_relaxed);
+    return s;
+}
+
+void
+reset_peak() noexcept {
+    gheap.peak_bytes.store(
+        gheap.bytes.load(std::memory_order_relaxed),
+        std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace memory
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+
+// the allocator of mbedtls, @sa MBEDTLS_PLATFORM_STD_CALLOC in
+// mbedcrypto_mbedtls_config.h
+extern "C" void*
+mbedcrypto_accounted_calloc(size_t count, size_t size) {
+    using namespace mbedcrypto::memory;
+    if (size != 0 && count > (SIZE_MAX - header_size) / size)
+        return nullptr;
+
+    const size_t bytes = count * size;
+    auto* block = static_cast<uint8_t*>(std::calloc(1, header_size + bytes));
+    if (block == nullptr)
+        return nullptr;
+
+    std::memcpy(block, &bytes, sizeof(bytes));
+    gheap.allocated(bytes);
+    return block + header_size;
+}
+
+extern "C" void
+mbedcrypto_accounted_free(void* p) {
+    using namespace mbedcrypto::memory;
+    if (p == nullptr)
+        return;
+
+    auto* block = static_cast<uint8_t*>(p) - header_size;
+    gheap.freed(read_header(block));
+    std::free(block);
+}
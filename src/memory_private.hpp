@@ -0,0 +1,56 @@
+/** @file memory_private.hpp
+ * the internals of the memory accounting, @sa mbedcrypto/memory.hpp
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_MEMORY_PRIVATE_HPP
+#define MBEDCRYPTO_MEMORY_PRIVATE_HPP
+
+#include "mbedcrypto/memory.hpp"
+
+#include <mbedtls/bignum.h>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace memory {
+//-----------------------------------------------------------------------------
+
+/** returns the size of a block by mbedtls_calloc(), or 0 for nullptr.
+ * @warning p must not point into a static table (ex: the constants of the
+ * ec groups).
+ */
+size_t block_size(const void* p) noexcept;
+
+/// the heap of a big number
+inline size_t
+mpi_size(const mbedtls_mpi& x) noexcept {
+    return x.n * sizeof(mbedtls_mpi_uint);
+}
+
+/** a member of the private implementations, counts the live objects of a
+ * kind. a copy (or a move) is a new object, the assignments change nothing.
+ */
+class counter
+{
+public:
+    counter(kind k, size_t inline_size) noexcept;
+    ~counter();
+
+    counter(const counter& other) noexcept
+        : counter{other.kind_, other.size_} {}
+
+    counter& operator=(const counter&) noexcept {
+        return *this;
+    }
+
+private:
+    kind   kind_;
+    size_t size_;
+}; // class counter
+
+//-----------------------------------------------------------------------------
+} // namespace memory
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_MEMORY_PRIVATE_HPP
@@ -0,0 +1,342 @@
+#include "mbedcrypto/merkle.hpp"
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/public_key.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <iterator>
+#include <mutex>
+#include <thread>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace merkle {
+namespace {
+//-----------------------------------------------------------------------------
+
+enum K : size_t {
+    version   = 1,
+    header    = 11, ///< version, type, index, count and path size
+    max_depth = 32, ///< of 2^32 messages
+};
+
+constexpr char Domain[] = "mbedcrypto merkle batch";
+
+void
+put32(buffer_t& out, uint32_t v) {
+    for (int i = 3; i >= 0; --i)
+        out.push_back(static_cast<char>(v >> (8 * i)));
+}
+
+uint32_t
+get32(const uint8_t* p) noexcept {
+    return uint32_t{p[0]} << 24 | uint32_t{p[1]} << 16 | uint32_t{p[2]} << 8 |
+           uint32_t{p[3]};
+}
+
+buffer_t
+leaf_of(hash& h, buffer_view_t digest) {
+    const uint8_t prefix = 0x00;
+    h.start();
+    h.update(&prefix, 1);
+    h.update(digest);
+    return h.finish();
+}
+
+buffer_t
+node_of(hash& h, buffer_view_t left, buffer_view_t right) {
+    const uint8_t prefix = 0x01;
+    h.start();
+    h.update(&prefix, 1);
+    h.update(left);
+    h.update(right);
+    return h.finish();
+}
+
+/// the hash value which is signed by the key
+buffer_t
+signed_of(hash& h, uint32_t count, buffer_view_t root) {
+    buffer_t n;
+    put32(n, count);
+    h.start();
+    h.update(reinterpret_cast<const uint8_t*>(Domain), sizeof(Domain) - 1);
+    h.update(n);
+    h.update(root);
+    return h.finish();
+}
+
+/// builds the tree over the digests of the messages and signs its root
+std::vector<batch_signature>
+sign_digests(pk::pk_base& key, std::vector<buffer_t> level, hash_t type) {
+    if (level.empty())
+        return {};
+    if (level.size() > 0xffffffff)
+        throw exceptions::usage_error{"too many messages in a batch"};
+
+    const auto count = static_cast<uint32_t>(level.size());
+    hash       h{type};
+    for (auto& d : level)
+        d = leaf_of(h, d);
+
+    std::vector<batch_signature> result(count);
+    std::vector<uint32_t>        position(count); // of each message
+    for (uint32_t i = 0; i < count; ++i) {
+        result[i].type  = type;
+        result[i].index = i;
+        result[i].count = count;
+        position[i]     = i;
+    }
+
+    while (level.size() > 1) {
+        const size_t n = level.size();
+        for (uint32_t i = 0; i < count; ++i) {
+            const size_t sibling = position[i] ^ 1;
+            if (sibling < n)
+                result[i].path.push_back(level[sibling]);
+            position[i] /= 2;
+        }
+        std::vector<buffer_t> upper;
+        upper.reserve((n + 1) / 2);
+        for (size_t j = 0; j + 1 < n; j += 2)
+            upper.push_back(node_of(h, level[j], level[j + 1]));
+        if (n % 2 == 1) // moved up
+            upper.push_back(std::move(level[n - 1]));
+        level.swap(upper);
+    }
+
+    const auto signature =
+        pk::sign(key.context(), signed_of(h, count, level[0]), type);
+    for (auto& s : result)
+        s.root_signature = signature;
+    return result;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+buffer_t
+batch_signature::dump() const {
+    buffer_t out;
+    out.reserve(
+        header + path.size() * hash::length(type) + 2 + root_signature.size());
+    out.push_back(static_cast<char>(version));
+    out.push_back(static_cast<char>(type));
+    put32(out, index);
+    put32(out, count);
+    out.push_back(static_cast<char>(path.size()));
+    for (const auto& p : path)
+        out.append(p);
+    out.push_back(static_cast<char>(root_signature.size() >> 8));
+    out.push_back(static_cast<char>(root_signature.size()));
+    out.append(root_signature);
+    return out;
+}
+
+batch_signature
+batch_signature::parse(buffer_view_t data) {
+    const auto* p    = data.data();
+    size_t      left = data.size();
+    if (left < header || p[0] != version)
+        throw exceptions::usage_error{"invalid batch signature"};
+
+    batch_signature s;
+    s.type             = static_cast<hash_t>(p[1]);
+    s.index            = get32(p + 2);
+    s.count            = get32(p + 6);
+    const size_t depth = p[10];
+    if (s.type == hash_t::none || !supports(s.type) || depth > max_depth)
+        throw exceptions::usage_error{"invalid batch signature"};
+
+    const size_t hsize = hash::length(s.type);
+    p += header;
+    left -= header;
+    if (left < depth * hsize + 2)
+        throw exceptions::usage_error{"invalid batch signature"};
+    for (size_t i = 0; i < depth; ++i, p += hsize)
+        s.path.emplace_back(reinterpret_cast<const char*>(p), hsize);
+    left -= depth * hsize;
+
+    const size_t size = size_t{p[0]} << 8 | p[1];
+    if (left != size + 2)
+        throw exceptions::usage_error{"invalid batch signature"};
+    s.root_signature.assign(reinterpret_cast<const char*>(p + 2), size);
+    return s;
+}
+
+std::vector<batch_signature>
+sign_batch(
+    pk::pk_base&                      key,
+    const std::vector<buffer_view_t>& messages,
+    hash_t                            type) {
+    return sign_digests(key, hash::make_many(type, messages), type);
+}
+
+buffer_t
+signed_hash(buffer_view_t message, const batch_signature& s) {
+    if (s.count == 0 || s.index >= s.count || s.type == hash_t::none ||
+        !supports(s.type) || s.path.size() > max_depth)
+        return buffer_t{};
+
+    const size_t hsize = hash::length(s.type);
+    hash         h{s.type};
+    auto         digest = leaf_of(h, hash::make(s.type, message));
+    auto         it     = s.path.cbegin();
+    for (uint32_t i = s.index, n = s.count; n > 1; i /= 2, n = n / 2 + n % 2) {
+        if (i % 2 == 1 || i + 1 < n) {
+            if (it == s.path.cend() || it->size() != hsize)
+                return buffer_t{};
+            digest = i % 2 == 1 ? node_of(h, *it, digest)
+                                : node_of(h, digest, *it);
+            ++it;
+        }
+    }
+    if (it != s.path.cend())
+        return buffer_t{};
+
+    return signed_of(h, s.count, digest);
+}
+
+bool
+verify(pk::pk_base& key, buffer_view_t message, const batch_signature& s) {
+    const auto hvalue = signed_hash(message, s);
+    return !hvalue.empty() &&
+           pk::verify(key.context(), s.root_signature, hvalue, s.type);
+}
+
+bool
+verify(const public_key& key, buffer_view_t message, const batch_signature& s) {
+    const auto hvalue = signed_hash(message, s);
+    return !hvalue.empty() && key.verify(s.root_signature, hvalue, s.type);
+}
+
+//-----------------------------------------------------------------------------
+
+struct batch_signer::impl {
+    using clock_type = std::chrono::steady_clock;
+
+    struct item {
+        buffer_t                      digest;
+        clock_type::time_point        arrival;
+        std::promise<batch_signature> promise;
+    };
+
+    pk::pk_base&                    key_;
+    const hash_t                    type_;
+    const size_t                    max_messages_;
+    const std::chrono::milliseconds window_;
+    std::mutex                      mutex_;
+    std::condition_variable         cv_;
+    std::vector<item>               pending_;
+    bool                            flush_ = false;
+    bool                            stop_  = false;
+    size_t                          batches_ = 0;
+    std::thread                     thread_;
+
+    explicit impl(
+        pk::pk_base& key, hash_t t, size_t max, std::chrono::milliseconds w)
+        : key_{key}, type_{t}, max_messages_{max}, window_{w} {
+        if (max_messages_ == 0)
+            throw exceptions::usage_error{"invalid batch size"};
+        hash::length(type_); // throws if not supported
+        thread_ = std::thread{[this]() { run(); }};
+    }
+
+    ~impl() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    std::future<batch_signature> submit(buffer_view_t message) {
+        item i{hash::make(type_, message), clock_type::now(), {}};
+        auto f = i.promise.get_future();
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            pending_.push_back(std::move(i));
+            if (pending_.size() < max_messages_)
+                return f;
+        }
+        cv_.notify_all();
+        return f;
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock{mutex_};
+        for (;;) {
+            cv_.wait(lock, [this]() { return stop_ || !pending_.empty(); });
+            if (pending_.empty())
+                return; // stopped
+            const auto deadline = pending_.front().arrival + window_;
+            cv_.wait_until(lock, deadline, [this]() {
+                return stop_ || flush_ || pending_.size() >= max_messages_;
+            });
+
+            std::vector<item> batch;
+            const size_t      size = std::min(pending_.size(), max_messages_);
+            std::move(
+                pending_.begin(),
+                pending_.begin() + size,
+                std::back_inserter(batch));
+            pending_.erase(pending_.begin(), pending_.begin() + size);
+            flush_ = flush_ && !pending_.empty();
+            ++batches_;
+
+            lock.unlock();
+            sign(batch);
+            lock.lock();
+        }
+    }
+
+    void sign(std::vector<item>& batch) {
+        try {
+            std::vector<buffer_t> digests;
+            digests.reserve(batch.size());
+            for (auto& i : batch)
+                digests.push_back(std::move(i.digest));
+
+            auto signatures = sign_digests(key_, std::move(digests), type_);
+            for (size_t j = 0; j < batch.size(); ++j)
+                batch[j].promise.set_value(std::move(signatures[j]));
+        } catch (...) {
+            for (auto& i : batch)
+                i.promise.set_exception(std::current_exception());
+        }
+    }
+}; // struct batch_signer::impl
+
+batch_signer::batch_signer(
+    pk::pk_base&              key,
+    hash_t                    type,
+    size_t                    max_messages,
+    std::chrono::milliseconds window)
+    : pimpl{std::make_unique<impl>(key, type, max_messages, window)} {}
+
+batch_signer::~batch_signer() = default;
+
+std::future<batch_signature>
+batch_signer::submit(buffer_view_t message) {
+    return pimpl->submit(message);
+}
+
+void
+batch_signer::flush() {
+    {
+        std::lock_guard<std::mutex> lock{pimpl->mutex_};
+        pimpl->flush_ = !pimpl->pending_.empty();
+    }
+    pimpl->cv_.notify_all();
+}
+
+size_t
+batch_signer::batches() const noexcept {
+    std::lock_guard<std::mutex> lock{pimpl->mutex_};
+    return pimpl->batches_;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace merkle
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,303 @@
+#include "mbedcrypto/pipeline.hpp"
+#include "mbedcrypto/tcodec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+/// a piece of data flowing between the stages
+struct span_t {
+    const uint8_t* data = nullptr;
+    size_t         size = 0;
+};
+
+/// grows once, then the buffer is reused by all the blocks
+uint8_t*
+room(buffer_t& buf, size_t size) {
+    if (buf.size() < size)
+        buf.resize(size);
+    return to_ptr(buf);
+}
+
+struct stage_t {
+    virtual ~stage_t() = default;
+    virtual void start() {}
+    /// processes a piece of data, returns the data for the next stage
+    virtual span_t push(span_t) = 0;
+    /// returns the remaining data at the end of the input, if any
+    virtual span_t flush() {
+        return span_t{};
+    }
+}; // struct stage_t
+
+template <class Digest> struct digest_stage : stage_t {
+    Digest&   digest_;
+    buffer_t& output_;
+
+    digest_stage(Digest& d, buffer_t& output) : digest_(d), output_(output) {}
+
+    void start() override {
+        digest_.start();
+    }
+
+    span_t push(span_t in) override {
+        digest_.update(in.data, in.size);
+        return in;
+    }
+
+    span_t flush() override {
+        output_ = digest_.finish();
+        return span_t{};
+    }
+}; // struct digest_stage
+
+struct cipher_stage : stage_t {
+    cipher&  cipher_;
+    buffer_t buffer_;
+
+    explicit cipher_stage(cipher& c) : cipher_(c) {}
+
+    void start() override {
+        cipher_.start();
+    }
+
+    span_t push(span_t in) override {
+        size_t osize = in.size + cipher_.block_size() + 32;
+        auto*  out   = room(buffer_, osize);
+        int    ret   = cipher_.update({in.data, in.size}, out, osize);
+        if (ret != 0)
+            throw exception{ret, __FUNCTION__};
+        return span_t{out, osize};
+    }
+
+    span_t flush() override {
+        size_t osize = cipher_.block_size() + 32;
+        auto*  out   = room(buffer_, osize);
+        int    ret   = cipher_.finish(out, osize);
+        if (ret != 0)
+            throw exception{ret, __FUNCTION__};
+        return span_t{out, osize};
+    }
+}; // struct cipher_stage
+
+/// keeps the bytes of an incomplete 3-byte group for the next push
+struct base64_stage : stage_t {
+    buffer_t buffer_;
+    uint8_t  carry_[3];
+    size_t   carried_ = 0;
+
+    void start() override {
+        carried_ = 0;
+    }
+
+    /// encodes size bytes (padded if not a multiple of 3) into out
+    static size_t encode(const uint8_t* src, size_t size, uint8_t* out) {
+        size_t olen = (size + 2) / 3 * 4 + 1; // + null
+        int    ret  = base64::encode(src, size, out, olen);
+        if (ret != 0)
+            throw exception{ret, __FUNCTION__};
+        return olen;
+    }
+
+    span_t push(span_t in) override {
+        auto* out = room(buffer_, (carried_ + in.size) / 3 * 4 + 1);
+        size_t o  = 0;
+        if (carried_ > 0) {
+            while (carried_ < 3 && in.size > 0) {
+                carry_[carried_++] = *in.data++;
+                --in.size;
+            }
+            if (carried_ < 3)
+                return span_t{};
+            o        = encode(carry_, 3, out);
+            carried_ = 0;
+        }
+
+        const size_t bulk = in.size / 3 * 3;
+        if (bulk > 0)
+            o += encode(in.data, bulk, out + o);
+        carried_ = in.size - bulk;
+        std::memcpy(carry_, in.data + bulk, carried_);
+        return span_t{out, o};
+    }
+
+    span_t flush() override {
+        if (carried_ == 0)
+            return span_t{};
+        auto* out = room(buffer_, 5);
+        auto  o   = encode(carry_, carried_, out);
+        carried_  = 0;
+        return span_t{out, o};
+    }
+}; // struct base64_stage
+
+struct hex_stage : stage_t {
+    buffer_t buffer_;
+
+    span_t push(span_t in) override {
+        static constexpr char Digits[] = "0123456789abcdef";
+        auto* out = room(buffer_, in.size * 2);
+        for (size_t i = 0; i < in.size; ++i) {
+            out[i * 2]     = Digits[in.data[i] >> 4];
+            out[i * 2 + 1] = Digits[in.data[i] & 0x0f];
+        }
+        return span_t{out, in.size * 2};
+    }
+}; // struct hex_stage
+
+struct sink_stage : stage_t {
+    pipeline::sink_t fn_;
+
+    explicit sink_stage(pipeline::sink_t fn) : fn_(std::move(fn)) {}
+
+    span_t push(span_t in) override {
+        fn_(in.data, in.size);
+        return in;
+    }
+}; // struct sink_stage
+
+struct buffer_sink_stage : stage_t {
+    buffer_t& output_;
+
+    explicit buffer_sink_stage(buffer_t& output) : output_(output) {}
+
+    span_t push(span_t in) override {
+        output_.append(reinterpret_cast<const char*>(in.data), in.size);
+        return in;
+    }
+}; // struct buffer_sink_stage
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct pipeline::impl {
+    size_t                                block_size = 0;
+    std::vector<std::unique_ptr<stage_t>> stages;
+    bool                                  started = false;
+
+    void add(std::unique_ptr<stage_t> s) {
+        stages.push_back(std::move(s));
+        started = false;
+    }
+
+    /// runs a piece of data through the stages, from the first index
+    void flow(size_t first, span_t data) {
+        for (size_t i = first; i < stages.size() && data.size > 0; ++i)
+            data = stages[i]->push(data);
+    }
+
+    void check_started() const {
+        if (!started)
+            throw exceptions::usage_error{"the pipeline is not started"};
+    }
+}; // struct pipeline::impl
+
+//-----------------------------------------------------------------------------
+
+constexpr size_t pipeline::default_block_size;
+
+pipeline::pipeline(size_t block_size) : pimpl{std::make_unique<impl>()} {
+    pimpl->block_size = block_size == 0 ? default_block_size : block_size;
+}
+
+pipeline::~pipeline()                     = default;
+pipeline::pipeline(pipeline&&)            = default;
+pipeline& pipeline::operator=(pipeline&&) = default;
+
+pipeline&
+pipeline::add_hash(hash& h, buffer_t& digest) {
+    pimpl->add(std::make_unique<digest_stage<hash>>(h, digest));
+    return *this;
+}
+
+pipeline&
+pipeline::add_hmac(hmac& h, buffer_t& digest) {
+    pimpl->add(std::make_unique<digest_stage<hmac>>(h, digest));
+    return *this;
+}
+
+pipeline&
+pipeline::add_cipher(cipher& c) {
+    pimpl->add(std::make_unique<cipher_stage>(c));
+    return *this;
+}
+
+pipeline&
+pipeline::add_base64() {
+    pimpl->add(std::make_unique<base64_stage>());
+    return *this;
+}
+
+pipeline&
+pipeline::add_hex() {
+    pimpl->add(std::make_unique<hex_stage>());
+    return *this;
+}
+
+pipeline&
+pipeline::add_sink(sink_t fn) {
+    if (!fn)
+        throw exceptions::usage_error{"the pipeline sink is empty"};
+    pimpl->add(std::make_unique<sink_stage>(std::move(fn)));
+    return *this;
+}
+
+pipeline&
+pipeline::add_sink(buffer_t& output) {
+    pimpl->add(std::make_unique<buffer_sink_stage>(output));
+    return *this;
+}
+
+size_t
+pipeline::size() const noexcept {
+    return pimpl->stages.size();
+}
+
+size_t
+pipeline::block_size() const noexcept {
+    return pimpl->block_size;
+}
+
+void
+pipeline::start() {
+    if (pimpl->stages.empty())
+        throw exceptions::usage_error{"the pipeline has no stage"};
+    for (auto& s : pimpl->stages)
+        s->start();
+    pimpl->started = true;
+}
+
+void
+pipeline::update(const uint8_t* chunk, size_t chunk_size) {
+    pimpl->check_started();
+    const auto bsize = pimpl->block_size;
+    for (size_t offset = 0; offset < chunk_size; offset += bsize) {
+        const auto size = std::min(bsize, chunk_size - offset);
+        pimpl->flow(0, span_t{chunk + offset, size});
+    }
+}
+
+void
+pipeline::finish() {
+    pimpl->check_started();
+    pimpl->started = false;
+    // the remainder of a stage flows through the next ones before they flush
+    for (size_t i = 0; i < pimpl->stages.size(); ++i)
+        pimpl->flow(i + 1, pimpl->stages[i]->flush());
+}
+
+void
+pipeline::run(buffer_view_t input) {
+    start();
+    update(input);
+    finish();
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
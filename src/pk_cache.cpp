@@ -0,0 +1,322 @@
+#include "mbedcrypto/pk_cache.hpp"
+#include "./pk_private.hpp"
+
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace pk {
+namespace {
+//-----------------------------------------------------------------------------
+
+/* layout (native byte order, guarded by the marker):
+ *  0: "MBCK"
+ *  4: version (1 byte), limb size (1 byte), pk type (1 byte), flags (1 byte)
+ *  8: byte order marker (4 bytes)
+ * 12: total size (4 bytes), including the checksum
+ * 16: ec group id (2 bytes), reserved (2 bytes)
+ * 20: big numbers, each as the number of limbs (4 bytes) and the limbs
+ *  -: CRC-32 of all the above (4 bytes)
+ */
+enum K : uint32_t {
+    version     = 2, ///< 1 also kept R^2 mod N, P and Q
+    header_size = 20,
+    crc_size    = 4,
+    marker      = 0x01020304,
+    is_private  = 0x01, ///< flags
+};
+
+constexpr char Magic[4] = {'M', 'B', 'C', 'K'};
+
+/// CRC-32 (IEEE 802.3), a table driven implementation
+uint32_t
+crc32(const uint8_t* data, size_t size) noexcept {
+    struct table_t {
+        uint32_t values[256];
+        table_t() noexcept {
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+                values[i] = c;
+            }
+        }
+    };
+    static const table_t table;
+
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; ++i)
+        crc = table.values[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    return crc ^ 0xffffffffu;
+}
+
+[[noreturn]] void
+invalid_cache() {
+    throw exception{MBEDTLS_ERR_PK_KEY_INVALID_FORMAT, "invalid key cache"};
+}
+
+/// true if 0 < a < n
+bool
+in_range(const mbedtls_mpi& a, const mbedtls_mpi& n) noexcept {
+    return mbedtls_mpi_cmp_int(&a, 0) > 0 && mbedtls_mpi_cmp_mpi(&a, &n) < 0;
+}
+
+/** the cheap checks of a loaded rsa key, by the sizes and the ranges of its
+ * values (no exponentiation). the pairing of the private and the public
+ * parts is not checked.
+ */
+void
+check_rsa(const mbedtls_rsa_context& rsa, bool priv) {
+    if (mbedtls_rsa_check_pubkey(&rsa) != 0)
+        invalid_cache();
+    if (!priv)
+        return;
+
+    const size_t bits = mbedtls_mpi_bitlen(&rsa.N);
+    const size_t pq   = mbedtls_mpi_bitlen(&rsa.P) + mbedtls_mpi_bitlen(&rsa.Q);
+    if (pq < bits || pq > bits + 1 || mbedtls_mpi_get_bit(&rsa.P, 0) != 1 ||
+        mbedtls_mpi_get_bit(&rsa.Q, 0) != 1 || !in_range(rsa.D, rsa.N) ||
+        !in_range(rsa.DP, rsa.P) || !in_range(rsa.DQ, rsa.Q) ||
+        !in_range(rsa.QP, rsa.P))
+        invalid_cache();
+}
+
+/// number of significant limbs
+size_t
+limbs_of(const mbedtls_mpi& x) noexcept {
+    return (mbedtls_mpi_size(&x) + sizeof(mbedtls_mpi_uint) - 1) /
+           sizeof(mbedtls_mpi_uint);
+}
+
+struct writer {
+    buffer_t& out;
+
+    template <typename T> void put(T value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    /// stores the significant limbs only
+    void put_mpi(const mbedtls_mpi& x) {
+        const auto limbs = static_cast<uint32_t>(limbs_of(x));
+        put(limbs);
+        out.append(
+            reinterpret_cast<const char*>(x.p),
+            limbs * sizeof(mbedtls_mpi_uint));
+    }
+}; // struct writer
+
+struct reader {
+    const uint8_t* p;
+    const uint8_t* end;
+
+    template <typename T> T get() {
+        T value;
+        if (static_cast<size_t>(end - p) < sizeof(T))
+            invalid_cache();
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return value;
+    }
+
+    void get_mpi(mbedtls_mpi& x) {
+        const auto limbs = get<uint32_t>();
+        const auto bytes = size_t{limbs} * sizeof(mbedtls_mpi_uint);
+        if (static_cast<size_t>(end - p) < bytes)
+            invalid_cache();
+
+        mbedtls_mpi_free(&x);
+        if (limbs == 0) { // zero
+            mbedcrypto_c_call(mbedtls_mpi_lset, &x, 0);
+            return;
+        }
+        mbedcrypto_c_call(mbedtls_mpi_grow, &x, limbs);
+        std::memcpy(x.p, p, bytes);
+        p += bytes;
+    }
+}; // struct reader
+
+/// by the key data, load_key() does not mark the private keys
+bool
+has_secret(const context& d) {
+    switch (type_of(d)) {
+    case pk_t::rsa:
+        return mbedtls_mpi_cmp_int(&mbedtls_pk_rsa(d.pk_)->D, 0) != 0;
+#if defined(MBEDTLS_ECP_C)
+    case pk_t::eckey:
+    case pk_t::eckey_dh:
+    case pk_t::ecdsa:
+        return mbedtls_mpi_cmp_int(&mbedtls_pk_ec(d.pk_)->d, 0) != 0;
+#endif // MBEDTLS_ECP_C
+    default:
+        return false;
+    }
+}
+
+/// checks the header and the checksum
+bool
+check_cache(buffer_view_t data) noexcept {
+    if (data.size() < header_size + crc_size)
+        return false;
+
+    const auto* p = data.data();
+    uint32_t    mark = 0, total = 0, crc = 0;
+    std::memcpy(&mark, p + 8, 4);
+    std::memcpy(&total, p + 12, 4);
+    std::memcpy(&crc, p + data.size() - crc_size, 4);
+
+    return std::memcmp(p, Magic, 4) == 0 && p[4] == version &&
+           p[5] == sizeof(mbedtls_mpi_uint) && mark == marker &&
+           total == data.size() && crc == crc32(p, data.size() - crc_size);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+buffer_t
+to_cache(const context& d) {
+    const auto ptype = type_of(d);
+    if (d.pk_.pk_info == nullptr || key_bitlen(d) == 0)
+        throw exceptions::usage_error{"the key is empty"};
+    const bool priv = has_secret(d);
+
+    buffer_t out;
+    out.reserve(header_size + crc_size + 16 * key_length(d));
+    writer w{out};
+    out.append(Magic, 4);
+    w.put(static_cast<uint8_t>(version));
+    w.put(static_cast<uint8_t>(sizeof(mbedtls_mpi_uint)));
+    w.put(static_cast<uint8_t>(to_native(ptype)));
+    w.put(static_cast<uint8_t>(priv ? uint32_t{is_private} : 0));
+    w.put(static_cast<uint32_t>(marker));
+    w.put(uint32_t{0}); // total size, set below
+    uint16_t group_id = 0;
+
+    switch (ptype) {
+    case pk_t::rsa: {
+        const auto* rsa = mbedtls_pk_rsa(d.pk_);
+        w.put(group_id);
+        w.put(uint16_t{0});
+
+        // the montgomery constants (RN, RP, RQ) are not kept: a forged one
+        // would make faulty CRT signatures, leaking P and Q (bellcore).
+        // mbedtls computes them by the first operation
+        w.put_mpi(rsa->N);
+        w.put_mpi(rsa->E);
+        if (priv) {
+            w.put_mpi(rsa->D);
+            w.put_mpi(rsa->P);
+            w.put_mpi(rsa->Q);
+            w.put_mpi(rsa->DP);
+            w.put_mpi(rsa->DQ);
+            w.put_mpi(rsa->QP);
+        }
+    } break;
+
+#if defined(MBEDTLS_ECP_C)
+    case pk_t::eckey:
+    case pk_t::eckey_dh:
+    case pk_t::ecdsa: {
+        const auto* ec = mbedtls_pk_ec(d.pk_);
+        group_id       = static_cast<uint16_t>(ec->grp.id);
+        w.put(group_id);
+        w.put(uint16_t{0});
+        // the public point is kept in the affine (decompressed) form
+        w.put_mpi(ec->Q.X);
+        w.put_mpi(ec->Q.Y);
+        w.put_mpi(ec->Q.Z);
+        if (priv)
+            w.put_mpi(ec->d);
+    } break;
+#endif // MBEDTLS_ECP_C
+
+    default:
+        throw exceptions::unknown_pk{};
+    }
+
+    const auto total = static_cast<uint32_t>(out.size() + crc_size);
+    std::memcpy(&out[12], &total, 4);
+    w.put(crc32(to_const_ptr(out), out.size()));
+    return out;
+}
+
+void
+from_cache(context& d, buffer_view_t cache) {
+    if (!check_cache(cache)) {
+        if (cache.size() > 5 && std::memcmp(cache.data(), Magic, 4) == 0 &&
+            cache.data()[4] != version)
+            throw exception{
+                MBEDTLS_ERR_PK_KEY_INVALID_VERSION, "invalid key cache"};
+        invalid_cache();
+    }
+
+    const auto* p     = cache.data();
+    const auto  ptype = from_native(static_cast<mbedtls_pk_type_t>(p[6]));
+    const bool  priv  = (p[7] & is_private) != 0;
+    uint16_t    group_id = 0;
+    std::memcpy(&group_id, p + 16, 2);
+
+    reset_as(d, ptype); // throws on type mismatch
+    reader r{p + header_size, p + cache.size() - crc_size};
+
+    try {
+        switch (ptype) {
+        case pk_t::rsa: {
+            auto* rsa = mbedtls_pk_rsa(d.pk_);
+            r.get_mpi(rsa->N);
+            r.get_mpi(rsa->E);
+            if (priv) {
+                r.get_mpi(rsa->D);
+                r.get_mpi(rsa->P);
+                r.get_mpi(rsa->Q);
+                r.get_mpi(rsa->DP);
+                r.get_mpi(rsa->DQ);
+                r.get_mpi(rsa->QP);
+            }
+            rsa->len = mbedtls_mpi_size(&rsa->N);
+            check_rsa(*rsa, priv);
+            check_public_exponent(d.pk_);
+        } break;
+
+#if defined(MBEDTLS_ECP_C)
+        case pk_t::eckey:
+        case pk_t::eckey_dh:
+        case pk_t::ecdsa: {
+            auto* ec = mbedtls_pk_ec(d.pk_);
+            mbedcrypto_c_call(
+                mbedtls_ecp_group_load,
+                &ec->grp,
+                static_cast<mbedtls_ecp_group_id>(group_id));
+            r.get_mpi(ec->Q.X);
+            r.get_mpi(ec->Q.Y);
+            r.get_mpi(ec->Q.Z);
+            mbedcrypto_c_call(mbedtls_ecp_check_pubkey, &ec->grp, &ec->Q);
+            if (priv) {
+                r.get_mpi(ec->d);
+                mbedcrypto_c_call(mbedtls_ecp_check_privkey, &ec->grp, &ec->d);
+            }
+        } break;
+#endif // MBEDTLS_ECP_C
+
+        default:
+            invalid_cache();
+        }
+
+        if (r.p != r.end)
+            invalid_cache();
+    } catch (...) {
+        reset_as(d, ptype);
+        throw;
+    }
+
+    d.key_is_private_ = priv;
+}
+
+bool
+is_cache(buffer_view_t data) noexcept {
+    return check_cache(data);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace pk
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,635 @@
+#include "mbedcrypto/pk_loader.hpp"
+#include "mbedcrypto/ecp.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "./fs_utils.hpp"
+#include "./pk_private.hpp"
+#include "./worker_pool.hpp"
+
+#include <mbedtls/asn1.h>
+#include <mbedtls/pem.h>
+#include <mbedtls/pkcs5.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace pk {
+namespace {
+//-----------------------------------------------------------------------------
+
+enum class entry_kind {
+    public_key,    ///< pem: PUBLIC KEY
+    rsa_public,    ///< pem: RSA PUBLIC KEY (PKCS#1)
+    private_key,   ///< pem: PRIVATE KEY, RSA PRIVATE KEY, EC PRIVATE KEY
+    encrypted_key, ///< pem: ENCRYPTED PRIVATE KEY (PKCS#8)
+    der,           ///< binary, private or public
+    failed,        ///< the source could not be read
+    no_footer,     ///< pem: a known header without its footer
+};
+
+struct pem_label {
+    const char* name;
+    entry_kind  kind;
+    const char* header;
+    const char* footer;
+};
+
+#define MBEDCRYPTO_PEM_LABEL(NAME, KIND)                                       \
+    { NAME, entry_kind::KIND,                                                  \
+      "-----BEGIN " NAME "-----", "-----END " NAME "-----" }
+
+const pem_label KnownLabels[] = {
+    MBEDCRYPTO_PEM_LABEL("PUBLIC KEY",            public_key),
+    MBEDCRYPTO_PEM_LABEL("RSA PUBLIC KEY",        rsa_public),
+    MBEDCRYPTO_PEM_LABEL("PRIVATE KEY",           private_key),
+    MBEDCRYPTO_PEM_LABEL("RSA PRIVATE KEY",       private_key),
+    MBEDCRYPTO_PEM_LABEL("EC PRIVATE KEY",        private_key),
+    MBEDCRYPTO_PEM_LABEL("ENCRYPTED PRIVATE KEY", encrypted_key),
+};
+
+#undef MBEDCRYPTO_PEM_LABEL
+
+/** a key inside a source buffer, a view (no copy).
+ * for pem entries data points to the "-----BEGIN" line and the source is
+ * null terminated at data + size - 1.
+ */
+struct entry_t {
+    const uint8_t*   data  = nullptr;
+    size_t           size  = 0;
+    const pem_label* label = nullptr; ///< nullptr for der and failed entries
+    entry_kind       kind  = entry_kind::der;
+    std::string      name; ///< source name, @sa loaded_key::source
+};
+
+using entries_t = std::vector<entry_t>;
+
+// RAII helpers
+struct pem_holder {
+    mbedtls_pem_context ctx_;
+    pem_holder() {
+        mbedtls_pem_init(&ctx_);
+    }
+    ~pem_holder() {
+        mbedtls_pem_free(&ctx_);
+    }
+};
+
+struct pk_holder {
+    mbedtls_pk_context ctx_;
+    pk_holder() {
+        mbedtls_pk_init(&ctx_);
+    }
+    ~pk_holder() {
+        mbedtls_pk_free(&ctx_);
+    }
+};
+
+struct md_holder {
+    mbedtls_md_context_t ctx_;
+    md_holder() {
+        mbedtls_md_init(&ctx_);
+    }
+    ~md_holder() {
+        mbedtls_md_free(&ctx_);
+    }
+};
+
+struct cipher_holder {
+    mbedtls_cipher_context_t ctx_;
+    cipher_holder() {
+        mbedtls_cipher_init(&ctx_);
+    }
+    ~cipher_holder() {
+        mbedtls_cipher_free(&ctx_);
+    }
+};
+
+/// wipes the sensitive data on scope exit
+struct secret_buffer : buffer_t {
+    using buffer_t::buffer_t;
+    ~secret_buffer() {
+        if (!empty())
+            mbedtls_platform_zeroize(&front(), size());
+    }
+};
+
+//-----------------------------------------------------------------------------
+
+const char*
+find(const char* begin, const char* end, const char* needle) {
+    return std::search(begin, end, needle, needle + std::strlen(needle));
+}
+
+const pem_label*
+find_label(const char* name, size_t length) {
+    for (const auto& l : KnownLabels) {
+        if (std::strlen(l.name) == length &&
+            std::memcmp(l.name, name, length) == 0)
+            return &l;
+    }
+    return nullptr;
+}
+
+bool
+is_pem(buffer_view_t src) {
+    const auto* begin = reinterpret_cast<const char*>(src.data());
+    const auto* end   = begin + src.size();
+    return find(begin, end, "-----BEGIN ") != end;
+}
+
+bool
+is_null_terminated(buffer_view_t src) {
+    return src.size() > 0 && src.data()[src.size() - 1] == '\0';
+}
+
+/** splits a null terminated pem bundle into its key entries. unknown blocks
+ * (certificates, ...) are skipped.
+ * src.size() must include the null terminator.
+ */
+void
+split_pem(buffer_view_t src, const std::string& name, entries_t& entries) {
+    const auto* begin = reinterpret_cast<const char*>(src.data());
+    const auto* end   = begin + src.size();
+
+    entries_t found;
+    for (const auto* p = find(begin, end, "-----BEGIN "); p != end;) {
+        const auto* label     = p + 11; // strlen("-----BEGIN ")
+        const auto* label_end = find(label, end, "-----");
+        if (label_end == end)
+            break;
+
+        const auto* next  = find(label_end, end, "-----BEGIN ");
+        const auto* known = find_label(label, label_end - label);
+        if (known != nullptr) {
+            entry_t e;
+            e.data  = reinterpret_cast<const uint8_t*>(p);
+            e.size  = end - p;
+            e.label = known;
+            e.kind  = known->kind;
+            // mbedtls looks for the footer up to the end of the bundle, the
+            // headers without a footer before the next block would make the
+            // parsing quadratic
+            if (find(label_end, next, known->footer) == next)
+                e.kind = entry_kind::no_footer;
+            found.emplace_back(std::move(e));
+        }
+
+        p = next;
+    }
+
+    // names are indexed only if a source has more than a key
+    for (size_t i = 0; i < found.size(); ++i) {
+        found[i].name = name;
+        if (found.size() > 1)
+            found[i].name.append("#").append(std::to_string(i));
+        entries.emplace_back(std::move(found[i]));
+    }
+}
+
+void
+add_der(buffer_view_t src, const std::string& name, entries_t& entries) {
+    entry_t e;
+    e.data = src.data();
+    e.size = src.size();
+    e.kind = entry_kind::der;
+    e.name = name;
+    entries.emplace_back(std::move(e));
+}
+
+void
+add_source(
+    buffer_view_t      src,
+    const std::string& name,
+    buffer_t&          copy, // storage if a pem source is not null terminated
+    entries_t&         entries) {
+    if (!is_pem(src)) {
+        add_der(src, name, entries);
+    } else if (is_null_terminated(src)) {
+        split_pem(src, name, entries);
+    } else {
+        copy = src.to<buffer_t>();
+        split_pem(
+            buffer_view_t{to_const_ptr(copy), copy.size() + 1}, name, entries);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// PKCS#8 PBES2 (RFC 8018) decryption, mbedtls' own pkcs5 only supports
+// hmacWithSHA1 and DES based schemes, modern tools default to AES and SHA256.
+
+struct oid_t {
+    const uint8_t* data;
+    size_t         size;
+};
+
+#define MBEDCRYPTO_OID(...)                                                    \
+    oid_t {                                                                    \
+        (const uint8_t*)__VA_ARGS__, sizeof(__VA_ARGS__) - 1                   \
+    }
+
+const oid_t OidPbes2  = MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x01\x05\x0d");
+const oid_t OidPbkdf2 = MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x01\x05\x0c");
+
+const struct {
+    oid_t             oid;
+    mbedtls_md_type_t md;
+} PbePrfs[] = {
+    {MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x02\x07"), MBEDTLS_MD_SHA1},
+    {MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x02\x08"), MBEDTLS_MD_SHA224},
+    {MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x02\x09"), MBEDTLS_MD_SHA256},
+    {MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x02\x0a"), MBEDTLS_MD_SHA384},
+    {MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x02\x0b"), MBEDTLS_MD_SHA512},
+};
+
+const struct {
+    oid_t                 oid;
+    mbedtls_cipher_type_t cipher;
+} PbeCiphers[] = {
+    {MBEDCRYPTO_OID("\x60\x86\x48\x01\x65\x03\x04\x01\x02"),
+     MBEDTLS_CIPHER_AES_128_CBC},
+    {MBEDCRYPTO_OID("\x60\x86\x48\x01\x65\x03\x04\x01\x16"),
+     MBEDTLS_CIPHER_AES_192_CBC},
+    {MBEDCRYPTO_OID("\x60\x86\x48\x01\x65\x03\x04\x01\x2a"),
+     MBEDTLS_CIPHER_AES_256_CBC},
+    {MBEDCRYPTO_OID("\x2a\x86\x48\x86\xf7\x0d\x03\x07"),
+     MBEDTLS_CIPHER_DES_EDE3_CBC},
+    {MBEDCRYPTO_OID("\x2b\x0e\x03\x02\x07"), MBEDTLS_CIPHER_DES_CBC},
+};
+
+#undef MBEDCRYPTO_OID
+
+bool
+operator==(const mbedtls_asn1_buf& a, const oid_t& b) {
+    return a.len == b.size && std::memcmp(a.p, b.data, b.size) == 0;
+}
+
+constexpr int SequenceTag = MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE;
+
+[[noreturn]] void
+throw_format_error() {
+    throw exception{MBEDTLS_ERR_PK_KEY_INVALID_FORMAT, "pbes2"};
+}
+
+/** decrypts a PKCS#8 EncryptedPrivateKeyInfo if it has been encrypted by
+ * PBES2, returns false if the der is not a PBES2 key, throws on errors.
+ */
+bool
+pbes2_decrypt(
+    const uint8_t* der, size_t length, buffer_view_t pass, secret_buffer& out) {
+    auto* p   = const_cast<uint8_t*>(der);
+    auto* end = p + length;
+
+    size_t len = 0;
+    if (mbedtls_asn1_get_tag(&p, end, &len, SequenceTag) != 0)
+        return false;
+    end = p + len;
+
+    mbedtls_asn1_buf alg, params;
+    if (mbedtls_asn1_get_alg(&p, end, &alg, &params) != 0 ||
+        !(alg == OidPbes2))
+        return false; // not a PBES2, probably a PKCS#12 pbe
+
+    if (pass.empty())
+        throw exception{MBEDTLS_ERR_PK_PASSWORD_REQUIRED, "pbes2"};
+
+    const uint8_t* encrypted = nullptr;
+    size_t         enc_size  = 0;
+    mbedcrypto_c_call(
+        mbedtls_asn1_get_tag, &p, end, &enc_size, MBEDTLS_ASN1_OCTET_STRING);
+    encrypted = p;
+
+    // PBES2-params: { keyDerivationFunc, encryptionScheme }
+    if (params.tag != SequenceTag)
+        throw_format_error();
+    p   = params.p;
+    end = p + params.len;
+
+    mbedtls_asn1_buf kdf, kdf_params, scheme, iv;
+    mbedcrypto_c_call(mbedtls_asn1_get_alg, &p, end, &kdf, &kdf_params);
+    mbedcrypto_c_call(mbedtls_asn1_get_alg, &p, end, &scheme, &iv);
+    if (!(kdf == OidPbkdf2) || kdf_params.tag != SequenceTag ||
+        iv.tag != MBEDTLS_ASN1_OCTET_STRING)
+        throw_format_error();
+
+    // PBKDF2-params: { salt, iterationCount, keyLength OPTIONAL, prf DEFAULT }
+    p   = kdf_params.p;
+    end = p + kdf_params.len;
+
+    size_t salt_size = 0;
+    mbedcrypto_c_call(
+        mbedtls_asn1_get_tag, &p, end, &salt_size, MBEDTLS_ASN1_OCTET_STRING);
+    const uint8_t* salt = p;
+    p += salt_size;
+
+    int iterations = 0;
+    mbedcrypto_c_call(mbedtls_asn1_get_int, &p, end, &iterations);
+
+    int key_size = 0;
+    if (p < end && *p == MBEDTLS_ASN1_INTEGER)
+        mbedcrypto_c_call(mbedtls_asn1_get_int, &p, end, &key_size);
+
+    auto md_type = MBEDTLS_MD_SHA1;
+    if (p < end) {
+        mbedtls_asn1_buf prf, prf_params;
+        mbedcrypto_c_call(mbedtls_asn1_get_alg, &p, end, &prf, &prf_params);
+
+        md_type = MBEDTLS_MD_NONE;
+        for (const auto& m : PbePrfs) {
+            if (prf == m.oid)
+                md_type = m.md;
+        }
+    }
+
+    const mbedtls_cipher_info_t* cinfo = nullptr;
+    for (const auto& c : PbeCiphers) {
+        if (scheme == c.oid)
+            cinfo = mbedtls_cipher_info_from_type(c.cipher);
+    }
+
+    const auto* minfo = mbedtls_md_info_from_type(md_type);
+    if (cinfo == nullptr || minfo == nullptr)
+        throw exception{MBEDTLS_ERR_PK_FEATURE_UNAVAILABLE, "pbes2"};
+
+    // the cost is set by the key itself
+    if (iterations > MaxPbkdf2Iterations)
+        throw exception{
+            MBEDTLS_ERR_PK_KEY_INVALID_FORMAT, "too many pbkdf2 iterations"};
+
+    const size_t cipher_key_size = cinfo->key_bitlen / 8;
+    if (iterations <= 0 ||
+        (key_size != 0 && static_cast<size_t>(key_size) != cipher_key_size) ||
+        iv.len != cinfo->iv_size)
+        throw_format_error();
+
+    // derive the key
+    secret_buffer key(cipher_key_size, '\0');
+    {
+        md_holder md;
+        mbedcrypto_c_call(mbedtls_md_setup, &md.ctx_, minfo, 1);
+        mbedcrypto_c_call(
+            mbedtls_pkcs5_pbkdf2_hmac,
+            &md.ctx_,
+            pass.data(),
+            pass.size(),
+            salt,
+            salt_size,
+            static_cast<unsigned int>(iterations),
+            static_cast<uint32_t>(cipher_key_size),
+            to_ptr(key));
+    }
+
+    // decrypt, the padding check is the password check
+    cipher_holder cipher;
+    mbedcrypto_c_call(mbedtls_cipher_setup, &cipher.ctx_, cinfo);
+    mbedcrypto_c_call(
+        mbedtls_cipher_setkey,
+        &cipher.ctx_,
+        to_const_ptr(key),
+        static_cast<int>(cinfo->key_bitlen),
+        MBEDTLS_DECRYPT);
+
+    out.resize(enc_size + cinfo->block_size);
+    size_t olen = 0;
+    int    ret  = mbedtls_cipher_crypt(
+        &cipher.ctx_,
+        iv.p,
+        iv.len,
+        encrypted,
+        enc_size,
+        to_ptr(out),
+        &olen);
+    if (ret == MBEDTLS_ERR_CIPHER_INVALID_PADDING ||
+        (ret == 0 && (olen == 0 || out[0] != 0x30)))
+        throw exception{MBEDTLS_ERR_PK_PASSWORD_MISMATCH, "pbes2"};
+    else if (ret != 0)
+        throw exception{ret, "pbes2"};
+
+    out.resize(olen);
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+
+void
+parse_private_der(
+    mbedtls_pk_context& pk, const uint8_t* der, size_t size, buffer_view_t pass) {
+    secret_buffer plain;
+    if (pbes2_decrypt(der, size, pass, plain)) {
+        mbedcrypto_c_call(
+            mbedtls_pk_parse_key,
+            &pk,
+            to_const_ptr(plain),
+            plain.size(),
+            nullptr,
+            0);
+    } else {
+        mbedcrypto_c_call(
+            mbedtls_pk_parse_key, &pk, der, size, pass.data(), pass.size());
+    }
+}
+
+/// returns true if the parsed key is a private one
+bool
+parse_entry(mbedtls_pk_context& pk, const entry_t& e, buffer_view_t pass) {
+    switch (e.kind) {
+    case entry_kind::failed:
+        throw exceptions::usage_error{reinterpret_cast<const char*>(e.data)};
+
+    case entry_kind::no_footer:
+        throw exception{MBEDTLS_ERR_PEM_NO_HEADER_FOOTER_PRESENT, "pem"};
+
+    case entry_kind::der:
+        // a public key is cheaper to check, the private key error is
+        // reported if neither works
+        if (mbedtls_pk_parse_public_key(&pk, e.data, e.size) == 0)
+            return false;
+
+        mbedtls_pk_free(&pk);
+        mbedtls_pk_init(&pk);
+        parse_private_der(pk, e.data, e.size, pass);
+        return true;
+
+    case entry_kind::rsa_public:
+        // the first header mbedtls looks for is the RSA PUBLIC KEY, which
+        // is exactly where this entry begins
+        mbedcrypto_c_call(mbedtls_pk_parse_public_key, &pk, e.data, e.size);
+        return false;
+
+    default:
+        break;
+    }
+
+    const bool legacy_encryption = e.kind == entry_kind::private_key;
+
+    pem_holder pem;
+    size_t     used = 0;
+    mbedcrypto_c_call(
+        mbedtls_pem_read_buffer,
+        &pem.ctx_,
+        e.label->header,
+        e.label->footer,
+        e.data,
+        legacy_encryption ? pass.data() : nullptr,
+        legacy_encryption ? pass.size() : 0,
+        &used);
+
+    if (e.kind == entry_kind::public_key) {
+        mbedcrypto_c_call(
+            mbedtls_pk_parse_public_key, &pk, pem.ctx_.buf, pem.ctx_.buflen);
+        return false;
+    }
+
+    if (e.kind == entry_kind::encrypted_key) {
+        parse_private_der(pk, pem.ctx_.buf, pem.ctx_.buflen, pass);
+    } else {
+        mbedcrypto_c_call(
+            mbedtls_pk_parse_key,
+            &pk,
+            pem.ctx_.buf,
+            pem.ctx_.buflen,
+            nullptr,
+            0);
+    }
+    return true;
+}
+
+std::unique_ptr<pk_base>
+make_key(mbedtls_pk_context& parsed, bool is_private) {
+    check_public_exponent(parsed);
+
+    std::unique_ptr<pk_base> key;
+
+    auto ptype = from_native(mbedtls_pk_get_type(&parsed));
+    switch (ptype) {
+    case pk_t::rsa:
+        key = std::make_unique<rsa>();
+        break;
+
+#if defined(MBEDTLS_ECP_C)
+    case pk_t::eckey:
+    case pk_t::ecdsa:
+        key = std::make_unique<ecp>(ptype);
+        break;
+#endif // MBEDTLS_ECP_C
+
+    default:
+        throw exceptions::unknown_pk{};
+    }
+
+    // moves the parsed key into the instance
+    auto& d = key->context();
+    reset(d);
+    std::swap(d.pk_, parsed);
+    d.key_is_private_ = is_private;
+
+    return key;
+}
+
+loaded_keys
+parse_all(const entries_t& entries, const bulk_options& opts) {
+    loaded_keys keys(entries.size());
+
+    worker_pool::shared().parallel_for(
+        entries.size(),
+        [&](size_t i) {
+            const auto& e = entries[i];
+            auto&       k = keys[i];
+            k.source      = e.name;
+
+            try {
+                pk_holder pk;
+                bool is_private = parse_entry(pk.ctx_, e, opts.password);
+                k.key           = make_key(pk.ctx_, is_private);
+            } catch (const exception& err) {
+                k.error        = err.code();
+                k.error_string = err.what();
+            } catch (const std::exception& err) {
+                k.error_string = err.what();
+            }
+        },
+        opts.max_threads);
+
+    return keys;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+loaded_keys
+load_bundle(buffer_view_t bundle, const bulk_options& opts) {
+    entries_t entries;
+    buffer_t  copy;
+    if (is_null_terminated(bundle)) {
+        split_pem(bundle, std::string{}, entries);
+    } else {
+        copy = bundle.to<buffer_t>();
+        split_pem(
+            buffer_view_t{to_const_ptr(copy), copy.size() + 1},
+            std::string{},
+            entries);
+    }
+
+    return parse_all(entries, opts);
+}
+
+loaded_keys
+load_buffers(const std::vector<buffer_view_t>& keys, const bulk_options& opts) {
+    entries_t             entries;
+    std::vector<buffer_t> copies(keys.size());
+
+    for (size_t i = 0; i < keys.size(); ++i) {
+        add_source(
+            keys[i], "[" + std::to_string(i) + "]", copies[i], entries);
+    }
+
+    return parse_all(entries, opts);
+}
+
+loaded_keys
+load_directory(const char* dir_path, const bulk_options& opts) {
+    auto files = fs::list_files(dir_path);
+
+    // the file i/o is also done in parallel
+    std::vector<buffer_t>    contents(files.size());
+    std::vector<std::string> errors(files.size());
+    worker_pool::shared().parallel_for(
+        files.size(),
+        [&](size_t i) {
+            try {
+                contents[i] = fs::read_file(files[i].c_str());
+            } catch (const std::exception& err) {
+                errors[i] = err.what();
+            }
+        },
+        opts.max_threads);
+
+    entries_t entries;
+    for (size_t i = 0; i < files.size(); ++i) {
+        if (!errors[i].empty()) {
+            entry_t e;
+            e.data = reinterpret_cast<const uint8_t*>(errors[i].c_str());
+            e.kind = entry_kind::failed;
+            e.name = files[i];
+            entries.emplace_back(std::move(e));
+        } else {
+            // std::string is always null terminated
+            buffer_view_t src{to_const_ptr(contents[i]), contents[i].size()};
+            if (is_pem(src))
+                split_pem(
+                    buffer_view_t{src.data(), src.size() + 1},
+                    files[i],
+                    entries);
+            else
+                add_der(src, files[i], entries);
+        }
+    }
+
+    return parse_all(entries, opts);
+}
+
+//-----------------------------------------------------------------------------
+} // namespace pk
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
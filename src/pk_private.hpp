@@ -13,6 +13,7 @@
 #include "mbedcrypto/rnd_generator.hpp"
 
 #include "./conversions.hpp"
+#include "./memory_private.hpp"
 
 #include <mbedtls/bignum.h>
 #include <mbedtls/pk_internal.h>
@@ -23,12 +24,36 @@ namespace pk {
 
 auto native_info(pk_t) -> const mbedtls_pk_info_t*;
 
+/** deep copies the public part of src (rsa or ec) into dst.
+ * dst must be set up by the type of src, the private part is not copied.
+ */
+void copy_public_part(mbedtls_pk_context& dst, const mbedtls_pk_context& src);
+
+/// the mbedtls heap of a pk context (the key and its big numbers)
+size_t heap_size(const mbedtls_pk_context&) noexcept;
+
+/// the limits of the costs which an imported key sets by itself
+constexpr int    MaxPbkdf2Iterations   = 1000000;
+constexpr size_t MaxPublicExponentBits = 64;
+
+/** throws if the PBKDF2 iterations of an encrypted PKCS#8 key (der or pem)
+ * are more than MaxPbkdf2Iterations. other keys are left to the parser.
+ */
+void check_pbkdf2_iterations(buffer_view_t key);
+
+/** frees pk and throws if it is a rsa key with a public exponent larger than
+ * MaxPublicExponentBits, which makes the public operations (verify, encrypt)
+ * and the blinding of the private ones as slow as a non-CRT private operation.
+ */
+void check_public_exponent(mbedtls_pk_context& pk);
+
 //-----------------------------------------------------------------------------
 
 struct context {
     bool               key_is_private_ = false;
     rnd_generator      rnd_{"mbedcrypto pki implementation"};
     mbedtls_pk_context pk_;
+    memory::counter    counter_{memory::kind::pk, sizeof(context)};
 
     context() {
         mbedtls_pk_init(&pk_);
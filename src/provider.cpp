@@ -0,0 +1,487 @@
+#include "mbedcrypto/provider.hpp"
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/hash.hpp"
+
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_move_constructible<dispatcher>::value == true, "");
+static_assert(std::is_copy_constructible<dispatcher>::value == false, "");
+static_assert(std::is_nothrow_move_constructible<operation>::value, "");
+
+using kind_t = operation::kind_t;
+
+/// the in-process operations, by the public apis of mbedcrypto
+class builtin final : public provider
+{
+public:
+    const char* name() const noexcept override {
+        return "builtin";
+    }
+
+    bool supports(const operation& op) const noexcept override {
+        switch (op.kind) {
+        case kind_t::hash:
+        case kind_t::hmac:
+            return mbedcrypto::supports(op.hash_type);
+        case kind_t::encrypt:
+        case kind_t::decrypt:
+        case kind_t::encrypt_aead:
+        case kind_t::decrypt_aead:
+            return mbedcrypto::supports(op.cipher_type);
+        case kind_t::sign:
+        case kind_t::verify:
+            return op.pk_key != nullptr;
+        }
+        return false;
+    }
+
+    op_result run(const operation& op) override {
+        op_result r;
+        r.provider = name();
+        try {
+            compute(op, r);
+        } catch (...) {
+            r.ok    = false;
+            r.error = std::current_exception();
+        }
+        return r;
+    }
+
+protected:
+    static void compute(const operation& op, op_result& r) {
+        switch (op.kind) {
+        case kind_t::hash:
+            r.output = hash::make(op.hash_type, op.input);
+            break;
+        case kind_t::hmac:
+            r.output = hmac::make(op.hash_type, op.key, op.input);
+            break;
+        case kind_t::encrypt:
+            r.output = cipher::encrypt(
+                op.cipher_type, op.padding, op.iv, op.key, op.input);
+            break;
+        case kind_t::decrypt:
+            r.output = cipher::decrypt(
+                op.cipher_type, op.padding, op.iv, op.key, op.input);
+            break;
+        case kind_t::encrypt_aead:
+            std::tie(r.tag, r.output) = cipher::encrypt_aead(
+                op.cipher_type, op.iv, op.key, op.ad, op.input);
+            break;
+        case kind_t::decrypt_aead:
+            std::tie(r.ok, r.output) = cipher::decrypt_aead(
+                op.cipher_type, op.iv, op.key, op.ad, op.tag, op.input);
+            break;
+        case kind_t::sign:
+            r.output = pk::sign(pk_key_of(op), op.input, op.hash_type);
+            break;
+        case kind_t::verify:
+            r.ok = pk::verify(pk_key_of(op), op.tag, op.input, op.hash_type);
+            break;
+        }
+    }
+
+    static pk::context& pk_key_of(const operation& op) {
+        if (op.pk_key == nullptr)
+            throw exceptions::usage_error{"the operation requires a pk key"};
+        return *op.pk_key;
+    }
+}; // class builtin
+
+/** zeroes the whole capacity of a key. a moved-from short key leaves its
+ * bytes in the inline (small string) buffer of the source.
+ */
+void
+wipe(buffer_t& key) noexcept {
+    key.resize(key.capacity());
+    mbedtls_platform_zeroize(&key[0], key.size());
+    key.clear();
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+operation::~operation() {
+    wipe(key);
+}
+
+operation
+operation::hash(hash_t type, buffer_view_t input) {
+    operation op;
+    op.kind      = kind_t::hash;
+    op.hash_type = type;
+    op.input     = input.to<buffer_t>();
+    return op;
+}
+
+operation
+operation::hmac(hash_t type, buffer_view_t key, buffer_view_t input) {
+    operation op;
+    op.kind      = kind_t::hmac;
+    op.hash_type = type;
+    op.key       = key.to<buffer_t>();
+    op.input     = input.to<buffer_t>();
+    return op;
+}
+
+operation
+operation::encrypt(
+    cipher_t      type,
+    padding_t     pad,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t input) {
+    operation op;
+    op.kind        = kind_t::encrypt;
+    op.cipher_type = type;
+    op.padding     = pad;
+    op.iv          = iv.to<buffer_t>();
+    op.key         = key.to<buffer_t>();
+    op.input       = input.to<buffer_t>();
+    return op;
+}
+
+operation
+operation::decrypt(
+    cipher_t      type,
+    padding_t     pad,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t input) {
+    auto op = encrypt(type, pad, iv, key, input);
+    op.kind = kind_t::decrypt;
+    return op;
+}
+
+operation
+operation::encrypt_aead(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t ad,
+    buffer_view_t input) {
+    operation op;
+    op.kind        = kind_t::encrypt_aead;
+    op.cipher_type = type;
+    op.iv          = iv.to<buffer_t>();
+    op.key         = key.to<buffer_t>();
+    op.ad          = ad.to<buffer_t>();
+    op.input       = input.to<buffer_t>();
+    return op;
+}
+
+operation
+operation::decrypt_aead(
+    cipher_t      type,
+    buffer_view_t iv,
+    buffer_view_t key,
+    buffer_view_t ad,
+    buffer_view_t tag,
+    buffer_view_t input) {
+    auto op = encrypt_aead(type, iv, key, ad, input);
+    op.kind = kind_t::decrypt_aead;
+    op.tag  = tag.to<buffer_t>();
+    return op;
+}
+
+operation
+operation::sign(pk::context& key, buffer_view_t hash_value, hash_t type) {
+    operation op;
+    op.kind      = kind_t::sign;
+    op.hash_type = type;
+    op.input     = hash_value.to<buffer_t>();
+    op.pk_key    = &key;
+    return op;
+}
+
+operation
+operation::verify(
+    pk::context&  key,
+    buffer_view_t signature,
+    buffer_view_t hash_value,
+    hash_t        type) {
+    auto op = sign(key, hash_value, type);
+    op.kind = kind_t::verify;
+    op.tag  = signature.to<buffer_t>();
+    return op;
+}
+
+std::shared_ptr<provider>
+builtin_provider() {
+    static auto instance = std::make_shared<builtin>();
+    return instance;
+}
+
+//-----------------------------------------------------------------------------
+
+struct offload_provider::impl {
+    struct slot {
+        operation    op;
+        completion_t done;
+    };
+
+    std::shared_ptr<provider> backend_;
+    size_t                    batch_size_;
+
+    mutable std::mutex       mutex_;
+    std::condition_variable  cv_;
+    std::vector<slot>        ring_; ///< [head_, head_ + count_) are queued
+    size_t                   head_  = 0;
+    size_t                   count_ = 0;
+    bool                     stop_  = false;
+    counters                 stats_;
+    std::vector<std::thread> workers_;
+
+    explicit impl(options& opt)
+        : backend_{opt.backend ? opt.backend : builtin_provider()},
+          batch_size_{std::max<size_t>(opt.batch_size, 1)},
+          ring_(std::max<size_t>(opt.queue_size, 1)) {
+        size_t n = opt.workers;
+        if (n == 0)
+            n = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+        workers_.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            workers_.emplace_back([this]() { work(); });
+    }
+
+    ~impl() {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            stop_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_)
+            t.join();
+    }
+
+    bool push(operation& op, completion_t& done) {
+        {
+            std::lock_guard<std::mutex> lock{mutex_};
+            if (count_ == ring_.size()) {
+                ++stats_.rejected;
+                return false;
+            }
+            auto& s = ring_[(head_ + count_) % ring_.size()];
+            s.op    = std::move(op);
+            s.done  = std::move(done);
+            ++count_;
+            ++stats_.submitted;
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    /// takes a batch per wake up, runs it, then reports its completions
+    void work() {
+        std::vector<slot>      batch;
+        std::vector<op_result> results;
+        batch.reserve(batch_size_);
+        results.reserve(batch_size_);
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock{mutex_};
+                cv_.wait(lock, [this]() { return stop_ || count_ > 0; });
+                if (count_ == 0) // stopped and drained
+                    return;
+                while (count_ > 0 && batch.size() < batch_size_) {
+                    auto& s = ring_[head_];
+                    batch.push_back(std::move(s));
+                    // no key nor callback is left in the ring
+                    wipe(s.op.key);
+                    s.done = nullptr;
+                    head_  = (head_ + 1) % ring_.size();
+                    --count_;
+                }
+                ++stats_.batches;
+            }
+
+            for (const auto& s : batch)
+                results.push_back(execute(s.op));
+            for (size_t i = 0; i < batch.size(); ++i)
+                batch[i].done(std::move(results[i]));
+
+            {
+                std::lock_guard<std::mutex> lock{mutex_};
+                stats_.completed += batch.size();
+            }
+            batch.clear();
+            results.clear();
+        }
+    }
+
+    op_result execute(const operation& op) {
+        op_result r;
+        try {
+            r = backend_->run(op);
+        } catch (...) {
+            r.ok    = false;
+            r.error = std::current_exception();
+        }
+        r.provider = "offload";
+        return r;
+    }
+}; // struct offload_provider::impl
+
+offload_provider::offload_provider() : offload_provider(options{}) {}
+
+offload_provider::offload_provider(options opt)
+    : pimpl{std::make_unique<impl>(opt)} {}
+
+offload_provider::~offload_provider() = default;
+
+const char*
+offload_provider::name() const noexcept {
+    return "offload";
+}
+
+bool
+offload_provider::supports(const operation& op) const noexcept {
+    return pimpl->backend_->supports(op);
+}
+
+op_result
+offload_provider::run(const operation& op) {
+    return pimpl->execute(op);
+}
+
+bool
+offload_provider::submit(operation& op, completion_t done) {
+    return pimpl->push(op, done);
+}
+
+size_t
+offload_provider::pending() const {
+    std::lock_guard<std::mutex> lock{pimpl->mutex_};
+    return pimpl->count_;
+}
+
+size_t
+offload_provider::capacity() const noexcept {
+    return pimpl->ring_.size();
+}
+
+auto
+offload_provider::stats() const -> counters {
+    std::lock_guard<std::mutex> lock{pimpl->mutex_};
+    return pimpl->stats_;
+}
+
+//-----------------------------------------------------------------------------
+
+struct dispatcher::impl {
+    /// by priority, the builtin is not in the list
+    std::vector<std::shared_ptr<provider>> providers_;
+    std::shared_ptr<provider>              builtin_ = builtin_provider();
+
+    std::atomic<size_t> submitted_{0};
+    std::atomic<size_t> fallbacks_{0};
+    std::atomic<size_t> inline_runs_{0};
+};
+
+dispatcher::dispatcher() : pimpl{std::make_unique<impl>()} {}
+dispatcher::~dispatcher()                       = default;
+dispatcher::dispatcher(dispatcher&&)            = default;
+dispatcher& dispatcher::operator=(dispatcher&&) = default;
+
+dispatcher&
+dispatcher::add(std::shared_ptr<provider> p) {
+    if (!p)
+        throw exceptions::usage_error{"null crypto provider"};
+    pimpl->providers_.insert(pimpl->providers_.begin(), std::move(p));
+    return *this;
+}
+
+provider&
+dispatcher::resolve(const operation& op) const {
+    for (const auto& p : pimpl->providers_) {
+        if (p->supports(op))
+            return *p;
+    }
+    return *pimpl->builtin_;
+}
+
+void
+dispatcher::submit(operation op, provider::completion_t done) {
+    for (const auto& p : pimpl->providers_) {
+        if (!p->supports(op))
+            continue;
+        if (p->submit(op, done)) {
+            ++pimpl->submitted_;
+            return;
+        }
+        ++pimpl->fallbacks_; // saturated
+    }
+    ++pimpl->inline_runs_;
+    done(pimpl->builtin_->run(op));
+}
+
+std::future<op_result>
+dispatcher::async(operation op) {
+    auto promise = std::make_shared<std::promise<op_result>>();
+    auto future  = promise->get_future();
+    submit(std::move(op), [promise](op_result&& r) {
+        if (r.error)
+            promise->set_exception(r.error);
+        else
+            promise->set_value(std::move(r));
+    });
+    return future;
+}
+
+op_result
+dispatcher::run(operation op) {
+    return async(std::move(op)).get();
+}
+
+std::vector<op_result>
+dispatcher::run_many(std::vector<operation> ops) {
+    struct state_t {
+        std::vector<op_result>  results;
+        std::atomic<size_t>     remaining;
+        std::mutex              mutex;
+        std::condition_variable cv;
+
+        explicit state_t(size_t n) : results(n), remaining{n} {}
+    };
+
+    auto state = std::make_shared<state_t>(ops.size());
+    for (size_t i = 0; i < ops.size(); ++i) {
+        submit(std::move(ops[i]), [state, i](op_result&& r) {
+            state->results[i] = std::move(r);
+            if (--state->remaining == 0) {
+                std::lock_guard<std::mutex> lock{state->mutex};
+                state->cv.notify_one();
+            }
+        });
+    }
+
+    std::unique_lock<std::mutex> lock{state->mutex};
+    state->cv.wait(lock, [&state]() { return state->remaining == 0; });
+    return std::move(state->results);
+}
+
+auto
+dispatcher::stats() const -> counters {
+    counters c;
+    c.submitted   = pimpl->submitted_;
+    c.fallbacks   = pimpl->fallbacks_;
+    c.inline_runs = pimpl->inline_runs_;
+    return c;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,233 @@
+#include "mbedcrypto/public_key.hpp"
+#include "./pk_private.hpp"
+
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+static_assert(std::is_copy_constructible<public_key>::value == false, "");
+static_assert(std::is_move_constructible<public_key>::value == true, "");
+
+/// the generator of encrypt() without an explicit rnd_generator
+rnd_generator&
+thread_rnd() {
+    thread_local rnd_generator rnd{"mbedcrypto public key"};
+    return rnd;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct public_key::impl {
+    mbedtls_pk_context pk_;
+    memory::counter    counter_{
+        memory::kind::public_key, sizeof(public_key) + sizeof(impl)};
+
+    impl() {
+        mbedtls_pk_init(&pk_);
+    }
+
+    ~impl() {
+        mbedtls_pk_free(&pk_);
+    }
+
+    void reset() noexcept {
+        mbedtls_pk_free(&pk_);
+        mbedtls_pk_init(&pk_);
+    }
+
+    pk_t type() const {
+        return from_native(mbedtls_pk_get_type(&pk_));
+    }
+
+    bool can_do(pk_t ptype) const {
+        int ret = mbedtls_pk_can_do(&pk_, to_native(ptype));
+        // refinement due to build options, @sa pk::can_do()
+        if (type() == pk_t::eckey && ptype == pk_t::ecdsa) {
+            if (!supports(pk_t::ecdsa))
+                ret = 0;
+        }
+        return ret == 1;
+    }
+
+    size_t max_crypt_size() const {
+        if (type() == pk_t::rsa)
+            return mbedtls_pk_get_len(&pk_) - 11;
+#if defined(MBEDTLS_ECDSA_C)
+        else if (can_do(pk_t::ecdsa))
+            return (size_t)MBEDTLS_ECDSA_MAX_LEN;
+#endif
+        throw exceptions::support_error{};
+    }
+
+    void check_crypt_size_of(buffer_view_t in) const {
+        if (in.size() > max_crypt_size())
+            throw exceptions::usage_error{
+                "the input value is larger than max_crypt_size()"};
+    }
+}; // struct public_key::impl
+
+//-----------------------------------------------------------------------------
+
+public_key::public_key() : pimpl{std::make_unique<impl>()} {}
+
+public_key::public_key(buffer_view_t pub_data)
+    : pimpl{std::make_unique<impl>()} {
+    import(pub_data);
+}
+
+public_key::public_key(const pk::pk_base& key)
+    : pimpl{std::make_unique<impl>()} {
+    assign(key);
+}
+
+public_key::~public_key() = default;
+
+public_key::public_key(public_key&&) = default;
+
+public_key& public_key::operator=(public_key&&) = default;
+
+void
+public_key::import(buffer_view_t pub_data) {
+    pimpl->reset();
+    mbedcrypto_c_call(
+        mbedtls_pk_parse_public_key,
+        &pimpl->pk_,
+        pub_data.data(),
+        pub_data.size());
+    pk::check_public_exponent(pimpl->pk_);
+}
+
+void
+public_key::load(const char* fpath) {
+    pimpl->reset();
+    mbedcrypto_c_call(mbedtls_pk_parse_public_keyfile, &pimpl->pk_, fpath);
+    pk::check_public_exponent(pimpl->pk_);
+}
+
+void
+public_key::assign(const pk::pk_base& key) {
+    const auto& src = key.context().pk_;
+    if (src.pk_info == nullptr)
+        throw exceptions::usage_error{"the source key is empty"};
+
+    pimpl->reset();
+    mbedcrypto_c_call(mbedtls_pk_setup, &pimpl->pk_, src.pk_info);
+    try {
+        pk::copy_public_part(pimpl->pk_, src);
+    } catch (...) {
+        pimpl->reset();
+        throw;
+    }
+}
+
+bool
+public_key::empty() const noexcept {
+    return pimpl->pk_.pk_info == nullptr;
+}
+
+pk_t
+public_key::type() const {
+    return pimpl->type();
+}
+
+const char*
+public_key::name() const noexcept {
+    return mbedtls_pk_get_name(&pimpl->pk_);
+}
+
+size_t
+public_key::key_bitlen() const noexcept {
+    return (size_t)mbedtls_pk_get_bitlen(&pimpl->pk_);
+}
+
+size_t
+public_key::key_length() const noexcept {
+    return (size_t)mbedtls_pk_get_len(&pimpl->pk_);
+}
+
+size_t
+public_key::max_crypt_size() const {
+    return pimpl->max_crypt_size();
+}
+
+memory::usage
+public_key::footprint() const noexcept {
+    memory::usage u;
+    u.inline_bytes = sizeof(public_key) + sizeof(impl);
+    u.heap_bytes   = pk::heap_size(pimpl->pk_);
+    return u;
+}
+
+bool
+public_key::can_do(pk_t ptype) const {
+    return pimpl->can_do(ptype);
+}
+
+bool
+public_key::verify(
+    buffer_view_t signature, buffer_view_t hvalue, hash_t halgo) const {
+    auto& d = *pimpl;
+    if (d.type() != pk_t::rsa && !d.can_do(pk_t::ecdsa))
+        throw exceptions::support_error{};
+
+    d.check_crypt_size_of(hvalue);
+
+    int ret = mbedtls_pk_verify(
+        &d.pk_,
+        to_native(halgo),
+        hvalue.data(),
+        hvalue.size(),
+        signature.data(),
+        signature.size());
+
+    switch (ret) {
+    case 0:
+        return true;
+
+    case MBEDTLS_ERR_PK_BAD_INPUT_DATA:
+    case MBEDTLS_ERR_PK_TYPE_MISMATCH:
+        throw exception{ret, "failed to verify the signature"};
+        break;
+    default:
+        break;
+    }
+
+    return false;
+}
+
+buffer_t
+public_key::encrypt(buffer_view_t source, rnd_generator& rnd) const {
+    auto& d = *pimpl;
+    if (d.type() != pk_t::rsa)
+        throw exceptions::support_error{};
+
+    d.check_crypt_size_of(source);
+
+    size_t   olen = 32 + d.max_crypt_size();
+    buffer_t output(olen, '\0');
+
+    mbedcrypto_c_call(
+        mbedtls_pk_encrypt,
+        &d.pk_,
+        source.data(),
+        source.size(),
+        to_ptr(output),
+        &olen,
+        olen,
+        rnd_generator::maker,
+        &rnd);
+
+    output.resize(olen);
+    return output;
+}
+
+buffer_t
+public_key::encrypt(buffer_view_t source) const {
+    return encrypt(source, thread_rnd());
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,318 @@
+#include "mbedcrypto/record_layer.hpp"
+#include "./conversions.hpp"
+
+#include <mbedtls/cipher.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<record_layer>::value == false, "");
+static_assert(std::is_move_constructible<record_layer>::value == true, "");
+
+enum K : size_t {
+    word_bits = 64,
+};
+
+void
+put_be16(uint8_t* p, uint16_t v) noexcept {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v);
+}
+
+uint16_t
+get_be16(const uint8_t* p) noexcept {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+void
+put_be64(uint8_t* p, uint64_t v) noexcept {
+    for (int i = 7; i >= 0; --i, v >>= 8)
+        p[i] = static_cast<uint8_t>(v);
+}
+
+uint64_t
+get_be64(const uint8_t* p) noexcept {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+/** the received sequence numbers, a bitmap of the window below (and
+ * including) the highest one. bit s % size marks the sequence s.
+ */
+struct replay_window {
+    std::vector<uint64_t> bits;
+    uint64_t              top   = 0; ///< the highest accepted sequence
+    bool                  empty = true;
+
+    explicit replay_window(size_t window)
+        : bits((std::max<size_t>(window, 1) + word_bits - 1) / word_bits, 0) {}
+
+    uint64_t size() const noexcept {
+        return uint64_t{bits.size()} * word_bits;
+    }
+
+    bool test(uint64_t seq) const noexcept {
+        const auto i = seq % size();
+        return (bits[i / word_bits] >> (i % word_bits)) & 1;
+    }
+
+    void set(uint64_t seq) noexcept {
+        const auto i = seq % size();
+        bits[i / word_bits] |= uint64_t{1} << (i % word_bits);
+    }
+
+    void clear(uint64_t seq) noexcept {
+        const auto i = seq % size();
+        bits[i / word_bits] &= ~(uint64_t{1} << (i % word_bits));
+    }
+
+    /// true if seq is new and inside the window
+    bool check(uint64_t seq) const noexcept {
+        if (empty || seq > top)
+            return true;
+        if (top - seq >= size())
+            return false; // too old
+        return !test(seq);
+    }
+
+    /// marks an authenticated sequence, slides the window if newer
+    void accept(uint64_t seq) noexcept {
+        if (empty || seq > top) {
+            const auto shift = empty ? size() : seq - top;
+            if (shift >= size()) {
+                std::fill(bits.begin(), bits.end(), 0);
+            } else {
+                for (auto s = top + 1; s < seq; ++s)
+                    clear(s);
+            }
+            top   = seq;
+            empty = false;
+        }
+        set(seq);
+    }
+
+    void reset() noexcept {
+        std::fill(bits.begin(), bits.end(), 0);
+        top   = 0;
+        empty = true;
+    }
+}; // struct replay_window
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct record_layer::impl {
+    mbedtls_cipher_context_t ctx_;
+    uint16_t                 version_;
+    bool                     has_key_  = false;
+    uint64_t                 next_seq_ = 0;
+    uint8_t                  iv_[iv_size];
+    replay_window            window_;
+
+    impl(cipher_t type, uint16_t version, size_t window)
+        : version_{version}, window_{window} {
+        const auto bm = cipher::block_mode(type);
+        if (bm != cipher_bm::gcm && bm != cipher_bm::ccm)
+            throw exceptions::usage_error{"record_layer needs an aead cipher"};
+
+        mbedtls_cipher_init(&ctx_);
+        const auto* info = mbedtls_cipher_info_from_type(to_native(type));
+        if (info == nullptr)
+            throw exceptions::unknown_cipher{};
+        mbedcrypto_c_call(mbedtls_cipher_setup, &ctx_, info);
+    }
+
+    ~impl() {
+        mbedtls_cipher_free(&ctx_);
+        mbedtls_platform_zeroize(iv_, sizeof(iv_));
+    }
+
+    void nonce(uint8_t* out, uint64_t seq) const noexcept {
+        uint8_t counter[8];
+        put_be64(counter, seq);
+        std::memcpy(out, iv_, iv_size);
+        for (size_t i = 0; i < 8; ++i)
+            out[iv_size - 8 + i] ^= counter[i];
+    }
+
+    size_t seal(uint8_t type, buffer_view_t payload, uint8_t* output) {
+        if (!has_key_)
+            throw exceptions::usage_error{"the key of record_layer is not set"};
+        if (payload.size() > max_payload)
+            throw exceptions::usage_error{"the record payload is too large"};
+        if (next_seq_ == UINT64_MAX)
+            throw exceptions::usage_error{"the sequence numbers are exhausted"};
+
+        const auto seq = next_seq_;
+        output[0]      = type;
+        put_be16(output + 1, version_);
+        put_be64(output + 3, seq);
+        put_be16(output + 11, static_cast<uint16_t>(payload.size() + tag_size));
+
+        uint8_t iv[iv_size];
+        nonce(iv, seq);
+#if defined(MBEDTLS_CIPHER_MODE_AEAD)
+        size_t olen = 0;
+        mbedcrypto_c_call(
+            mbedtls_cipher_auth_encrypt,
+            &ctx_,
+            iv,
+            iv_size,
+            output,
+            header_size,
+            payload.data(),
+            payload.size(),
+            output + header_size,
+            &olen,
+            output + header_size + payload.size(),
+            tag_size);
+#else  // MBEDTLS_CIPHER_MODE_AEAD
+        throw exceptions::aead_error{};
+#endif // MBEDTLS_CIPHER_MODE_AEAD
+
+        ++next_seq_;
+        return sealed_size(payload.size());
+    }
+
+    opened open(buffer_view_t record, uint8_t* output) {
+        if (!has_key_)
+            throw exceptions::usage_error{"the key of record_layer is not set"};
+
+        opened r;
+        const auto* header = record.data();
+        if (record.size() < overhead || record_size(record) != record.size() ||
+            get_be16(header + 1) != version_)
+            return r; // malformed
+
+        r.type           = header[0];
+        r.sequence       = get_be64(header + 3);
+        const size_t len = record.size() - overhead;
+        if (!window_.check(r.sequence)) {
+            r.result = status::replayed;
+            return r;
+        }
+
+        uint8_t iv[iv_size];
+        nonce(iv, r.sequence);
+#if defined(MBEDTLS_CIPHER_MODE_AEAD)
+        size_t    olen = 0;
+        const int ret  = mbedtls_cipher_auth_decrypt(
+            &ctx_,
+            iv,
+            iv_size,
+            header,
+            header_size,
+            header + header_size,
+            len,
+            output,
+            &olen,
+            header + header_size + len,
+            tag_size);
+        if (ret == MBEDTLS_ERR_CIPHER_AUTH_FAILED) {
+            mbedtls_platform_zeroize(output, len);
+            r.result = status::forged;
+            return r;
+        } else if (ret != 0) {
+            mbedtls_platform_zeroize(output, len);
+            throw exception{ret, __FUNCTION__};
+        }
+#else  // MBEDTLS_CIPHER_MODE_AEAD
+        throw exceptions::aead_error{};
+#endif // MBEDTLS_CIPHER_MODE_AEAD
+
+        window_.accept(r.sequence);
+        r.result = status::ok;
+        r.size   = len;
+        return r;
+    }
+}; // struct record_layer::impl
+
+//-----------------------------------------------------------------------------
+
+constexpr size_t record_layer::header_size;
+constexpr size_t record_layer::tag_size;
+constexpr size_t record_layer::iv_size;
+constexpr size_t record_layer::overhead;
+constexpr size_t record_layer::max_payload;
+constexpr size_t record_layer::default_window;
+
+size_t
+record_layer::record_size(buffer_view_t data) noexcept {
+    if (data.size() < header_size)
+        return 0;
+    return header_size + get_be16(data.data() + 11);
+}
+
+record_layer::record_layer(cipher_t type, uint16_t version, size_t window)
+    : pimpl{std::make_unique<impl>(type, version, window)} {}
+
+record_layer::~record_layer() = default;
+
+record_layer::record_layer(record_layer&&) = default;
+
+record_layer& record_layer::operator=(record_layer&&) = default;
+
+record_layer&
+record_layer::key(buffer_view_t key_data, buffer_view_t iv) {
+    if (iv.size() != iv_size)
+        throw exceptions::usage_error{"record_layer needs a 12 bytes iv"};
+
+    auto& d = *pimpl;
+    // gcm and ccm only use the forward direction of the block cipher
+    mbedcrypto_c_call(
+        mbedtls_cipher_setkey,
+        &d.ctx_,
+        key_data.data(),
+        static_cast<int>(key_data.size() << 3),
+        MBEDTLS_ENCRYPT);
+    std::memcpy(d.iv_, iv.data(), iv_size);
+    d.has_key_  = true;
+    d.next_seq_ = 0;
+    d.window_.reset();
+    return *this;
+}
+
+size_t
+record_layer::seal(uint8_t type, buffer_view_t payload, uint8_t* output) {
+    return pimpl->seal(type, payload, output);
+}
+
+buffer_t
+record_layer::seal(uint8_t type, buffer_view_t payload) {
+    buffer_t output(sealed_size(payload.size()), '\0');
+    pimpl->seal(type, payload, to_ptr(output));
+    return output;
+}
+
+size_t
+record_layer::seal_many(
+    uint8_t                           type,
+    const std::vector<buffer_view_t>& payloads,
+    uint8_t*                          output) {
+    size_t total = 0;
+    for (const auto& p : payloads)
+        total += pimpl->seal(type, p, output + total);
+    return total;
+}
+
+auto
+record_layer::open(buffer_view_t record, uint8_t* output) -> opened {
+    return pimpl->open(record, output);
+}
+
+uint64_t
+record_layer::next_sequence() const noexcept {
+    return pimpl->next_seq_;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
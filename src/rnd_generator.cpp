@@ -1,4 +1,5 @@
 #include "mbedcrypto/rnd_generator.hpp"
+#include "./memory_private.hpp"
 
 #include <mbedtls/ctr_drbg.h>
 #include <mbedtls/entropy.h>
@@ -47,6 +48,8 @@ make_chunked(mbedtls_ctr_drbg_context* ctx, uint8_t* buffer, size_t length) {
 struct rnd_generator::impl {
     mbedtls_entropy_context  entropy_;
     mbedtls_ctr_drbg_context ctx_;
+    memory::counter          counter_{
+        memory::kind::rnd_generator, sizeof(rnd_generator) + sizeof(impl)};
 
     explicit impl() noexcept {}
 
@@ -123,6 +126,13 @@ rnd_generator::update(const uint8_t* additional, size_t length) noexcept {
     mbedtls_ctr_drbg_update(&pimpl->ctx_, additional, length);
 }
 
+memory::usage
+rnd_generator::footprint() const noexcept {
+    memory::usage u;
+    u.inline_bytes = sizeof(rnd_generator) + sizeof(impl);
+    return u;
+}
+
 //-----------------------------------------------------------------------------
 } // namespace mbedcrypto
 //-----------------------------------------------------------------------------
@@ -0,0 +1,449 @@
+#include "./rsa_crt.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "./conversions.hpp"
+#include "./fixed_base.hpp"
+
+#include <mbedtls/oid.h>
+#include <mbedtls/platform_util.h>
+
+#include <algorithm>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace rsa_crt {
+namespace {
+//-----------------------------------------------------------------------------
+
+using limb_t = mont_modulus::limb_t;
+
+enum : size_t {
+    sieve_bound   = 1 << 16, ///< the small primes of the sieve
+    sieve_window  = 4096,    ///< odd candidates after a random start
+    prime_rounds  = 5,       ///< Miller-Rabin rounds by random bases
+    min_padding   = 8,       ///< of the PKCS#1 v1.5 encoding
+    digest_header = 10,      ///< DER of a DigestInfo, except oid and hash
+};
+
+struct mpi_holder {
+    mbedtls_mpi ctx_;
+    mpi_holder() {
+        mbedtls_mpi_init(&ctx_);
+    }
+    ~mpi_holder() {
+        mbedtls_mpi_free(&ctx_);
+    }
+};
+
+/// a big-endian secret, wiped on destruction
+struct secret_t {
+    buffer_t data_;
+    explicit secret_t(size_t size) : data_(size, '\0') {}
+    ~secret_t() {
+        mbedtls_platform_zeroize(to_ptr(data_), data_.size());
+    }
+    uint8_t* ptr() noexcept {
+        return to_ptr(data_);
+    }
+};
+
+/// a number in Montgomery form, wiped on destruction
+struct number_t {
+    std::vector<limb_t> data_;
+    explicit number_t(const mont_modulus& m) : data_(m.limbs(), 0) {}
+    ~number_t() {
+        mbedtls_platform_zeroize(data_.data(), data_.size() * sizeof(limb_t));
+    }
+    limb_t* ptr() noexcept {
+        return data_.data();
+    }
+    bool operator==(const number_t& o) const noexcept {
+        return data_ == o.data_;
+    }
+};
+
+/// big-endian of size bytes
+void
+write_to(secret_t& out, const mbedtls_mpi& x) {
+    mbedcrypto_c_call(
+        mbedtls_mpi_write_binary, &x, out.ptr(), out.data_.size());
+}
+
+buffer_t
+binary_of(const mbedtls_mpi& x) {
+    buffer_t out(mbedtls_mpi_size(&x), '\0');
+    mbedcrypto_c_call(mbedtls_mpi_write_binary, &x, to_ptr(out), out.size());
+    return out;
+}
+
+size_t
+limbs_of(const mbedtls_mpi& x) noexcept {
+    return (mbedtls_mpi_size(&x) + sizeof(limb_t) - 1) / sizeof(limb_t);
+}
+
+/** the DigestInfo of a hash (RFC 8017, 9.2), or the hash itself for
+ * MBEDTLS_MD_NONE. returns false for an unknown algorithm or a hash value of
+ * another size.
+ */
+bool
+digest_info(buffer_t& out, mbedtls_md_type_t halgo, buffer_view_t hvalue) {
+    if (halgo == MBEDTLS_MD_NONE) {
+        out.assign(reinterpret_cast<const char*>(hvalue.data()), hvalue.size());
+        return true;
+    }
+
+    const auto* info = mbedtls_md_info_from_type(halgo);
+    const char* oid  = nullptr;
+    size_t      olen = 0;
+    if (info == nullptr || mbedtls_md_get_size(info) != hvalue.size() ||
+        mbedtls_oid_get_oid_by_md(halgo, &oid, &olen) != 0)
+        return false;
+
+    const auto hlen = hvalue.size();
+    out.clear();
+    out.reserve(digest_header + olen + hlen);
+    out.push_back(0x30); // SEQUENCE
+    out.push_back(static_cast<char>(0x08 + olen + hlen));
+    out.push_back(0x30); // SEQUENCE
+    out.push_back(static_cast<char>(0x04 + olen));
+    out.push_back(0x06); // OID
+    out.push_back(static_cast<char>(olen));
+    out.append(oid, olen);
+    out.push_back(0x05); // NULL
+    out.push_back(0x00);
+    out.push_back(0x04); // OCTET STRING
+    out.push_back(static_cast<char>(hlen));
+    out.append(reinterpret_cast<const char*>(hvalue.data()), hlen);
+    return true;
+}
+
+/// the Vi/Vf blinding pair of mbedtls: Vi = Vf^-e, squared on each use
+void
+prepare_blinding(mbedtls_rsa_context& rsa, rnd_generator& rnd) {
+    if (rsa.Vf.p != nullptr) {
+        mbedcrypto_c_call(mbedtls_mpi_mul_mpi, &rsa.Vi, &rsa.Vi, &rsa.Vi);
+        mbedcrypto_c_call(mbedtls_mpi_mod_mpi, &rsa.Vi, &rsa.Vi, &rsa.N);
+        mbedcrypto_c_call(mbedtls_mpi_mul_mpi, &rsa.Vf, &rsa.Vf, &rsa.Vf);
+        mbedcrypto_c_call(mbedtls_mpi_mod_mpi, &rsa.Vf, &rsa.Vf, &rsa.N);
+        return;
+    }
+
+    for (int count = 0; ; ++count) {
+        if (count > 10)
+            throw exception{
+                MBEDTLS_ERR_RSA_RNG_FAILED, "failed to make a blinding value"};
+        mbedcrypto_c_call(
+            mbedtls_mpi_fill_random,
+            &rsa.Vf,
+            rsa.len - 1,
+            rnd_generator::maker,
+            &rnd);
+        // not invertible by a chance of 1 / min(p, q)
+        const int ret = mbedtls_mpi_inv_mod(&rsa.Vi, &rsa.Vf, &rsa.N);
+        if (ret == 0)
+            break;
+        if (ret != MBEDTLS_ERR_MPI_NOT_ACCEPTABLE)
+            throw exception{ret, "mbedtls_mpi_inv_mod"};
+    }
+    mbedcrypto_c_call(
+        mbedtls_mpi_exp_mod, &rsa.Vi, &rsa.Vi, &rsa.E, &rsa.N, &rsa.RN);
+}
+
+//-----------------------------------------------------------------------------
+
+const std::vector<uint32_t>&
+small_primes() {
+    static const std::vector<uint32_t> primes = []() {
+        std::vector<bool>     composite(sieve_bound, false);
+        std::vector<uint32_t> result;
+        for (uint32_t i = 3; i < sieve_bound; i += 2) {
+            if (composite[i])
+                continue;
+            result.push_back(i);
+            for (uint32_t j = i * i; j < sieve_bound; j += 2 * i)
+                composite[j] = true;
+        }
+        return result;
+    }();
+    return primes;
+}
+
+/// Miller-Rabin tests of an odd candidate by random bases
+bool
+is_probable_prime(const mbedtls_mpi& x, rnd_generator& rnd) {
+    const mont_modulus m{binary_of(x), tuned_crossover()};
+
+    // x - 1 = d * 2^s
+    mpi_holder d;
+    mbedcrypto_c_call(mbedtls_mpi_sub_int, &d.ctx_, &x, 1);
+    const size_t s = mbedtls_mpi_lsb(&d.ctx_);
+    mbedcrypto_c_call(mbedtls_mpi_shift_r, &d.ctx_, s);
+    const auto exponent = binary_of(d.ctx_);
+
+    number_t one{m}, minus_one{m}, y{m};
+    std::copy(m.one(), m.one() + m.limbs(), one.ptr());
+    m.sub(minus_one.ptr(), y.ptr(), one.ptr()); // y is zero
+
+    for (size_t round = 0; round < prime_rounds; ++round) {
+        auto base = rnd.make(m.size() - 1); // less than x
+        base.back() |= 2;                   // and not 0 or 1
+        m.to_mont(y.ptr(), base);
+        m.power(y.ptr(), y.ptr(), exponent);
+        if (y == one || y == minus_one)
+            continue;
+
+        size_t i = 1;
+        for (; i < s; ++i) {
+            m.mul(y.ptr(), y.ptr(), y.ptr());
+            if (y == minus_one)
+                break;
+            if (y == one)
+                return false;
+        }
+        if (i == s)
+            return false;
+    }
+    return true;
+}
+
+/** a random prime of bits, the two top bits set (so the product of two such
+ * primes is 2 * bits long) and gcd(e, p - 1) = 1.
+ * the odd numbers after a random start are sieved by the small primes, only
+ * the remaining ones are tested by Miller-Rabin.
+ */
+void
+random_prime(
+    mbedtls_mpi& p, size_t bits, const mbedtls_mpi& e, rnd_generator& rnd) {
+    const auto&       primes = small_primes();
+    std::vector<bool> sieve(sieve_window);
+    mpi_holder        start, gcd;
+
+    for (;;) {
+        const size_t size = (bits + 7) / 8;
+        mbedcrypto_c_call(
+            mbedtls_mpi_fill_random,
+            &start.ctx_,
+            size,
+            rnd_generator::maker,
+            &rnd);
+        mbedcrypto_c_call(mbedtls_mpi_shift_r, &start.ctx_, size * 8 - bits);
+        mbedcrypto_c_call(mbedtls_mpi_set_bit, &start.ctx_, bits - 1, 1);
+        mbedcrypto_c_call(mbedtls_mpi_set_bit, &start.ctx_, bits - 2, 1);
+        mbedcrypto_c_call(mbedtls_mpi_set_bit, &start.ctx_, 0, 1);
+
+        // marks start + 2j divisible by a small prime
+        std::fill(sieve.begin(), sieve.end(), false);
+        for (uint32_t q : primes) {
+            mbedtls_mpi_uint r = 0;
+            mbedcrypto_c_call(mbedtls_mpi_mod_int, &r, &start.ctx_, q);
+            // r + 2j = 0 mod q, so j = (q - r) / 2 mod q
+            size_t j = static_cast<size_t>(q - r) % q;
+            j        = (j % 2 == 0) ? j / 2 : (j + q) / 2;
+            for (; j < sieve_window; j += q)
+                sieve[j] = true;
+        }
+
+        for (size_t j = 0; j < sieve_window; ++j) {
+            if (sieve[j])
+                continue;
+            mbedcrypto_c_call(
+                mbedtls_mpi_add_int,
+                &p,
+                &start.ctx_,
+                static_cast<mbedtls_mpi_sint>(2 * j));
+            if (mbedtls_mpi_bitlen(&p) != bits || !is_probable_prime(p, rnd))
+                continue;
+
+            mbedcrypto_c_call(mbedtls_mpi_sub_int, &gcd.ctx_, &p, 1);
+            mbedcrypto_c_call(mbedtls_mpi_gcd, &gcd.ctx_, &gcd.ctx_, &e);
+            if (mbedtls_mpi_cmp_int(&gcd.ctx_, 1) == 0)
+                return;
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+bool
+can_sign(
+    const mbedtls_rsa_context& rsa,
+    mbedtls_md_type_t          halgo,
+    buffer_view_t              hvalue) noexcept {
+    const size_t bits = mbedtls_mpi_bitlen(&rsa.N);
+    if (rsa.padding != MBEDTLS_RSA_PKCS_V15 || bits < min_bits ||
+        bits > max_bits || rsa.len != mbedtls_mpi_size(&rsa.N))
+        return false;
+
+    // the CRT parameters, primes of the same limbs (a message modulo N is
+    // less than p * R, and q * R)
+    for (const auto* x : {&rsa.P, &rsa.Q, &rsa.DP, &rsa.DQ, &rsa.QP}) {
+        if (mbedtls_mpi_cmp_int(x, 0) <= 0)
+            return false;
+    }
+    if (limbs_of(rsa.P) != limbs_of(rsa.Q))
+        return false;
+
+    try {
+        buffer_t t;
+        return digest_info(t, halgo, hvalue) &&
+               t.size() + 3 + min_padding <= rsa.len;
+    } catch (...) {
+        return false;
+    }
+}
+
+void
+sign(
+    mbedtls_rsa_context& rsa,
+    mbedtls_md_type_t    halgo,
+    buffer_view_t        hvalue,
+    uint8_t*             signature,
+    rnd_generator&       rnd) {
+    const size_t k = rsa.len;
+
+    // EM = 00 01 ff .. ff 00 T
+    buffer_t t;
+    if (!digest_info(t, halgo, hvalue) || t.size() + 3 + min_padding > k)
+        throw exceptions::usage_error{"invalid hash value of the rsa key"};
+    secret_t em{k};
+    em.data_[1] = 0x01;
+    std::fill(em.ptr() + 2, em.ptr() + k - t.size() - 1, 0xff);
+    std::copy(t.cbegin(), t.cend(), em.data_.begin() + (k - t.size()));
+
+    prepare_blinding(rsa, rnd);
+
+    const auto         x = tuned_crossover();
+    const mont_modulus mn{binary_of(rsa.N), x};
+    secret_t           p{mbedtls_mpi_size(&rsa.P)};
+    secret_t           q{mbedtls_mpi_size(&rsa.Q)};
+    write_to(p, rsa.P);
+    write_to(q, rsa.Q);
+    const mont_modulus mp{p.data_, x};
+    const mont_modulus mq{q.data_, x};
+
+    // c = EM * Vi mod N
+    secret_t c{k};
+    {
+        number_t a{mn}, b{mn};
+        secret_t vi{k};
+        write_to(vi, rsa.Vi);
+        mn.to_mont(a.ptr(), em.data_);
+        mn.to_mont(b.ptr(), vi.data_);
+        mn.mul(a.ptr(), a.ptr(), b.ptr());
+        mn.from_mont(c.ptr(), a.ptr());
+    }
+
+    // m1 = c^dp mod p, m2 = c^dq mod q
+    secret_t m1{p.data_.size()}, m2{q.data_.size()};
+    {
+        secret_t dp{mbedtls_mpi_size(&rsa.DP)}, dq{mbedtls_mpi_size(&rsa.DQ)};
+        write_to(dp, rsa.DP);
+        write_to(dq, rsa.DQ);
+        number_t a{mp}, b{mq};
+        mp.reduce(a.ptr(), c.data_);
+        mp.power(a.ptr(), a.ptr(), dp.data_);
+        mp.from_mont(m1.ptr(), a.ptr());
+        mq.reduce(b.ptr(), c.data_);
+        mq.power(b.ptr(), b.ptr(), dq.data_);
+        mq.from_mont(m2.ptr(), b.ptr());
+    }
+
+    // h = (m1 - m2) * qp mod p
+    secret_t h{p.data_.size()};
+    {
+        secret_t qp{p.data_.size()};
+        write_to(qp, rsa.QP);
+        number_t a{mp}, b{mp};
+        mp.to_mont(a.ptr(), m1.data_);
+        mp.reduce(b.ptr(), m2.data_);
+        mp.sub(a.ptr(), a.ptr(), b.ptr());
+        mp.to_mont(b.ptr(), qp.data_);
+        mp.mul(a.ptr(), a.ptr(), b.ptr());
+        mp.from_mont(h.ptr(), a.ptr());
+    }
+
+    // s = (m2 + h * q) * Vf mod N
+    {
+        secret_t vf{k};
+        write_to(vf, rsa.Vf);
+        number_t a{mn}, b{mn};
+        mn.to_mont(a.ptr(), h.data_);
+        mn.to_mont(b.ptr(), q.data_);
+        mn.mul(a.ptr(), a.ptr(), b.ptr());
+        mn.to_mont(b.ptr(), m2.data_);
+        mn.add(a.ptr(), a.ptr(), b.ptr());
+        mn.to_mont(b.ptr(), vf.data_);
+        mn.mul(a.ptr(), a.ptr(), b.ptr());
+        mn.from_mont(signature, a.ptr());
+    }
+
+    // a fault (ex: a glitch) of the CRT reveals the primes, checks s^e = EM
+    number_t a{mn};
+    secret_t check{k};
+    mn.to_mont(a.ptr(), buffer_view_t{signature, k});
+    mn.power(a.ptr(), a.ptr(), binary_of(rsa.E));
+    mn.from_mont(check.ptr(), a.ptr());
+    if (check.data_ != em.data_) {
+        mbedtls_platform_zeroize(signature, k);
+        throw exception{
+            MBEDTLS_ERR_RSA_PRIVATE_FAILED, "failed to verify the signature"};
+    }
+}
+
+bool
+can_generate(size_t key_bitlen, size_t exponent) noexcept {
+    return key_bitlen >= min_bits && key_bitlen <= max_bits &&
+           key_bitlen % 2 == 0 && exponent >= 3 && exponent % 2 == 1 &&
+           exponent <= 0x7fffffff;
+}
+
+void
+generate_key(
+    mbedtls_rsa_context& rsa,
+    size_t               key_bitlen,
+    size_t               exponent,
+    rnd_generator&       rnd) {
+    if (!can_generate(key_bitlen, exponent))
+        throw exceptions::usage_error{"invalid rsa key size or exponent"};
+
+    const int    padding = rsa.padding;
+    const int    hash_id = rsa.hash_id;
+    const size_t half    = key_bitlen / 2;
+    mpi_holder   e, p, q, diff;
+    mbedcrypto_c_call(
+        mbedtls_mpi_lset, &e.ctx_, static_cast<mbedtls_mpi_sint>(exponent));
+
+    for (;;) {
+        random_prime(p.ctx_, half, e.ctx_, rnd);
+        random_prime(q.ctx_, half, e.ctx_, rnd);
+
+        // |p - q| > 2^(half - 100), as mbedtls_rsa_gen_key()
+        mbedcrypto_c_call(mbedtls_mpi_sub_mpi, &diff.ctx_, &p.ctx_, &q.ctx_);
+        if (mbedtls_mpi_bitlen(&diff.ctx_) <= half - 99)
+            continue;
+        if (diff.ctx_.s < 0) // p > q
+            std::swap(p.ctx_, q.ctx_);
+
+        mbedtls_rsa_free(&rsa);
+        mbedtls_rsa_init(&rsa, padding, hash_id);
+        mbedcrypto_c_call(
+            mbedtls_rsa_import,
+            &rsa,
+            nullptr,
+            &p.ctx_,
+            &q.ctx_,
+            nullptr,
+            &e.ctx_);
+        mbedcrypto_c_call(mbedtls_rsa_complete, &rsa);
+
+        // a small private exponent, by a negligible chance
+        if (mbedtls_mpi_bitlen(&rsa.D) > half)
+            return;
+    }
+}
+
+//-----------------------------------------------------------------------------
+} // namespace rsa_crt
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
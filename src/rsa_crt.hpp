@@ -0,0 +1,73 @@
+/** @file rsa_crt.hpp
+ * the private operations of large RSA keys (4096bit and more) by the
+ * Montgomery arithmetic of fixed_base.hpp, instead of the generic big numbers
+ * of mbedtls.
+ *
+ * the products of the primes switch to Karatsuba and Toom-3 above the tuned
+ * crossovers (@sa tuning::thresholds), the smaller keys are left to mbedtls.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_RSA_CRT_HPP
+#define MBEDCRYPTO_RSA_CRT_HPP
+
+#include "mbedcrypto/types.hpp"
+
+#include <mbedtls/md.h>
+#include <mbedtls/rsa.h>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+class rnd_generator;
+//-----------------------------------------------------------------------------
+namespace rsa_crt {
+//-----------------------------------------------------------------------------
+
+enum K : size_t {
+    min_bits = 4096,  ///< smaller keys are left to mbedtls
+    max_bits = 16384, ///< the largest modulus of mont_modulus
+};
+
+/** returns true if sign() accepts this key and hash, as a private key of
+ * PKCS#1 v1.5 padding with the CRT parameters.
+ */
+bool
+can_sign(
+    const mbedtls_rsa_context&,
+    mbedtls_md_type_t,
+    buffer_view_t hvalue) noexcept;
+
+/** RSASSA-PKCS1-v1_5 signature, the same bytes as mbedtls_rsa_pkcs1_sign().
+ * signature: of rsa.len bytes. the message is blinded by the Vi/Vf pair of
+ * the context (as mbedtls), the exponentiations by the primes are in
+ * constant time and the result is checked by the public exponent.
+ */
+void
+sign(
+    mbedtls_rsa_context& rsa,
+    mbedtls_md_type_t    halgo,
+    buffer_view_t        hvalue,
+    uint8_t*             signature,
+    rnd_generator&       rnd);
+
+/// returns true if generate_key() accepts these parameters
+bool
+can_generate(size_t key_bitlen, size_t exponent) noexcept;
+
+/** makes a new key into an empty rsa context, as mbedtls_rsa_gen_key().
+ * the primes are found by a sieve of the small primes, then by Miller-Rabin
+ * tests of Montgomery exponentiations.
+ */
+void
+generate_key(
+    mbedtls_rsa_context& rsa,
+    size_t               key_bitlen,
+    size_t               exponent,
+    rnd_generator&       rnd);
+
+//-----------------------------------------------------------------------------
+} // namespace rsa_crt
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_RSA_CRT_HPP
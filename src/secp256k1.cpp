@@ -0,0 +1,1476 @@
+#include "mbedcrypto/secp256k1.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "./conversions.hpp"
+
+#include <mbedtls/platform_util.h>
+#include <mbedtls/sha256.h>
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace secp256k1 {
+namespace {
+//-----------------------------------------------------------------------------
+
+using limb_t = uint64_t;
+
+enum K : size_t {
+    limbs       = 4,
+    key_size    = 32,
+    g_window    = 8, ///< wNAF width of G and lambda(G), precomputed once
+    p_window    = 5, ///< wNAF width of the other points
+    g_table     = 1 << (g_window - 2),
+    p_table     = 1 << (p_window - 2),
+    max_naf     = 260,
+    batch_chunk = 64, ///< of schnorr_verify_batch()
+};
+
+#if defined(__SIZEOF_INT128__)
+__extension__ typedef unsigned __int128 dlimb_t;
+#endif
+
+/// returns the low limb of a * b, hi is the high limb
+inline limb_t
+mul64(limb_t a, limb_t b, limb_t& hi) noexcept {
+#if defined(__SIZEOF_INT128__)
+    const dlimb_t t = static_cast<dlimb_t>(a) * b;
+    hi              = static_cast<limb_t>(t >> 64);
+    return static_cast<limb_t>(t);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, &hi);
+#else  // portable
+    const limb_t al = a & 0xffffffff, ah = a >> 32;
+    const limb_t bl = b & 0xffffffff, bh = b >> 32;
+    const limb_t ll = al * bl, lh = al * bh, hl = ah * bl, hh = ah * bh;
+    const limb_t mid = (ll >> 32) + (lh & 0xffffffff) + (hl & 0xffffffff);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    return (mid << 32) | (ll & 0xffffffff);
+#endif
+}
+
+/// returns a + b + carry, carry (0 or 1) is updated
+inline limb_t
+addc(limb_t a, limb_t b, limb_t& carry) noexcept {
+    const limb_t s = a + carry;
+    const limb_t r = s + b;
+    carry          = (s < carry) | (r < b);
+    return r;
+}
+
+/// returns a - b - borrow, borrow (0 or 1) is updated
+inline limb_t
+subb(limb_t a, limb_t b, limb_t& borrow) noexcept {
+    const limb_t d = a - b;
+    const limb_t r = d - borrow;
+    borrow         = (a < b) | (d < borrow);
+    return r;
+}
+
+/// (c2:c1:c0) += a * b
+inline void
+muladd(limb_t a, limb_t b, limb_t& c0, limb_t& c1, limb_t& c2) noexcept {
+    limb_t hi;
+    limb_t lo = mul64(a, b, hi);
+    c0 += lo;
+    hi += c0 < lo;
+    c1 += hi;
+    c2 += c1 < hi;
+}
+
+/// t = a * b, 8 limbs
+void
+mul256(limb_t t[8], const limb_t a[4], const limb_t b[4]) noexcept {
+    limb_t c0 = 0, c1 = 0, c2 = 0;
+    for (size_t k = 0; k < 7; ++k) {
+        const size_t first = k < 3 ? 0 : k - 3;
+        const size_t last  = k < 3 ? k : 3;
+        for (size_t i = first; i <= last; ++i)
+            muladd(a[i], b[k - i], c0, c1, c2);
+        t[k] = c0;
+        c0   = c1;
+        c1   = c2;
+        c2   = 0;
+    }
+    t[7] = c0;
+}
+
+/// t = a * a, 8 limbs: the cross products once, then doubled
+void
+sqr256(limb_t t[8], const limb_t a[4]) noexcept {
+    limb_t cross[8] = {0};
+    for (size_t i = 0; i < 3; ++i) {
+        limb_t carry = 0;
+        for (size_t j = i + 1; j < 4; ++j) {
+            limb_t hi;
+            limb_t lo = mul64(a[i], a[j], hi);
+            lo += carry;
+            hi += lo < carry;
+            cross[i + j] += lo;
+            carry = hi + (cross[i + j] < lo);
+        }
+        cross[i + 4] = carry;
+    }
+    limb_t top = 0;
+    for (size_t k = 0; k < 8; ++k) { // cross * 2
+        const limb_t next = cross[k] >> 63;
+        cross[k]          = (cross[k] << 1) | top;
+        top               = next;
+    }
+    limb_t carry = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        limb_t hi;
+        limb_t lo    = mul64(a[i], a[i], hi);
+        t[2 * i]     = addc(cross[2 * i], lo, carry);
+        t[2 * i + 1] = addc(cross[2 * i + 1], hi, carry);
+    }
+}
+
+/// all ones if flag, zero otherwise
+inline limb_t
+mask_of(limb_t flag) noexcept {
+    return 0 - (flag & 1);
+}
+
+void
+read_be(limb_t r[4], const uint8_t* p) noexcept {
+    for (size_t i = 0; i < limbs; ++i) {
+        limb_t v = 0;
+        for (size_t j = 0; j < 8; ++j)
+            v = (v << 8) | p[(3 - i) * 8 + j];
+        r[i] = v;
+    }
+}
+
+void
+write_be(uint8_t* p, const limb_t a[4]) noexcept {
+    for (size_t i = 0; i < limbs; ++i) {
+        for (size_t j = 0; j < 8; ++j)
+            p[(3 - i) * 8 + j] = static_cast<uint8_t>(a[i] >> (56 - 8 * j));
+    }
+}
+
+/// true if a < b, by the borrow of a - b
+bool
+less_than(const limb_t a[4], const limb_t b[4]) noexcept {
+    limb_t borrow = 0;
+    for (size_t i = 0; i < limbs; ++i)
+        subb(a[i], b[i], borrow);
+    return borrow != 0;
+}
+
+//-----------------------------------------------------------------------------
+// the field of p = 2^256 - 2^32 - 977, the elements are fully reduced
+
+struct fe {
+    limb_t v[4];
+};
+
+constexpr limb_t FieldC = 0x1000003d1; ///< 2^256 mod p
+
+const fe FieldP = {
+    {0xfffffffefffffc2f,
+     0xffffffffffffffff,
+     0xffffffffffffffff,
+     0xffffffffffffffff}};
+
+const fe Beta = { // a cube root of unity, lambda(x, y) = (beta * x, y)
+    {0xc1396c28719501ee,
+     0x9cf0497512f58995,
+     0x6e64479eac3434e9,
+     0x7ae96a2b657c0710}};
+
+/// r = (t + top * 2^256) mod p, t is any 256 bits number
+void
+fe_fold(fe& r, const limb_t t[4], limb_t top) noexcept {
+    limb_t hi;
+    limb_t lo = mul64(top, FieldC, hi);
+    limb_t c  = 0;
+    limb_t x[4];
+    x[0] = addc(t[0], lo, c);
+    x[1] = addc(t[1], hi, c);
+    x[2] = addc(t[2], 0, c);
+    x[3] = addc(t[3], 0, c);
+    // a carry out is 2^256 = FieldC, x is small then
+    const limb_t wrap = FieldC & mask_of(c);
+    c                 = 0;
+    x[0]              = addc(x[0], wrap, c);
+    x[1]              = addc(x[1], 0, c);
+    x[2]              = addc(x[2], 0, c);
+    x[3]              = addc(x[3], 0, c);
+    // x < 2^256 < 2p: subtracts p if x + FieldC overflows
+    limb_t u[4];
+    c    = 0;
+    u[0] = addc(x[0], FieldC, c);
+    u[1] = addc(x[1], 0, c);
+    u[2] = addc(x[2], 0, c);
+    u[3] = addc(x[3], 0, c);
+    const limb_t m = mask_of(c);
+    for (size_t i = 0; i < limbs; ++i)
+        r.v[i] = (u[i] & m) | (x[i] & ~m);
+}
+
+/// r = t mod p, t of 8 limbs
+void
+fe_reduce(fe& r, const limb_t t[8]) noexcept {
+    limb_t x[4];
+    limb_t carry = 0;
+    for (size_t i = 0; i < limbs; ++i) {
+        limb_t hi;
+        limb_t lo = mul64(t[4 + i], FieldC, hi);
+        lo += carry;
+        hi += lo < carry;
+        x[i] = t[i] + lo;
+        hi += x[i] < lo;
+        carry = hi;
+    }
+    fe_fold(r, x, carry);
+}
+
+void
+fe_add(fe& r, const fe& a, const fe& b) noexcept {
+    // a + b < 2p: subtracts p if a + b or a + b + FieldC overflows
+    limb_t c = 0;
+    limb_t x[4], u[4];
+    for (size_t i = 0; i < limbs; ++i)
+        x[i] = addc(a.v[i], b.v[i], c);
+    limb_t c2 = 0;
+    u[0]      = addc(x[0], FieldC, c2);
+    for (size_t i = 1; i < limbs; ++i)
+        u[i] = addc(x[i], 0, c2);
+    const limb_t m = mask_of(c | c2);
+    for (size_t i = 0; i < limbs; ++i)
+        r.v[i] = (u[i] & m) | (x[i] & ~m);
+}
+
+void
+fe_sub(fe& r, const fe& a, const fe& b) noexcept {
+    limb_t borrow = 0;
+    limb_t x[4];
+    for (size_t i = 0; i < limbs; ++i)
+        x[i] = subb(a.v[i], b.v[i], borrow);
+    // a - b + p = x - 2^256 + p = x - FieldC
+    limb_t c = 0;
+    x[0]     = subb(x[0], FieldC & mask_of(borrow), c);
+    for (size_t i = 1; i < limbs; ++i)
+        x[i] = subb(x[i], 0, c);
+    std::memcpy(r.v, x, sizeof(x));
+}
+
+void
+fe_neg(fe& r, const fe& a) noexcept {
+    const fe zero = {{0, 0, 0, 0}};
+    fe_sub(r, zero, a);
+}
+
+void
+fe_mul(fe& r, const fe& a, const fe& b) noexcept {
+    limb_t t[8];
+    mul256(t, a.v, b.v);
+    fe_reduce(r, t);
+}
+
+void
+fe_sqr(fe& r, const fe& a) noexcept {
+    limb_t t[8];
+    sqr256(t, a.v);
+    fe_reduce(r, t);
+}
+
+/// r = a^(2^n)
+void
+fe_sqr_n(fe& r, const fe& a, size_t n) noexcept {
+    r = a;
+    for (size_t i = 0; i < n; ++i)
+        fe_sqr(r, r);
+}
+
+/// r = a * k, k is small
+void
+fe_mul_int(fe& r, const fe& a, limb_t k) noexcept {
+    limb_t x[4];
+    limb_t carry = 0;
+    for (size_t i = 0; i < limbs; ++i) {
+        limb_t hi;
+        limb_t lo = mul64(a.v[i], k, hi);
+        lo += carry;
+        hi += lo < carry;
+        x[i]  = lo;
+        carry = hi;
+    }
+    fe_fold(r, x, carry);
+}
+
+bool
+fe_is_zero(const fe& a) noexcept {
+    return (a.v[0] | a.v[1] | a.v[2] | a.v[3]) == 0;
+}
+
+bool
+fe_equal(const fe& a, const fe& b) noexcept {
+    return ((a.v[0] ^ b.v[0]) | (a.v[1] ^ b.v[1]) | (a.v[2] ^ b.v[2]) |
+            (a.v[3] ^ b.v[3])) == 0;
+}
+
+bool
+fe_is_odd(const fe& a) noexcept {
+    return (a.v[0] & 1) != 0;
+}
+
+/// r = mask ? a : r
+void
+fe_cmov(fe& r, const fe& a, limb_t mask) noexcept {
+    for (size_t i = 0; i < limbs; ++i)
+        r.v[i] = (a.v[i] & mask) | (r.v[i] & ~mask);
+}
+
+/// false if the number is not less than p
+bool
+fe_from_bytes(fe& r, const uint8_t* p) noexcept {
+    read_be(r.v, p);
+    return less_than(r.v, FieldP.v);
+}
+
+/** the common head of the inverse and the square root chains (as
+ * libsecp256k1): x2 = a^(2^2 - 1), x3 = a^(2^3 - 1), x22 and x223.
+ */
+void
+fe_chain(const fe& a, fe& x2, fe& x3, fe& x22, fe& x223) noexcept {
+    fe t, x6, x9, x11, x44, x88, x176, x220;
+    fe_sqr(t, a);
+    fe_mul(x2, t, a);
+    fe_sqr(t, x2);
+    fe_mul(x3, t, a);
+    fe_sqr_n(t, x3, 3);
+    fe_mul(x6, t, x3);
+    fe_sqr_n(t, x6, 3);
+    fe_mul(x9, t, x3);
+    fe_sqr_n(t, x9, 2);
+    fe_mul(x11, t, x2);
+    fe_sqr_n(t, x11, 11);
+    fe_mul(x22, t, x11);
+    fe_sqr_n(t, x22, 22);
+    fe_mul(x44, t, x22);
+    fe_sqr_n(t, x44, 44);
+    fe_mul(x88, t, x44);
+    fe_sqr_n(t, x88, 88);
+    fe_mul(x176, t, x88);
+    fe_sqr_n(t, x176, 44);
+    fe_mul(x220, t, x44);
+    fe_sqr_n(t, x220, 3);
+    fe_mul(x223, t, x3);
+}
+
+/// r = a^(p - 2) = 1 / a, in constant time
+void
+fe_inv(fe& r, const fe& a) noexcept {
+    fe x2, x3, x22, x223, t;
+    fe_chain(a, x2, x3, x22, x223);
+    fe_sqr_n(t, x223, 23);
+    fe_mul(t, t, x22);
+    fe_sqr_n(t, t, 5);
+    fe_mul(t, t, a);
+    fe_sqr_n(t, t, 3);
+    fe_mul(t, t, x2);
+    fe_sqr_n(t, t, 2);
+    fe_mul(r, t, a);
+}
+
+/// r = a^((p + 1) / 4), false if a is not a square
+bool
+fe_sqrt(fe& r, const fe& a) noexcept {
+    fe x2, x3, x22, x223, t;
+    fe_chain(a, x2, x3, x22, x223);
+    fe_sqr_n(t, x223, 23);
+    fe_mul(t, t, x22);
+    fe_sqr_n(t, t, 6);
+    fe_mul(t, t, x2);
+    fe_sqr_n(r, t, 2);
+    fe_sqr(t, r);
+    return fe_equal(t, a);
+}
+
+/// x^3 + 7
+void
+curve_rhs(fe& r, const fe& x) noexcept {
+    const fe seven = {{7, 0, 0, 0}};
+    fe       t;
+    fe_sqr(t, x);
+    fe_mul(t, t, x);
+    fe_add(r, t, seven);
+}
+
+//-----------------------------------------------------------------------------
+// the scalars, mod the group order n
+
+struct sc {
+    limb_t v[4];
+};
+
+const sc Order = {
+    {0xbfd25e8cd0364141,
+     0xbaaedce6af48a03b,
+     0xfffffffffffffffe,
+     0xffffffffffffffff}};
+
+/// 2^256 - n
+const limb_t OrderC[3] = {0x402da1732fc9bebf, 0x4551231950b75fc4, 0x1};
+
+// the GLV constants: k = k1 + k2 * lambda, by the rounded products of
+// k and g1, g2 (/ 2^384) and the short basis (a1, b1), (a2, b2)
+const sc MinusLambda = {
+    {0xe0cfc810b51283cf,
+     0xa880b9fc8ec739c2,
+     0x5ad9e3fd77ed9ba4,
+     0xac9c52b33fa3cf1f}};
+const sc MinusB1 = {{0x6f547fa90abfe4c3, 0xe4437ed6010e8828, 0, 0}};
+const sc MinusB2 = {
+    {0xd765cda83db1562c,
+     0x8a280ac50774346d,
+     0xfffffffffffffffe,
+     0xffffffffffffffff}};
+const sc G1 = {
+    {0xe893209a45dbb031,
+     0x3daa8a1471e8ca7f,
+     0xe86c90e49284eb15,
+     0x3086d221a7d46bcd}};
+const sc G2 = {
+    {0x1571b4ae8ac47f71,
+     0x221208ac9df506c6,
+     0x6f547fa90abfe4c4,
+     0xe4437ed6010e8828}};
+
+/// r = t mod n, t of 8 limbs, in constant time
+void
+sc_reduce(sc& r, const limb_t t8[8]) noexcept {
+    limb_t t[8];
+    std::memcpy(t, t8, sizeof(t));
+    // t = low + high * 2^256 = low + high * (2^256 - n), 4 rounds clear high
+    for (size_t round = 0; round < 4; ++round) {
+        limb_t m[8] = {t[0], t[1], t[2], t[3], 0, 0, 0, 0};
+        for (size_t i = 0; i < limbs; ++i) {
+            limb_t carry = 0;
+            for (size_t j = 0; j < 3; ++j) {
+                limb_t hi;
+                limb_t lo = mul64(t[4 + i], OrderC[j], hi);
+                lo += carry;
+                hi += lo < carry;
+                m[i + j] += lo;
+                carry = hi + (m[i + j] < lo);
+            }
+            limb_t c = 0;
+            m[i + 3] = addc(m[i + 3], carry, c);
+            for (size_t k = i + 4; k < 8; ++k)
+                m[k] = addc(m[k], 0, c);
+        }
+        std::memcpy(t, m, sizeof(t));
+    }
+    // t < 2^256 < 2n
+    limb_t u[4];
+    limb_t borrow = 0;
+    for (size_t i = 0; i < limbs; ++i)
+        u[i] = subb(t[i], Order.v[i], borrow);
+    const limb_t m = mask_of(borrow);
+    for (size_t i = 0; i < limbs; ++i)
+        r.v[i] = (t[i] & m) | (u[i] & ~m);
+    mbedtls_platform_zeroize(t, sizeof(t));
+}
+
+void
+sc_add(sc& r, const sc& a, const sc& b) noexcept {
+    limb_t t[8] = {0};
+    limb_t c    = 0;
+    for (size_t i = 0; i < limbs; ++i)
+        t[i] = addc(a.v[i], b.v[i], c);
+    t[4] = c;
+    sc_reduce(r, t);
+}
+
+void
+sc_mul(sc& r, const sc& a, const sc& b) noexcept {
+    limb_t t[8];
+    mul256(t, a.v, b.v);
+    sc_reduce(r, t);
+    mbedtls_platform_zeroize(t, sizeof(t));
+}
+
+bool
+sc_is_zero(const sc& a) noexcept {
+    return (a.v[0] | a.v[1] | a.v[2] | a.v[3]) == 0;
+}
+
+/// r = -a mod n
+void
+sc_neg(sc& r, const sc& a) noexcept {
+    const limb_t z      = a.v[0] | a.v[1] | a.v[2] | a.v[3];
+    const limb_t m      = mask_of((z | (0 - z)) >> 63); // a != 0
+    limb_t       borrow = 0;
+    for (size_t i = 0; i < limbs; ++i)
+        r.v[i] = subb(Order.v[i], a.v[i], borrow) & m;
+}
+
+/// r = mask ? a : r
+void
+sc_cmov(sc& r, const sc& a, limb_t mask) noexcept {
+    for (size_t i = 0; i < limbs; ++i)
+        r.v[i] = (a.v[i] & mask) | (r.v[i] & ~mask);
+}
+
+/// false if the number is not less than n
+bool
+sc_from_bytes(sc& r, const uint8_t* p) noexcept {
+    read_be(r.v, p);
+    return less_than(r.v, Order.v);
+}
+
+/// r = the 32 bytes big-endian number mod n
+void
+sc_reduce_bytes(sc& r, const uint8_t* p) noexcept {
+    limb_t t[8] = {0};
+    read_be(t, p);
+    sc_reduce(r, t);
+}
+
+/// r = x / 2 mod n, x < n
+void
+sc_half(limb_t x[4]) noexcept {
+    limb_t c = 0;
+    limb_t y[4];
+    const limb_t m = mask_of(x[0]);
+    for (size_t i = 0; i < limbs; ++i)
+        y[i] = addc(x[i], Order.v[i] & m, c);
+    for (size_t i = 0; i < limbs; ++i) {
+        const limb_t next = (i + 1 < limbs) ? y[i + 1] : c;
+        x[i]              = (y[i] >> 1) | (next << 63);
+    }
+}
+
+/// r = 1 / a mod n by the binary extended euclid, in variable time
+void
+sc_inv_var(sc& r, const sc& a) noexcept {
+    limb_t u[4], v[4], x1[4] = {1, 0, 0, 0}, x2[4] = {0};
+    std::memcpy(u, a.v, sizeof(u));
+    std::memcpy(v, Order.v, sizeof(v));
+    auto is_one = [](const limb_t* z) {
+        return z[0] == 1 && (z[1] | z[2] | z[3]) == 0;
+    };
+    auto shift = [](limb_t* z) {
+        for (size_t i = 0; i < limbs; ++i)
+            z[i] = (z[i] >> 1) | (i + 1 < limbs ? z[i + 1] << 63 : 0);
+    };
+    auto sub_mod = [](limb_t* z, const limb_t* w) { // z = z - w mod n
+        limb_t borrow = 0;
+        for (size_t i = 0; i < limbs; ++i)
+            z[i] = subb(z[i], w[i], borrow);
+        limb_t c = 0;
+        for (size_t i = 0; i < limbs; ++i)
+            z[i] = addc(z[i], Order.v[i] & mask_of(borrow), c);
+    };
+    while (!is_one(u) && !is_one(v)) {
+        while ((u[0] & 1) == 0) {
+            shift(u);
+            sc_half(x1);
+        }
+        while ((v[0] & 1) == 0) {
+            shift(v);
+            sc_half(x2);
+        }
+        if (!less_than(u, v)) {
+            limb_t borrow = 0;
+            for (size_t i = 0; i < limbs; ++i)
+                u[i] = subb(u[i], v[i], borrow);
+            sub_mod(x1, x2);
+        } else {
+            limb_t borrow = 0;
+            for (size_t i = 0; i < limbs; ++i)
+                v[i] = subb(v[i], u[i], borrow);
+            sub_mod(x2, x1);
+        }
+    }
+    std::memcpy(r.v, is_one(u) ? x1 : x2, sizeof(r.v));
+}
+
+/// round(k * g / 2^384), the result is at most 128 bits
+void
+mul_shift_384(sc& r, const sc& k, const sc& g) noexcept {
+    limb_t t[8];
+    mul256(t, k.v, g.v);
+    limb_t c = t[5] >> 63; // rounds by the bit 383
+    r.v[0]   = addc(t[6], 0, c);
+    r.v[1]   = addc(t[7], 0, c);
+    r.v[2]   = 0;
+    r.v[3]   = 0;
+}
+
+/** k = k1 + k2 * lambda mod n, as magnitudes of at most 128 bits and signs.
+ * in variable time, for the verifiers.
+ */
+void
+glv_split(const sc& k, sc& k1, bool& neg1, sc& k2, bool& neg2) noexcept {
+    sc c1, c2;
+    mul_shift_384(c1, k, G1);
+    mul_shift_384(c2, k, G2);
+    sc_mul(c1, c1, MinusB1);
+    sc_mul(c2, c2, MinusB2);
+    sc_add(k2, c1, c2);
+    sc_mul(k1, k2, MinusLambda);
+    sc_add(k1, k1, k);
+
+    auto magnitude = [](sc& x, bool& neg) {
+        // negative if x > n / 2, then uses n - x
+        neg = (x.v[3] | x.v[2]) != 0;
+        if (neg)
+            sc_neg(x, x);
+    };
+    magnitude(k1, neg1);
+    magnitude(k2, neg2);
+}
+
+/// the width w NAF digits of k, returns the number of digits
+size_t
+wnaf(int8_t* naf, const sc& k, size_t w) noexcept {
+    limb_t x[5] = {k.v[0], k.v[1], k.v[2], k.v[3], 0};
+    const int window = 1 << w;
+    size_t    length = 0;
+    while ((x[0] | x[1] | x[2] | x[3] | x[4]) != 0) {
+        int digit = 0;
+        if (x[0] & 1) {
+            digit = static_cast<int>(x[0] & (window - 1));
+            if (digit >= window / 2)
+                digit -= window;
+            // x -= digit, x is even then
+            limb_t c = 0;
+            if (digit > 0) {
+                x[0] = subb(x[0], static_cast<limb_t>(digit), c);
+                for (size_t i = 1; i < 5; ++i)
+                    x[i] = subb(x[i], 0, c);
+            } else {
+                x[0] = addc(x[0], static_cast<limb_t>(-digit), c);
+                for (size_t i = 1; i < 5; ++i)
+                    x[i] = addc(x[i], 0, c);
+            }
+        }
+        naf[length++] = static_cast<int8_t>(digit);
+        for (size_t i = 0; i < 5; ++i)
+            x[i] = (x[i] >> 1) | (i + 1 < 5 ? x[i + 1] << 63 : 0);
+    }
+    return length;
+}
+
+//-----------------------------------------------------------------------------
+// the points
+
+/// affine
+struct ge {
+    fe   x, y;
+    bool infinity;
+};
+
+/// jacobian: x = X / Z^2, y = Y / Z^3
+struct gej {
+    fe   x, y, z;
+    bool infinity;
+};
+
+const ge Generator = {
+    {{0x59f2815b16f81798,
+      0x029bfcdb2dce28d9,
+      0x55a06295ce870b07,
+      0x79be667ef9dcbbac}},
+    {{0x9c47d08ffb10d4b8,
+      0xfd17b448a6855419,
+      0x5da4fbfc0e1108a8,
+      0x483ada7726a3c465}},
+    false};
+
+void
+gej_set(gej& r, const ge& a) noexcept {
+    r.x        = a.x;
+    r.y        = a.y;
+    r.z        = fe{{1, 0, 0, 0}};
+    r.infinity = a.infinity;
+}
+
+/// r = 2a, by dbl-2009-l (a = 0)
+void
+gej_double(gej& r, const gej& a) noexcept {
+    if (a.infinity) {
+        r.infinity = true;
+        return;
+    }
+    fe A, B, C, D, E, F, t;
+    fe_sqr(A, a.x);
+    fe_sqr(B, a.y);
+    fe_sqr(C, B);
+    fe_add(t, a.x, B);
+    fe_sqr(t, t);
+    fe_sub(t, t, A);
+    fe_sub(t, t, C);
+    fe_add(D, t, t);
+    fe_mul_int(E, A, 3);
+    fe_sqr(F, E);
+
+    fe z;
+    fe_mul(z, a.y, a.z);
+    fe_add(r.z, z, z);
+    fe_sub(r.x, F, D);
+    fe_sub(r.x, r.x, D);
+    fe_sub(t, D, r.x);
+    fe_mul(t, E, t);
+    fe_mul_int(C, C, 8);
+    fe_sub(r.y, t, C);
+    r.infinity = false;
+}
+
+/** r = a + b where h = U2 - U1, rr = S2 - S1 and
+ * X3 = rr^2 - h^3 - 2 U1 h^2, Y3 = rr (U1 h^2 - X3) - S1 h^3
+ */
+void
+gej_finish_add(
+    gej&      r,
+    const fe& u1,
+    const fe& s1,
+    const fe& h,
+    const fe& rr,
+    const fe& z) noexcept {
+    fe hh, hhh, v, t;
+    fe_sqr(hh, h);
+    fe_mul(hhh, h, hh);
+    fe_mul(v, u1, hh);
+    fe_sqr(t, rr);
+    fe_sub(t, t, hhh);
+    fe_sub(t, t, v);
+    fe_sub(r.x, t, v);
+    fe_sub(t, v, r.x);
+    fe_mul(t, rr, t);
+    fe_mul(v, s1, hhh);
+    fe_sub(r.y, t, v);
+    r.z        = z;
+    r.infinity = false;
+}
+
+/// r = a + b, b affine (mixed addition)
+void
+gej_add_ge(gej& r, const gej& a, const ge& b) noexcept {
+    if (a.infinity) {
+        gej_set(r, b);
+        return;
+    }
+    fe z2, u2, s2, h, rr, z;
+    fe_sqr(z2, a.z);
+    fe_mul(u2, b.x, z2);
+    fe_mul(s2, b.y, z2);
+    fe_mul(s2, s2, a.z);
+    fe_sub(h, u2, a.x);
+    fe_sub(rr, s2, a.y);
+    if (fe_is_zero(h)) {
+        if (fe_is_zero(rr))
+            gej_double(r, a);
+        else
+            r.infinity = true;
+        return;
+    }
+    fe_mul(z, a.z, h);
+    const fe u1 = a.x, s1 = a.y;
+    gej_finish_add(r, u1, s1, h, rr, z);
+}
+
+/// r = a + b
+void
+gej_add(gej& r, const gej& a, const gej& b) noexcept {
+    if (a.infinity) {
+        r = b;
+        return;
+    }
+    if (b.infinity) {
+        r = a;
+        return;
+    }
+    fe z1, z2, u1, u2, s1, s2, h, rr, z;
+    fe_sqr(z1, a.z);
+    fe_sqr(z2, b.z);
+    fe_mul(u1, a.x, z2);
+    fe_mul(u2, b.x, z1);
+    fe_mul(s1, a.y, z2);
+    fe_mul(s1, s1, b.z);
+    fe_mul(s2, b.y, z1);
+    fe_mul(s2, s2, a.z);
+    fe_sub(h, u2, u1);
+    fe_sub(rr, s2, s1);
+    if (fe_is_zero(h)) {
+        if (fe_is_zero(rr))
+            gej_double(r, a);
+        else
+            r.infinity = true;
+        return;
+    }
+    fe_mul(z, a.z, b.z);
+    fe_mul(z, z, h);
+    gej_finish_add(r, u1, s1, h, rr, z);
+}
+
+/// the affine point, a must not be the infinity
+void
+gej_to_ge(ge& r, const gej& a) noexcept {
+    fe zi, zi2;
+    fe_inv(zi, a.z);
+    fe_sqr(zi2, zi);
+    fe_mul(r.x, a.x, zi2);
+    fe_mul(zi2, zi2, zi);
+    fe_mul(r.y, a.y, zi2);
+    r.infinity = false;
+}
+
+/// true if the affine x of a (not the infinity) is x: X == x * Z^2
+bool
+gej_has_x(const gej& a, const fe& x) noexcept {
+    fe t;
+    fe_sqr(t, a.z);
+    fe_mul(t, t, x);
+    return fe_equal(t, a.x);
+}
+
+/// P, 3P, 5P, ... (2n - 1)P
+void
+odd_multiples(gej* out, size_t n, const gej& p) noexcept {
+    gej twice;
+    gej_double(twice, p);
+    out[0] = p;
+    for (size_t i = 1; i < n; ++i)
+        gej_add(out[i], out[i - 1], twice);
+}
+
+/// jacobian to affine by a single inversion (Montgomery's trick)
+void
+to_affine(ge* out, const gej* in, size_t n) {
+    if (n == 0)
+        return;
+    std::vector<fe> acc(n);
+    acc[0] = in[0].z;
+    for (size_t i = 1; i < n; ++i)
+        fe_mul(acc[i], acc[i - 1], in[i].z);
+    fe inv;
+    fe_inv(inv, acc[n - 1]);
+    for (size_t i = n; i-- > 0;) {
+        fe zi, zi2;
+        if (i > 0) {
+            fe_mul(zi, inv, acc[i - 1]);
+            fe_mul(inv, inv, in[i].z);
+        } else {
+            zi = inv;
+        }
+        fe_sqr(zi2, zi);
+        fe_mul(out[i].x, in[i].x, zi2);
+        fe_mul(zi2, zi2, zi);
+        fe_mul(out[i].y, in[i].y, zi2);
+        out[i].infinity = false;
+    }
+}
+
+/// the x of lambda(P) = beta * x, y is the same
+template <class Point>
+void
+apply_lambda(Point* out, const Point* in, size_t n) noexcept {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = in[i];
+        fe_mul(out[i].x, in[i].x, Beta);
+    }
+}
+
+/// the precomputed odd multiples of G and lambda(G)
+struct generator_tables {
+    ge g[g_table];
+    ge lambda_g[g_table];
+
+    generator_tables() {
+        gej start;
+        gej_set(start, Generator);
+        gej multiples[g_table];
+        odd_multiples(multiples, g_table, start);
+        to_affine(g, multiples, g_table);
+        apply_lambda(lambda_g, g, g_table);
+    }
+
+    static const generator_tables& instance() {
+        static const generator_tables tables;
+        return tables;
+    }
+}; // struct generator_tables
+
+//-----------------------------------------------------------------------------
+// multi scalar multiplication (Strauss) by the wNAF digits
+
+struct msm_term {
+    int8_t     naf[max_naf];
+    size_t     length   = 0;
+    const ge*  affine   = nullptr; ///< the odd multiples, or
+    const gej* jacobian = nullptr;
+    bool       negate   = false;
+
+    void set(const sc& k, size_t window, bool neg) noexcept {
+        length = wnaf(naf, k, window);
+        negate = neg;
+    }
+}; // struct msm_term
+
+/// r = sum of the terms
+void
+multiply(gej& r, const msm_term* terms, size_t count) noexcept {
+    size_t top = 0;
+    for (size_t t = 0; t < count; ++t)
+        top = std::max(top, terms[t].length);
+
+    r.infinity = true;
+    for (size_t i = top; i-- > 0;) {
+        gej_double(r, r);
+        for (size_t t = 0; t < count; ++t) {
+            const auto& term = terms[t];
+            if (i >= term.length || term.naf[i] == 0)
+                continue;
+            const int    d     = term.naf[i];
+            const size_t index = static_cast<size_t>((d < 0 ? -d : d) / 2);
+            const bool   neg   = (d < 0) != term.negate;
+            if (term.affine != nullptr) {
+                ge pt = term.affine[index];
+                if (neg)
+                    fe_neg(pt.y, pt.y);
+                gej_add_ge(r, r, pt);
+            } else {
+                gej pt = term.jacobian[index];
+                if (neg)
+                    fe_neg(pt.y, pt.y);
+                gej_add(r, r, pt);
+            }
+        }
+    }
+}
+
+/// the 2 terms of k * G, by GLV
+void
+generator_terms(msm_term* terms, const sc& k) noexcept {
+    const auto& tables = generator_tables::instance();
+    sc          k1, k2;
+    bool        neg1, neg2;
+    glv_split(k, k1, neg1, k2, neg2);
+    terms[0].set(k1, g_window, neg1);
+    terms[0].affine = tables.g;
+    terms[1].set(k2, g_window, neg2);
+    terms[1].affine = tables.lambda_g;
+}
+
+/// u1 * G + u2 * P, for a single verification
+void
+double_multiply(gej& r, const sc& u1, const ge& p, const sc& u2) noexcept {
+    gej start, table[p_table], lambda_table[p_table];
+    gej_set(start, p);
+    odd_multiples(table, p_table, start);
+    apply_lambda(lambda_table, table, p_table);
+
+    msm_term terms[4];
+    generator_terms(terms, u1);
+    sc   k1, k2;
+    bool neg1, neg2;
+    glv_split(u2, k1, neg1, k2, neg2);
+    terms[2].set(k1, p_window, neg1);
+    terms[2].jacobian = table;
+    terms[3].set(k2, p_window, neg2);
+    terms[3].jacobian = lambda_table;
+    multiply(r, terms, 4);
+}
+
+//-----------------------------------------------------------------------------
+// constant time products of G, for the signer: the complete formulas of
+// Renes, Costello and Batina (a = 0) in projective coordinates
+
+/// projective: x = X / Z, y = Y / Z, the infinity is (0, 1, 0)
+struct gep {
+    fe x, y, z;
+};
+
+/// r = a + b, complete (also a == b and the infinity)
+void
+gep_add(gep& r, const gep& a, const gep& b) noexcept {
+    constexpr limb_t B3 = 21; // 3 * 7
+    fe t0, t1, t2, t3, t4, x3, y3, z3;
+    fe_mul(t0, a.x, b.x);
+    fe_mul(t1, a.y, b.y);
+    fe_mul(t2, a.z, b.z);
+    fe_add(t3, a.x, a.y);
+    fe_add(t4, b.x, b.y);
+    fe_mul(t3, t3, t4);
+    fe_add(t4, t0, t1);
+    fe_sub(t3, t3, t4);
+    fe_add(t4, a.y, a.z);
+    fe_add(x3, b.y, b.z);
+    fe_mul(t4, t4, x3);
+    fe_add(x3, t1, t2);
+    fe_sub(t4, t4, x3);
+    fe_add(x3, a.x, a.z);
+    fe_add(y3, b.x, b.z);
+    fe_mul(x3, x3, y3);
+    fe_add(y3, t0, t2);
+    fe_sub(y3, x3, y3);
+    fe_add(x3, t0, t0);
+    fe_add(t0, x3, t0);
+    fe_mul_int(t2, t2, B3);
+    fe_add(z3, t1, t2);
+    fe_sub(t1, t1, t2);
+    fe_mul_int(y3, y3, B3);
+    fe_mul(x3, t4, y3);
+    fe_mul(t2, t3, t1);
+    fe_sub(x3, t2, x3);
+    fe_mul(y3, y3, t0);
+    fe_mul(t1, t1, z3);
+    fe_add(y3, t1, y3);
+    fe_mul(t0, t0, t3);
+    fe_mul(z3, z3, t4);
+    fe_add(z3, z3, t0);
+    r.x = x3;
+    r.y = y3;
+    r.z = z3;
+}
+
+/// 0, G, 2G, ... 15G for the 4 bits windows
+struct signer_table {
+    gep multiples[16];
+
+    signer_table() {
+        multiples[0] = gep{fe{{0}}, fe{{1, 0, 0, 0}}, fe{{0}}};
+        multiples[1] = gep{Generator.x, Generator.y, fe{{1, 0, 0, 0}}};
+        for (size_t i = 2; i < 16; ++i)
+            gep_add(multiples[i], multiples[i - 1], multiples[1]);
+    }
+
+    static const signer_table& instance() {
+        static const signer_table table;
+        return table;
+    }
+}; // struct signer_table
+
+/// r = k * G in constant time, as affine (k != 0)
+void
+mul_generator_ct(ge& r, const sc& k) noexcept {
+    const auto& table = signer_table::instance();
+    gep         acc   = table.multiples[0];
+    for (size_t w = 64; w-- > 0;) {
+        for (size_t i = 0; i < 4; ++i)
+            gep_add(acc, acc, acc);
+        const limb_t nibble = (k.v[w / 16] >> ((w % 16) * 4)) & 0xf;
+        gep          pt     = table.multiples[0];
+        for (limb_t j = 1; j < 16; ++j) {
+            const limb_t x    = j ^ nibble;
+            const limb_t mask = ((x | (0 - x)) >> 63) - 1; // j == nibble
+            fe_cmov(pt.x, table.multiples[j].x, mask);
+            fe_cmov(pt.y, table.multiples[j].y, mask);
+            fe_cmov(pt.z, table.multiples[j].z, mask);
+        }
+        gep_add(acc, acc, pt);
+    }
+    fe zi;
+    fe_inv(zi, acc.z);
+    fe_mul(r.x, acc.x, zi);
+    fe_mul(r.y, acc.y, zi);
+    r.infinity = false;
+    mbedtls_platform_zeroize(&acc, sizeof(acc));
+}
+
+//-----------------------------------------------------------------------------
+// encodings
+
+/// the point of x with an even y (BIP340), false if x is not on the curve
+bool
+lift_x(ge& r, const uint8_t* x32) noexcept {
+    fe c;
+    if (!fe_from_bytes(r.x, x32))
+        return false;
+    curve_rhs(c, r.x);
+    if (!fe_sqrt(r.y, c))
+        return false;
+    if (fe_is_odd(r.y))
+        fe_neg(r.y, r.y);
+    r.infinity = false;
+    return true;
+}
+
+/// a SEC1 point of 33 or 65 bytes
+bool
+parse_point(ge& r, buffer_view_t in) noexcept {
+    const auto* p = in.data();
+    if (in.size() == 33 && (p[0] == 0x02 || p[0] == 0x03)) {
+        if (!lift_x(r, p + 1))
+            return false;
+        if (p[0] == 0x03)
+            fe_neg(r.y, r.y);
+        return true;
+    }
+    if (in.size() == 65 && p[0] == 0x04) {
+        fe c, y2;
+        if (!fe_from_bytes(r.x, p + 1) || !fe_from_bytes(r.y, p + 33))
+            return false;
+        curve_rhs(c, r.x);
+        fe_sqr(y2, r.y);
+        r.infinity = false;
+        return fe_equal(c, y2);
+    }
+    return false;
+}
+
+/// a DER integer in [1, n), returns the bytes read or 0
+size_t
+parse_der_scalar(sc& r, const uint8_t* p, size_t size) noexcept {
+    if (size < 2 || p[0] != 0x02)
+        return 0;
+    size_t length = p[1];
+    if (length == 0 || length > size - 2 || (p[2] & 0x80) != 0)
+        return 0;
+    const uint8_t* value = p + 2;
+    size_t         left  = length;
+    while (left > 0 && *value == 0) { // the sign padding
+        ++value;
+        --left;
+    }
+    if (left > key_size)
+        return 0;
+    uint8_t be[key_size] = {0};
+    std::memcpy(be + key_size - left, value, left);
+    if (!sc_from_bytes(r, be) || sc_is_zero(r))
+        return 0;
+    return length + 2;
+}
+
+/// SEQUENCE { INTEGER r, INTEGER s }, as mbedtls_ecdsa_write_signature()
+bool
+parse_der_signature(sc& r, sc& s, buffer_view_t in) noexcept {
+    const auto* p    = in.data();
+    const auto  size = in.size();
+    if (size < 8 || p[0] != 0x30 || p[1] != size - 2)
+        return false;
+    const size_t rlen = parse_der_scalar(r, p + 2, size - 2);
+    if (rlen == 0)
+        return false;
+    const size_t slen = parse_der_scalar(s, p + 2 + rlen, size - 2 - rlen);
+    return slen != 0 && 2 + rlen + slen == size;
+}
+
+//-----------------------------------------------------------------------------
+// BIP340 tagged hashes, the sha256 state after the tag prefix is cached
+
+class tagged_hash
+{
+    mbedtls_sha256_context prefix_;
+
+public:
+    explicit tagged_hash(const char* tag) {
+        uint8_t h[32];
+        mbedcrypto_c_call(
+            mbedtls_sha256_ret,
+            reinterpret_cast<const uint8_t*>(tag),
+            std::strlen(tag),
+            h,
+            0);
+        mbedtls_sha256_init(&prefix_);
+        mbedcrypto_c_call(mbedtls_sha256_starts_ret, &prefix_, 0);
+        mbedcrypto_c_call(mbedtls_sha256_update_ret, &prefix_, h, sizeof(h));
+        mbedcrypto_c_call(mbedtls_sha256_update_ret, &prefix_, h, sizeof(h));
+    }
+
+    ~tagged_hash() {
+        mbedtls_sha256_free(&prefix_);
+    }
+
+    /// out = the hash of a | b | c
+    void operator()(
+        uint8_t       out[32],
+        buffer_view_t a,
+        buffer_view_t b = buffer_view_t{nullptr},
+        buffer_view_t c = buffer_view_t{nullptr}) const {
+        mbedtls_sha256_context ctx;
+        mbedtls_sha256_init(&ctx);
+        mbedtls_sha256_clone(&ctx, &prefix_);
+        for (const auto* part : {&a, &b, &c}) {
+            mbedcrypto_c_call(
+                mbedtls_sha256_update_ret, &ctx, part->data(), part->size());
+        }
+        mbedcrypto_c_call(mbedtls_sha256_finish_ret, &ctx, out);
+        mbedtls_sha256_free(&ctx);
+    }
+
+    tagged_hash(const tagged_hash&) = delete;
+    tagged_hash& operator=(const tagged_hash&) = delete;
+}; // class tagged_hash
+
+const tagged_hash&
+challenge_hash() {
+    static const tagged_hash h{"BIP0340/challenge"};
+    return h;
+}
+
+/// e = hash(r | P | m) mod n
+void
+challenge(sc& e, const uint8_t* r, const uint8_t* px, buffer_view_t message) {
+    uint8_t h[32];
+    challenge_hash()(
+        h, buffer_view_t{r, key_size}, buffer_view_t{px, key_size}, message);
+    sc_reduce_bytes(e, h);
+}
+
+/// the parts of a schnorr signature
+struct schnorr_parts {
+    ge pub;
+    ge r;
+    sc s;
+    sc e;
+};
+
+/// false for an invalid public key or signature encoding
+bool
+parse_schnorr(schnorr_parts& parts, const schnorr_item& item, bool lift_r) {
+    if (item.public_key.size() != key_size ||
+        item.signature.size() != 2 * key_size)
+        return false;
+    const auto* sig = item.signature.data();
+    if (!lift_x(parts.pub, item.public_key.data()))
+        return false;
+    if (lift_r) {
+        if (!lift_x(parts.r, sig))
+            return false;
+    } else if (!fe_from_bytes(parts.r.x, sig)) {
+        return false;
+    }
+    if (!sc_from_bytes(parts.s, sig + key_size))
+        return false;
+    challenge(parts.e, sig, item.public_key.data(), item.message);
+    return true;
+}
+
+/// the weighted equation of a chunk of signatures
+bool
+verify_chunk(const schnorr_item* items, size_t count, rnd_generator& rnd) {
+    std::vector<schnorr_parts> parts(count);
+    for (size_t i = 0; i < count; ++i) {
+        if (!parse_schnorr(parts[i], items[i], true))
+            return false;
+    }
+
+    // a_0 = 1, the others random 128-bit and non zero
+    std::vector<uint8_t> random(count * 16);
+    const int ret = rnd.make(random.data(), random.size());
+    if (ret != 0)
+        throw exception{ret, "the weights of schnorr_verify_batch"};
+    std::vector<sc> weights(count, sc{{1, 0, 0, 0}});
+    for (size_t i = 1; i < count; ++i) {
+        auto& a = weights[i];
+        std::memcpy(&a.v[0], &random[i * 16], 8);
+        std::memcpy(&a.v[1], &random[i * 16 + 8], 8);
+        if (sc_is_zero(a))
+            a.v[0] = 1;
+    }
+
+    // the odd multiples of R_i and P_i, affine by a single inversion
+    const size_t     per_item = 2 * p_table;
+    std::vector<gej> jacobian(count * per_item);
+    for (size_t i = 0; i < count; ++i) {
+        gej start;
+        gej_set(start, parts[i].r);
+        odd_multiples(&jacobian[i * per_item], p_table, start);
+        gej_set(start, parts[i].pub);
+        odd_multiples(&jacobian[i * per_item + p_table], p_table, start);
+    }
+    std::vector<ge> affine(count * (per_item + p_table));
+    to_affine(affine.data(), jacobian.data(), jacobian.size());
+    ge* lambda_tables = affine.data() + jacobian.size();
+    for (size_t i = 0; i < count; ++i) {
+        apply_lambda(
+            lambda_tables + i * p_table,
+            &affine[i * per_item + p_table],
+            p_table);
+    }
+
+    // (-sum a_i s_i) G + sum a_i R_i + sum (a_i e_i) P_i == infinity
+    std::vector<msm_term> terms(2 + 3 * count);
+    sc                    g_scalar{{0, 0, 0, 0}};
+    for (size_t i = 0; i < count; ++i) {
+        sc t;
+        sc_mul(t, weights[i], parts[i].s);
+        sc_add(g_scalar, g_scalar, t);
+
+        auto* term = &terms[2 + 3 * i];
+        term[0].set(weights[i], p_window, false);
+        term[0].affine = &affine[i * per_item];
+
+        sc_mul(t, weights[i], parts[i].e);
+        sc   k1, k2;
+        bool neg1, neg2;
+        glv_split(t, k1, neg1, k2, neg2);
+        term[1].set(k1, p_window, neg1);
+        term[1].affine = &affine[i * per_item + p_table];
+        term[2].set(k2, p_window, neg2);
+        term[2].affine = lambda_tables + i * p_table;
+    }
+    sc_neg(g_scalar, g_scalar);
+    generator_terms(terms.data(), g_scalar);
+
+    gej sum;
+    multiply(sum, terms.data(), terms.size());
+    return sum.infinity;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+bool
+ecdsa_verify(
+    buffer_view_t public_key,
+    buffer_view_t hash_value,
+    buffer_view_t signature) {
+    ge q;
+    sc r, s;
+    if (!parse_point(q, public_key) || !parse_der_signature(r, s, signature))
+        return false;
+
+    // the leftmost 256 bits of the hash value, mod n
+    uint8_t      h[key_size] = {0};
+    const size_t hsize = std::min<size_t>(hash_value.size(), key_size);
+    std::memcpy(h + key_size - hsize, hash_value.data(), hsize);
+    sc e;
+    sc_reduce_bytes(e, h);
+
+    sc w, u1, u2;
+    sc_inv_var(w, s);
+    sc_mul(u1, e, w);
+    sc_mul(u2, r, w);
+    gej sum;
+    double_multiply(sum, u1, q, u2);
+    if (sum.infinity)
+        return false;
+
+    // x mod n == r, x is r or r + n (if less than p)
+    fe x;
+    std::memcpy(x.v, r.v, sizeof(x.v));
+    if (gej_has_x(sum, x))
+        return true;
+    limb_t c = 0;
+    for (size_t i = 0; i < limbs; ++i)
+        x.v[i] = addc(r.v[i], Order.v[i], c);
+    return c == 0 && less_than(x.v, FieldP.v) && gej_has_x(sum, x);
+}
+
+buffer_t
+schnorr_public_key(buffer_view_t secret_key) {
+    sc d;
+    if (secret_key.size() != key_size ||
+        !sc_from_bytes(d, secret_key.data()) || sc_is_zero(d))
+        throw exceptions::usage_error{"invalid secp256k1 secret key"};
+    ge p;
+    mul_generator_ct(p, d);
+    mbedtls_platform_zeroize(&d, sizeof(d));
+
+    buffer_t pub(key_size, '\0');
+    write_be(to_ptr(pub), p.x.v);
+    return pub;
+}
+
+buffer_t
+schnorr_sign(
+    buffer_view_t secret_key,
+    buffer_view_t message,
+    buffer_view_t aux_random) {
+    static const tagged_hash aux_hash{"BIP0340/aux"};
+    static const tagged_hash nonce_hash{"BIP0340/nonce"};
+
+    sc d;
+    if (secret_key.size() != key_size ||
+        !sc_from_bytes(d, secret_key.data()) || sc_is_zero(d))
+        throw exceptions::usage_error{"invalid secp256k1 secret key"};
+    if (aux_random.size() != key_size)
+        throw exceptions::usage_error{"aux_random must be 32 bytes"};
+
+    // d = n - d if P has an odd y
+    ge p;
+    mul_generator_ct(p, d);
+    sc neg;
+    sc_neg(neg, d);
+    sc_cmov(d, neg, mask_of(p.y.v[0]));
+    uint8_t px[key_size];
+    write_be(px, p.x.v);
+
+    // t = d xor hash(aux), k = hash(t | P | m) mod n
+    uint8_t t[key_size];
+    aux_hash(t, aux_random);
+    uint8_t db[key_size];
+    write_be(db, d.v);
+    for (size_t i = 0; i < key_size; ++i)
+        t[i] ^= db[i];
+    uint8_t kb[key_size];
+    nonce_hash(
+        kb,
+        buffer_view_t{t, key_size},
+        buffer_view_t{px, key_size},
+        message);
+    sc k;
+    sc_reduce_bytes(k, kb);
+    if (sc_is_zero(k))
+        throw exceptions::usage_error{"invalid schnorr nonce"};
+
+    ge r;
+    mul_generator_ct(r, k);
+    sc_neg(neg, k);
+    sc_cmov(k, neg, mask_of(r.y.v[0]));
+
+    buffer_t sig(2 * key_size, '\0');
+    auto*    out = to_ptr(sig);
+    write_be(out, r.x.v);
+    sc e, s;
+    challenge(e, out, px, message);
+    sc_mul(s, e, d);
+    sc_add(s, s, k);
+    write_be(out + key_size, s.v);
+
+    mbedtls_platform_zeroize(&d, sizeof(d));
+    mbedtls_platform_zeroize(&k, sizeof(k));
+    mbedtls_platform_zeroize(&neg, sizeof(neg));
+    mbedtls_platform_zeroize(t, sizeof(t));
+    mbedtls_platform_zeroize(db, sizeof(db));
+    mbedtls_platform_zeroize(kb, sizeof(kb));
+    return sig;
+}
+
+bool
+schnorr_verify(
+    buffer_view_t public_key, buffer_view_t message, buffer_view_t signature) {
+    schnorr_parts parts;
+    if (!parse_schnorr(parts, {public_key, message, signature}, false))
+        return false;
+
+    // R = s G - e P, must have an even y and the x of the signature
+    sc minus_e;
+    sc_neg(minus_e, parts.e);
+    gej sum;
+    double_multiply(sum, parts.s, parts.pub, minus_e);
+    if (sum.infinity || !gej_has_x(sum, parts.r.x))
+        return false;
+    ge r;
+    gej_to_ge(r, sum);
+    return !fe_is_odd(r.y);
+}
+
+bool
+schnorr_verify_batch(
+    const std::vector<schnorr_item>& items, rnd_generator& rnd) {
+    for (size_t i = 0; i < items.size(); i += batch_chunk) {
+        const size_t count = std::min<size_t>(batch_chunk, items.size() - i);
+        if (!verify_chunk(items.data() + i, count, rnd))
+            return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace secp256k1
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
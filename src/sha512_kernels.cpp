@@ -0,0 +1,482 @@
+#include "./sha512_kernels.hpp"
+#include "./cpu_features.hpp"
+
+#include <mbedtls/platform_util.h>
+#include <mbedtls/sha512.h>
+
+#include <cstring>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#include <immintrin.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace sha512 {
+namespace {
+//-----------------------------------------------------------------------------
+
+/// the round constants (FIPS 180-4)
+alignas(32) const uint64_t RC[80] = {
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f,
+    0xe9b5dba58189dbbc, 0x3956c25bf348b538, 0x59f111f1b605d019,
+    0x923f82a4af194f9b, 0xab1c5ed5da6d8118, 0xd807aa98a3030242,
+    0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+    0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235,
+    0xc19bf174cf692694, 0xe49b69c19ef14ad2, 0xefbe4786384f25e3,
+    0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65, 0x2de92c6f592b0275,
+    0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+    0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f,
+    0xbf597fc7beef0ee4, 0xc6e00bf33da88fc2, 0xd5a79147930aa725,
+    0x06ca6351e003826f, 0x142929670a0e6e70, 0x27b70a8546d22ffc,
+    0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+    0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6,
+    0x92722c851482353b, 0xa2bfe8a14cf10364, 0xa81a664bbc423001,
+    0xc24b8b70d0f89791, 0xc76c51a30654be30, 0xd192e819d6ef5218,
+    0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+    0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99,
+    0x34b0bcb5e19b48a8, 0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb,
+    0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3, 0x748f82ee5defb2fc,
+    0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915,
+    0xc67178f2e372532b, 0xca273eceea26619c, 0xd186b8c721c0c207,
+    0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178, 0x06f067aa72176fba,
+    0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+    0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc,
+    0x431d67c49c100d4c, 0x4cc5d4becb3e42b6, 0x597f299cfc657e2a,
+    0x5fcb6fab3ad6faec, 0x6c44198c4a475817};
+
+const uint64_t Sha384Iv[8] = {
+    0xcbbb9d5dc1059ed8, 0x629a292a367cd507, 0x9159015a3070dd17,
+    0x152fecd8f70e5939, 0x67332667ffc00b31, 0x8eb44a8768581511,
+    0xdb0c2e0d64f98fa7, 0x47b5481dbefa4fa4};
+
+const uint64_t Sha512Iv[8] = {
+    0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b,
+    0xa54ff53a5f1d36f1, 0x510e527fade682d1, 0x9b05688c2b3e6c1f,
+    0x1f83d9abfb41bd6b, 0x5be0cd19137e2179};
+
+inline uint64_t
+get_be64(const uint8_t* p) noexcept {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+inline void
+put_be64(uint8_t* p, uint64_t v) noexcept {
+    for (int i = 7; i >= 0; --i, v >>= 8)
+        p[i] = static_cast<uint8_t>(v);
+}
+
+inline uint64_t
+rotr(uint64_t x, int n) noexcept {
+    return (x >> n) | (x << (64 - n));
+}
+
+inline uint64_t
+small_sigma0(uint64_t x) noexcept {
+    return rotr(x, 1) ^ rotr(x, 8) ^ (x >> 7);
+}
+
+inline uint64_t
+small_sigma1(uint64_t x) noexcept {
+    return rotr(x, 19) ^ rotr(x, 61) ^ (x >> 6);
+}
+
+/// the 80 rounds by the schedule words, already added by the constants
+inline void
+rounds(uint64_t state[8], const uint64_t wk[80]) noexcept {
+    uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+    uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int t = 0; t < 80; ++t) {
+        const uint64_t t1 = h + (rotr(e, 14) ^ rotr(e, 18) ^ rotr(e, 41)) +
+                            ((e & f) ^ (~e & g)) + wk[t];
+        const uint64_t t2 = (rotr(a, 28) ^ rotr(a, 34) ^ rotr(a, 39)) +
+                            ((a & b) | ((a | b) & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = b;
+        b = a;
+        a = t1 + t2;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+}
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+MBEDCRYPTO_TARGET("avx2") inline __m256i
+rotr_x4(__m256i x, int n) noexcept {
+    return _mm256_or_si256(
+        _mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - n));
+}
+
+MBEDCRYPTO_TARGET("avx2") inline __m256i
+small_sigma0_x4(__m256i x) noexcept {
+    return _mm256_xor_si256(
+        _mm256_xor_si256(rotr_x4(x, 1), rotr_x4(x, 8)),
+        _mm256_srli_epi64(x, 7));
+}
+
+MBEDCRYPTO_TARGET("avx2") inline __m256i
+small_sigma1_x4(__m256i x) noexcept {
+    return _mm256_xor_si256(
+        _mm256_xor_si256(rotr_x4(x, 19), rotr_x4(x, 61)),
+        _mm256_srli_epi64(x, 6));
+}
+
+MBEDCRYPTO_TARGET("avx2") inline __m128i
+small_sigma1_x2(__m128i x) noexcept {
+    auto r19 = _mm_or_si128(_mm_srli_epi64(x, 19), _mm_slli_epi64(x, 45));
+    auto r61 = _mm_or_si128(_mm_srli_epi64(x, 61), _mm_slli_epi64(x, 3));
+    return _mm_xor_si128(_mm_xor_si128(r19, r61), _mm_srli_epi64(x, 6));
+}
+
+/// [x1, x2, x3, y0] of x = [x0, x1, x2, x3] and y = [y0, ...]
+MBEDCRYPTO_TARGET("avx2") inline __m256i
+shift_in(__m256i x, __m256i y) noexcept {
+    return _mm256_alignr_epi8(_mm256_permute2x128_si256(x, y, 0x21), x, 8);
+}
+
+/// transposes 4 rows of 4 words in place
+MBEDCRYPTO_TARGET("avx2") inline void
+transpose(__m256i& r0, __m256i& r1, __m256i& r2, __m256i& r3) noexcept {
+    const auto t0 = _mm256_unpacklo_epi64(r0, r1);
+    const auto t1 = _mm256_unpackhi_epi64(r0, r1);
+    const auto t2 = _mm256_unpacklo_epi64(r2, r3);
+    const auto t3 = _mm256_unpackhi_epi64(r2, r3);
+    r0            = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r1            = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r2            = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r3            = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+MBEDCRYPTO_TARGET("avx2") inline __m256i
+load_be64_x4(const uint8_t* p) noexcept {
+    const auto swap = _mm256_setr_epi8(
+        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+        7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    return _mm256_shuffle_epi8(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), swap);
+}
+
+/// wk[t .. t+3] = w + RC[t .. t+3]
+MBEDCRYPTO_TARGET("avx2") inline void
+store_wk(uint64_t* wk, int t, __m256i w) noexcept {
+    const auto k = _mm256_load_si256(reinterpret_cast<const __m256i*>(RC + t));
+    _mm256_store_si256(
+        reinterpret_cast<__m256i*>(wk + t), _mm256_add_epi64(w, k));
+}
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+/// a message being digested by a lane of digest_many()
+struct lane_t {
+    size_t         index  = 0; ///< of the message
+    const uint8_t* data   = nullptr;
+    size_t         blocks = 0; ///< the remaining full blocks of data
+    size_t         tail_blocks = 0;
+    size_t         tail_next   = 0;
+    uint8_t        tail[2 * block_size]; ///< the last bytes and the padding
+    uint64_t       state[8];
+
+    void setup(
+        size_t i, buffer_view_t msg, const uint64_t init[8], uint64_t prefix) {
+        index             = i;
+        data              = msg.data();
+        blocks            = msg.size() / block_size;
+        const size_t rest = msg.size() % block_size;
+        tail_blocks       = rest + 1 + 16 <= block_size ? 1 : 2;
+        tail_next         = 0;
+        std::memset(tail, 0, sizeof(tail));
+        std::memcpy(tail, data + blocks * block_size, rest);
+        tail[rest] = 0x80;
+        // the length in bits, as a 128-bit big endian number
+        const uint64_t length = prefix + msg.size();
+        auto*          end    = tail + tail_blocks * block_size;
+        put_be64(end - 16, length >> 61);
+        put_be64(end - 8, length << 3);
+        std::memcpy(state, init, sizeof(state));
+    }
+
+    bool done() const noexcept {
+        return blocks == 0 && tail_next == tail_blocks;
+    }
+
+    const uint8_t* next_block() noexcept {
+        if (blocks > 0) {
+            const auto* p = data;
+            data += block_size;
+            --blocks;
+            return p;
+        }
+        return tail + block_size * tail_next++;
+    }
+
+    buffer_t digest(bool is384) const {
+        buffer_t out(64, '\0');
+        for (size_t i = 0; i < 8; ++i)
+            put_be64(to_ptr(out) + 8 * i, state[i]);
+        out.resize(is384 ? 48 : 64);
+        return out;
+    }
+}; // struct lane_t
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+void
+process_portable(uint64_t state[8], const uint8_t* block) noexcept {
+    uint64_t w[80];
+    for (int t = 0; t < 16; ++t)
+        w[t] = get_be64(block + 8 * t);
+    for (int t = 16; t < 80; ++t) {
+        w[t] = small_sigma1(w[t - 2]) + w[t - 7] + small_sigma0(w[t - 15]) +
+               w[t - 16];
+    }
+    for (int t = 0; t < 80; ++t)
+        w[t] += RC[t];
+    rounds(state, w);
+}
+
+MBEDCRYPTO_TARGET("avx2") void
+process_avx2(uint64_t state[8], const uint8_t* block) noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+    alignas(32) uint64_t wk[80];
+
+    // the last 16 words of the schedule: w[t-16 .. t-1]
+    __m256i x0 = load_be64_x4(block);
+    __m256i x1 = load_be64_x4(block + 32);
+    __m256i x2 = load_be64_x4(block + 64);
+    __m256i x3 = load_be64_x4(block + 96);
+    store_wk(wk, 0, x0);
+    store_wk(wk, 4, x1);
+    store_wk(wk, 8, x2);
+    store_wk(wk, 12, x3);
+
+    for (int t = 16; t < 80; t += 4) {
+        // w[t-16 .. t-13] + s0(w[t-15 .. t-12]) + w[t-7 .. t-4]
+        const auto x = _mm256_add_epi64(
+            _mm256_add_epi64(x0, small_sigma0_x4(shift_in(x0, x1))),
+            shift_in(x2, x3));
+        // s1 of w[t-2 .. t-1], then of the two new words
+        const auto lo = _mm_add_epi64(
+            _mm256_castsi256_si128(x),
+            small_sigma1_x2(_mm256_extracti128_si256(x3, 1)));
+        const auto hi = _mm_add_epi64(
+            _mm256_extracti128_si256(x, 1), small_sigma1_x2(lo));
+
+        x0 = x1;
+        x1 = x2;
+        x2 = x3;
+        x3 = _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+        store_wk(wk, t, x3);
+    }
+
+    rounds(state, wk);
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+    process_portable(state, block);
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+}
+
+MBEDCRYPTO_TARGET("avx2") void
+process_x4(
+    uint64_t* const      states[lanes],
+    const uint8_t* const blocks[lanes]) noexcept {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+    // transposed: each register holds a word of the 4 messages
+    __m256i w[16];
+    for (int j = 0; j < 16; j += 4) {
+        w[j]     = load_be64_x4(blocks[0] + 8 * j);
+        w[j + 1] = load_be64_x4(blocks[1] + 8 * j);
+        w[j + 2] = load_be64_x4(blocks[2] + 8 * j);
+        w[j + 3] = load_be64_x4(blocks[3] + 8 * j);
+        transpose(w[j], w[j + 1], w[j + 2], w[j + 3]);
+    }
+
+    __m256i s[8];
+    for (int j = 0; j < 8; j += 4) {
+        for (int k = 0; k < 4; ++k) {
+            s[j + k] = _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(states[k] + j));
+        }
+        transpose(s[j], s[j + 1], s[j + 2], s[j + 3]);
+    }
+
+    __m256i a = s[0], b = s[1], c = s[2], d = s[3];
+    __m256i e = s[4], f = s[5], g = s[6], h = s[7];
+    for (int t = 0; t < 80; ++t) {
+        auto& wt = w[t & 15];
+        if (t >= 16) {
+            wt = _mm256_add_epi64(
+                _mm256_add_epi64(
+                    small_sigma1_x4(w[(t - 2) & 15]), w[(t - 7) & 15]),
+                _mm256_add_epi64(small_sigma0_x4(w[(t - 15) & 15]), wt));
+        }
+
+        const auto big_sigma1 = _mm256_xor_si256(
+            _mm256_xor_si256(rotr_x4(e, 14), rotr_x4(e, 18)), rotr_x4(e, 41));
+        const auto ch = _mm256_xor_si256(
+            _mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        const auto t1 = _mm256_add_epi64(
+            _mm256_add_epi64(h, big_sigma1),
+            _mm256_add_epi64(
+                ch,
+                _mm256_add_epi64(
+                    wt, _mm256_set1_epi64x(static_cast<int64_t>(RC[t])))));
+
+        const auto big_sigma0 = _mm256_xor_si256(
+            _mm256_xor_si256(rotr_x4(a, 28), rotr_x4(a, 34)), rotr_x4(a, 39));
+        const auto maj = _mm256_or_si256(
+            _mm256_and_si256(a, b),
+            _mm256_and_si256(_mm256_or_si256(a, b), c));
+        const auto t2 = _mm256_add_epi64(big_sigma0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi64(d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi64(t1, t2);
+    }
+
+    s[0] = _mm256_add_epi64(s[0], a);
+    s[1] = _mm256_add_epi64(s[1], b);
+    s[2] = _mm256_add_epi64(s[2], c);
+    s[3] = _mm256_add_epi64(s[3], d);
+    s[4] = _mm256_add_epi64(s[4], e);
+    s[5] = _mm256_add_epi64(s[5], f);
+    s[6] = _mm256_add_epi64(s[6], g);
+    s[7] = _mm256_add_epi64(s[7], h);
+    for (int j = 0; j < 8; j += 4) {
+        transpose(s[j], s[j + 1], s[j + 2], s[j + 3]);
+        for (int k = 0; k < 4; ++k) {
+            _mm256_storeu_si256(
+                reinterpret_cast<__m256i*>(states[k] + j), s[j + k]);
+        }
+    }
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+    for (size_t k = 0; k < lanes; ++k)
+        process_portable(states[k], blocks[k]);
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+}
+
+process_t
+best_process() noexcept {
+    static const process_t fn =
+        cpu::has_avx2() ? process_t{process_avx2} : process_t{process_portable};
+    return fn;
+}
+
+bool
+supports_multi_buffer() noexcept {
+    return cpu::has_avx2();
+}
+
+void
+initial_state(uint64_t state[8], bool is384) noexcept {
+    std::memcpy(state, is384 ? Sha384Iv : Sha512Iv, 8 * sizeof(uint64_t));
+}
+
+std::vector<buffer_t>
+digest_many(
+    const uint64_t                    init[8],
+    uint64_t                          prefix_length,
+    bool                              is384,
+    const std::vector<buffer_view_t>& messages) {
+    std::vector<buffer_t> digests(messages.size());
+    lane_t                lane[lanes];
+    const auto            process = best_process();
+
+    // one by one, also the last message of the multi-buffer loop
+    auto by_single = [&](lane_t& l) {
+        while (!l.done())
+            process(l.state, l.next_block());
+        digests[l.index] = l.digest(is384);
+    };
+
+    if (!supports_multi_buffer() || messages.size() < 2) {
+        for (size_t i = 0; i < messages.size(); ++i) {
+            lane[0].setup(i, messages[i], init, prefix_length);
+            by_single(lane[0]);
+        }
+    } else {
+        // the idle lanes compress a dummy block
+        const uint8_t  idle_block[block_size] = {0};
+        uint64_t       idle_state[8]          = {0};
+        bool           active[lanes]          = {false};
+        uint64_t*      states[lanes];
+        const uint8_t* blocks[lanes];
+
+        size_t next = 0;
+        for (size_t k = 0; k < lanes && next < messages.size(); ++k, ++next) {
+            lane[k].setup(next, messages[next], init, prefix_length);
+            active[k] = true;
+        }
+
+        for (;;) {
+            size_t count = 0, last = 0;
+            for (size_t k = 0; k < lanes; ++k) {
+                if (active[k]) {
+                    ++count;
+                    last = k;
+                }
+            }
+            if (count == 0)
+                break;
+            if (count == 1 && next == messages.size()) {
+                by_single(lane[last]);
+                break;
+            }
+
+            for (size_t k = 0; k < lanes; ++k) {
+                states[k] = active[k] ? lane[k].state : idle_state;
+                blocks[k] = active[k] ? lane[k].next_block() : idle_block;
+            }
+            process_x4(states, blocks);
+
+            for (size_t k = 0; k < lanes; ++k) {
+                if (!active[k] || !lane[k].done())
+                    continue;
+                digests[lane[k].index] = lane[k].digest(is384);
+                if (next < messages.size()) {
+                    lane[k].setup(next, messages[next], init, prefix_length);
+                    ++next;
+                } else {
+                    active[k] = false;
+                }
+            }
+        }
+    }
+
+    // the states may derive from a key (hmac)
+    mbedtls_platform_zeroize(lane, sizeof(lane));
+    return digests;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace sha512
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+
+#if defined(MBEDTLS_SHA512_PROCESS_ALT)
+/// replaces the portable compression of the mbedtls sha512 module
+extern "C" int
+mbedtls_internal_sha512_process(
+    mbedtls_sha512_context* ctx, const unsigned char data[128]) {
+    static const auto process = mbedcrypto::sha512::best_process();
+    process(ctx->state, data);
+    return 0;
+}
+#endif // MBEDTLS_SHA512_PROCESS_ALT
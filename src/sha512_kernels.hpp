@@ -0,0 +1,75 @@
+/** @file sha512_kernels.hpp
+ * the SHA-512 (and SHA-384) compression function by portable, AVX2 and
+ * AVX2 multi-buffer kernels.
+ *
+ * the mbedtls sha512 module is built by MBEDTLS_SHA512_PROCESS_ALT, so all
+ * the sha384 / sha512 digests (hash, hmac, pk signatures, ...) use
+ * best_process(), dispatched once per process by the CPU features.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_SHA512_KERNELS_HPP
+#define MBEDCRYPTO_SHA512_KERNELS_HPP
+
+#include "mbedcrypto/types.hpp"
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace sha512 {
+//-----------------------------------------------------------------------------
+
+enum K : size_t {
+    block_size = 128,
+    lanes      = 4, ///< of the multi-buffer kernel
+};
+
+/// a compression function of a single block
+using process_t = void (*)(uint64_t state[8], const uint8_t* block);
+
+/// the portable kernel
+void process_portable(uint64_t state[8], const uint8_t* block) noexcept;
+
+/** the message schedule is computed by 4 words per AVX2 step, the rounds are
+ * scalar. only callable if cpu::has_avx2().
+ */
+void process_avx2(uint64_t state[8], const uint8_t* block) noexcept;
+
+/** compresses a block of 4 independent messages, each lane (a 64-bit word of
+ * a ymm register) runs the full rounds of a message.
+ * only callable if cpu::has_avx2().
+ */
+void process_x4(
+    uint64_t* const      states[lanes],
+    const uint8_t* const blocks[lanes]) noexcept;
+
+/// the best single block kernel of this CPU
+process_t
+best_process() noexcept;
+
+/// true if process_x4() is available on this CPU
+bool
+supports_multi_buffer() noexcept;
+
+/// the initial state of sha384 or sha512
+void
+initial_state(uint64_t state[8], bool is384) noexcept;
+
+/** digests many independent messages by the multi-buffer kernel (or one by
+ * one if not available).
+ * every message starts by the state init, after prefix_length bytes (a
+ * multiple of block_size) already compressed into init (ex: the ipad block
+ * of an hmac). the digests are truncated to 48 bytes if is384.
+ */
+std::vector<buffer_t>
+digest_many(
+    const uint64_t                    init[8],
+    uint64_t                          prefix_length,
+    bool                              is384,
+    const std::vector<buffer_view_t>& messages);
+
+//-----------------------------------------------------------------------------
+} // namespace sha512
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_SHA512_KERNELS_HPP
@@ -0,0 +1,242 @@
+#include "mbedcrypto/shamir.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "./conversions.hpp"
+#include "./gf256.hpp"
+
+#include <mbedtls/platform_util.h>
+
+#include <cstring>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace shamir {
+namespace {
+//-----------------------------------------------------------------------------
+
+enum K : size_t {
+    max_shares = 255, ///< the non zero elements of GF(2^8)
+};
+
+void
+check_split(size_t threshold, size_t count) {
+    if (threshold < 2)
+        throw exceptions::usage_error{"the threshold must be at least 2"};
+    if (count < threshold)
+        throw exceptions::usage_error{"fewer shares than the threshold"};
+    if (count > max_shares)
+        throw exceptions::usage_error{"too many shares, the max is 255"};
+}
+
+/// wipes a buffer of secrets (or of random coefficients) on scope exit
+struct wipe_guard {
+    buffer_t& data;
+
+    ~wipe_guard() {
+        mbedtls_platform_zeroize(to_ptr(data), data.size());
+    }
+}; // struct wipe_guard
+
+/** the random coefficients of the polynomials of n secret bytes, the
+ * coefficient t (1 ... threshold - 1) of all the bytes are at (t - 1) * n.
+ */
+buffer_t
+make_coefficients(rnd_generator& rnd, size_t threshold, size_t n) {
+    buffer_t coefs((threshold - 1) * n, '\0');
+    const int ret = rnd.make(to_ptr(coefs), coefs.size());
+    if (ret != 0)
+        throw exception{ret, "the random coefficients of shamir::split"};
+    return coefs;
+}
+
+/// evaluates the polynomials of n bytes at x into y, by horner's method
+void
+evaluate(
+    gf256::mul_xor_t kernel,
+    const uint8_t*   secret,
+    const uint8_t*   coefs,
+    size_t           n,
+    size_t           threshold,
+    uint8_t          x,
+    uint8_t*         y) {
+    std::memcpy(y, coefs + (threshold - 2) * n, n);
+    for (size_t t = threshold - 2; t >= 1; --t)
+        kernel(y, y, x, coefs + (t - 1) * n, n);
+    kernel(y, y, x, secret, n);
+}
+
+/// the shares at x = 1 ... count, of n secret bytes
+std::vector<buffer_t>
+split_bytes(
+    const uint8_t* secret,
+    size_t         n,
+    size_t         threshold,
+    size_t         count,
+    rnd_generator& rnd) {
+    auto       coefs  = make_coefficients(rnd, threshold, n);
+    wipe_guard guard{coefs};
+    const auto kernel = gf256::best_mul_xor();
+
+    std::vector<buffer_t> shares(count, buffer_t(n + 1, '\0'));
+    for (size_t i = 0; i < count; ++i) {
+        auto* share = to_ptr(shares[i]);
+        share[0]    = static_cast<uint8_t>(i + 1);
+        evaluate(
+            kernel,
+            secret,
+            to_const_ptr(coefs),
+            n,
+            threshold,
+            share[0],
+            share + 1);
+    }
+    return shares;
+}
+
+/// true if both sets have the same x coordinates, in the same order
+bool
+same_points(const std::vector<buffer_t>& a, const std::vector<buffer_t>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i].empty() || b[i].empty() || a[i][0] != b[i][0])
+            return false;
+    }
+    return true;
+}
+
+void
+validate(const std::vector<buffer_t>& shares) {
+    if (shares.size() < 2)
+        throw exceptions::usage_error{"at least 2 shares are needed"};
+    const auto size = shares[0].size();
+    if (size < 2)
+        throw exceptions::usage_error{"invalid share"};
+
+    bool seen[max_shares + 1] = {false};
+    for (const auto& s : shares) {
+        if (s.size() != size)
+            throw exceptions::usage_error{"the shares have different sizes"};
+        const auto x = static_cast<uint8_t>(s[0]);
+        if (x == 0 || seen[x])
+            throw exceptions::usage_error{"invalid or repeated share"};
+        seen[x] = true;
+    }
+}
+
+/** the lagrange coefficients of the points of the (valid) shares at x = 0:
+ * l_i = prod(x_j / (x_j - x_i)) for j != i.
+ */
+std::vector<uint8_t>
+lagrange(const std::vector<buffer_t>& shares) {
+    std::vector<uint8_t> coefs(shares.size());
+    for (size_t i = 0; i < shares.size(); ++i) {
+        const auto xi  = static_cast<uint8_t>(shares[i][0]);
+        uint8_t    num = 1;
+        uint8_t    den = 1;
+        for (size_t j = 0; j < shares.size(); ++j) {
+            if (j == i)
+                continue;
+            const auto xj = static_cast<uint8_t>(shares[j][0]);
+            num           = gf256::mul(num, xj);
+            den           = gf256::mul(den, xj ^ xi); // - is + in GF(2^8)
+        }
+        coefs[i] = gf256::mul(num, gf256::inverse(den));
+    }
+    return coefs;
+}
+
+buffer_t
+interpolate(
+    gf256::mul_xor_t             kernel,
+    const std::vector<buffer_t>& shares,
+    const std::vector<uint8_t>&  coefs) {
+    const auto n = shares[0].size() - 1;
+    buffer_t   secret(n, '\0');
+    auto*      out = to_ptr(secret);
+    for (size_t i = 0; i < shares.size(); ++i)
+        kernel(out, to_const_ptr(shares[i]) + 1, coefs[i], out, n);
+    return secret;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+std::vector<buffer_t>
+split(
+    buffer_view_t  secret,
+    size_t         threshold,
+    size_t         count,
+    rnd_generator& rnd) {
+    check_split(threshold, count);
+    if (secret.size() == 0)
+        throw exceptions::usage_error{"the secret is empty"};
+    return split_bytes(secret.data(), secret.size(), threshold, count, rnd);
+}
+
+buffer_t
+combine(const std::vector<buffer_t>& shares) {
+    validate(shares);
+    return interpolate(gf256::best_mul_xor(), shares, lagrange(shares));
+}
+
+std::vector<std::vector<buffer_t>>
+split_many(
+    const std::vector<buffer_view_t>& secrets,
+    size_t                            threshold,
+    size_t                            count,
+    rnd_generator&                    rnd) {
+    check_split(threshold, count);
+
+    // all the secrets as a single vector, the polynomials are independent
+    buffer_t all;
+    for (const auto& s : secrets) {
+        if (s.size() == 0)
+            throw exceptions::usage_error{"the secret is empty"};
+        all.append(reinterpret_cast<const char*>(s.data()), s.size());
+    }
+    wipe_guard guard{all};
+
+    std::vector<std::vector<buffer_t>> result(secrets.size());
+    if (secrets.empty())
+        return result;
+
+    auto whole =
+        split_bytes(to_const_ptr(all), all.size(), threshold, count, rnd);
+    for (auto& r : result)
+        r.reserve(count);
+    for (auto& share : whole) {
+        const char x      = share[0];
+        size_t     offset = 1;
+        for (size_t s = 0; s < secrets.size(); ++s) {
+            const auto size = secrets[s].size();
+            buffer_t   part(size + 1, '\0');
+            part[0] = x;
+            part.replace(1, size, share, offset, size);
+            result[s].push_back(std::move(part));
+            offset += size;
+        }
+    }
+    return result;
+}
+
+std::vector<buffer_t>
+combine_many(const std::vector<std::vector<buffer_t>>& share_sets) {
+    const auto            kernel = gf256::best_mul_xor();
+    std::vector<buffer_t> secrets;
+    secrets.reserve(share_sets.size());
+
+    std::vector<uint8_t> coefs;
+    for (size_t i = 0; i < share_sets.size(); ++i) {
+        const auto& shares = share_sets[i];
+        validate(shares);
+        if (i == 0 || !same_points(shares, share_sets[i - 1]))
+            coefs = lagrange(shares);
+        secrets.push_back(interpolate(kernel, shares, coefs));
+    }
+    return secrets;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace shamir
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,515 @@
+#include "mbedcrypto/tuning.hpp"
+#include "mbedcrypto/cipher.hpp"
+#include "./cpu_features.hpp"
+#include "./fixed_base.hpp"
+#include "./fs_utils.hpp"
+#include "./worker_pool.hpp"
+
+#include <mbedtls/aes.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#include <wmmintrin.h>
+#endif
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace tuning {
+namespace {
+//-----------------------------------------------------------------------------
+
+using clock_type = std::chrono::steady_clock;
+
+enum K {
+    cache_version  = 2,
+    chunk_size     = 16 * 1024,
+    min_parallel   = 64 * 1024,
+    max_parallel   = 256 * 1024 * 1024,
+    min_segment    = 16 * 1024,
+    max_segment    = 4 * 1024 * 1024,
+    max_lanes      = 16,
+    min_crossover  = 8,
+    dispatch_loops = 200,
+};
+
+const char CacheName[] = "mbedcrypto_tuning.cache";
+
+double
+seconds_since(clock_type::time_point start) {
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+size_t
+hardware_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/// the smallest power of two >= n, clamped to [lo, hi]
+size_t
+pow2_clamp(double n, size_t lo, size_t hi) {
+    size_t p = lo;
+    while (p < hi && static_cast<double>(p) < n)
+        p <<= 1;
+    return std::min(p, hi);
+}
+
+/// the cache is valid only on the same (kind of) host
+std::string
+host_fingerprint() {
+    std::string fp = std::to_string(hardware_threads());
+    fp.append(cipher::supports_aes_ni() ? "-aesni" : "-soft");
+    fp.append(sizeof(void*) == 8 ? "-64" : "-32");
+    return fp;
+}
+
+std::string
+default_cache_path() {
+    const char* env = std::getenv("MBEDCRYPTO_TUNING_FILE");
+    if (env != nullptr)
+        return env; // an empty value disables the cache
+
+    auto in_dir = [](const char* dir, const char* sub) -> std::string {
+        if (dir == nullptr || *dir == '\0')
+            return std::string{};
+        std::string path{dir};
+        if (path.back() != '/' && path.back() != '\\')
+            path.push_back('/');
+        return path.append(sub).append(CacheName);
+    };
+
+#if defined(_WIN32)
+    return in_dir(std::getenv("LOCALAPPDATA"), "");
+#else
+    auto path = in_dir(std::getenv("XDG_CACHE_HOME"), "");
+    if (path.empty())
+        path = in_dir(std::getenv("HOME"), ".cache/");
+    return path;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+// micro-benchmarks
+
+struct aes_context {
+    mbedtls_aes_context ctx_;
+
+    aes_context() {
+        const uint8_t Key[16] = {0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae};
+        mbedtls_aes_init(&ctx_);
+        mbedtls_aes_setkey_enc(&ctx_, Key, 128);
+    }
+
+    ~aes_context() {
+        mbedtls_aes_free(&ctx_);
+    }
+
+    void encrypt(uint8_t* data, size_t size) {
+        for (size_t i = 0; i + 16 <= size; i += 16) {
+            mbedtls_aes_crypt_ecb(
+                &ctx_, MBEDTLS_AES_ENCRYPT, data + i, data + i);
+        }
+    }
+}; // struct aes_context
+
+/// single thread AES-128 throughput in bytes per second
+double
+aes_throughput() {
+    aes_context aes;
+    uint8_t     chunk[chunk_size] = {0};
+
+    aes.encrypt(chunk, sizeof(chunk)); // warm up
+    size_t bytes = 0;
+    auto   start = clock_type::now();
+    double elapsed = 0.;
+    do {
+        aes.encrypt(chunk, sizeof(chunk));
+        bytes += sizeof(chunk);
+        elapsed = seconds_since(start);
+    } while (elapsed < 0.01);
+
+    return static_cast<double>(bytes) / elapsed;
+}
+
+/// average latency of a trivial parallel_for() on the pool, in seconds
+double
+dispatch_overhead(worker_pool& pool) {
+    std::atomic<size_t> sink{0};
+    auto fn = [&sink](size_t i) { sink += i; };
+
+    const size_t tasks = pool.size() + 1;
+    for (size_t i = 0; i < dispatch_loops / 10; ++i) // warm up
+        pool.parallel_for(tasks, fn);
+
+    auto start = clock_type::now();
+    for (size_t i = 0; i < dispatch_loops; ++i)
+        pool.parallel_for(tasks, fn);
+    return seconds_since(start) / dispatch_loops;
+}
+
+/** the smallest pool which reaches 90% of the best parallel throughput.
+ * every candidate encrypts the same total size (~4ms of one core work).
+ */
+size_t
+best_pool_threads(double throughput) {
+    const size_t hw = hardware_threads();
+    if (hw == 1)
+        return 1;
+
+    const size_t tasks = hw * 4;
+    const size_t total = std::max<size_t>(
+        tasks * chunk_size, static_cast<size_t>(throughput * 0.004));
+    const size_t per_task = (total / tasks + 15) & ~size_t{15};
+
+    std::vector<size_t> candidates;
+    for (size_t n = 1; n < hw; n <<= 1)
+        candidates.push_back(n);
+    candidates.push_back(hw);
+
+    std::vector<double> rates;
+    for (size_t n : candidates) {
+        worker_pool pool{n};
+        auto        fn = [per_task](size_t) {
+            aes_context aes;
+            uint8_t     chunk[chunk_size] = {0};
+            for (size_t done = 0; done < per_task; done += chunk_size) {
+                aes.encrypt(
+                    chunk, std::min<size_t>(chunk_size, per_task - done));
+            }
+        };
+
+        pool.parallel_for(n + 1, fn); // warm up the threads
+        auto start = clock_type::now();
+        pool.parallel_for(tasks, fn);
+        const double elapsed = seconds_since(start);
+        rates.push_back(static_cast<double>(per_task * tasks) / elapsed);
+    }
+
+    const double best = *std::max_element(rates.begin(), rates.end());
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        if (rates[i] >= best * 0.9)
+            return candidates[i];
+    }
+    return hw;
+}
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+
+/// time of a single aesenc by Lanes independent chains, in seconds
+template <size_t Lanes>
+MBEDCRYPTO_TARGET("aes,sse2") double
+aesenc_time(size_t rounds) {
+    const __m128i key = _mm_set_epi32(0x0c0d0e0f, 0x08090a0b, 0x04050607, 1);
+    __m128i       state[Lanes];
+    for (size_t i = 0; i < Lanes; ++i)
+        state[i] = _mm_set1_epi32(static_cast<int>(i));
+
+    auto start = clock_type::now();
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < Lanes; ++i)
+            state[i] = _mm_aesenc_si128(state[i], key);
+    }
+    double elapsed = seconds_since(start);
+
+    __m128i x = state[0];
+    for (size_t i = 1; i < Lanes; ++i)
+        x = _mm_xor_si128(x, state[i]);
+    volatile int sink = _mm_cvtsi128_si32(x);
+    (void)sink;
+
+    return elapsed / static_cast<double>(rounds * Lanes);
+}
+
+template <size_t Lanes>
+double
+best_aesenc_time() {
+    double best = aesenc_time<Lanes>(1 << 16);
+    for (int i = 0; i < 2; ++i)
+        best = std::min(best, aesenc_time<Lanes>(1 << 16));
+    return best;
+}
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+
+/** the smallest count of interleaved blocks which hides the latency of the
+ * AES-NI pipeline (within 15% of the best per block time).
+ * without AES-NI the table based software AES does not gain by interleaving.
+ */
+size_t
+best_lanes() {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+    if (cipher::supports_aes_ni()) {
+        const size_t Lanes[] = {1, 2, 4, 8};
+        const double times[] = {
+            best_aesenc_time<1>(),
+            best_aesenc_time<2>(),
+            best_aesenc_time<4>(),
+            best_aesenc_time<8>(),
+        };
+
+        const double best = *std::min_element(times, times + 4);
+        for (size_t i = 0; i < 4; ++i) {
+            if (times[i] <= best * 1.15)
+                return Lanes[i];
+        }
+        return 8;
+    }
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+    return 1;
+}
+
+thresholds
+measure() {
+    thresholds t;
+    t.lanes        = best_lanes();
+    t.pool_threads = best_pool_threads(aes_throughput());
+
+    // the throughput after the threads have settled
+    const double throughput = aes_throughput();
+    double       overhead   = 0.;
+    {
+        worker_pool pool{t.pool_threads};
+        overhead = dispatch_overhead(pool);
+    }
+
+    // bytes processed in a single dispatch latency
+    const double break_even = throughput * overhead;
+    if (hardware_threads() == 1) {
+        t.parallel_min_bytes = SIZE_MAX; // never parallel
+    } else {
+        // the work of a parallel call must hide its latency many times
+        t.parallel_min_bytes =
+            pow2_clamp(break_even * 8, min_parallel, max_parallel);
+    }
+    t.segment_size = pow2_clamp(break_even * 2, min_segment, max_segment);
+    t.segment_size = std::min(t.segment_size, t.parallel_min_bytes / 2);
+
+    const auto crossover = measure_mul_crossover();
+    t.karatsuba_limbs    = crossover.karatsuba;
+    t.toom3_limbs        = crossover.toom3;
+    return t;
+}
+
+/// the static thresholds of an uncalibrated host, no benchmark is run
+thresholds
+defaults() {
+    thresholds t;
+    t.pool_threads = hardware_threads();
+    return t;
+}
+
+bool
+is_valid(const thresholds& t) noexcept {
+    return t.parallel_min_bytes > 0 && t.segment_size > 0 && t.lanes > 0 &&
+           t.lanes <= max_lanes && t.pool_threads > 0 &&
+           t.karatsuba_limbs >= min_crossover &&
+           t.toom3_limbs >= t.karatsuba_limbs;
+}
+
+//-----------------------------------------------------------------------------
+
+struct state_t {
+    std::mutex  mutex;
+    bool        ready = false;
+    thresholds  values;
+    origin_t    origin = origin_t::defaults;
+    bool        has_path = false;
+    std::string path;
+
+    const std::string& cache() { // under mutex
+        if (!has_path) {
+            path     = default_cache_path();
+            has_path = true;
+        }
+        return path;
+    }
+
+    /// saves into the cache file if possible (under mutex)
+    void persist() noexcept {
+        if (cache().empty())
+            return;
+        try {
+            save(path.c_str(), values);
+        } catch (...) {
+            // read-only or missing directories only disable the cache
+        }
+    }
+
+    void calibrate(bool persist_it) { // under mutex
+        values = measure();
+        origin = origin_t::calibration;
+        ready  = true;
+        if (persist_it)
+            persist();
+    }
+
+    /// loads an existing cache, never measures nor writes (under mutex)
+    void init() {
+        if (ready)
+            return;
+        if (!cache().empty() && load(path.c_str(), values)) {
+            origin = origin_t::cache;
+        } else {
+            values = defaults();
+            origin = origin_t::defaults;
+        }
+        ready = true;
+    }
+}; // struct state_t
+
+state_t&
+state() {
+    static state_t s;
+    return s;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+thresholds
+current() {
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.init();
+    return s.values;
+}
+
+origin_t
+origin() {
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.origin;
+}
+
+thresholds
+calibrate(bool persist) {
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.calibrate(persist);
+    return s.values;
+}
+
+void
+set_thresholds(const thresholds& t, bool persist) {
+    if (!is_valid(t))
+        throw exceptions::usage_error{"invalid tuning thresholds"};
+
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.values = t;
+    s.origin = origin_t::user;
+    s.ready  = true;
+    if (persist && !s.cache().empty())
+        save(s.path.c_str(), t);
+}
+
+std::string
+cache_path() {
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.cache();
+}
+
+void
+set_cache_path(const std::string& path) {
+    auto&                       s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.path     = path;
+    s.has_path = true;
+}
+
+void
+save(const char* file_path, const thresholds& t) {
+    if (file_path == nullptr || *file_path == '\0')
+        throw exceptions::usage_error{"invalid tuning cache path"};
+
+    std::ostringstream out;
+    out << "version=" << cache_version << '\n'
+        << "host=" << host_fingerprint() << '\n'
+        << "parallel_min_bytes=" << t.parallel_min_bytes << '\n'
+        << "segment_size=" << t.segment_size << '\n'
+        << "lanes=" << t.lanes << '\n'
+        << "pool_threads=" << t.pool_threads << '\n'
+        << "karatsuba_limbs=" << t.karatsuba_limbs << '\n'
+        << "toom3_limbs=" << t.toom3_limbs << '\n';
+
+    fs::write_file(file_path, out.str());
+}
+
+bool
+load(const char* file_path, thresholds& t) {
+    if (file_path == nullptr || fs::file_size(file_path) <= 0)
+        return false;
+
+    buffer_t content;
+    try {
+        content = fs::read_file(file_path);
+    } catch (...) {
+        return false;
+    }
+
+    thresholds         values;
+    size_t             found = 0;
+    bool               matched_version = false, matched_host = false;
+    std::istringstream in{content};
+    std::string        line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+
+        const auto eq = line.find('=');
+        if (eq == std::string::npos)
+            return false;
+        const auto key   = line.substr(0, eq);
+        const auto value = line.substr(eq + 1);
+
+        if (key == "version") {
+            matched_version = value == std::to_string(cache_version);
+            continue;
+        } else if (key == "host") {
+            matched_host = value == host_fingerprint();
+            continue;
+        }
+
+        char* end    = nullptr;
+        auto  number = std::strtoull(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0')
+            return false;
+
+        const auto n = static_cast<size_t>(number);
+        if (key == "parallel_min_bytes")
+            values.parallel_min_bytes = n;
+        else if (key == "segment_size")
+            values.segment_size = n;
+        else if (key == "lanes")
+            values.lanes = n;
+        else if (key == "pool_threads")
+            values.pool_threads = n;
+        else if (key == "karatsuba_limbs")
+            values.karatsuba_limbs = n;
+        else if (key == "toom3_limbs")
+            values.toom3_limbs = n;
+        else
+            continue; // unknown keys of the same version are ignored
+        ++found;
+    }
+
+    if (!matched_version || !matched_host || found != 6 || !is_valid(values))
+        return false;
+
+    t = values;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace tuning
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -1,6 +1,8 @@
 #include "mbedcrypto/types.hpp"
 #include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/dhm.hpp"
 #include "mbedcrypto/pk.hpp"
+#include "mbedcrypto/x509.hpp"
 
 #include "./conversions.hpp"
 #include "./enumerator.hxx"
@@ -77,6 +79,12 @@ supports(features f) {
     case features::ec_keygen:
         return pk::supports_ec_keygen();
 
+    case features::x509:
+        return supports_x509();
+
+    case features::dhm:
+        return supports_dhm();
+
     default:
         return false;
     }
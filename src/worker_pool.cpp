@@ -0,0 +1,149 @@
+#include "./worker_pool.hpp"
+#include "mbedcrypto/tuning.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+namespace {
+//-----------------------------------------------------------------------------
+
+/// shared state of a parallel_for() call, outlives the caller if a helper
+/// task is dequeued after the loop has been finished.
+struct loop_state {
+    std::atomic<size_t> next{0};
+    size_t              count = 0;
+    size_t              done  = 0; ///< guarded by mutex
+    size_t              busy  = 0; ///< guarded by mutex
+    std::exception_ptr  error;     ///< guarded by mutex
+    std::mutex          mutex;
+    std::condition_variable cv;
+
+    const std::function<void(size_t)>* fn = nullptr;
+
+    void work() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (done >= count)
+                return;
+            ++busy;
+        }
+
+        size_t finished = 0;
+        std::exception_ptr err;
+        for (size_t i = next++; i < count; i = next++) {
+            try {
+                (*fn)(i);
+            } catch (...) {
+                err = std::current_exception();
+                // skip the remaining indices
+                finished += 1 + (count - std::min(count, next.exchange(count)));
+                break;
+            }
+            ++finished;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        done += finished;
+        --busy;
+        if (err && !error)
+            error = err;
+        if (done >= count && busy == 0)
+            cv.notify_all();
+    }
+}; // struct loop_state
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+worker_pool&
+worker_pool::shared() {
+    // the size is set by tuning, the pool itself is never tuned by
+    // the shared pool (no recursion)
+    static worker_pool pool{tuning::current().pool_threads};
+    return pool;
+}
+
+worker_pool::worker_pool(size_t thread_count) {
+    if (thread_count == 0)
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i)
+        threads_.emplace_back([this]() { run(); });
+}
+
+worker_pool::~worker_pool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+
+    for (auto& t : threads_)
+        t.join();
+}
+
+void
+worker_pool::post(task_t task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.emplace_back(std::move(task));
+    }
+    cv_.notify_one();
+}
+
+void
+worker_pool::parallel_for(
+    size_t count, const std::function<void(size_t)>& fn, size_t max_workers) {
+    if (count == 0)
+        return;
+
+    if (max_workers == 0 || max_workers > size() + 1)
+        max_workers = size() + 1;
+
+    auto state   = std::make_shared<loop_state>();
+    state->count = count;
+    state->fn    = &fn;
+
+    // the caller is also a worker
+    size_t helpers = std::min(max_workers, count) - 1;
+    for (size_t i = 0; i < helpers; ++i)
+        post([state]() { state->work(); });
+
+    state->work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&state]() {
+        return state->done >= state->count && state->busy == 0;
+    });
+
+    if (state->error)
+        std::rethrow_exception(state->error);
+}
+
+void
+worker_pool::run() {
+    for (;;) {
+        task_t task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            if (stop_ && tasks_.empty())
+                return;
+
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+
+        task();
+    }
+}
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
@@ -0,0 +1,73 @@
+/** @file worker_pool.hpp
+ * a small, shared thread pool used internally by the bulk (batch) apis.
+ *
+ * @copyright (C) 2026
+ * @date 2026.10.19
+ */
+
+#ifndef MBEDCRYPTO_WORKER_POOL_HPP
+#define MBEDCRYPTO_WORKER_POOL_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+/** a fixed size pool of worker threads.
+ * tasks are executed in FIFO order. parallel_for() is the main entry point,
+ * the calling thread also takes part in the work, so nested calls (from inside
+ * a worker) never dead-lock even if all the workers are busy.
+ */
+class worker_pool
+{
+public:
+    using task_t = std::function<void()>;
+
+    /// the process wide pool, created on first use by tuning::current() size
+    static worker_pool& shared();
+
+    /// 0 means std::thread::hardware_concurrency()
+    explicit worker_pool(size_t thread_count = 0);
+    ~worker_pool();
+
+    /// number of worker threads
+    size_t size() const noexcept {
+        return threads_.size();
+    }
+
+    /// queues a task, fire and forget
+    void post(task_t);
+
+    /** calls fn(i) for every i in [0, count) and blocks until all are done.
+     * at most max_workers threads (including the caller) take part, 0 means
+     * all the pool threads.
+     * the first exception thrown by fn is re-thrown in the calling thread,
+     * the remaining indices are skipped.
+     */
+    void parallel_for(
+        size_t count, const std::function<void(size_t)>& fn,
+        size_t max_workers = 0);
+
+public: // non-copyable, non-movable
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+
+protected:
+    void run();
+
+    std::mutex               mutex_;
+    std::condition_variable  cv_;
+    std::deque<task_t>       tasks_;
+    std::vector<std::thread> threads_;
+    bool                     stop_ = false;
+}; // class worker_pool
+
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
+#endif // MBEDCRYPTO_WORKER_POOL_HPP
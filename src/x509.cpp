@@ -0,0 +1,462 @@
+#include "mbedcrypto/x509.hpp"
+#include "mbedcrypto/ecp.hpp"
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/public_key.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "./pk_private.hpp"
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+
+#include <mbedtls/x509_crt.h>
+
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#endif // MBEDTLS_X509_CRT_PARSE_C
+//-----------------------------------------------------------------------------
+namespace mbedcrypto {
+//-----------------------------------------------------------------------------
+
+bool
+supports_x509() noexcept {
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    return true;
+#else  // MBEDTLS_X509_CRT_PARSE_C
+    return false;
+#endif // MBEDTLS_X509_CRT_PARSE_C
+}
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+//-----------------------------------------------------------------------------
+namespace {
+//-----------------------------------------------------------------------------
+
+static_assert(std::is_copy_constructible<x509_cert>::value == false, "");
+static_assert(std::is_move_constructible<x509_cert>::value == true,  "");
+static_assert(std::is_copy_constructible<x509_verifier>::value == false, "");
+static_assert(std::is_move_constructible<x509_verifier>::value == true,  "");
+
+enum K {
+    dn_length   = 1024,
+    info_length = 4096,
+};
+
+/// utc time to time_t, independent of the local time zone (days from civil)
+std::time_t
+to_time_t(const mbedtls_x509_time& t) {
+    const int      y   = t.year - (t.mon <= 2 ? 1 : 0);
+    const int      era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = static_cast<unsigned>(
+        (153 * (t.mon + (t.mon > 2 ? -3 : 9)) + 2) / 5 + t.day - 1);
+    const unsigned doe  = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    const int64_t  days = era * 146097LL + static_cast<int64_t>(doe) - 719468;
+
+    return static_cast<std::time_t>(
+        days * 86400 + t.hour * 3600 + t.min * 60 + t.sec);
+}
+
+template <class Func, class... Args>
+std::string
+gets_string(size_t capacity, Func&& c_func, Args&&... args) {
+    std::string buffer(capacity, '\0');
+    int ret = c_func(&buffer.front(), capacity, std::forward<Args&&>(args)...);
+    if (ret < 0)
+        throw exception{ret, "x509 string conversion"};
+
+    buffer.resize(static_cast<size_t>(ret));
+    return buffer;
+}
+
+bool
+is_pem(buffer_view_t data) {
+    const char Header[] = "-----BEGIN ";
+    const auto* begin   = data.data();
+    const auto* end     = begin + data.size();
+    return std::search(begin, end, Header, Header + sizeof(Header) - 1) != end;
+}
+
+/// parses pem or der data and appends the certificates into chain
+void
+parse_into(mbedtls_x509_crt& chain, buffer_view_t data) {
+    if (data.empty())
+        throw exceptions::usage_error{"empty certificate data"};
+
+    int ret = 0;
+    if (!is_pem(data)) {
+        ret = mbedtls_x509_crt_parse_der(&chain, data.data(), data.size());
+    } else if (data.data()[data.size() - 1] == '\0') {
+        ret = mbedtls_x509_crt_parse(&chain, data.data(), data.size());
+    } else { // mbedtls pem reader needs a null terminated input
+        auto copy = data.to<buffer_t>();
+        ret = mbedtls_x509_crt_parse(
+            &chain, to_const_ptr(copy), copy.size() + 1);
+    }
+
+    if (ret < 0)
+        throw exception{ret, "x509 certificate parse"};
+    else if (ret > 0)
+        throw exceptions::usage_error{"some certificates failed to parse"};
+}
+
+size_t
+count_of(const mbedtls_x509_crt& chain) noexcept {
+    size_t count = 0;
+    for (const auto* c = &chain; c != nullptr && c->raw.len > 0; c = c->next)
+        ++count;
+    return count;
+}
+
+/// returns the public key of crt as a new rsa or ecp instance
+std::unique_ptr<pk::pk_base>
+make_key_of(const mbedtls_x509_crt& crt) {
+    auto ptype = from_native(mbedtls_pk_get_type(&crt.pk));
+    switch (ptype) {
+    case pk_t::rsa:
+        return std::make_unique<rsa>();
+
+#if defined(MBEDTLS_ECP_C)
+    case pk_t::eckey:
+    case pk_t::ecdsa:
+        return std::make_unique<ecp>(ptype);
+#endif // MBEDTLS_ECP_C
+
+    default:
+        throw exceptions::unknown_pk{};
+    }
+}
+
+/// deep copies the public key of crt into d
+void
+copy_public_key(pk::context& d, const mbedtls_x509_crt& crt) {
+    auto ptype = from_native(mbedtls_pk_get_type(&crt.pk));
+    pk::reset_as(d, ptype);
+
+    pk::copy_public_part(d.pk_, crt.pk);
+    d.key_is_private_ = false;
+}
+
+/// collects the earliest not_after of the verified chain
+int
+on_verify(void* p, mbedtls_x509_crt* crt, int, uint32_t*) {
+    auto* expires = reinterpret_cast<std::time_t*>(p);
+    *expires      = std::min(*expires, to_time_t(crt->valid_to));
+    return 0;
+}
+
+//-----------------------------------------------------------------------------
+} // namespace anon
+//-----------------------------------------------------------------------------
+
+struct x509_cert::impl {
+    mbedtls_x509_crt chain_;
+
+    explicit impl() {
+        mbedtls_x509_crt_init(&chain_);
+    }
+
+    ~impl() {
+        mbedtls_x509_crt_free(&chain_);
+    }
+
+    const mbedtls_x509_crt& at(size_t index) const {
+        const auto* c = &chain_;
+        for (size_t i = 0; c != nullptr && i < index; ++i)
+            c = c->next;
+
+        if (c == nullptr || c->raw.len == 0)
+            throw exceptions::usage_error{"invalid certificate index"};
+        return *c;
+    }
+
+    /// sha256 of all the certificates, the chain identity of the cache
+    std::string chain_id() const {
+        std::string id;
+        for (const auto* c = &chain_; c != nullptr && c->raw.len > 0;
+             c             = c->next) {
+            id += hash::make(hash_t::sha256, buffer_view_t{c->raw.p, c->raw.len});
+        }
+        return id;
+    }
+}; // struct x509_cert::impl
+
+//-----------------------------------------------------------------------------
+
+x509_cert::x509_cert() : pimpl{std::make_unique<impl>()} {}
+
+x509_cert::~x509_cert() = default;
+
+x509_cert::x509_cert(x509_cert&&) = default;
+
+x509_cert& x509_cert::operator=(x509_cert&&) = default;
+
+void
+x509_cert::import(buffer_view_t pem_or_der) {
+    parse_into(pimpl->chain_, pem_or_der);
+}
+
+void
+x509_cert::load(const char* file_path) {
+    mbedcrypto_c_call(mbedtls_x509_crt_parse_file, &pimpl->chain_, file_path);
+}
+
+size_t
+x509_cert::size() const noexcept {
+    return count_of(pimpl->chain_);
+}
+
+auto
+x509_cert::info(size_t index) const -> info_t {
+    const auto& crt = pimpl->at(index);
+
+    info_t inf;
+    inf.version = crt.version;
+    inf.serial  = gets_string(dn_length, mbedtls_x509_serial_gets, &crt.serial);
+    inf.subject = gets_string(dn_length, mbedtls_x509_dn_gets, &crt.subject);
+    inf.issuer  = gets_string(dn_length, mbedtls_x509_dn_gets, &crt.issuer);
+    inf.not_before     = to_time_t(crt.valid_from);
+    inf.not_after      = to_time_t(crt.valid_to);
+    inf.is_ca          = crt.ca_istrue != 0;
+    inf.path_length    = crt.max_pathlen - 1; // mbedtls stores 1 + pathlen
+    inf.key_type       = from_native(mbedtls_pk_get_type(&crt.pk));
+    inf.key_bitlen     = mbedtls_pk_get_bitlen(&crt.pk);
+    inf.signature_hash = from_native(crt.sig_md);
+    return inf;
+}
+
+buffer_t
+x509_cert::der(size_t index) const {
+    const auto& crt = pimpl->at(index);
+    return buffer_t{reinterpret_cast<const char*>(crt.raw.p), crt.raw.len};
+}
+
+buffer_t
+x509_cert::fingerprint(size_t index, hash_t type) const {
+    const auto& crt = pimpl->at(index);
+    return hash::make(type, buffer_view_t{crt.raw.p, crt.raw.len});
+}
+
+void
+x509_cert::public_key(pk::pk_base& pk, size_t index) const {
+    copy_public_key(pk.context(), pimpl->at(index));
+}
+
+auto
+x509_cert::public_key(size_t index) const -> std::unique_ptr<pk::pk_base> {
+    const auto& crt = pimpl->at(index);
+    auto        key = make_key_of(crt);
+    copy_public_key(key->context(), crt);
+    return key;
+}
+
+void
+x509_cert::public_key(mbedcrypto::public_key& pub, size_t index) const {
+    const auto& raw = pimpl->at(index).pk_raw; // the SubjectPublicKeyInfo
+    pub.import(buffer_view_t{raw.p, raw.len});
+}
+
+std::string
+x509_cert::dump(size_t index) const {
+    const auto& crt = pimpl->at(index);
+    return gets_string(info_length, mbedtls_x509_crt_info, "", &crt);
+}
+
+//-----------------------------------------------------------------------------
+
+std::string
+x509_verifier::result_t::reason() const {
+    if (flags == 0)
+        return std::string{};
+    return gets_string(info_length, mbedtls_x509_crt_verify_info, "", flags);
+}
+
+struct x509_verifier::impl {
+    struct entry_t {
+        std::string key;
+        std::time_t expires = 0;
+    };
+
+    using lru_t   = std::list<entry_t>;
+    using index_t = std::unordered_map<std::string, lru_t::iterator>;
+
+    const size_t               capacity_;
+    const std::chrono::seconds ttl_;
+
+    // the trust store only grows, verifications share the lock
+    mutable std::shared_timed_mutex trust_mutex_;
+    mbedtls_x509_crt                trusted_;
+
+    mutable std::mutex cache_mutex_;
+    lru_t              lru_; ///< most recently used first
+    index_t            index_;
+    stats_t            stats_;
+
+    explicit impl(size_t capacity, std::chrono::seconds ttl)
+        : capacity_{capacity}, ttl_{ttl} {
+        mbedtls_x509_crt_init(&trusted_);
+    }
+
+    ~impl() {
+        mbedtls_x509_crt_free(&trusted_);
+    }
+
+    bool cache_enabled() const noexcept {
+        return capacity_ > 0 && ttl_.count() > 0;
+    }
+
+    void erase(lru_t::iterator it) {
+        index_.erase(it->key);
+        lru_.erase(it);
+        ++stats_.evictions;
+    }
+
+    /// returns the expiry of a valid cached entry or 0
+    std::time_t lookup(const std::string& key, std::time_t now) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            if (it->second->expires > now) {
+                lru_.splice(lru_.begin(), lru_, it->second);
+                ++stats_.hits;
+                return it->second->expires;
+            }
+            erase(it->second);
+        }
+
+        ++stats_.misses;
+        return 0;
+    }
+
+    void insert(std::string key, std::time_t expires) {
+        std::lock_guard<std::mutex> lock(cache_mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end()) { // verified concurrently by another thread
+            it->second->expires = expires;
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return;
+        }
+
+        lru_.push_front(entry_t{key, expires});
+        index_.emplace(std::move(key), lru_.begin());
+        while (lru_.size() > capacity_)
+            erase(std::prev(lru_.end()));
+    }
+
+    static std::string make_key(const x509_cert& chain, const char* name) {
+        auto key = chain.pimpl->chain_id();
+        if (name != nullptr) {
+            key.push_back('\0');
+            key.append(name);
+        }
+        return key;
+    }
+}; // struct x509_verifier::impl
+
+//-----------------------------------------------------------------------------
+
+x509_verifier::x509_verifier(size_t capacity, std::chrono::seconds ttl)
+    : pimpl{std::make_unique<impl>(capacity, ttl)} {}
+
+x509_verifier::~x509_verifier() = default;
+
+x509_verifier::x509_verifier(x509_verifier&&) = default;
+
+x509_verifier& x509_verifier::operator=(x509_verifier&&) = default;
+
+void
+x509_verifier::add_trusted(buffer_view_t pem_or_der) {
+    std::unique_lock<std::shared_timed_mutex> lock(pimpl->trust_mutex_);
+    parse_into(pimpl->trusted_, pem_or_der);
+}
+
+void
+x509_verifier::add_trusted(const x509_cert& certs) {
+    std::unique_lock<std::shared_timed_mutex> lock(pimpl->trust_mutex_);
+    for (const auto* c = &certs.pimpl->chain_; c != nullptr && c->raw.len > 0;
+         c             = c->next) {
+        mbedcrypto_c_call(
+            mbedtls_x509_crt_parse_der, &pimpl->trusted_, c->raw.p, c->raw.len);
+    }
+}
+
+size_t
+x509_verifier::trusted_size() const {
+    std::shared_lock<std::shared_timed_mutex> lock(pimpl->trust_mutex_);
+    return count_of(pimpl->trusted_);
+}
+
+auto
+x509_verifier::verify(const x509_cert& chain, const char* expected_name)
+    -> result_t {
+    if (chain.empty())
+        throw exceptions::usage_error{"empty certificate chain"};
+
+    auto& d   = *pimpl;
+    auto  now = std::time(nullptr);
+
+    result_t    result;
+    std::string key;
+    if (d.cache_enabled()) {
+        key            = impl::make_key(chain, expected_name);
+        result.expires = d.lookup(key, now);
+        if (result.expires != 0) {
+            result.ok         = true;
+            result.from_cache = true;
+            return result;
+        }
+    }
+
+    auto chain_expiry = std::numeric_limits<std::time_t>::max();
+    int  ret          = 0;
+    {
+        std::shared_lock<std::shared_timed_mutex> lock(d.trust_mutex_);
+        ret = mbedtls_x509_crt_verify(
+            &chain.pimpl->chain_,
+            &d.trusted_,
+            nullptr,
+            expected_name,
+            &result.flags,
+            on_verify,
+            &chain_expiry);
+    }
+
+    if (ret != 0 && ret != MBEDTLS_ERR_X509_CERT_VERIFY_FAILED)
+        throw exception{ret, "x509 chain verification"};
+
+    result.ok = ret == 0;
+    // only the successful verifications are cached
+    if (result.ok && d.cache_enabled()) {
+        auto expires = std::min(chain_expiry, now + d.ttl_.count());
+        if (expires > now) {
+            result.expires = expires;
+            d.insert(std::move(key), expires);
+        }
+    }
+
+    return result;
+}
+
+void
+x509_verifier::clear_cache() {
+    std::lock_guard<std::mutex> lock(pimpl->cache_mutex_);
+    pimpl->lru_.clear();
+    pimpl->index_.clear();
+}
+
+auto
+x509_verifier::stats() const -> stats_t {
+    std::lock_guard<std::mutex> lock(pimpl->cache_mutex_);
+    auto s = pimpl->stats_;
+    s.size = pimpl->lru_.size();
+    return s;
+}
+
+//-----------------------------------------------------------------------------
+#endif // MBEDTLS_X509_CRT_PARSE_C
+//-----------------------------------------------------------------------------
+} // namespace mbedcrypto
+//-----------------------------------------------------------------------------
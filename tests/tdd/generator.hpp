@@ -38,6 +38,15 @@ buffer_t rsa_private_key();
 /// @endcode
 buffer_t rsa_private_key_password();
 
+/// same as above key, as PKCS#8 PBES2 (AES256, hmacWithSHA256).
+/// password is: mbedcrypto1234
+/// generated by:
+/// @code
+/// $> openssl pkcs8 -topk8 -v2 aes-256-cbc -v2prf hmacWithSHA256 -iter 2048
+///     -in mprivate.pem -out mprivate_pkcs8.pem
+/// @endcode
+buffer_t rsa_private_key_pkcs8();
+
 /// the public pair of the above key
 /// generated by:
 /// @code
@@ -51,6 +60,26 @@ buffer_t rsa_public_key();
 /// $> openssl dgst -sha1 -verify public.pem -signature signature.bin long.txt
 buffer_t long_text_signature();
 
+/// a self signed X.509 root CA (rsa 2048, sha256), serial 01, valid until 2126
+/// generated by:
+/// @code
+/// $> openssl req -x509 -new -key root.key -sha256 -days 36500
+///     -subj "/C=NL/O=mbedcrypto/CN=mbedcrypto test root CA"
+///     -set_serial 1 -extensions v3_root -out root.pem
+/// @endcode
+buffer_t x509_root_ca();
+
+/// an intermediate CA (pathlen:0) issued by x509_root_ca(), valid until 2125
+buffer_t x509_intermediate_ca();
+
+/// a server certificate of "mbedcrypto.test" (also as subjectAltName) issued
+/// by x509_intermediate_ca(), the key pair is rsa_private_key().
+/// not before: 2026-10-19 00:51:00, not after: 2122-08-17 00:51:00 (utc)
+buffer_t x509_leaf();
+
+/// an unrelated self signed root CA, x509_leaf() does not chain to it
+buffer_t x509_other_root_ca();
+
 ///////////////////////////////////////////////////////////////////////////////
 
 /// utility function for reading a buffer in chunks
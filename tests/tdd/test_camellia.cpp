@@ -0,0 +1,314 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+#include "../../src/camellia_kernels.hpp"
+#include "../../src/cpu_features.hpp"
+
+#if defined(MBEDTLS_CAMELLIA_C)
+#include <chrono>
+#include <cstdio>
+#include <vector>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+///////////////////////////////////////////////////////////////////////////////
+using namespace mbedcrypto;
+
+struct kernel_t {
+    const char*     name;
+    camellia::ecb_t fn;
+};
+
+std::vector<kernel_t>
+kernels() {
+    std::vector<kernel_t> v{{"portable", camellia::ecb_portable}};
+    if (cpu::has_aesni() && cpu::has_ssse3())
+        v.push_back({"x16", camellia::ecb_x16});
+    if (cpu::has_aesni() && cpu::has_avx2())
+        v.push_back({"x32", camellia::ecb_x32});
+    return v;
+}
+
+struct context {
+    mbedtls_camellia_context ctx_;
+
+    context(buffer_view_t key, bool encrypting) {
+        mbedtls_camellia_init(&ctx_);
+        const auto bits = static_cast<unsigned int>(key.size() * 8);
+        if (encrypting)
+            mbedtls_camellia_setkey_enc(&ctx_, key.data(), bits);
+        else
+            mbedtls_camellia_setkey_dec(&ctx_, key.data(), bits);
+    }
+
+    ~context() {
+        mbedtls_camellia_free(&ctx_);
+    }
+
+    buffer_t ecb(buffer_view_t input) {
+        buffer_t output(input.size(), '\0');
+        for (size_t i = 0; i < input.size(); i += 16) {
+            mbedtls_camellia_crypt_ecb(
+                &ctx_,
+                MBEDTLS_CAMELLIA_ENCRYPT,
+                input.data() + i,
+                to_ptr(output) + i);
+        }
+        return output;
+    }
+
+    buffer_t crypt(camellia::ecb_t fn, buffer_view_t input) const {
+        buffer_t output(input.size(), '\0');
+        fn(ctx_, input.data(), to_ptr(output), input.size() / 16);
+        return output;
+    }
+};
+
+buffer_t
+repeat(buffer_view_t block, size_t n) {
+    buffer_t s;
+    for (size_t i = 0; i < n; ++i)
+        s.append(reinterpret_cast<const char*>(block.data()), block.size());
+    return s;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("camellia kernels", "[camellia][cipher]") {
+    rnd_generator rnd;
+
+    SECTION("rfc 3713 vectors") {
+        const char plain[] = "\x01\x23\x45\x67\x89\xab\xcd\xef"
+                             "\xfe\xdc\xba\x98\x76\x54\x32\x10";
+        const char tail[]  = "\x00\x11\x22\x33\x44\x55\x66\x77"
+                            "\x88\x99\xaa\xbb\xcc\xdd\xee\xff";
+        const char* cipher_texts[] = {
+            "\x67\x67\x31\x38\x54\x96\x69\x73"
+            "\x08\x57\x06\x56\x48\xea\xbe\x43",
+            "\xb4\x99\x34\x01\xb3\xe9\x96\xf8"
+            "\x4e\xe5\xce\xe7\xd7\x9b\x09\xb9",
+            "\x9a\xcc\x23\x7d\xff\x16\xd7\x6c"
+            "\x20\xef\x7c\x91\x9e\x3a\x75\x09",
+        };
+
+        for (size_t i = 0; i < 3; ++i) {
+            const buffer_t key = buffer_t(plain, 16) + buffer_t(tail, 8 * i);
+            const auto     pt  = repeat(buffer_t(plain, 16), 45);
+            const auto     ct  = repeat(buffer_t(cipher_texts[i], 16), 45);
+            context        enc{key, true}, dec{key, false};
+            for (const auto& k : kernels()) {
+                INFO(k.name << " of " << key.size() * 8 << "bit key");
+                REQUIRE(enc.crypt(k.fn, pt) == ct);
+                REQUIRE(dec.crypt(k.fn, ct) == pt);
+            }
+        }
+    }
+
+    SECTION("random keys and sizes") {
+        for (size_t key_size : {16, 24, 32}) {
+            const auto key = rnd.make(key_size);
+            for (bool encrypting : {true, false}) {
+                context c{key, encrypting};
+                for (size_t blocks : {1, 3, 4, 8, 15, 16, 17, 31, 32, 33, 75}) {
+                    const auto input    = rnd.make(blocks * 16);
+                    const auto expected = c.ecb(input);
+                    for (const auto& k : kernels()) {
+                        INFO(k.name << " of " << blocks << " blocks");
+                        REQUIRE(c.crypt(k.fn, input) == expected);
+
+                        auto in_place = input;
+                        k.fn(
+                            c.ctx_,
+                            to_const_ptr(in_place),
+                            to_ptr(in_place),
+                            blocks);
+                        REQUIRE(in_place == expected);
+                    }
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("camellia cipher modes", "[camellia][cipher]") {
+    rnd_generator rnd;
+    const auto    key   = rnd.make(32);
+    const auto    iv    = rnd.make(16);
+    const auto    input = rnd.make(16 * 300);
+
+    SECTION("ecb") {
+        const auto expected = context{key, true}.ecb(input);
+        const auto ct       = cipher::encrypt(
+            cipher_t::camellia_256_ecb, padding_t::none, "", key, input);
+        REQUIRE(ct == expected);
+
+        cipher c{cipher_t::camellia_256_ecb};
+        c.key(key, cipher::decrypt_mode).start();
+        REQUIRE(c.update(ct) == input);
+    }
+
+    SECTION("cbc") {
+        context  ref{key, true};
+        auto     ref_iv = iv;
+        buffer_t expected(input.size(), '\0');
+        mbedtls_camellia_crypt_cbc(
+            &ref.ctx_,
+            MBEDTLS_CAMELLIA_ENCRYPT,
+            input.size(),
+            to_ptr(ref_iv),
+            to_const_ptr(input),
+            to_ptr(expected));
+
+        // padding_t::none keeps the default padding of mbedtls
+        const auto ct = cipher::encrypt(
+            cipher_t::camellia_256_cbc, padding_t::none, iv, key, input);
+        REQUIRE(ct.substr(0, input.size()) == expected);
+        REQUIRE(
+            cipher::decrypt(
+                cipher_t::camellia_256_cbc, padding_t::none, iv, key, ct) ==
+            input);
+
+        // by odd chunks, padded
+        const auto padded = input.substr(0, 3001);
+        const auto pct    = cipher::encrypt(
+            cipher_t::camellia_256_cbc, padding_t::pkcs7, iv, key, padded);
+        cipher c{cipher_t::camellia_256_cbc};
+        c.padding(padding_t::pkcs7).iv(iv).key(key, cipher::decrypt_mode);
+        c.start();
+        buffer_t output;
+        for (size_t i = 0; i < pct.size(); i += 777)
+            output += c.update(pct.substr(i, 777));
+        output += c.finish();
+        REQUIRE(output == padded);
+    }
+
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    SECTION("ctr") {
+        const auto odd = input.substr(0, 4000 + 7);
+        context    ref{key, true};
+        auto       counter     = iv;
+        uint8_t    stream[16]  = {0};
+        size_t     offset      = 0;
+        buffer_t   expected(odd.size(), '\0');
+        mbedtls_camellia_crypt_ctr(
+            &ref.ctx_,
+            odd.size(),
+            &offset,
+            to_ptr(counter),
+            stream,
+            to_const_ptr(odd),
+            to_ptr(expected));
+
+        REQUIRE(
+            cipher::encrypt(
+                cipher_t::camellia_256_ctr, padding_t::none, iv, key, odd) ==
+            expected);
+
+        cipher c{cipher_t::camellia_256_ctr};
+        c.iv(iv).key(key, cipher::encrypt_mode);
+        c.start();
+        buffer_t output;
+        for (size_t i = 0, n = 1; i < odd.size(); i += n, n = n * 3 + 1)
+            output += c.update(odd.substr(i, n));
+        output += c.finish();
+        REQUIRE(output == expected);
+    }
+#endif // MBEDTLS_CIPHER_MODE_CTR
+
+#if defined(MBEDTLS_GCM_C)
+    SECTION("gcm") {
+        const auto odd = input.substr(0, 3333);
+
+        // the streaming cipher object stays on mbedtls gcm
+        cipher enc{cipher_t::camellia_256_gcm};
+        enc.iv(iv.substr(0, 12)).key(key, cipher::encrypt_mode);
+        enc.start();
+        enc.gcm_additional_data("header");
+        auto ct = enc.update(odd);
+        ct += enc.finish();
+        const auto tag = enc.gcm_encryption_tag(16);
+
+        auto aead = cipher::encrypt_aead(
+            cipher_t::camellia_256_gcm, iv.substr(0, 12), key, "header", odd);
+        REQUIRE(std::get<0>(aead) == tag);
+        REQUIRE(std::get<1>(aead) == ct);
+
+        auto dec = cipher::decrypt_aead(
+            cipher_t::camellia_256_gcm, iv.substr(0, 12), key, "header", aead);
+        REQUIRE(std::get<0>(dec));
+        REQUIRE(std::get<1>(dec) == odd);
+
+        ct[100] ^= 0x01;
+        dec = cipher::decrypt_aead(
+            cipher_t::camellia_256_gcm,
+            iv.substr(0, 12),
+            key,
+            "header",
+            tag,
+            ct);
+        REQUIRE_FALSE(std::get<0>(dec));
+    }
+#endif // MBEDTLS_GCM_C
+}
+
+TEST_CASE("camellia benchmark", "[.][bench][camellia]") {
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    constexpr size_t Size = 64 * 1024 * 1024;
+
+    rnd_generator rnd;
+    const auto    key  = rnd.make(16);
+    const auto    iv   = rnd.make(16);
+    const auto    data = rnd.make(Size);
+
+    auto mbps = [](clock_type::time_point start) {
+        return (Size >> 20) / seconds(clock_type::now() - start).count();
+    };
+
+    std::printf("camellia-128 of %zuMB\n", Size >> 20);
+    context c{key, true};
+    buffer_t output(Size, '\0');
+    for (const auto& k : kernels()) {
+        const auto start = clock_type::now();
+        k.fn(c.ctx_, to_const_ptr(data), to_ptr(output), Size / 16);
+        std::printf("  ecb %-8s       %8.1f MB/s\n", k.name, mbps(start));
+    }
+
+    const cipher_t types[][2] = {
+        {cipher_t::camellia_128_ctr, cipher_t::aes_128_ctr},
+        {cipher_t::camellia_128_cbc, cipher_t::aes_128_cbc},
+    };
+    for (const auto& pair : types) {
+        for (auto type : pair) {
+            if (!supports(type))
+                continue;
+            auto start = clock_type::now();
+            auto ct = cipher::encrypt(type, padding_t::none, iv, key, data);
+            const auto encrypt = mbps(start);
+            start              = clock_type::now();
+            auto pt = cipher::decrypt(type, padding_t::none, iv, key, ct);
+            REQUIRE(pt == data);
+            std::printf(
+                "  %-16s encrypt %8.1f MB/s, decrypt %8.1f MB/s\n",
+                to_string(type),
+                encrypt,
+                mbps(start));
+        }
+    }
+
+#if defined(MBEDTLS_GCM_C)
+    for (auto type : {cipher_t::camellia_128_gcm, cipher_t::aes_128_gcm}) {
+        const auto start = clock_type::now();
+        auto aead = cipher::encrypt_aead(type, iv.substr(0, 12), key, "", data);
+        REQUIRE(std::get<1>(aead).size() == Size);
+        std::printf(
+            "  %-16s encrypt %8.1f MB/s\n", to_string(type), mbps(start));
+    }
+#endif // MBEDTLS_GCM_C
+}
+
+#endif // MBEDTLS_CAMELLIA_C
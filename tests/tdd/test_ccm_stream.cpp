@@ -0,0 +1,211 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/ccm_stream.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+
+#if defined(MBEDTLS_CCM_C)
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+/// feeds the input by chunks of growing sizes
+buffer_t
+chunked(ccm_stream& ccm, const buffer_t& input) {
+    buffer_t output;
+    size_t   offset = 0;
+    for (size_t n = 0; offset < input.size(); n = (n + 7) % 53) {
+        auto chunk = std::min(n, input.size() - offset);
+        output +=
+            ccm.update(buffer_view_t{to_const_ptr(input) + offset, chunk});
+        offset += chunk;
+    }
+    return output;
+}
+
+std::vector<cipher_t>
+ccm_types() {
+    std::vector<cipher_t> types{
+        cipher_t::aes_128_ccm, cipher_t::aes_192_ccm, cipher_t::aes_256_ccm};
+    if (supports(cipher_t::camellia_128_ccm)) {
+        types.push_back(cipher_t::camellia_128_ccm);
+        types.push_back(cipher_t::camellia_256_ccm);
+    }
+    return types;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("ccm streaming", "[ccm][cipher]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+
+    SECTION("compatibility with cipher") {
+        for (auto type : ccm_types()) {
+            const auto key = rnd.make(cipher::key_bitlen(type) / 8);
+
+            ccm_stream enc{type};
+            ccm_stream dec{type};
+            enc.key(key);
+            dec.key(key);
+
+            for (size_t size : {0, 1, 15, 16, 17, 255, 1000}) {
+                for (size_t iv_size : {7, 12, 13}) {
+                    auto iv   = rnd.make(iv_size);
+                    auto ad   = rnd.make(size % 41);
+                    auto data = rnd.make(size);
+
+                    auto ref = cipher::encrypt_aead(type, iv, key, ad, data);
+
+                    enc.start(cipher::encrypt_mode, iv, ad, data.size());
+                    REQUIRE(enc.remaining() == data.size());
+                    auto ct  = chunked(enc, data);
+                    auto tag = enc.finish();
+                    REQUIRE(tag == std::get<0>(ref));
+                    REQUIRE(ct == std::get<1>(ref));
+
+                    dec.start(cipher::decrypt_mode, iv, ad, ct.size());
+                    auto pt = chunked(dec, ct);
+                    REQUIRE(dec.finish(tag));
+                    REQUIRE(pt == data);
+                }
+            }
+        }
+    }
+
+    SECTION("tag lengths and in place") {
+        ccm_stream ccm{cipher_t::aes_256_ccm};
+        ccm.key(rnd.make(32));
+
+        const auto iv   = rnd.make(11);
+        const auto data = rnd.make(300);
+        for (size_t tag_length = 4; tag_length <= 16; tag_length += 2) {
+            ccm.start(cipher::encrypt_mode, iv, "ad", data.size(), tag_length);
+            auto buffer = data;
+            ccm.update(buffer, to_ptr(buffer)); // in place
+            auto tag = ccm.finish();
+            REQUIRE(tag.size() == tag_length);
+            REQUIRE(buffer != data);
+
+            ccm.start(cipher::decrypt_mode, iv, "ad", data.size(), tag_length);
+            ccm.update(buffer, to_ptr(buffer));
+            REQUIRE(ccm.finish(tag));
+            REQUIRE(buffer == data);
+        }
+    }
+
+    SECTION("large additional data") {
+        ccm_stream ccm{cipher_t::aes_128_ccm};
+        ccm.key(rnd.make(16));
+
+        const auto iv = rnd.make(13);
+        const auto ad = rnd.make(70000); // the 0xfffe size encoding
+        ccm.start(cipher::encrypt_mode, iv, ad, 5);
+        auto ct  = ccm.update("hello");
+        auto tag = ccm.finish();
+
+        ccm.start(cipher::decrypt_mode, iv, ad, 5);
+        REQUIRE(ccm.update(ct) == "hello");
+        REQUIRE(ccm.finish(tag));
+    }
+
+    SECTION("authentication") {
+        ccm_stream ccm{cipher_t::aes_128_ccm};
+        ccm.key(rnd.make(16));
+
+        const auto iv = rnd.make(12);
+        ccm.start(cipher::encrypt_mode, iv, "header", 11);
+        auto ct  = ccm.update("some secret");
+        auto tag = ccm.finish();
+
+        auto bad = tag;
+        bad[3] ^= 0x01;
+        ccm.start(cipher::decrypt_mode, iv, "header", ct.size());
+        ccm.update(ct);
+        REQUIRE_FALSE(ccm.finish(bad));
+
+        ccm.start(cipher::decrypt_mode, iv, "headers", ct.size());
+        ccm.update(ct);
+        REQUIRE_FALSE(ccm.finish(tag));
+
+        ct[0] ^= 0x01;
+        ccm.start(cipher::decrypt_mode, iv, "header", ct.size());
+        ccm.update(ct);
+        REQUIRE_FALSE(ccm.finish(tag));
+    }
+
+    SECTION("invalid usage") {
+        REQUIRE_THROWS(ccm_stream{cipher_t::aes_128_gcm});
+
+        ccm_stream ccm{cipher_t::aes_128_ccm};
+        REQUIRE_THROWS(ccm.start(cipher::encrypt_mode, rnd.make(12), "", 1));
+        REQUIRE_THROWS(ccm.update("not started"));
+
+        ccm.key(rnd.make(16));
+        REQUIRE_THROWS(ccm.start(cipher::encrypt_mode, rnd.make(6), "", 1));
+        REQUIRE_THROWS(ccm.start(cipher::encrypt_mode, rnd.make(14), "", 1));
+        REQUIRE_THROWS(ccm.start(cipher::encrypt_mode, rnd.make(12), "", 1, 5));
+        // a 2 bytes length field
+        REQUIRE_THROWS(
+            ccm.start(cipher::encrypt_mode, rnd.make(13), "", 65536));
+
+        ccm.start(cipher::encrypt_mode, rnd.make(12), "", 4);
+        REQUIRE_THROWS(ccm.update("too long"));
+        ccm.update("abc");
+        REQUIRE(ccm.remaining() == 1);
+        REQUIRE_THROWS(ccm.finish()); // too short
+        REQUIRE_THROWS(ccm.finish(rnd.make(16)));
+    }
+}
+
+TEST_CASE("ccm streaming benchmark", "[.][bench][ccm]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t ImageSize = 16 * 1024 * 1024;
+    constexpr size_t ChunkSize = 64 * 1024;
+
+    rnd_generator rnd;
+    const auto    key   = rnd.make(16);
+    const auto    iv    = rnd.make(12);
+    const auto    image = rnd.make(ImageSize);
+
+    auto seconds = [](clock_type::time_point start) {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    };
+
+    auto start = clock_type::now();
+    auto ref = cipher::encrypt_aead(cipher_t::aes_128_ccm, iv, key, "", image);
+    const double one_shot = seconds(start);
+
+    ccm_stream ccm{cipher_t::aes_128_ccm};
+    ccm.key(key);
+    buffer_t chunk(ChunkSize, '\0');
+
+    start = clock_type::now();
+    ccm.start(cipher::encrypt_mode, iv, "", image.size());
+    for (size_t offset = 0; offset < image.size(); offset += ChunkSize) {
+        ccm.update(
+            buffer_view_t{to_const_ptr(image) + offset, ChunkSize},
+            to_ptr(chunk));
+    }
+    auto         tag    = ccm.finish();
+    const double stream = seconds(start);
+    REQUIRE(tag == std::get<0>(ref));
+
+    std::printf(
+        "ccm %zuMB: one shot %.1f MB/s (holds %zuMB), streaming %.1f MB/s "
+        "(holds %zuKB)\n",
+        ImageSize >> 20,
+        (ImageSize >> 20) / one_shot,
+        2 * (ImageSize >> 20),
+        (ImageSize >> 20) / stream,
+        ChunkSize >> 10);
+}
+///////////////////////////////////////////////////////////////////////////////
+#endif // MBEDTLS_CCM_C
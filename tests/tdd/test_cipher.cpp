@@ -8,6 +8,9 @@
 
 #include "mbedtls/cipher.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <iostream>
 ///////////////////////////////////////////////////////////////////////////////
 namespace {
@@ -350,4 +353,86 @@ TEST_CASE("test ciphers against mbedtls", "[cipher]") {
 }
 
 
+TEST_CASE("ctr random access", "[cipher]") {
+    using namespace mbedcrypto;
+    if (!supports(cipher_bm::ctr))
+        return;
+
+    rnd_generator drbg;
+    // an iv near the overflow of the lower bytes, to check the carry
+    auto iv = drbg.make(16);
+    for (size_t i = 8; i < 16; ++i)
+        iv[i] = static_cast<char>(0xff);
+    const auto key   = drbg.make(32);
+    const auto input = drbg.make(10000);
+    const auto encr  = cipher::encrypt(
+        cipher_t::aes_256_ctr, padding_t::none, iv, key, input);
+
+    cipher dec{cipher_t::aes_256_ctr};
+    dec.iv(iv).key(key, cipher::decrypt_mode);
+
+    for (size_t offset : {0, 1, 15, 16, 17, 4095, 9999}) {
+        const size_t size = std::min(size_t{1000}, input.size() - offset);
+        dec.ctr_seek(offset);
+        const auto* piece = to_const_ptr(encr) + offset;
+        auto        decr  = dec.update(buffer_view_t{piece, size});
+        REQUIRE(decr == input.substr(offset, size));
+    }
+
+    // scattered and overlapping ranges
+    std::vector<cipher::ctr_range> ranges;
+    buffer_t                       expected;
+    for (size_t offset : {5000, 33, 33, 9000, 7}) {
+        const auto* piece = to_const_ptr(encr) + offset;
+        ranges.push_back({offset, buffer_view_t{piece, 500}});
+        expected += input.substr(offset, 500);
+    }
+    REQUIRE(dec.ctr_crypt(ranges) == expected);
+    REQUIRE(dec.ctr_crypt(9500, encr.substr(9500)) == input.substr(9500));
+
+    // start() goes back to the beginning
+    dec.start();
+    REQUIRE(dec.update(encr) == input);
+
+    cipher cbc{cipher_t::aes_256_cbc};
+    cbc.iv(iv).key(key, cipher::decrypt_mode);
+    REQUIRE_THROWS(cbc.ctr_seek(16));
+}
+
+TEST_CASE("ctr random access benchmark", "[.][bench][cipher]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    if (!supports(cipher_bm::ctr))
+        return;
+
+    rnd_generator drbg;
+    const auto    iv   = drbg.make(16);
+    const auto    key  = drbg.make(16);
+    const auto    file = drbg.make(64 * 1024 * 1024);
+    const size_t  Size = 4096; // a ranged read at the end of the file
+
+    cipher dec{cipher_t::aes_128_ctr};
+    dec.iv(iv).key(key, cipher::decrypt_mode);
+
+    auto start = clock_type::now();
+    dec.start();
+    dec.update(buffer_view_t{to_const_ptr(file), file.size() - Size});
+    auto tail = dec.update(
+        buffer_view_t{to_const_ptr(file) + file.size() - Size, Size});
+    const auto from_start = clock_type::now() - start;
+
+    start     = clock_type::now();
+    auto seek = dec.ctr_crypt(
+        file.size() - Size,
+        buffer_view_t{to_const_ptr(file) + file.size() - Size, Size});
+    const auto by_seek = clock_type::now() - start;
+    REQUIRE(seek == tail);
+
+    using us = std::chrono::duration<double, std::micro>;
+    std::printf(
+        "ctr: last 4KB of 64MB, from the start %10.1f us, by seek %6.1f us\n",
+        us(from_start).count(),
+        us(by_seek).count());
+}
+
 ///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/ctr_keystream.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("ctr precomputed keystream", "[cipher]") {
+    using namespace mbedcrypto;
+    if (!supports(cipher_bm::ctr))
+        return;
+
+    rnd_generator rnd;
+    const auto    key   = rnd.make(16);
+    const auto    iv    = rnd.make(16);
+    const auto    input = rnd.make(300 * 1024 + 3);
+    const auto    expected =
+        cipher::encrypt(cipher_t::aes_128_ctr, padding_t::none, iv, key, input);
+
+    // messages of random sizes, crossing the ring boundaries
+    auto by_messages = [&](ctr_keystream& ks, bool refill) {
+        buffer_t output;
+        for (size_t i = 0; i < input.size();) {
+            const auto   r    = static_cast<uint8_t>(rnd.make(1)[0]);
+            const size_t size = std::min(input.size() - i, size_t{1} + r * 7);
+            output += ks.update(input.substr(i, size));
+            i += size;
+            if (refill && i % 3 == 0)
+                ks.refill();
+        }
+        return output;
+    };
+
+    SECTION("by idle refills") {
+        ctr_keystream ks{cipher_t::aes_128_ctr, 8192, false};
+        ks.key(key).start(iv);
+        REQUIRE(ks.available() == 0);
+        REQUIRE(ks.refill() == ks.ring_size());
+        REQUIRE(ks.available() == ks.ring_size());
+        REQUIRE(ks.refill() == 0); // full
+
+        REQUIRE(by_messages(ks, true) == expected);
+        REQUIRE(ks.ring_bytes() > 0);
+        REQUIRE(ks.ring_bytes() + ks.inline_bytes() == input.size());
+    }
+
+    SECTION("inline fallback") {
+        ctr_keystream ks{cipher_t::aes_128_ctr, 4096, false};
+        ks.key(key).start(iv);
+        REQUIRE(by_messages(ks, false) == expected);
+        REQUIRE(ks.ring_bytes() == 0);
+        REQUIRE(ks.inline_bytes() == input.size());
+    }
+
+    SECTION("background refills") {
+        ctr_keystream ks{cipher_t::aes_128_ctr};
+        ks.key(key).start(iv);
+        REQUIRE(by_messages(ks, false) == expected);
+
+        // restarts the same stream, after the ring is warmed up
+        ks.start(iv);
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        REQUIRE(ks.update(input) == expected);
+        // in place
+        auto data = input;
+        ks.start(iv).update(data, to_ptr(data));
+        REQUIRE(data == expected);
+    }
+
+    SECTION("usage errors") {
+        REQUIRE_THROWS(ctr_keystream{cipher_t::aes_128_cbc});
+        ctr_keystream ks{cipher_t::aes_128_ctr};
+        REQUIRE_THROWS(ks.start(iv)); // no key
+        ks.key(key);
+        REQUIRE_THROWS(ks.update(input)); // not started
+        REQUIRE_THROWS(ks.start(iv.substr(0, 8)));
+    }
+}
+
+TEST_CASE("ctr precomputed keystream benchmark", "[.][bench][cipher]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    if (!supports(cipher_bm::ctr))
+        return;
+
+    constexpr size_t Messages = 20000;
+    constexpr size_t Size     = 256;
+
+    rnd_generator rnd;
+    const auto    key     = rnd.make(16);
+    const auto    iv      = rnd.make(16);
+    const auto    message = rnd.make(Size);
+    buffer_t      output(Size, '\0');
+
+    // only the encryption of each message is timed, the refills happen
+    // between the messages, as on an idle feed
+    using ns = std::chrono::duration<double, std::nano>;
+    auto report = [](const char* name, clock_type::duration total) {
+        std::printf(
+            "  %-22s %8.1f ns/message\n",
+            name,
+            ns(total).count() / Messages);
+    };
+
+    std::printf("ctr keystream: %zu messages of %zu bytes\n", Messages, Size);
+
+    cipher aes{cipher_t::aes_128_ctr};
+    aes.iv(iv).key(key, cipher::encrypt_mode);
+    aes.start();
+    clock_type::duration total{};
+    for (size_t i = 0; i < Messages; ++i) {
+        auto   start = clock_type::now();
+        size_t osize = Size;
+        aes.update(message, to_ptr(output), osize);
+        total += clock_type::now() - start;
+    }
+    report("cipher::update", total);
+
+    ctr_keystream idle{cipher_t::aes_128_ctr, 64 * 1024, false};
+    idle.key(key).start(iv);
+    total = clock_type::duration{};
+    for (size_t i = 0; i < Messages; ++i) {
+        idle.refill();
+        auto start = clock_type::now();
+        idle.update(message, to_ptr(output));
+        total += clock_type::now() - start;
+    }
+    report("keystream, idle refill", total);
+
+    ctr_keystream bg{cipher_t::aes_128_ctr};
+    bg.key(key).start(iv);
+    total = clock_type::duration{};
+    for (size_t i = 0; i < Messages; ++i) {
+        if (i % 64 == 0) // gives the background some idle time
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        auto start = clock_type::now();
+        bg.update(message, to_ptr(output));
+        total += clock_type::now() - start;
+    }
+    report("keystream, background", total);
+    std::printf(
+        "  background: %llu bytes by the ring, %llu inline\n",
+        static_cast<unsigned long long>(bg.ring_bytes()),
+        static_cast<unsigned long long>(bg.inline_bytes()));
+}
@@ -0,0 +1,239 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/dhm.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+
+#if defined(MBEDTLS_DHM_C)
+#include <mbedtls/dhm.h>
+
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+const dh_group_t AllGroups[] = {
+    dh_group_t::ffdhe2048,
+    dh_group_t::ffdhe3072,
+    dh_group_t::ffdhe4096,
+    dh_group_t::ffdhe6144,
+    dh_group_t::ffdhe8192,
+};
+
+/// the plain mbedtls implementation, as the reference
+struct mbedtls_dhm {
+    mbedtls_dhm_context ctx_;
+    rnd_generator       rnd_;
+
+    explicit mbedtls_dhm(const buffer_t& server_key_exchange) {
+        mbedtls_dhm_init(&ctx_);
+        auto* p = reinterpret_cast<unsigned char*>(
+            const_cast<char*>(server_key_exchange.data()));
+        mbedcrypto_c_call(
+            mbedtls_dhm_read_params, &ctx_, &p, p + server_key_exchange.size());
+    }
+
+    ~mbedtls_dhm() {
+        mbedtls_dhm_free(&ctx_);
+    }
+
+    buffer_t make_public() {
+        buffer_t pub(ctx_.len, '\0');
+        mbedcrypto_c_call(
+            mbedtls_dhm_make_public,
+            &ctx_,
+            static_cast<int>(ctx_.len),
+            to_ptr(pub),
+            pub.size(),
+            rnd_generator::maker,
+            &rnd_);
+        return pub;
+    }
+
+    buffer_t calc_secret() {
+        buffer_t secret(ctx_.len, '\0');
+        size_t   olen = 0;
+        mbedcrypto_c_call(
+            mbedtls_dhm_calc_secret,
+            &ctx_,
+            to_ptr(secret),
+            secret.size(),
+            &olen,
+            rnd_generator::maker,
+            &rnd_);
+        secret.resize(olen);
+        return secret;
+    }
+}; // struct mbedtls_dhm
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("dhm (ffdhe) key exchange", "[dhm]") {
+    using namespace mbedcrypto;
+
+    REQUIRE(supports_dhm());
+
+    SECTION("rfc 7919 groups") {
+        for (auto g : AllGroups) {
+            for (bool short_exponent : {false, true}) {
+                dhm server{short_exponent};
+                dhm client;
+
+                auto srv_pub = server.make_peer_key(g);
+                auto cli_pub = client.make_peer_key(g);
+                REQUIRE(server.group() == g);
+                REQUIRE(srv_pub.size() == server.key_length());
+                REQUIRE(srv_pub == server.peer_key());
+                REQUIRE(srv_pub != cli_pub);
+
+                auto sss = server.shared_secret(cli_pub);
+                auto css = client.shared_secret(srv_pub);
+                REQUIRE(sss == css);
+                REQUIRE(sss.size() <= server.key_length());
+            }
+        }
+
+        dhm ffdhe2048{true};
+        ffdhe2048.make_peer_key(dh_group_t::ffdhe2048);
+        REQUIRE(ffdhe2048.key_length() == 256);
+        REQUIRE(ffdhe2048.exponent_bitlen() == 225);
+
+        dhm full;
+        full.make_peer_key(dh_group_t::ffdhe3072);
+        REQUIRE(full.key_length() == 384);
+        REQUIRE(full.exponent_bitlen() == 3071);
+    }
+
+    SECTION("server key exchange") {
+        dhm  server;
+        auto skex = server.make_server_key_exchange(dh_group_t::ffdhe3072);
+
+        dhm  client{true};
+        auto cli_pub = client.make_client_peer_key(skex);
+        REQUIRE(client.group() == dh_group_t::ffdhe3072);
+        REQUIRE(client.exponent_bitlen() == 275);
+
+        auto css = client.shared_secret();
+        auto sss = server.shared_secret(cli_pub);
+        REQUIRE(sss == css);
+    }
+
+    SECTION("compatibility with mbedtls") {
+        for (auto g : {dh_group_t::ffdhe2048, dh_group_t::ffdhe4096}) {
+            dhm  server{true};
+            auto skex = server.make_server_key_exchange(g);
+
+            // the public key made by the precomputed table is verified by
+            // the peer's secret
+            mbedtls_dhm client{skex};
+            auto        cli_pub = client.make_public();
+            auto        css     = client.calc_secret();
+
+            REQUIRE(server.shared_secret(cli_pub) == css);
+            // blinding is used on the second use of a key
+            REQUIRE(server.shared_secret(cli_pub) == css);
+        }
+    }
+
+    SECTION("invalid inputs") {
+        dhm server;
+        REQUIRE_THROWS(server.peer_key());
+        REQUIRE_THROWS(server.make_peer_key(dh_group_t::none));
+
+        server.make_peer_key(dh_group_t::ffdhe2048);
+        const uint8_t One[] = {1};
+        REQUIRE_THROWS(server.shared_secret(buffer_view_t{One, 1}));
+        REQUIRE_THROWS(server.shared_secret(buffer_t(257, '\x01')));
+
+        // p - 1
+        auto pminus1 = server.make_server_key_exchange(dh_group_t::ffdhe2048)
+                           .substr(2, 256);
+        pminus1.back() = static_cast<char>(pminus1.back() - 1);
+        REQUIRE_THROWS(server.shared_secret(pminus1));
+
+        dhm client;
+        REQUIRE_THROWS(client.make_client_peer_key("not a valid params"));
+    }
+
+    SECTION("custom groups") {
+        dhm  server;
+        auto skex = server.make_server_key_exchange(dh_group_t::ffdhe2048);
+        // the prime is the 1st value, after its 2 bytes length: p - 2
+        skex[2 + 255] = static_cast<char>(skex[2 + 255] - 2);
+
+        // a full size exponent, even if the short one is requested
+        for (bool short_exponent : {false, true}) {
+            dhm client{short_exponent};
+            client.make_client_peer_key(skex);
+            REQUIRE(client.group() == dh_group_t::none);
+            REQUIRE(client.key_length() == 256);
+            REQUIRE(client.exponent_bitlen() == 2047);
+        }
+
+        // larger than the largest rfc 7919 group
+        dhm           client;
+        rnd_generator rnd;
+        auto          p = rnd.make(8192 / 8);
+        p.front() |= '\x80';
+        p.back() |= '\x01';
+        const auto skex_of = [](const buffer_t& prime) {
+            const buffer_t two{"\x00\x01\x02", 3};
+            const auto     len = prime.size();
+            return buffer_t{static_cast<char>(len >> 8)} +
+                   static_cast<char>(len & 0xff) + prime + two + two;
+        };
+        REQUIRE_THROWS(client.make_client_peer_key(skex_of('\x01' + p)));
+        REQUIRE_NOTHROW(client.make_client_peer_key(skex_of(p)));
+        REQUIRE(client.exponent_bitlen() == 8191);
+    }
+}
+
+TEST_CASE("dhm benchmark", "[.][bench][dhm]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t Count = 64;
+
+    auto seconds = [](clock_type::time_point start) {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    };
+
+    for (auto g : {dh_group_t::ffdhe2048, dh_group_t::ffdhe3072}) {
+        dhm  params;
+        auto skex = params.make_server_key_exchange(g);
+
+        // plain mbedtls: ephemeral key and the shared secret
+        auto start = clock_type::now();
+        for (size_t i = 0; i < Count; ++i) {
+            mbedtls_dhm ref{skex};
+            ref.make_public();
+            ref.calc_secret();
+        }
+        double plain = seconds(start);
+
+        for (bool short_exponent : {false, true}) {
+            dhm client{short_exponent};
+            client.make_client_peer_key(skex); // warms up the table
+
+            start = clock_type::now();
+            for (size_t i = 0; i < Count; ++i) {
+                client.make_client_peer_key(skex);
+                client.shared_secret();
+            }
+            double fixed = seconds(start);
+
+            std::printf(
+                "ffdhe%zu %s exponent: mbedtls %.0f, fixed-base %.0f "
+                "handshakes/sec\n",
+                params.key_length() * 8,
+                short_exponent ? "short" : "full",
+                Count / plain,
+                Count / fixed);
+        }
+    }
+}
+///////////////////////////////////////////////////////////////////////////////
+#endif // MBEDTLS_DHM_C
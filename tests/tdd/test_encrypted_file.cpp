@@ -0,0 +1,260 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/encrypted_file.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "generator.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+const char FilePath[] = "./encrypted_file.bin";
+
+/// the aead and the ctr layouts, by the supported modes
+std::vector<cipher_t>
+layouts() {
+    std::vector<cipher_t> types;
+    if (supports(cipher_bm::gcm))
+        types.push_back(cipher_t::aes_128_gcm);
+    if (supports(cipher_bm::ccm))
+        types.push_back(cipher_t::aes_128_ccm);
+    if (supports(cipher_bm::ctr))
+        types.push_back(cipher_t::aes_128_ctr);
+    return types;
+}
+
+buffer_t
+make_iv(rnd_generator& rnd, cipher_t type) {
+    return rnd.make(cipher::block_mode(type) == cipher_bm::ctr ? 16 : 12);
+}
+
+struct file_guard {
+    ~file_guard() {
+        std::remove(FilePath);
+    }
+}; // struct file_guard
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("random access encrypted file", "[cipher]") {
+    using namespace mbedcrypto;
+
+    file_guard    guard;
+    rnd_generator rnd;
+    const auto    key   = rnd.make(16);
+    const auto    plain = rnd.make(200 * 1024 + 13);
+
+    encrypted_file::options opts;
+    opts.page_size   = 4096;
+    opts.cache_pages = 16;
+
+    for (auto type : layouts()) {
+        const auto iv = make_iv(rnd, type);
+        test::dump_to_file(
+            encrypted_file::encrypt(type, key, iv, "", opts.page_size),
+            FilePath);
+        REQUIRE(encrypted_file{FilePath, type, key, iv, opts}.size() == 0);
+
+        test::dump_to_file(
+            encrypted_file::encrypt(type, key, iv, plain, opts.page_size),
+            FilePath);
+        encrypted_file ef{FilePath, type, key, iv, opts};
+        REQUIRE(ef.size() == plain.size());
+        REQUIRE(ef.page_size() == opts.page_size);
+
+        // crossing the pages, and the end of file
+        REQUIRE(ef.read(4000, 200) == plain.substr(4000, 200));
+        REQUIRE(ef.read(0, plain.size()) == plain);
+        const auto tail = plain.size() - 5;
+        REQUIRE(ef.read(tail, 100) == plain.substr(tail));
+        REQUIRE(ef.read(plain.size(), 10).empty());
+
+        // concurrent readers of a shared cache
+        std::atomic<size_t>      mismatches{0};
+        std::vector<std::thread> readers;
+        for (size_t t = 0; t < 4; ++t) {
+            readers.emplace_back([&, t]() {
+                for (size_t i = 0; i < 500; ++i) {
+                    const size_t offset =
+                        (i * 7919 + t * 104729) % plain.size();
+                    const size_t length = (i * 31) % 9000;
+                    if (ef.read(offset, length) != plain.substr(offset, length))
+                        ++mismatches;
+                }
+            });
+        }
+        for (auto& r : readers)
+            r.join();
+        REQUIRE(mismatches == 0);
+
+        // a sequential scan decrypts ahead
+        ef.clear_cache();
+        buffer_t scan;
+        for (size_t offset = 0; offset < plain.size(); offset += 1000)
+            scan += ef.read(offset, 1000);
+        REQUIRE(scan == plain);
+        const auto st = ef.stats();
+        REQUIRE(st.hits > 0);
+        REQUIRE(st.evictions > 0);
+    }
+}
+
+TEST_CASE("encrypted file authentication", "[cipher]") {
+    using namespace mbedcrypto;
+    if (!supports(cipher_bm::gcm))
+        return;
+
+    file_guard     guard;
+    rnd_generator  rnd;
+    const auto     key   = rnd.make(16);
+    const auto     iv    = rnd.make(12);
+    const auto     plain = rnd.make(10000);
+    const cipher_t type  = cipher_t::aes_128_gcm;
+
+    encrypted_file::options opts;
+    opts.page_size = 4096;
+    auto sealed = encrypted_file::encrypt(type, key, iv, plain, 4096);
+    REQUIRE(sealed.size() == plain.size() + 3 * encrypted_file::tag_size);
+
+    SECTION("modified page") {
+        sealed[4096 + 16 + 10] ^= 0x01; // the 2nd page
+        test::dump_to_file(sealed, FilePath);
+        encrypted_file ef{FilePath, type, key, iv, opts};
+        REQUIRE(ef.read(0, 100) == plain.substr(0, 100));
+        REQUIRE_THROWS(ef.read(5000, 10));
+        REQUIRE_THROWS(ef.read(5000, 10)); // not cached
+    }
+
+    SECTION("truncated file") {
+        sealed.resize(sealed.size() - (plain.size() - 8192) - 16);
+        test::dump_to_file(sealed, FilePath);
+        encrypted_file ef{FilePath, type, key, iv, opts};
+        REQUIRE(ef.size() == 8192);
+        REQUIRE_THROWS(ef.read(0, 10)); // the plain size is authenticated
+
+        sealed.resize(4096 + 16 + 10); // shorter than a tag
+        test::dump_to_file(sealed, FilePath);
+        REQUIRE_THROWS(encrypted_file{FilePath, type, key, iv, opts});
+
+        sealed.clear();
+        test::dump_to_file(sealed, FilePath);
+        REQUIRE_THROWS(encrypted_file{FilePath, type, key, iv, opts});
+    }
+
+    SECTION("empty plain text") {
+        auto empty = encrypted_file::encrypt(type, key, iv, "", 4096);
+        REQUIRE(empty.size() == encrypted_file::tag_size);
+        test::dump_to_file(empty, FilePath);
+        encrypted_file ef{FilePath, type, key, iv, opts};
+        REQUIRE(ef.size() == 0);
+        REQUIRE(ef.read(0, 10).empty());
+
+        // authenticated by the constructor
+        REQUIRE_THROWS(encrypted_file{FilePath, type, rnd.make(16), iv, opts});
+        empty[3] ^= 0x01;
+        test::dump_to_file(empty, FilePath);
+        REQUIRE_THROWS(encrypted_file{FilePath, type, key, iv, opts});
+    }
+
+    SECTION("usage errors") {
+        test::dump_to_file(sealed, FilePath);
+        REQUIRE_THROWS(encrypted_file{FilePath, type, key, rnd.make(16), opts});
+        REQUIRE_THROWS(
+            encrypted_file{FilePath, cipher_t::aes_128_cbc, key, iv, opts});
+        REQUIRE_THROWS(encrypted_file{"./no_such_file", type, key, iv, opts});
+    }
+}
+
+TEST_CASE("encrypted file benchmark", "[.][bench][cipher]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    if (layouts().empty())
+        return;
+
+    constexpr size_t Size  = 64 * 1024 * 1024;
+    constexpr size_t Reads = 20000;
+    constexpr size_t Chunk = 4096;
+
+    file_guard    guard;
+    rnd_generator rnd;
+    const auto    key   = rnd.make(16);
+    const auto    plain = rnd.make(Size);
+    buffer_t      output(Chunk, '\0');
+
+    // the wall time gives the IOPS, the process cpu time per decrypted GB
+    auto report = [](const char* name,
+                     size_t      reads,
+                     uint64_t    bytes,
+                     clock_type::duration wall,
+                     std::clock_t         cpu) {
+        using seconds     = std::chrono::duration<double>;
+        const double secs = seconds(wall).count();
+        const double cpus = double(cpu) / CLOCKS_PER_SEC;
+        std::printf(
+            "  %-28s %10.0f IOPS  %6.2f cpu-s/GB\n",
+            name,
+            reads / secs,
+            cpus / (double(bytes) / (1 << 30)));
+    };
+
+    std::printf(
+        "encrypted file: %zu MB, reads of %zu bytes\n", Size >> 20, Chunk);
+    for (auto type : layouts()) {
+        const auto iv = make_iv(rnd, type);
+        test::dump_to_file(
+            encrypted_file::encrypt(type, key, iv, plain), FilePath);
+        std::printf(" %s\n", to_string(type));
+
+        encrypted_file ef{FilePath, type, key, iv};
+
+        // cold random reads, each decrypts a page
+        ef.clear_cache();
+        auto wall = clock_type::now();
+        auto cpu  = std::clock();
+        for (size_t i = 0; i < Reads / 10; ++i) {
+            const uint64_t offset = (i * 2654435761u) % (Size - Chunk);
+            ef.read(offset, to_ptr(output), Chunk);
+        }
+        report(
+            "random, cold",
+            Reads / 10,
+            uint64_t{Reads / 10} * ef.page_size(),
+            clock_type::now() - wall,
+            std::clock() - cpu);
+
+        // random reads of a working set in the cache
+        wall = clock_type::now();
+        cpu  = std::clock();
+        for (size_t i = 0; i < Reads; ++i) {
+            const uint64_t offset = (i * 2654435761u) % (8 * 1024 * 1024);
+            ef.read(offset, to_ptr(output), Chunk);
+        }
+        report(
+            "random, cached working set",
+            Reads,
+            uint64_t{Reads} * Chunk,
+            clock_type::now() - wall,
+            std::clock() - cpu);
+
+        // a sequential scan, by the read-ahead
+        ef.clear_cache();
+        wall = clock_type::now();
+        cpu  = std::clock();
+        for (uint64_t offset = 0; offset < Size; offset += Chunk)
+            ef.read(offset, to_ptr(output), Chunk);
+        report(
+            "sequential",
+            Size / Chunk,
+            Size,
+            clock_type::now() - wall,
+            std::clock() - cpu);
+    }
+}
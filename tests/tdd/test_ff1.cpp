@@ -0,0 +1,212 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/ff1.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/tcodec.hpp"
+
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+// the samples of NIST SP 800-38G (FF1)
+const char KeyPrefix[] = "2b7e151628aed2a6abf7158809cf4f3c";
+const char Key192[]    = "ef4359d8d580aa4f";
+const char Key256[]    = "ef4359d8d580aa4f7f036d6f04fc6a94";
+const char Tweak10[]   = "39383736353433323130";
+const char Tweak36[]   = "3737373770717273373737";
+
+struct sample_t {
+    const char* key_tail;
+    const char* decimal;       ///< of "0123456789" without a tweak
+    const char* decimal_tweak; ///< of "0123456789" by Tweak10
+    const char* alnum;         ///< of "0123456789abcdefghi" by Tweak36
+};
+
+const sample_t Samples[] = {
+    {"", "2433477484", "6124200773", "a9tv40mll9kdu509eum"},
+    {Key192, "2830668132", "2496655549", "xbj3kv35jrawxv32ysr"},
+    {Key256, "6657667009", "1001623463", "xs8a0azh2avyalyzuwd"},
+};
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("ff1 samples", "[ff1]") {
+    using namespace mbedcrypto;
+
+    for (const auto& s : Samples) {
+        const auto key = from_hex(buffer_t{KeyPrefix} + s.key_tail);
+        const auto t10 = from_hex(Tweak10);
+        const auto t36 = from_hex(Tweak36);
+
+        ff1 decimal{10};
+        ff1 alnum{36};
+        decimal.key(key);
+        alnum.key(key);
+
+        REQUIRE(decimal.encrypt("0123456789") == s.decimal);
+        REQUIRE(decimal.encrypt("0123456789", t10) == s.decimal_tweak);
+        REQUIRE(alnum.encrypt("0123456789abcdefghi", t36) == s.alnum);
+
+        REQUIRE(decimal.decrypt(s.decimal) == "0123456789");
+        REQUIRE(decimal.decrypt(s.decimal_tweak, t10) == "0123456789");
+        REQUIRE(alnum.decrypt(s.alnum, t36) == "0123456789abcdefghi");
+    }
+}
+
+TEST_CASE("ff1 round trip", "[ff1]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+    for (size_t radix : {2, 3, 10, 26, 36, 256, 1000, 65535, 65536}) {
+        ff1 fpe{radix};
+        fpe.key(rnd.make(32));
+        REQUIRE(fpe.radix() == radix);
+        REQUIRE(fpe.min_length() >= 2);
+
+        for (size_t i = 0; i < 50; ++i) {
+            const auto len = fpe.min_length() +
+                             i * (fpe.max_length() - fpe.min_length()) / 49;
+            const auto random = rnd.make(len * 2);
+            const auto tweak  = rnd.make(i % 21);
+
+            std::vector<uint16_t> digits(len);
+            for (size_t j = 0; j < len; ++j)
+                digits[j] = static_cast<uint16_t>(
+                    (uint8_t(random[2 * j]) << 8 | uint8_t(random[2 * j + 1])) %
+                    radix);
+            auto token = digits;
+            fpe.encrypt(token.data(), len, tweak);
+            for (auto d : token)
+                REQUIRE(d < radix);
+            if (len > 8)
+                REQUIRE(token != digits);
+            fpe.decrypt(token.data(), len, tweak);
+            REQUIRE(token == digits);
+        }
+    }
+
+    // a custom alphabet, the tweak changes the token
+    ff1 hexa{"0123456789ABCDEF"};
+    hexa.key(rnd.make(16));
+    REQUIRE(hexa.radix() == 16);
+    const auto token = hexa.encrypt("DEADBEEF00C0FFEE", "tenant-1");
+    REQUIRE(token.size() == 16);
+    REQUIRE(token.find_first_not_of("0123456789ABCDEF") == buffer_t::npos);
+    REQUIRE(token != hexa.encrypt("DEADBEEF00C0FFEE", "tenant-2"));
+    REQUIRE(hexa.decrypt(token, "tenant-1") == "DEADBEEF00C0FFEE");
+}
+
+TEST_CASE("ff1 batches and errors", "[ff1]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+    ff1           fpe{10};
+    fpe.key(rnd.make(16));
+
+    SECTION("batches") {
+        std::vector<buffer_t>      pans;
+        std::vector<buffer_view_t> views;
+        for (size_t i = 0; i < 100; ++i) {
+            buffer_t pan(12 + i % 8, '0');
+            const auto random = rnd.make(pan.size());
+            for (size_t j = 0; j < pan.size(); ++j)
+                pan[j] = static_cast<char>('0' + uint8_t(random[j]) % 10);
+            pans.push_back(pan);
+        }
+        for (const auto& p : pans)
+            views.emplace_back(p);
+
+        // the same as single tokens, in the order of the inputs
+        const auto tokens = fpe.encrypt_many(views, "merchant");
+        REQUIRE(tokens.size() == pans.size());
+        std::vector<buffer_view_t> token_views;
+        for (size_t i = 0; i < pans.size(); ++i) {
+            REQUIRE(tokens[i] == fpe.encrypt(pans[i], "merchant"));
+            token_views.emplace_back(tokens[i]);
+        }
+        REQUIRE(fpe.decrypt_many(token_views, "merchant") == pans);
+    }
+
+    SECTION("usage errors") {
+        REQUIRE_THROWS(ff1{1});
+        REQUIRE_THROWS(ff1{65537});
+        REQUIRE_THROWS(ff1{"a"});
+        REQUIRE_THROWS(ff1{"abca"});
+
+        ff1 no_key{10};
+        REQUIRE_THROWS(no_key.encrypt("0123456789"));
+        REQUIRE_THROWS(fpe.key(rnd.make(15)));
+
+        REQUIRE(fpe.min_length() == 6);
+        REQUIRE(fpe.max_length() == 154);
+        REQUIRE_THROWS(fpe.encrypt("12345"));
+        REQUIRE_THROWS(fpe.encrypt(buffer_t(155, '1')));
+        REQUIRE_THROWS(fpe.encrypt("1234567a"));
+
+        uint16_t digits[] = {1, 2, 3, 4, 5, 6, 7, 10};
+        REQUIRE_THROWS(fpe.encrypt(digits, 8));
+
+        // no alphabet for a radix > 36, only the digits apis
+        ff1 wide{1000};
+        wide.key(rnd.make(16));
+        REQUIRE_THROWS(wide.encrypt("0123456789"));
+    }
+}
+
+TEST_CASE("ff1 benchmark", "[.][bench][ff1]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    constexpr size_t Tokens = 100000;
+
+    rnd_generator rnd;
+    ff1           fpe{10};
+    fpe.key(rnd.make(16));
+
+    std::vector<buffer_t> pans;
+    for (size_t i = 0; i < Tokens; ++i) {
+        buffer_t   pan(16, '0');
+        const auto random = rnd.make(pan.size());
+        for (size_t j = 0; j < pan.size(); ++j)
+            pan[j] = static_cast<char>('0' + uint8_t(random[j]) % 10);
+        pans.push_back(pan);
+    }
+    std::vector<buffer_view_t> views;
+    for (const auto& p : pans)
+        views.emplace_back(p);
+
+    auto start = clock_type::now();
+    for (const auto& p : pans)
+        fpe.encrypt(p, "merchant");
+    const auto single = seconds(clock_type::now() - start).count();
+
+    start            = clock_type::now();
+    const auto batch = fpe.encrypt_many(views, "merchant");
+    const auto many  = seconds(clock_type::now() - start).count();
+
+    // the low level api, in place and without allocations
+    std::vector<uint16_t> digits(16 * Tokens);
+    for (size_t i = 0; i < digits.size(); ++i)
+        digits[i] = static_cast<uint16_t>(pans[i / 16][i % 16] - '0');
+    start = clock_type::now();
+    for (size_t i = 0; i < Tokens; ++i)
+        fpe.encrypt(&digits[i * 16], 16, "merchant");
+    const auto low = seconds(clock_type::now() - start).count();
+
+    std::printf(
+        "ff1, %zu card numbers of 16 digits\n"
+        "  encrypt      %10.0f tokens/s\n"
+        "  encrypt_many %10.0f tokens/s\n"
+        "  digits       %10.0f tokens/s\n",
+        Tokens,
+        Tokens / single,
+        Tokens / many,
+        Tokens / low);
+    REQUIRE(batch.size() == Tokens);
+}
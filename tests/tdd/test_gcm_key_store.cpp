@@ -0,0 +1,278 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/gcm_key_store.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+
+#if defined(MBEDTLS_GCM_C)
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+cipher_t
+gcm_of(size_t key_bitlen) {
+    switch (key_bitlen) {
+    case 128:
+        return cipher_t::aes_128_gcm;
+    case 192:
+        return cipher_t::aes_192_gcm;
+    default:
+        return cipher_t::aes_256_gcm;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("gcm key store", "[gcm][cipher]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+
+    SECTION("compatibility with cipher") {
+        for (size_t bits : {128, 192, 256}) {
+            gcm_key_store store{bits};
+            std::vector<buffer_t> keys;
+            for (size_t i = 0; i < 8; ++i) {
+                keys.push_back(rnd.make(bits / 8));
+                REQUIRE(store.add(keys.back()) == i);
+            }
+            REQUIRE(store.size() == 8);
+
+            for (size_t size : {0, 1, 15, 16, 17, 100, 1000}) {
+                for (size_t iv_size : {12, 1, 16, 60}) {
+                    const size_t id   = size % keys.size();
+                    auto         iv   = rnd.make(iv_size);
+                    auto         ad   = rnd.make(size % 37);
+                    auto         data = rnd.make(size);
+
+                    auto ref = cipher::encrypt_aead(
+                        gcm_of(bits), iv, keys[id], ad, data);
+                    auto enc = store.encrypt(id, iv, ad, data);
+                    REQUIRE(enc == ref);
+
+                    auto dec = store.decrypt(id, iv, ad, enc);
+                    REQUIRE(std::get<0>(dec));
+                    REQUIRE(std::get<1>(dec) == data);
+                }
+            }
+        }
+    }
+
+    SECTION("authentication") {
+        gcm_key_store store;
+        auto          id   = store.add(rnd.make(16));
+        auto          iv   = rnd.make(12);
+        auto          enc  = store.encrypt(id, iv, "header", "some secret");
+        auto          tag  = std::get<0>(enc);
+        auto          data = std::get<1>(enc);
+
+        // truncated tags
+        auto tag12 = tag.substr(0, 12);
+        auto tag3  = tag.substr(0, 3);
+        REQUIRE(std::get<0>(store.decrypt(id, iv, "header", tag12, data)));
+        REQUIRE_THROWS(store.decrypt(id, iv, "header", tag3, data));
+
+        auto bad_tag = tag;
+        bad_tag[5] ^= 0x01;
+        auto dec = store.decrypt(id, iv, "header", bad_tag, data);
+        REQUIRE_FALSE(std::get<0>(dec));
+        REQUIRE(std::get<1>(dec).empty());
+
+        dec = store.decrypt(id, iv, "headers", tag, data);
+        REQUIRE_FALSE(std::get<0>(dec));
+        data[0] ^= 0x01;
+        dec = store.decrypt(id, iv, "header", tag, data);
+        REQUIRE_FALSE(std::get<0>(dec));
+    }
+
+    SECTION("invalid inputs") {
+        REQUIRE_THROWS(gcm_key_store{100});
+
+        gcm_key_store store{256};
+        REQUIRE_THROWS(store.add(rnd.make(16)));
+        REQUIRE_THROWS(store.encrypt(0, rnd.make(12), "", "no key"));
+
+        auto id = store.add(rnd.make(32));
+        REQUIRE_THROWS(store.encrypt(id, "", "", "empty iv"));
+        REQUIRE_THROWS(store.replace(id + 1, rnd.make(32)));
+    }
+
+    SECTION("replace and cache") {
+        // room for a single expanded key per shard
+        gcm_key_store store{128, 1};
+        REQUIRE(store.expanded_key_size() > 0);
+
+        std::vector<buffer_t> keys;
+        for (size_t i = 0; i < 64; ++i) {
+            keys.push_back(rnd.make(16));
+            store.add(keys.back());
+        }
+
+        auto iv = rnd.make(12);
+        for (size_t round = 0; round < 2; ++round) {
+            for (size_t i = 0; i < keys.size(); ++i) {
+                auto ref = cipher::encrypt_aead(
+                    cipher_t::aes_128_gcm, iv, keys[i], "", "data");
+                REQUIRE(store.encrypt(i, iv, "", "data") == ref);
+            }
+        }
+
+        auto st = store.stats();
+        REQUIRE(st.keys == 64);
+        REQUIRE(st.expanded <= 16);
+        REQUIRE(st.misses == 128);
+        REQUIRE(st.evictions == st.misses - st.expanded);
+        REQUIRE(st.memory == 64 * 16 + st.expanded * store.expanded_key_size());
+
+        // the cached key is dropped
+        auto enc = store.encrypt(3, iv, "", "data");
+        keys[3]  = rnd.make(16);
+        store.replace(3, keys[3]);
+        auto ref = cipher::encrypt_aead(
+            cipher_t::aes_128_gcm, iv, keys[3], "", "data");
+        REQUIRE(store.encrypt(3, iv, "", "data") != enc);
+        REQUIRE(store.encrypt(3, iv, "", "data") == ref);
+
+        store.clear_cache();
+        REQUIRE(store.stats().expanded == 0);
+
+        // hits
+        gcm_key_store large;
+        auto          id = large.add(keys[0]);
+        for (size_t i = 0; i < 10; ++i)
+            large.encrypt(id, iv, "", "data");
+        st = large.stats();
+        REQUIRE(st.misses == 1);
+        REQUIRE(st.hits == 9);
+    }
+
+    SECTION("many keys") {
+        // the raw keys span several fixed chunks
+        gcm_key_store         store{192, 1024};
+        std::vector<buffer_t> keys;
+        for (size_t i = 0; i < 2500; ++i) {
+            keys.push_back(rnd.make(24));
+            REQUIRE(store.add(keys.back()) == i);
+        }
+        REQUIRE(store.size() == keys.size());
+
+        auto iv = rnd.make(12);
+        for (size_t i : {0, 1023, 1024, 2047, 2048, 2499}) {
+            auto ref = cipher::encrypt_aead(
+                cipher_t::aes_192_gcm, iv, keys[i], "", "data");
+            REQUIRE(store.encrypt(i, iv, "", "data") == ref);
+        }
+        REQUIRE_THROWS(store.encrypt(2500, iv, "", "data"));
+    }
+
+    SECTION("concurrency") {
+        gcm_key_store store{128, 16 * 1024};
+        std::vector<buffer_t> keys;
+        for (size_t i = 0; i < 256; ++i) {
+            keys.push_back(rnd.make(16));
+            store.add(keys.back());
+        }
+
+        const auto iv = rnd.make(12);
+        std::vector<buffer_t> refs;
+        for (const auto& k : keys) {
+            refs.push_back(std::get<1>(cipher::encrypt_aead(
+                cipher_t::aes_128_gcm, iv, k, "", "payload")));
+        }
+
+        std::atomic<size_t>      errors{0};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < 4; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = 0; i < 2000; ++i) {
+                    const size_t id = (i * 7 + t * 13) % keys.size();
+                    auto enc = store.encrypt(id, iv, "", "payload");
+                    if (std::get<1>(enc) != refs[id])
+                        ++errors;
+                }
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+        REQUIRE(errors == 0);
+    }
+}
+
+TEST_CASE("gcm key store benchmark", "[.][bench][gcm]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t KeyCount = 1024 * 1024;
+    constexpr size_t Budget   = 16 * 1024 * 1024;
+    constexpr size_t Messages = 200000;
+    constexpr size_t Payload  = 256;
+
+    rnd_generator rnd;
+    gcm_key_store store{128, Budget};
+    auto          keys = rnd.make(KeyCount * 16);
+    for (size_t i = 0; i < KeyCount; ++i)
+        store.add(buffer_view_t{to_const_ptr(keys) + i * 16, 16});
+
+    const size_t cached = Budget / store.expanded_key_size();
+    std::printf(
+        "gcm key store: %zu keys, %zu bytes per raw key, %zu bytes per "
+        "expanded key (%s GHASH), %zu expanded keys in %zuMB\n",
+        KeyCount,
+        size_t{16},
+        store.expanded_key_size(),
+        store.uses_clmul() ? "clmul" : "table",
+        cached,
+        Budget / (1024 * 1024));
+
+    const auto iv   = rnd.make(12);
+    const auto data = rnd.make(Payload);
+
+    // the working set against the cache size, sets the hit rate
+    for (size_t working_set : {cached / 2, cached * 2, cached * 8, KeyCount}) {
+        store.clear_cache();
+        auto before = store.stats();
+
+        auto start = clock_type::now();
+        for (size_t i = 0; i < Messages; ++i) {
+            const size_t id = (i * 2654435761u) % working_set;
+            store.encrypt(id, iv, "", data);
+        }
+        const double elapsed =
+            std::chrono::duration<double>(clock_type::now() - start).count();
+
+        auto after = store.stats();
+        auto hits  = after.hits - before.hits;
+        std::printf(
+            "  working set %7zu keys: hit rate %5.1f%%, %8.0f msg/sec, "
+            "%.1f MB/s\n",
+            working_set,
+            100. * hits / Messages,
+            Messages / elapsed,
+            Messages * Payload / elapsed / (1024 * 1024));
+    }
+
+    // the plain cipher sets up a context for each message
+    auto start = clock_type::now();
+    for (size_t i = 0; i < Messages / 10; ++i) {
+        const size_t id = (i * 2654435761u) % KeyCount;
+        cipher::encrypt_aead(
+            cipher_t::aes_128_gcm,
+            iv,
+            buffer_view_t{to_const_ptr(keys) + id * 16, 16},
+            "",
+            data);
+    }
+    const double elapsed =
+        std::chrono::duration<double>(clock_type::now() - start).count();
+    std::printf(
+        "  cipher::encrypt_aead: %8.0f msg/sec\n", Messages / 10 / elapsed);
+}
+///////////////////////////////////////////////////////////////////////////////
+#endif // MBEDTLS_GCM_C
@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/gcm_parallel.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/tuning.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+#include "../../src/worker_pool.hpp"
+
+#if defined(MBEDTLS_GCM_C)
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("parallel gcm", "[gcm][cipher]") {
+    using namespace mbedcrypto;
+
+    // small segments: many segments and a partial last one
+    const auto original = tuning::current();
+    auto       small    = original;
+    small.segment_size       = 16 * 1024;
+    small.parallel_min_bytes = 32 * 1024;
+    tuning::set_thresholds(small);
+
+    rnd_generator rnd;
+    const cipher_t types[] = {
+        cipher_t::aes_128_gcm, cipher_t::aes_192_gcm, cipher_t::aes_256_gcm};
+
+    SECTION("compatibility with cipher") {
+        for (auto type : types) {
+            const auto key = rnd.make(cipher::key_bitlen(type) / 8);
+            for (size_t size :
+                 {0, 1, 17, 4096, 16384, 16385, 49157, 300000, 1048583}) {
+                for (size_t iv_size : {12, 1, 60}) {
+                    auto iv   = rnd.make(iv_size);
+                    auto ad   = rnd.make(size % 37);
+                    auto data = rnd.make(size);
+
+                    auto ref = cipher::encrypt_aead(type, iv, key, ad, data);
+                    for (size_t threads : {0, 1, 3}) {
+                        auto enc = gcm::parallel_encrypt(
+                            type, iv, key, ad, data, threads);
+                        REQUIRE(enc == ref);
+
+                        auto dec = gcm::parallel_decrypt(
+                            type, iv, key, ad, enc, threads);
+                        REQUIRE(std::get<0>(dec));
+                        REQUIRE(std::get<1>(dec) == data);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("authentication") {
+        const auto key  = rnd.make(32);
+        const auto iv   = rnd.make(12);
+        const auto data = rnd.make(100000);
+        auto       enc  = gcm::parallel_encrypt(
+            cipher_t::aes_256_gcm, iv, key, "header", data);
+        auto tag = std::get<0>(enc);
+        auto ct  = std::get<1>(enc);
+
+        REQUIRE(std::get<0>(gcm::parallel_decrypt(
+            cipher_t::aes_256_gcm, iv, key, "header", tag.substr(0, 12), ct)));
+        REQUIRE_THROWS(gcm::parallel_decrypt(
+            cipher_t::aes_256_gcm, iv, key, "header", tag.substr(0, 3), ct));
+
+        // a bit of the last and of a middle segment
+        for (size_t at : {ct.size() - 1, ct.size() / 2}) {
+            auto bad = ct;
+            bad[at] ^= 0x01;
+            auto dec = gcm::parallel_decrypt(
+                cipher_t::aes_256_gcm, iv, key, "header", tag, bad);
+            REQUIRE_FALSE(std::get<0>(dec));
+            REQUIRE(std::get<1>(dec).empty());
+        }
+        REQUIRE_FALSE(std::get<0>(gcm::parallel_decrypt(
+            cipher_t::aes_256_gcm, iv, key, "headers", tag, ct)));
+
+        REQUIRE_THROWS(gcm::parallel_encrypt(
+            cipher_t::aes_256_gcm, "", key, "", "empty iv"));
+        REQUIRE_THROWS(gcm::parallel_encrypt(
+            cipher_t::aes_256_gcm, iv, rnd.make(16), "", "key size"));
+    }
+
+    SECTION("other gcm ciphers") {
+        if (supports(cipher_t::camellia_128_gcm)) {
+            const auto key  = rnd.make(16);
+            const auto iv   = rnd.make(12);
+            const auto data = rnd.make(50000);
+            auto       ref  = cipher::encrypt_aead(
+                cipher_t::camellia_128_gcm, iv, key, "", data);
+            REQUIRE(
+                gcm::parallel_encrypt(
+                    cipher_t::camellia_128_gcm, iv, key, "", data) == ref);
+        }
+    }
+
+    tuning::set_thresholds(original);
+}
+
+TEST_CASE("parallel gcm benchmark", "[.][bench][gcm]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    constexpr size_t Size = 256 * 1024 * 1024;
+
+    rnd_generator rnd;
+    const auto    key  = rnd.make(32);
+    const auto    iv   = rnd.make(12);
+    const auto    data = rnd.make(Size);
+
+    auto start = clock_type::now();
+    auto ref = cipher::encrypt_aead(cipher_t::aes_256_gcm, iv, key, "", data);
+    const auto serial = seconds(clock_type::now() - start).count();
+    std::printf(
+        "gcm of %zuMB, %zu pool threads, segments of %zuKB\n"
+        "  encrypt_aead           %8.1f MB/s\n",
+        Size >> 20,
+        worker_pool::shared().size(),
+        tuning::current().segment_size >> 10,
+        (Size >> 20) / serial);
+
+    for (size_t threads : {1, 2, 4, 8, 16, 32}) {
+        start    = clock_type::now();
+        auto enc = gcm::parallel_encrypt(
+            cipher_t::aes_256_gcm, iv, key, "", data, threads);
+        const auto encrypt = seconds(clock_type::now() - start).count();
+
+        start    = clock_type::now();
+        auto dec = gcm::parallel_decrypt(
+            cipher_t::aes_256_gcm, iv, key, "", enc, threads);
+        const auto decrypt = seconds(clock_type::now() - start).count();
+
+        REQUIRE(enc == ref);
+        REQUIRE(std::get<0>(dec));
+        std::printf(
+            "  %2zu threads: encrypt %8.1f MB/s (x%4.1f), decrypt %8.1f MB/s\n",
+            threads,
+            (Size >> 20) / encrypt,
+            serial / encrypt,
+            (Size >> 20) / decrypt);
+    }
+}
+
+#endif // MBEDTLS_GCM_C
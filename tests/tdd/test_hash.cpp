@@ -4,8 +4,21 @@
 #include "mbedcrypto/hash.hpp"
 #include "mbedcrypto/tcodec.hpp"
 #include "mbedcrypto_mbedtls_config.h"
+#include "src/cpu_features.hpp"
+#include "src/sha512_kernels.hpp"
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <iostream>
+
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
 ///////////////////////////////////////////////////////////////////////////////
 namespace {
 using namespace mbedcrypto;
@@ -169,3 +182,134 @@ TEST_CASE("hash tests", "[hash]") {
 #endif // MBEDTLS_SHA1_C
     }
 }
+
+TEST_CASE("sha512 kernels", "[hash]") {
+    using namespace mbedcrypto;
+
+    // messages of all the padding boundaries
+    std::vector<buffer_t> messages;
+    const buffer_t        src(test::long_binary());
+    for (size_t i = 0; i < 300; ++i)
+        messages.push_back(src.substr(0, i % src.size()));
+    messages.push_back(src);
+    std::vector<buffer_view_t> views;
+    for (const auto& m : messages)
+        views.emplace_back(m);
+
+    SECTION("known answers") {
+        const std::vector<buffer_view_t> abc{buffer_view_t{"abc"}};
+        REQUIRE(
+            to_hex(hash::make_many(hash_t::sha512, abc)[0]) ==
+            "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a"
+            "2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f");
+        REQUIRE(
+            to_hex(hash::make_many(hash_t::sha384, abc)[0]) ==
+            "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed"
+            "8086072ba1e7cc2358baeca134c825a7");
+    }
+
+    SECTION("single block kernels") {
+        if (!cpu::has_avx2())
+            return;
+        for (size_t i = 0; i + sha512::block_size <= src.size(); i += 17) {
+            uint64_t a[8], b[8];
+            sha512::initial_state(a, false);
+            sha512::initial_state(b, false);
+            sha512::process_portable(a, to_const_ptr(src) + i);
+            sha512::process_avx2(b, to_const_ptr(src) + i);
+            REQUIRE(std::memcmp(a, b, sizeof(a)) == 0);
+        }
+    }
+
+    SECTION("multi buffer") {
+        for (auto type : {hash_t::sha384, hash_t::sha512}) {
+            const auto digests = hash::make_many(type, views);
+            REQUIRE(digests.size() == messages.size());
+            for (size_t i = 0; i < messages.size(); ++i)
+                REQUIRE(digests[i] == hash::make(type, messages[i]));
+
+            // short and long (hashed) keys
+            for (size_t key_size : {16, 128, 129, 200}) {
+                const auto key  = src.substr(7, key_size);
+                const auto macs = hmac::make_many(type, key, views);
+                for (size_t i = 0; i < messages.size(); ++i)
+                    REQUIRE(macs[i] == hmac::make(type, key, messages[i]));
+            }
+        }
+
+#if defined(MBEDTLS_SHA1_C)
+        // the other types are computed one by one
+        const auto digests = hash::make_many(hash_t::sha1, views);
+        REQUIRE(digests.back() == hash::make(hash_t::sha1, messages.back()));
+#endif // MBEDTLS_SHA1_C
+        REQUIRE(hash::make_many(hash_t::sha512, {}).empty());
+    }
+}
+
+TEST_CASE("sha512 kernels benchmark", "[.][bench][hash]") {
+    using namespace mbedcrypto;
+
+    constexpr size_t Size = 4 * 1024 * 1024;
+    const buffer_t   data(Size, 'x');
+    const auto*      blocks = to_const_ptr(data);
+
+    // cycles per byte by the time stamp counter (if available)
+    auto report = [](const char* name, auto&& fn) {
+#if defined(MBEDCRYPTO_X86_64_INTRINSICS)
+        const auto start = __rdtsc();
+        fn();
+        std::printf(
+            "  %-16s %6.2f cycles/byte\n",
+            name,
+            double(__rdtsc() - start) / Size);
+#else  // MBEDCRYPTO_X86_64_INTRINSICS
+        using clock_type = std::chrono::steady_clock;
+        using ns         = std::chrono::duration<double, std::nano>;
+        const auto start = clock_type::now();
+        fn();
+        std::printf(
+            "  %-16s %6.2f ns/byte\n",
+            name,
+            ns(clock_type::now() - start).count() / Size);
+#endif // MBEDCRYPTO_X86_64_INTRINSICS
+    };
+
+    std::printf(
+        "sha512 kernels: %zu bytes, avx2: %d\n", Size, int{cpu::has_avx2()});
+
+    uint64_t state[8];
+    sha512::initial_state(state, false);
+    report("portable", [&]() {
+        for (size_t i = 0; i < Size; i += sha512::block_size)
+            sha512::process_portable(state, blocks + i);
+    });
+    report("hash::make", [&]() { hash::make(hash_t::sha512, data); });
+    if (!cpu::has_avx2())
+        return;
+
+    report("avx2", [&]() {
+        for (size_t i = 0; i < Size; i += sha512::block_size)
+            sha512::process_avx2(state, blocks + i);
+    });
+
+    uint64_t  lanes[sha512::lanes][8];
+    uint64_t* states[sha512::lanes];
+    for (size_t k = 0; k < sha512::lanes; ++k)
+        states[k] = lanes[k];
+    report("avx2 x4", [&]() {
+        const size_t step = sha512::lanes * sha512::block_size;
+        for (size_t i = 0; i < Size; i += step) {
+            const uint8_t* b[sha512::lanes];
+            for (size_t k = 0; k < sha512::lanes; ++k)
+                b[k] = blocks + i + k * sha512::block_size;
+            sha512::process_x4(states, b);
+        }
+    });
+
+    std::vector<buffer_view_t> messages;
+    for (size_t i = 0; i < Size; i += 1024)
+        messages.emplace_back(blocks + i, 1024);
+    report("make_many 1KB", [&]() {
+        hash::make_many(hash_t::sha512, messages);
+    });
+}
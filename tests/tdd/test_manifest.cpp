@@ -0,0 +1,209 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/manifest.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "generator.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+void
+make_dir(const char* path) {
+#if defined(_WIN32)
+    _mkdir(path);
+#else
+    mkdir(path, 0755);
+#endif
+}
+
+void
+remove_dir(const char* path) {
+#if defined(_WIN32)
+    _rmdir(path);
+#else
+    rmdir(path);
+#endif
+}
+
+/// the expected tree digest, @sa manifest::options::tree_hash
+buffer_t
+tree_digest(const buffer_t& data, size_t leaf_size) {
+    hash    root{hash_t::sha256};
+    hash    leaf{hash_t::sha256};
+    uint8_t prefix = 0x01;
+    root.start();
+    root.update(&prefix, 1);
+    for (size_t offset = 0; offset < data.size(); offset += leaf_size) {
+        prefix = 0x00;
+        leaf.start();
+        leaf.update(&prefix, 1);
+        leaf.update(data.substr(offset, leaf_size));
+        root.update(leaf.finish());
+    }
+    return root.finish();
+}
+
+struct sample_files {
+    std::vector<std::string> paths;
+    std::vector<buffer_t>    contents;
+
+    sample_files() {
+        make_dir("./manifest_files");
+        make_dir("./manifest_files/sub");
+
+        rnd_generator rnd;
+        for (size_t i = 0; i < 40; ++i) {
+            // mostly small files, and a few large ones
+            size_t size = (i % 10 == 3) ? 300 * 1024 + i : i * 97;
+            char   name[64];
+            std::snprintf(
+                name,
+                sizeof(name),
+                "./manifest_files/%sf%02zu",
+                (i % 2) ? "sub/" : "",
+                i);
+            contents.push_back(rnd.make(size));
+            paths.emplace_back(name);
+            test::dump_to_file(contents.back(), name);
+        }
+    }
+
+    ~sample_files() {
+        for (const auto& p : paths)
+            std::remove(p.c_str());
+        remove_dir("./manifest_files/sub");
+        remove_dir("./manifest_files");
+    }
+}; // struct sample_files
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("manifest hashing", "[hash][manifest]") {
+    using namespace mbedcrypto;
+
+    sample_files samples;
+
+    SECTION("files in order") {
+        auto paths = samples.paths;
+        paths.insert(paths.begin() + 3, "./manifest_files/no_such_file");
+
+        for (size_t threads : {1, 2, 0}) {
+            manifest::options opts;
+            opts.max_threads = threads;
+            opts.batch_size  = 5;
+
+            size_t index = 0;
+            manifest::hash_files(
+                paths,
+                [&](const manifest::entry& e) {
+                    REQUIRE(e.path == paths[index]);
+                    if (index++ == 3) {
+                        REQUIRE_FALSE(e.ok());
+                        REQUIRE(e.digest.empty());
+                        return;
+                    }
+                    REQUIRE(e.ok());
+                    REQUIRE_FALSE(e.tree);
+                    REQUIRE(
+                        e.digest ==
+                        hash::of_file(hash_t::sha256, e.path.c_str()));
+                },
+                opts);
+            REQUIRE(index == paths.size());
+        }
+    }
+
+    SECTION("tree hash") {
+        manifest::options opts;
+        opts.tree_hash = true;
+        opts.leaf_size = 64 * 1024;
+
+        auto entries = manifest::of_files(samples.paths, opts);
+        REQUIRE(entries.size() == samples.paths.size());
+        for (size_t i = 0; i < entries.size(); ++i) {
+            const auto& e    = entries[i];
+            const auto& data = samples.contents[i];
+            REQUIRE(e.ok());
+            REQUIRE(e.size == static_cast<int64_t>(data.size()));
+            if (data.size() > opts.leaf_size) {
+                REQUIRE(e.tree);
+                REQUIRE(e.digest == tree_digest(data, opts.leaf_size));
+            } else {
+                REQUIRE_FALSE(e.tree);
+                REQUIRE(e.digest == hash::make(hash_t::sha256, data));
+            }
+        }
+    }
+
+    SECTION("directory tree") {
+        manifest::options opts;
+        opts.type = hash_t::sha1;
+
+        auto entries = manifest::of_tree("./manifest_files", opts);
+        REQUIRE(entries.size() == samples.paths.size());
+        for (size_t i = 1; i < entries.size(); ++i)
+            REQUIRE(entries[i - 1].path < entries[i].path);
+        for (const auto& e : entries)
+            REQUIRE(e.digest == hash::of_file(hash_t::sha1, e.path.c_str()));
+
+        REQUIRE_THROWS(manifest::of_tree("./no_such_directory"));
+    }
+
+    SECTION("stop by the callback") {
+        size_t count = 0;
+        REQUIRE_THROWS(manifest::hash_files(
+            samples.paths, [&count](const manifest::entry&) {
+                if (++count == 3)
+                    throw std::runtime_error{"enough"};
+            }));
+        REQUIRE(count == 3);
+    }
+}
+
+TEST_CASE("manifest hashing benchmark", "[.][bench][manifest]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    sample_files samples;
+    // many copies of the same list, the files are served by the os cache
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < 250; ++i)
+        paths.insert(paths.end(), samples.paths.begin(), samples.paths.end());
+
+    auto start = clock_type::now();
+    for (const auto& p : paths)
+        hash::of_file(hash_t::sha256, p.c_str());
+    const double serial =
+        std::chrono::duration<double>(clock_type::now() - start).count();
+
+    std::printf("manifest: %zu files\n", paths.size());
+    std::printf(
+        "  hash::of_file loop:    %8.0f files/sec\n", paths.size() / serial);
+    for (size_t threads : {1, 2, 4, 0}) {
+        manifest::options opts;
+        opts.max_threads = threads;
+        start            = clock_type::now();
+        manifest::hash_files(paths, [](const manifest::entry&) {}, opts);
+        const double elapsed =
+            std::chrono::duration<double>(clock_type::now() - start).count();
+        std::printf(
+            "  manifest, %s threads: %8.0f files/sec\n",
+            threads == 0 ? "all" : std::to_string(threads).c_str(),
+            paths.size() / elapsed);
+    }
+}
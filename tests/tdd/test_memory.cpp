@@ -0,0 +1,184 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/ecp.hpp"
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/memory.hpp"
+#include "mbedcrypto/public_key.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "generator.hpp"
+
+#include <cstdio>
+#include <vector>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+void
+print_usage(const char* name, const memory::usage& u) {
+    std::printf(
+        "  %-24s inline %6zu + heap %6zu = %6zu bytes (%7.0f objects/MB)\n",
+        name,
+        u.inline_bytes,
+        u.heap_bytes,
+        u.total(),
+        1024. * 1024. / u.total());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("object footprints", "[memory]") {
+    using namespace mbedcrypto;
+
+    SECTION("hash and hmac") {
+        hash h{hash_t::sha256};
+        hmac m{hash_t::sha256};
+        REQUIRE(h.footprint().inline_bytes >= sizeof(hash));
+        REQUIRE(h.footprint().heap_bytes > 0);
+        // the hmac has the inner and outer pads too
+        REQUIRE(m.footprint().heap_bytes > h.footprint().heap_bytes);
+    }
+
+    SECTION("cipher") {
+        cipher cbc{cipher_t::aes_128_cbc};
+        const auto u = cbc.footprint();
+        REQUIRE(u.heap_bytes > 0);
+        REQUIRE(u.total() == u.inline_bytes + u.heap_bytes);
+
+        if (supports(cipher_bm::gcm)) {
+            // the gcm tables and its aes context
+            cipher gcm{cipher_t::aes_128_gcm};
+            REQUIRE(gcm.footprint().heap_bytes > u.heap_bytes);
+        }
+    }
+
+    SECTION("rnd generator") {
+        rnd_generator rnd;
+        REQUIRE(rnd.footprint().inline_bytes > sizeof(rnd_generator));
+        REQUIRE(rnd.footprint().heap_bytes == 0);
+    }
+
+    SECTION("pk") {
+        rsa pri;
+        const auto empty = pri.footprint();
+        REQUIRE(empty.inline_bytes > pri.rnd().footprint().inline_bytes);
+
+        pri.import_key(test::rsa_private_key());
+        const auto full = pri.footprint();
+        REQUIRE(full.inline_bytes == empty.inline_bytes);
+        // N, D and the CRT values, of a 2048 bits key
+        REQUIRE(full.heap_bytes > 4 * 256);
+
+        public_key pub{pri};
+        REQUIRE(pub.footprint().heap_bytes >= 256);
+        REQUIRE(pub.footprint().heap_bytes < full.heap_bytes);
+        REQUIRE(pub.footprint().total() < full.total());
+
+        if (supports(features::ec_keygen) && supports(pk_t::ecdsa)) {
+            const auto before = memory::heap().bytes;
+            ecdsa      ec;
+            ec.generate_key(curve_t::secp256r1);
+            ec.sign(hash::make(hash_t::sha256, "message"), hash_t::sha256);
+
+            // d, Q and the precomputed points (if not static), never more
+            // than the heap of the key
+            const auto heap = ec.footprint().heap_bytes;
+            REQUIRE(heap >= 32 + 3 * 32);
+            REQUIRE(heap <= memory::heap().bytes - before);
+            REQUIRE(heap < 64 * 1024);
+        }
+    }
+}
+
+TEST_CASE("live objects and heap", "[memory]") {
+    using namespace mbedcrypto;
+    using memory::kind;
+
+    SECTION("live objects") {
+        const auto hashes = memory::live(kind::hash);
+        const auto pks    = memory::live(kind::pk);
+        const auto rnds   = memory::live(kind::rnd_generator);
+        {
+            std::vector<std::unique_ptr<hash>> list;
+            for (size_t i = 0; i < 10; ++i)
+                list.push_back(std::make_unique<hash>(hash_t::sha1));
+            REQUIRE(memory::live(kind::hash).objects == hashes.objects + 10);
+            REQUIRE(
+                memory::live(kind::hash).inline_bytes ==
+                hashes.inline_bytes + 10 * list[0]->footprint().inline_bytes);
+
+            rsa key;
+            REQUIRE(memory::live(kind::pk).objects == pks.objects + 1);
+            REQUIRE(
+                memory::live(kind::rnd_generator).objects == rnds.objects + 1);
+        }
+        REQUIRE(memory::live(kind::hash).objects == hashes.objects);
+        REQUIRE(memory::live(kind::pk).objects == pks.objects);
+        REQUIRE(memory::live(kind::rnd_generator).objects == rnds.objects);
+    }
+
+    SECTION("mbedtls heap") {
+        rnd_generator rnd;
+        const auto    key    = rnd.make(32);
+        const auto    before = memory::heap();
+        {
+            std::vector<std::unique_ptr<cipher>> list;
+            size_t                               heap = 0;
+            for (size_t i = 0; i < 10; ++i) {
+                list.push_back(std::make_unique<cipher>(cipher_t::aes_256_cbc));
+                list.back()->key(key, cipher::encrypt_mode);
+                heap += list.back()->footprint().heap_bytes;
+            }
+            const auto now = memory::heap();
+            REQUIRE(now.bytes >= before.bytes + heap);
+            REQUIRE(now.blocks >= before.blocks + 10);
+            REQUIRE(now.total_blocks >= before.total_blocks + 10);
+            REQUIRE(now.peak_bytes >= now.bytes);
+        }
+
+        memory::reset_peak();
+        const auto after = memory::heap();
+        REQUIRE(after.peak_bytes >= after.bytes);
+        REQUIRE(after.total_blocks >= before.total_blocks + 10);
+    }
+}
+
+TEST_CASE("object footprints benchmark", "[.][bench][memory]") {
+    using namespace mbedcrypto;
+
+    std::printf("memory footprints\n");
+    print_usage(
+        "cipher aes-128-cbc", cipher{cipher_t::aes_128_cbc}.footprint());
+    if (supports(cipher_bm::gcm))
+        print_usage(
+            "cipher aes-128-gcm", cipher{cipher_t::aes_128_gcm}.footprint());
+    print_usage("hash sha256", hash{hash_t::sha256}.footprint());
+    print_usage("hmac sha512", hmac{hash_t::sha512}.footprint());
+    print_usage("rnd_generator", rnd_generator{}.footprint());
+
+    rsa pri;
+    print_usage("rsa (empty)", pri.footprint());
+    pri.import_key(test::rsa_private_key());
+    print_usage("rsa 2048, private", pri.footprint());
+    print_usage("public_key rsa 2048", public_key{pri}.footprint());
+
+    if (supports(pk_t::eckey)) {
+        ecp ec;
+        ec.generate_key(curve_t::secp256r1);
+        print_usage("ecp secp256r1, private", ec.footprint());
+        print_usage("public_key secp256r1", public_key{ec}.footprint());
+    }
+
+    const auto h = memory::heap();
+    std::printf(
+        " mbedtls heap: %zu bytes in %zu blocks, peak %zu bytes, "
+        "%zu allocations\n",
+        h.bytes,
+        h.blocks,
+        h.peak_bytes,
+        h.total_blocks);
+}
@@ -0,0 +1,182 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/merkle.hpp"
+#include "mbedcrypto/public_key.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "pk_common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+std::vector<buffer_t>
+make_messages(rnd_generator& rnd, size_t count) {
+    std::vector<buffer_t> result;
+    for (size_t i = 0; i < count; ++i)
+        result.push_back(rnd.make(1 + i % 200));
+    return result;
+}
+
+std::vector<buffer_view_t>
+views_of(const std::vector<buffer_t>& messages) {
+    return std::vector<buffer_view_t>(messages.cbegin(), messages.cend());
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("merkle batch signing", "[merkle][pk]") {
+    using namespace mbedcrypto;
+
+    rsa key;
+    key.import_key(test::rsa_private_key());
+    public_key pub{test::rsa_public_key()};
+    rnd_generator rnd;
+
+    // full, odd and single node levels
+    for (size_t count : {1, 2, 3, 5, 8, 13, 64, 100}) {
+        const auto messages   = make_messages(rnd, count);
+        const auto signatures = merkle::sign_batch(key, views_of(messages));
+        REQUIRE(signatures.size() == count);
+
+        for (size_t i = 0; i < count; ++i) {
+            const auto& s = signatures[i];
+            REQUIRE(s.index == i);
+            REQUIRE(s.count == count);
+            REQUIRE(s.root_signature == signatures[0].root_signature);
+            REQUIRE(merkle::verify(key, messages[i], s));
+            REQUIRE(merkle::verify(pub, messages[i], s));
+
+            const auto parsed = merkle::batch_signature::parse(s.dump());
+            REQUIRE(parsed.path == s.path);
+            REQUIRE(merkle::verify(pub, messages[i], parsed));
+        }
+
+        // another message, index or path
+        auto other = messages[count / 2];
+        other.push_back('x');
+        REQUIRE_FALSE(merkle::verify(pub, other, signatures[count / 2]));
+        if (count > 1) {
+            auto s = signatures[0];
+            s.index = 1;
+            REQUIRE_FALSE(merkle::verify(pub, messages[0], s));
+            s = signatures[0];
+            s.path.back()[3] ^= 0x01;
+            REQUIRE_FALSE(merkle::verify(pub, messages[0], s));
+            s = signatures[0];
+            s.path.pop_back();
+            REQUIRE(merkle::signed_hash(messages[0], s).empty());
+        }
+    }
+
+    // the root signature is not a signature of a single message
+    const auto messages = make_messages(rnd, 4);
+    const auto s        = merkle::sign_batch(key, views_of(messages))[2];
+    REQUIRE_FALSE(pub.verify_message(s.root_signature, messages[2], s.type));
+
+    REQUIRE(merkle::sign_batch(key, {}).empty());
+    auto wire = s.dump();
+    REQUIRE_THROWS(merkle::batch_signature::parse(wire.substr(0, 10)));
+    REQUIRE_THROWS(merkle::batch_signature::parse(wire + "x"));
+    wire[0] = 0x07; // version
+    REQUIRE_THROWS(merkle::batch_signature::parse(wire));
+}
+
+TEST_CASE("merkle batch signer", "[merkle][pk]") {
+    using namespace mbedcrypto;
+
+    rsa key;
+    key.import_key(test::rsa_private_key());
+    public_key pub{test::rsa_public_key()};
+
+    constexpr size_t Threads = 4;
+    constexpr size_t Count   = 50;
+    std::vector<std::vector<merkle::batch_signature>> results(Threads);
+    {
+        merkle::batch_signer signer{
+            key, hash_t::sha256, 64, std::chrono::milliseconds{20}};
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < Threads; ++t) {
+            threads.emplace_back([&, t]() {
+                std::vector<std::future<merkle::batch_signature>> futures;
+                for (size_t i = 0; i < Count; ++i)
+                    futures.push_back(signer.submit(std::to_string(t * i)));
+                for (auto& f : futures)
+                    results[t].push_back(f.get());
+            });
+        }
+        for (auto& t : threads)
+            t.join();
+
+        // 200 messages, batches of at most 64
+        REQUIRE(signer.batches() >= 4);
+        REQUIRE(signer.batches() < Threads * Count);
+
+        // the destructor signs the pending messages
+        auto last = signer.submit("last");
+        signer.flush();
+        REQUIRE(merkle::verify(pub, "last", last.get()));
+    }
+
+    for (size_t t = 0; t < Threads; ++t) {
+        for (size_t i = 0; i < Count; ++i) {
+            const auto& s = results[t][i];
+            REQUIRE(s.count <= 64);
+            REQUIRE(merkle::verify(pub, std::to_string(t * i), s));
+        }
+    }
+}
+
+TEST_CASE("merkle benchmark", "[.][bench][merkle]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    rsa key;
+    if (supports(features::rsa_keygen))
+        key.generate_key(3072);
+    else
+        key.import_key(test::rsa_private_key());
+
+    rnd_generator rnd;
+    const auto    messages = make_messages(rnd, 4096);
+    const auto    views    = views_of(messages);
+
+    constexpr size_t Singles = 100;
+    auto             start   = clock_type::now();
+    for (size_t i = 0; i < Singles; ++i)
+        key.sign_message(messages[i], hash_t::sha256);
+    const auto single = seconds(clock_type::now() - start).count();
+
+    std::printf(
+        "merkle, rsa %zu bits\n  sign_message      %10.0f messages/s\n",
+        key.key_bitlen(),
+        Singles / single);
+
+    for (size_t batch : {16, 256, 4096}) {
+        const size_t rounds = 4096 / batch;
+        start               = clock_type::now();
+        for (size_t r = 0; r < rounds; ++r) {
+            const std::vector<buffer_view_t> part(
+                views.cbegin() + r * batch, views.cbegin() + (r + 1) * batch);
+            merkle::sign_batch(key, part);
+        }
+        const auto elapsed = seconds(clock_type::now() - start).count();
+        std::printf(
+            "  batches of %5zu  %10.0f messages/s\n", batch, 4096 / elapsed);
+    }
+
+    const auto s = merkle::sign_batch(key, views)[100];
+    start        = clock_type::now();
+    for (size_t i = 0; i < Singles; ++i)
+        merkle::verify(key, messages[100], s);
+    std::printf(
+        "  verify (4096)     %10.0f messages/s\n",
+        Singles / seconds(clock_type::now() - start).count());
+}
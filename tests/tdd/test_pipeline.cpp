@@ -0,0 +1,157 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/pipeline.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/tcodec.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("fused pipeline", "[pipeline]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+    const auto    key   = rnd.make(32);
+    const auto    iv    = rnd.make(16);
+    const auto    input = rnd.make(200 * 1024 + 7);
+
+    const auto ciphertext = cipher::encrypt(
+        cipher_t::aes_256_cbc, padding_t::pkcs7, iv, key, input);
+
+    SECTION("hash, encrypt and encode") {
+        // block sizes which do not divide the sizes of the input, nor the
+        // 16 bytes of the cipher, nor the 3 bytes of base64
+        for (size_t bsize : {size_t{0}, size_t{1000}, size_t{17}}) {
+            hash   sha{hash_t::sha256};
+            cipher aes{cipher_t::aes_256_cbc};
+            aes.padding(padding_t::pkcs7).iv(iv).key(key, cipher::encrypt_mode);
+
+            buffer_t digest, encrypted, encoded;
+            pipeline p{bsize};
+            p.add_hash(sha, digest)
+                .add_cipher(aes)
+                .add_sink(encrypted)
+                .add_base64()
+                .add_sink(encoded);
+            REQUIRE(p.size() == 5);
+
+            p.start();
+            for (size_t i = 0; i < input.size(); i += 3001) {
+                p.update(
+                    to_const_ptr(input) + i,
+                    std::min(size_t{3001}, input.size() - i));
+            }
+            p.finish();
+
+            REQUIRE(digest == hash::make(hash_t::sha256, input));
+            REQUIRE(encrypted == ciphertext);
+            REQUIRE(encoded == to_base64(ciphertext));
+        }
+    }
+
+    SECTION("decrypt and hmac") {
+        hmac mac{hash_t::sha512};
+        mac.start(key);
+        cipher aes{cipher_t::aes_256_cbc};
+        aes.padding(padding_t::pkcs7).iv(iv).key(key, cipher::decrypt_mode);
+
+        buffer_t tag, plain;
+        size_t   pieces = 0;
+        pipeline p{4096};
+        p.add_cipher(aes).add_hmac(mac, tag).add_sink(
+            [&](const uint8_t* data, size_t size) {
+                plain.append(reinterpret_cast<const char*>(data), size);
+                ++pieces;
+            });
+        p.run(ciphertext);
+
+        REQUIRE(plain == input);
+        REQUIRE(pieces > 1);
+        REQUIRE(tag == make_hmac(hash_t::sha512, key, input));
+
+        // restarts with the same key
+        plain.clear();
+        p.run(ciphertext);
+        REQUIRE(plain == input);
+        REQUIRE(tag == make_hmac(hash_t::sha512, key, input));
+    }
+
+    SECTION("codecs") {
+        for (size_t size : {0, 1, 2, 3, 4, 5, 100, 65537}) {
+            const auto data = rnd.make(size);
+            buffer_t   raw, b64;
+            pipeline   p{7};
+            p.add_sink(raw).add_base64().add_sink(b64);
+            p.run(data);
+            REQUIRE(raw == data);
+            REQUIRE(b64 == to_base64(data));
+
+            buffer_t encoded;
+            pipeline q{5};
+            q.add_hex().add_sink(encoded);
+            q.run(data);
+            REQUIRE(encoded == to_hex(data));
+        }
+    }
+
+    SECTION("usage errors") {
+        pipeline empty;
+        REQUIRE_THROWS(empty.start());
+        REQUIRE_THROWS(empty.add_sink(pipeline::sink_t{}));
+
+        buffer_t out;
+        pipeline p;
+        p.add_base64().add_sink(out);
+        REQUIRE_THROWS(p.update(input)); // not started
+        REQUIRE_THROWS(p.finish());
+    }
+}
+
+TEST_CASE("fused pipeline benchmark", "[.][bench][pipeline]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    rnd_generator rnd;
+    const auto    key   = rnd.make(32);
+    const auto    iv    = rnd.make(16);
+    const auto    input = rnd.make(64 * 1024 * 1024);
+
+    hash   sha{hash_t::sha256};
+    cipher aes{cipher_t::aes_256_cbc};
+    aes.padding(padding_t::pkcs7).iv(iv).key(key, cipher::encrypt_mode);
+
+    auto report = [&](const char* name, clock_type::time_point start) {
+        const double elapsed =
+            std::chrono::duration<double>(clock_type::now() - start).count();
+        std::printf(
+            "  %-24s %8.1f MB/s\n",
+            name,
+            input.size() / elapsed / (1024.0 * 1024.0));
+    };
+
+    std::printf("pipeline: sha256 + aes-256-cbc + base64 of 64MB\n");
+
+    // three passes over the memory, each with its own output
+    auto start  = clock_type::now();
+    auto digest = hash::make(hash_t::sha256, input);
+    auto ct     = aes.crypt(input);
+    auto b64    = base64::encode(ct);
+    report("separate passes", start);
+
+    for (size_t bsize : {16 * 1024, 64 * 1024, 256 * 1024, 4 * 1024 * 1024}) {
+        buffer_t fused_digest, fused_b64;
+        fused_b64.reserve(b64.size());
+        pipeline p{bsize};
+        p.add_hash(sha, fused_digest).add_cipher(aes).add_base64().add_sink(
+            fused_b64);
+
+        char name[64];
+        std::snprintf(name, sizeof(name), "fused, %zuKB blocks", bsize / 1024);
+        start = clock_type::now();
+        p.run(input);
+        report(name, start);
+        REQUIRE(fused_digest == digest);
+        REQUIRE(fused_b64 == b64);
+    }
+}
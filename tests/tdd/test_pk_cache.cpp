@@ -0,0 +1,201 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/pk_cache.hpp"
+#include "pk_common.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+/// flips the lowest bit of the index-th big number, and fixes the CRC-32
+buffer_t
+forge(buffer_t cache, size_t index) {
+    const size_t limb = static_cast<uint8_t>(cache[5]);
+    size_t       at   = 20;
+    for (size_t i = 0; i < index; ++i) {
+        uint32_t limbs = 0;
+        std::memcpy(&limbs, &cache[at], 4);
+        at += 4 + limbs * limb;
+    }
+    cache[at + 4] ^= 0x01; // little endian limbs
+
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < cache.size() - 4; ++i) {
+        crc ^= static_cast<uint8_t>(cache[i]);
+        for (int k = 0; k < 8; ++k)
+            crc = (crc & 1) ? 0xedb88320u ^ (crc >> 1) : crc >> 1;
+    }
+    crc ^= 0xffffffffu;
+    std::memcpy(&cache[cache.size() - 4], &crc, 4);
+    return cache;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("pk binary cache", "[pk]") {
+    using namespace mbedcrypto;
+
+    SECTION("rsa") {
+        rsa pri;
+        pri.import_key(test::rsa_private_key());
+        const auto cache = pk::to_cache(pri);
+        REQUIRE(pk::is_cache(cache));
+        REQUIRE_FALSE(pk::is_cache(test::rsa_private_key()));
+
+        rsa loaded;
+        pk::from_cache(loaded, cache);
+        REQUIRE(loaded.has_private_key());
+        REQUIRE(loaded.key_bitlen() == 2048);
+        REQUIRE(check_pair(loaded, pri));
+        // PKCS#1 v1.5 signatures are deterministic
+        const std::string message{test::long_text()};
+        REQUIRE(
+            loaded.sign_message(message, hash_t::sha1) ==
+            test::long_text_signature());
+        REQUIRE(loaded.decrypt(pri.encrypt("secret")) == "secret");
+        // a cache of the cache is the same
+        REQUIRE(pk::to_cache(loaded) == cache);
+
+        rsa pub;
+        pub.import_public_key(test::rsa_public_key());
+        const auto pub_cache = pk::to_cache(pub);
+        REQUIRE(pub_cache.size() < cache.size());
+
+        rsa pub_loaded;
+        pk::from_cache(pub_loaded, pub_cache);
+        REQUIRE_FALSE(pub_loaded.has_private_key());
+        REQUIRE(check_pair(pub_loaded, pri));
+        REQUIRE(pub_loaded.verify_message(
+            test::long_text_signature(), message, hash_t::sha1));
+        REQUIRE(pri.decrypt(pub_loaded.encrypt("secret")) == "secret");
+    }
+
+    if (supports(features::ec_keygen) && supports(pk_t::ecdsa)) {
+        SECTION("ec") {
+            ecdsa pri;
+            pri.generate_key(curve_t::secp384r1);
+            const auto cache = pk::to_cache(pri);
+
+            ecdsa loaded;
+            pk::from_cache(loaded, cache);
+            REQUIRE(loaded.has_private_key());
+            REQUIRE(loaded.key_bitlen() == 384);
+            REQUIRE(pk::check_pair(loaded.context(), pri.context()));
+
+            const std::string message{"some message to be signed"};
+            auto sig = loaded.sign_message(message, hash_t::sha384);
+            REQUIRE(pri.verify_message(sig, message, hash_t::sha384));
+
+            // an ec key can not be loaded into an rsa
+            rsa other;
+            REQUIRE_THROWS(pk::from_cache(other, cache));
+        }
+    }
+
+    SECTION("invalid caches") {
+        rsa empty;
+        REQUIRE_THROWS(pk::to_cache(empty));
+
+        rsa key;
+        key.import_key(test::rsa_private_key());
+        const auto cache = pk::to_cache(key);
+
+        REQUIRE_THROWS(pk::from_cache(key, ""));
+        REQUIRE_THROWS(pk::from_cache(key, test::rsa_private_key()));
+        REQUIRE_THROWS(pk::from_cache(key, cache.substr(0, cache.size() - 1)));
+
+        // corrupted
+        for (size_t i : {size_t{0}, size_t{4}, size_t{30}, cache.size() - 1}) {
+            auto bad = cache;
+            bad[i] ^= 0x01;
+            REQUIRE_FALSE(pk::is_cache(bad));
+            REQUIRE_THROWS(pk::from_cache(key, bad));
+        }
+
+        // the key is still usable
+        pk::from_cache(key, cache);
+        REQUIRE(key.has_private_key());
+    }
+
+    SECTION("forged caches") {
+        // the checksum is valid, the values are not
+        rsa key;
+        key.import_key(test::rsa_private_key());
+        const auto cache = pk::to_cache(key);
+        REQUIRE(pk::is_cache(forge(cache, 0)));
+        // N, E (even) and P (even)
+        for (size_t i : {0, 1, 3})
+            REQUIRE_THROWS(pk::from_cache(key, forge(cache, i)));
+
+        // no forged value makes a faulty signature (bellcore), the montgomery
+        // constant of N (once after E) is not kept anymore
+        const std::string message{test::long_text()};
+        for (size_t i = 0; i < 8; ++i) {
+            rsa forged;
+            try {
+                pk::from_cache(forged, forge(cache, i));
+                REQUIRE(
+                    forged.sign_message(message, hash_t::sha1) ==
+                    test::long_text_signature());
+            } catch (const exception&) {
+            }
+        }
+
+        if (supports(features::ec_keygen) && supports(pk_t::ecdsa)) {
+            ecdsa ec;
+            ec.generate_key(curve_t::secp256r1);
+            // the x of the public point, off the curve
+            REQUIRE_THROWS(pk::from_cache(ec, forge(pk::to_cache(ec), 0)));
+        }
+    }
+}
+
+TEST_CASE("pk binary cache benchmark", "[.][bench][pk]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t Loads = 200;
+
+    rsa source;
+    source.import_key(test::rsa_private_key());
+    const auto pem   = test::rsa_private_key();
+    const auto cache = pk::to_cache(source);
+    const auto hval  = hash::make(hash_t::sha256, test::long_text());
+
+    // average us of a load, and of the first signature after a load. the
+    // keys are constructed before, to only measure the loads
+    auto measure = [&](const char* name, size_t size, auto&& load) {
+        std::vector<rsa> keys(Loads);
+        auto             start = clock_type::now();
+        for (auto& key : keys)
+            load(key);
+        auto loaded = clock_type::now();
+        for (auto& key : keys)
+            key.sign(hval, hash_t::sha256);
+        auto first_sign = clock_type::now();
+
+        using us = std::chrono::duration<double, std::micro>;
+        std::printf(
+            "  %-6s %5zu bytes: load %8.1f us, first sign %8.1f us\n",
+            name,
+            size,
+            us(loaded - start).count() / Loads,
+            us(first_sign - loaded).count() / Loads);
+    };
+
+    std::printf("pk binary cache: rsa 2048 private key\n");
+    measure("pem", pem.size(), [&pem](rsa& k) { k.import_key(pem); });
+    if (supports(features::pk_export)) {
+        const auto der = source.export_key(pk::der_format);
+        measure("der", der.size(), [&der](rsa& k) { k.import_key(der); });
+    }
+    measure("cache", cache.size(), [&cache](rsa& k) {
+        pk::from_cache(k, cache);
+    });
+}
@@ -0,0 +1,316 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/provider.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "generator.hpp"
+
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+/// a builtin backend whose run() blocks until the gate is opened
+class gated_provider : public provider
+{
+public:
+    const char* name() const noexcept override {
+        return "gated";
+    }
+
+    bool supports(const operation& op) const noexcept override {
+        return builtin_provider()->supports(op);
+    }
+
+    op_result run(const operation& op) override {
+        gate_.wait();
+        return builtin_provider()->run(op);
+    }
+
+    void open() {
+        opener_.set_value();
+    }
+
+protected:
+    std::promise<void>       opener_;
+    std::shared_future<void> gate_ = opener_.get_future().share();
+}; // class gated_provider
+
+/// a card which implements sha256 only, by a fixed digest
+class sha256_card : public provider
+{
+public:
+    const char* name() const noexcept override {
+        return "sha256 card";
+    }
+
+    bool supports(const operation& op) const noexcept override {
+        return op.kind == operation::kind_t::hash &&
+               op.hash_type == hash_t::sha256;
+    }
+
+    op_result run(const operation&) override {
+        op_result r;
+        r.output   = "digest";
+        r.provider = name();
+        return r;
+    }
+}; // class sha256_card
+
+std::vector<operation>
+mixed_operations(rnd_generator& rnd, size_t count) {
+    const auto key = rnd.make(32);
+    const auto iv  = rnd.make(16);
+
+    std::vector<operation> ops;
+    for (size_t i = 0; i < count; ++i) {
+        const auto data = rnd.make(1 + i * 7 % 2000);
+        switch (i % 4) {
+        case 0:
+            ops.push_back(operation::hash(hash_t::sha256, data));
+            break;
+        case 1:
+            ops.push_back(operation::hmac(hash_t::sha512, key, data));
+            break;
+        case 2:
+            ops.push_back(operation::encrypt(
+                cipher_t::aes_256_cbc, padding_t::pkcs7, iv, key, data));
+            break;
+        default:
+            ops.push_back(operation::hash(hash_t::sha1, data));
+            break;
+        }
+    }
+    return ops;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("builtin provider", "[provider]") {
+    rnd_generator rnd;
+    const auto    key  = rnd.make(32);
+    const auto    iv   = rnd.make(16);
+    const auto    data = rnd.make(1000);
+    auto          p    = builtin_provider();
+
+    auto r = p->run(operation::hash(hash_t::sha256, data));
+    REQUIRE(r.ok);
+    REQUIRE(r.output == hash::make(hash_t::sha256, data));
+    REQUIRE(std::string{r.provider} == "builtin");
+
+    r = p->run(operation::hmac(hash_t::sha256, key, data));
+    REQUIRE(r.output == hmac::make(hash_t::sha256, key, data));
+
+    r = p->run(operation::encrypt(
+        cipher_t::aes_256_cbc, padding_t::pkcs7, iv, key, data));
+    const auto ct = cipher::encrypt(
+        cipher_t::aes_256_cbc, padding_t::pkcs7, iv, key, data);
+    REQUIRE(r.output == ct);
+    r = p->run(operation::decrypt(
+        cipher_t::aes_256_cbc, padding_t::pkcs7, iv, key, ct));
+    REQUIRE(r.output == data);
+
+    if (supports(cipher_t::aes_256_gcm) && cipher::supports_aead()) {
+        const auto nonce = iv.substr(0, 12);
+        r = p->run(operation::encrypt_aead(
+            cipher_t::aes_256_gcm, nonce, key, "header", data));
+        REQUIRE(r.ok);
+        REQUIRE(r.tag.size() == 16);
+        auto d = p->run(operation::decrypt_aead(
+            cipher_t::aes_256_gcm, nonce, key, "header", r.tag, r.output));
+        REQUIRE(d.ok);
+        REQUIRE(d.output == data);
+        d = p->run(operation::decrypt_aead(
+            cipher_t::aes_256_gcm, nonce, key, "other", r.tag, r.output));
+        REQUIRE_FALSE(d.ok);
+        REQUIRE_FALSE(d.error);
+    }
+
+    SECTION("pk") {
+        rsa pri;
+        pri.import_key(test::rsa_private_key());
+        const auto hvalue = hash::make(hash_t::sha256, data);
+
+        auto s =
+            p->run(operation::sign(pri.context(), hvalue, hash_t::sha256));
+        REQUIRE(s.ok);
+        REQUIRE(s.output == pri.sign(hvalue, hash_t::sha256));
+
+        auto v = p->run(operation::verify(
+            pri.context(), s.output, hvalue, hash_t::sha256));
+        REQUIRE(v.ok);
+        s.output[10] ^= 0x01;
+        v = p->run(operation::verify(
+            pri.context(), s.output, hvalue, hash_t::sha256));
+        REQUIRE_FALSE(v.ok);
+    }
+
+    SECTION("errors") {
+        auto e = p->run(operation::encrypt(
+            cipher_t::aes_256_cbc, padding_t::pkcs7, iv, "short key", data));
+        REQUIRE_FALSE(e.ok);
+        REQUIRE(e.error);
+        REQUIRE_THROWS(e.rethrow());
+
+        operation op;
+        op.kind = operation::kind_t::sign;
+        REQUIRE_FALSE(p->supports(op)); // no pk key
+        REQUIRE(p->run(op).error);
+    }
+}
+
+TEST_CASE("offload provider", "[provider]") {
+    rnd_generator rnd;
+
+    SECTION("same results as the builtin") {
+        offload_provider::options opt;
+        opt.workers    = 3;
+        opt.queue_size = 64;
+        opt.batch_size = 8;
+        auto card      = std::make_shared<offload_provider>(opt);
+
+        dispatcher d;
+        d.add(card);
+        auto ops      = mixed_operations(rnd, 500);
+        auto expected = ops;
+        auto results  = d.run_many(std::move(ops));
+        REQUIRE(results.size() == expected.size());
+
+        size_t offloaded = 0;
+        for (size_t i = 0; i < results.size(); ++i) {
+            const auto ref = builtin_provider()->run(expected[i]);
+            REQUIRE(results[i].ok);
+            REQUIRE_FALSE(results[i].error);
+            REQUIRE(results[i].output == ref.output);
+            if (std::string{results[i].provider} == "offload")
+                ++offloaded;
+        }
+
+        const auto s  = card->stats();
+        const auto ds = d.stats();
+        REQUIRE(s.submitted == offloaded);
+        REQUIRE(s.completed == s.submitted);
+        REQUIRE(s.batches <= s.completed);
+        REQUIRE(ds.submitted == offloaded);
+        REQUIRE(ds.fallbacks == s.rejected);
+        REQUIRE(ds.submitted + ds.inline_runs == expected.size());
+        REQUIRE(card->pending() == 0);
+    }
+
+    SECTION("fallback when saturated") {
+        auto gate = std::make_shared<gated_provider>();
+
+        offload_provider::options opt;
+        opt.workers    = 1;
+        opt.queue_size = 2;
+        opt.batch_size = 1;
+        opt.backend    = gate;
+        auto card      = std::make_shared<offload_provider>(opt);
+
+        dispatcher d;
+        d.add(card);
+        const auto data = rnd.make(100);
+        std::vector<std::future<op_result>> futures;
+        for (size_t i = 0; i < 10; ++i)
+            futures.push_back(d.async(operation::hash(hash_t::sha256, data)));
+
+        // a single operation in the worker, 2 in the ring, the rest inline
+        const auto ds = d.stats();
+        REQUIRE(ds.submitted <= 3);
+        REQUIRE(ds.fallbacks >= 7);
+        REQUIRE(ds.inline_runs == ds.fallbacks);
+        REQUIRE(card->stats().rejected == ds.fallbacks);
+
+        gate->open();
+        size_t offloaded = 0;
+        for (auto& f : futures) {
+            const auto r = f.get();
+            REQUIRE(r.output == hash::make(hash_t::sha256, data));
+            if (std::string{r.provider} == "offload")
+                ++offloaded;
+        }
+        REQUIRE(offloaded == ds.submitted);
+    }
+
+    SECTION("errors through the futures") {
+        auto      card = std::make_shared<offload_provider>();
+        dispatcher d;
+        d.add(card);
+
+        const auto key = rnd.make(32);
+        auto       bad = d.async(operation::encrypt(
+            cipher_t::aes_256_cbc, padding_t::pkcs7, "", "short", "data"));
+        REQUIRE_THROWS(bad.get());
+        REQUIRE_THROWS(d.run(operation::hmac(hash_t::none, key, "data")));
+
+        std::vector<operation> ops;
+        ops.push_back(operation::hash(hash_t::sha256, "data"));
+        ops.push_back(operation::encrypt(
+            cipher_t::aes_256_cbc, padding_t::pkcs7, "", "short", "data"));
+        auto results = d.run_many(std::move(ops));
+        REQUIRE_FALSE(results[0].error);
+        REQUIRE(results[1].error);
+    }
+}
+
+TEST_CASE("provider resolution", "[provider]") {
+    dispatcher d;
+    auto       card = std::make_shared<offload_provider>();
+    d.add(card).add(std::make_shared<sha256_card>());
+    REQUIRE_THROWS(d.add(nullptr));
+
+    const auto sha256 = operation::hash(hash_t::sha256, "message");
+    const auto sha1   = operation::hash(hash_t::sha1, "message");
+    REQUIRE(std::string{d.resolve(sha256).name()} == "sha256 card");
+    REQUIRE(std::string{d.resolve(sha1).name()} == "offload");
+    REQUIRE(d.run(sha256).output == "digest");
+    REQUIRE(d.run(sha1).output == hash::make(hash_t::sha1, "message"));
+
+    dispatcher plain;
+    REQUIRE(std::string{plain.resolve(sha256).name()} == "builtin");
+    REQUIRE(std::string{plain.run(sha256).provider} == "builtin");
+}
+
+TEST_CASE("offload provider benchmark", "[.][bench][provider]") {
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    rnd_generator rnd;
+    const auto    ops = mixed_operations(rnd, 20000);
+
+    auto start = clock_type::now();
+    for (const auto& op : ops)
+        builtin_provider()->run(op);
+    const auto serial = seconds(clock_type::now() - start).count();
+    std::printf(
+        "%zu mixed operations\n  inline        %8.1f kops/s\n",
+        ops.size(),
+        ops.size() / serial / 1000);
+
+    for (size_t workers : {1, 2, 4, 8}) {
+        for (size_t batch : {1, 16}) {
+            offload_provider::options opt;
+            opt.workers    = workers;
+            opt.batch_size = batch;
+            dispatcher d;
+            d.add(std::make_shared<offload_provider>(opt));
+
+            auto copy = ops;
+            start     = clock_type::now();
+            d.run_many(std::move(copy));
+            const auto elapsed = seconds(clock_type::now() - start).count();
+            std::printf(
+                "  %zu workers, batches of %2zu: %8.1f kops/s (%zu inline)\n",
+                workers,
+                batch,
+                ops.size() / elapsed / 1000,
+                d.stats().inline_runs);
+        }
+    }
+}
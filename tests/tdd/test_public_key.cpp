@@ -0,0 +1,198 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/public_key.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/x509.hpp"
+#include "pk_common.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+
+#include <cstdio>
+#include <vector>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+/// bytes in use on the heap, or 0 if not supported on this platform
+size_t
+heap_in_use() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2().uordblks;
+#elif defined(__GLIBC__)
+    return static_cast<size_t>(mallinfo().uordblks);
+#else
+    return 0;
+#endif
+}
+
+/// average heap bytes of a key made by make()
+template <class Maker>
+size_t
+bytes_per_key(size_t count, Maker&& make) {
+    using key_t = decltype(make());
+    std::vector<key_t> keys;
+    keys.reserve(count);
+
+    const size_t before = heap_in_use();
+    for (size_t i = 0; i < count; ++i)
+        keys.push_back(make());
+    const size_t after = heap_in_use();
+    return (after - before) / count + sizeof(key_t);
+}
+
+void
+print_density(const char* name, size_t full, size_t slim) {
+    constexpr double MB = 1024. * 1024.;
+    std::printf(
+        "  %-16s full %6zu bytes/key (%6.0f keys/MB), slim %5zu bytes/key "
+        "(%6.0f keys/MB), x%.1f\n",
+        name,
+        full,
+        MB / full,
+        slim,
+        MB / slim,
+        double(full) / slim);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("slim public key", "[pk]") {
+    using namespace mbedcrypto;
+
+    SECTION("empty") {
+        public_key pub;
+        REQUIRE(pub.empty());
+        REQUIRE(pub.key_bitlen() == 0);
+        REQUIRE(pub.type() == pk_t::none);
+        REQUIRE_THROWS(pub.verify("sig", "hash", hash_t::sha1));
+        REQUIRE_THROWS(pub.encrypt("data"));
+        REQUIRE_THROWS(pub.import("not a key"));
+        REQUIRE(pub.empty());
+    }
+
+    SECTION("rsa verify and encrypt") {
+        std::string message{test::long_text()};
+        const auto  signature = test::long_text_signature();
+
+        public_key pub{test::rsa_public_key()};
+        REQUIRE_FALSE(pub.empty());
+        REQUIRE(pub.type() == pk_t::rsa);
+        REQUIRE(test::icompare(pub.name(), "RSA"));
+        REQUIRE(pub.key_bitlen() == 2048);
+        REQUIRE(pub.max_crypt_size() == pub.key_length() - 11);
+        REQUIRE(pub.can_do(pk_t::rsa));
+        REQUIRE_FALSE(pub.can_do(pk_t::ecdsa));
+
+        REQUIRE(pub.verify_message(signature, message, hash_t::sha1));
+        REQUIRE(pub.verify(signature, to_sha1(message), hash_t::sha1));
+        REQUIRE_FALSE(pub.verify_message(signature, "other", hash_t::sha1));
+        REQUIRE_THROWS(pub.verify(signature, message, hash_t::sha1));
+
+        rsa pri;
+        pri.import_key(test::rsa_private_key());
+        const std::string plain{"a secret to the owner of the key"};
+        REQUIRE(pri.decrypt(pub.encrypt(plain)) == plain);
+
+        rnd_generator rnd;
+        REQUIRE(pri.decrypt(pub.encrypt(plain, rnd)) == plain);
+        REQUIRE_THROWS(pub.encrypt(std::string(pub.key_length(), 'x')));
+
+        // the public part of a private key
+        public_key slim{pri};
+        REQUIRE(slim.key_bitlen() == 2048);
+        REQUIRE(slim.verify_message(signature, message, hash_t::sha1));
+        REQUIRE(pri.decrypt(slim.encrypt(plain)) == plain);
+
+        // move
+        public_key moved{std::move(slim)};
+        REQUIRE(moved.verify_message(signature, message, hash_t::sha1));
+
+        rsa empty;
+        REQUIRE_THROWS(moved.assign(empty));
+    }
+
+    if (supports(pk_t::ecdsa) && supports(features::ec_keygen)) {
+        SECTION("ecdsa verify") {
+            ecdsa pri;
+            pri.generate_key(curve_t::secp256r1);
+            const std::string message{"the message to be signed"};
+            auto signature = pri.sign_message(message, hash_t::sha256);
+
+            public_key pub{pri};
+            REQUIRE(pub.can_do(pk_t::ecdsa));
+            REQUIRE(pub.key_bitlen() == 256);
+            REQUIRE(pub.verify_message(signature, message, hash_t::sha256));
+            REQUIRE_FALSE(
+                pub.verify_message(signature, "other", hash_t::sha256));
+            // ec keys do not encrypt
+            REQUIRE_THROWS(pub.encrypt("data"));
+
+            if (supports(features::pk_export)) {
+                public_key parsed{pri.export_public_key(pk::pem_format)};
+                REQUIRE(
+                    parsed.verify_message(signature, message, hash_t::sha256));
+            }
+        }
+    }
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+    SECTION("from a certificate") {
+        x509_cert leaf;
+        leaf.import(test::x509_leaf());
+
+        public_key pub;
+        leaf.public_key(pub);
+        REQUIRE(pub.type() == pk_t::rsa);
+
+        rsa pri;
+        pri.import_key(test::rsa_private_key());
+        auto sig = pri.sign_message(test::long_text(), hash_t::sha1);
+        REQUIRE(pub.verify_message(sig, test::long_text(), hash_t::sha1));
+    }
+#endif // MBEDTLS_X509_CRT_PARSE_C
+}
+
+TEST_CASE("slim public key memory", "[.][bench][pk]") {
+    using namespace mbedcrypto;
+
+    constexpr size_t Count = 2000;
+
+    if (heap_in_use() == 0) {
+        std::printf("slim public key: heap statistics are not available\n");
+        return;
+    }
+
+    std::printf(
+        "slim public key: heap bytes per cached key (%zu keys)\n", Count);
+
+    const auto rsa_pem = test::rsa_public_key();
+    auto full_rsa = bytes_per_key(Count, [&rsa_pem]() {
+        auto key = std::make_unique<rsa>();
+        key->import_public_key(rsa_pem);
+        return key;
+    });
+    auto slim_rsa = bytes_per_key(Count, [&rsa_pem]() {
+        return std::make_unique<public_key>(rsa_pem);
+    });
+    print_density("rsa 2048", full_rsa, slim_rsa);
+
+    if (supports(features::ec_keygen) && supports(features::pk_export)) {
+        ecdsa source;
+        source.generate_key(curve_t::secp256r1);
+        const auto ec_pem = source.export_public_key(pk::pem_format);
+
+        auto full_ec = bytes_per_key(Count, [&ec_pem]() {
+            auto key = std::make_unique<ecdsa>();
+            key->import_public_key(ec_pem);
+            return key;
+        });
+        auto slim_ec = bytes_per_key(Count, [&ec_pem]() {
+            return std::make_unique<public_key>(ec_pem);
+        });
+        print_density("ecdsa secp256r1", full_ec, slim_ec);
+    }
+}
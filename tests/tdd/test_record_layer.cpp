@@ -0,0 +1,186 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/record_layer.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("record layer", "[cipher]") {
+    using namespace mbedcrypto;
+    if (!supports(cipher_bm::gcm))
+        return;
+    using status = record_layer::status;
+
+    rnd_generator rnd;
+    const auto    key = rnd.make(16);
+    const auto    iv  = rnd.make(record_layer::iv_size);
+
+    record_layer tx{cipher_t::aes_128_gcm};
+    record_layer rx{cipher_t::aes_128_gcm, 0x0303, 128};
+    tx.key(key, iv);
+    rx.key(key, iv);
+
+    std::vector<buffer_t> payloads;
+    std::vector<buffer_t> records;
+    for (size_t i = 0; i < 300; ++i) {
+        payloads.push_back(rnd.make(i * 3));
+        records.push_back(tx.seal(23, payloads.back()));
+    }
+    REQUIRE(tx.next_sequence() == 300);
+    buffer_t output(1024, '\0');
+    auto     open = [&rx, &output](const buffer_t& record) {
+        return rx.open(record, to_ptr(output)).result;
+    };
+
+    SECTION("compatibility") {
+        // the same as the single shot aead, by the header as additional data
+        const auto& rec   = records[5];
+        buffer_t    nonce = iv;
+        nonce.back() ^= 5;
+        const auto result = cipher::decrypt_aead(
+            cipher_t::aes_128_gcm,
+            nonce,
+            key,
+            rec.substr(0, record_layer::header_size),
+            rec.substr(rec.size() - record_layer::tag_size),
+            rec.substr(
+                record_layer::header_size,
+                rec.size() - record_layer::overhead));
+        REQUIRE(std::get<0>(result));
+        REQUIRE(std::get<1>(result) == payloads[5]);
+    }
+
+    SECTION("replay window") {
+        for (size_t i = 0; i < 10; ++i) {
+            const auto r = rx.open(records[i], to_ptr(output));
+            REQUIRE(r.result == status::ok);
+            REQUIRE(r.type == 23);
+            REQUIRE(r.sequence == i);
+            REQUIRE(output.substr(0, r.size) == payloads[i]);
+        }
+        REQUIRE(open(records[3]) == status::replayed);
+
+        // a jump, then the reordered records inside the window
+        REQUIRE(open(records[200]) == status::ok);
+        REQUIRE(open(records[100]) == status::ok);
+        REQUIRE(open(records[100]) == status::replayed);
+        REQUIRE(open(records[50]) == status::replayed);
+
+        // a forged record does not enter the window
+        auto forged = records[201];
+        forged[record_layer::header_size] ^= 0x01;
+        REQUIRE(open(forged) == status::forged);
+        REQUIRE(open(records[201]) == status::ok);
+
+        auto truncated = records[202];
+        truncated.pop_back();
+        REQUIRE(open(truncated) == status::malformed);
+
+        // in place
+        auto rec = records[203];
+        auto r   = rx.open(rec, to_ptr(rec) + record_layer::header_size);
+        REQUIRE(r.result == status::ok);
+        REQUIRE(
+            rec.substr(record_layer::header_size, r.size) == payloads[203]);
+    }
+
+    SECTION("batch sealing") {
+        std::vector<buffer_view_t> views;
+        size_t                     total = 0;
+        for (const auto& p : payloads) {
+            views.emplace_back(p);
+            total += record_layer::sealed_size(p.size());
+        }
+        record_layer batch{cipher_t::aes_128_gcm};
+        batch.key(key, iv);
+        buffer_t stream(total, '\0');
+        REQUIRE(batch.seal_many(23, views, to_ptr(stream)) == total);
+
+        // splits the stream by the headers
+        size_t offset = 0;
+        for (size_t i = 0; i < records.size(); ++i) {
+            const auto size = record_layer::record_size(
+                buffer_view_t{to_const_ptr(stream) + offset, total - offset});
+            REQUIRE(stream.substr(offset, size) == records[i]);
+            offset += size;
+        }
+        REQUIRE(offset == total);
+    }
+
+    SECTION("usage errors") {
+        REQUIRE_THROWS(record_layer{cipher_t::aes_128_cbc});
+        record_layer rl{cipher_t::aes_128_gcm};
+        REQUIRE_THROWS(rl.seal(23, payloads[1]));  // no key
+        REQUIRE_THROWS(rl.key(key, rnd.make(16))); // invalid iv
+        rl.key(key, iv);
+        REQUIRE_THROWS(rl.seal(23, buffer_t(0x10000, 'x')));
+        REQUIRE(record_layer::record_size(buffer_view_t{"short"}) == 0);
+    }
+}
+
+TEST_CASE("record layer benchmark", "[.][bench][cipher]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    if (!supports(cipher_bm::gcm))
+        return;
+
+    constexpr size_t Records = 100000;
+
+    rnd_generator rnd;
+    const auto    key = rnd.make(16);
+    const auto    iv  = rnd.make(record_layer::iv_size);
+
+    auto report = [](const char* name, size_t size, clock_type::duration d) {
+        using seconds = std::chrono::duration<double>;
+        std::printf(
+            "  %-22s %5zu bytes: %10.0f records/s\n",
+            name,
+            size,
+            Records / seconds(d).count());
+    };
+
+    std::printf("record layer, aes-128-gcm, %zu records\n", Records);
+    for (size_t size : {64, 512, 1400, 16384}) {
+        const auto payload = rnd.make(size);
+        buffer_t   wire(record_layer::sealed_size(size), '\0');
+        buffer_t   plain(size, '\0');
+
+        // the per record apis: a key setup and allocations per record
+        buffer_t nonce = iv;
+        auto     start = clock_type::now();
+        for (size_t i = 0; i < Records; ++i) {
+            nonce.back() = static_cast<char>(i);
+            cipher::encrypt_aead(
+                cipher_t::aes_128_gcm, nonce, key, iv, payload);
+        }
+        report("cipher::encrypt_aead", size, clock_type::now() - start);
+
+        record_layer tx{cipher_t::aes_128_gcm};
+        record_layer rx{cipher_t::aes_128_gcm};
+        tx.key(key, iv);
+        rx.key(key, iv);
+        start = clock_type::now();
+        for (size_t i = 0; i < Records; ++i)
+            tx.seal(23, payload, to_ptr(wire));
+        report("record_layer::seal", size, clock_type::now() - start);
+
+        // only the opening is timed, each record is sealed just before
+        tx.key(key, iv);
+        clock_type::duration total{};
+        for (size_t i = 0; i < Records; ++i) {
+            tx.seal(23, payload, to_ptr(wire));
+            start = clock_type::now();
+            rx.open(wire, to_ptr(plain));
+            total += clock_type::now() - start;
+        }
+        report("record_layer::open", size, total);
+
+        std::vector<buffer_view_t> batch(64, payload);
+        buffer_t stream(batch.size() * record_layer::sealed_size(size), '\0');
+        start = clock_type::now();
+        for (size_t i = 0; i < Records; i += batch.size())
+            tx.seal_many(23, batch, to_ptr(stream));
+        report("record_layer::seal_many", size, clock_type::now() - start);
+    }
+}
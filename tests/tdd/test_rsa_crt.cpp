@@ -0,0 +1,177 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "mbedcrypto/tuning.hpp"
+#include "pk_common.hpp"
+#include "../../src/fixed_base.hpp"
+#include "../../src/pk_private.hpp"
+#include "../../src/rsa_crt.hpp"
+
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+/// a random odd modulus of bits
+buffer_t
+make_modulus(rnd_generator& rnd, size_t bits) {
+    auto m = rnd.make(bits / 8);
+    m[0] |= 0x80;
+    m.back() |= 0x01;
+    return m;
+}
+
+/// a ^ e mod m, by the given crossovers
+buffer_t
+power_of(
+    const buffer_t&      m,
+    const buffer_t&      a,
+    const buffer_t&      e,
+    const mul_crossover& x) {
+    const mont_modulus                mod{m, x};
+    std::vector<mont_modulus::limb_t> r(mod.limbs());
+    mod.reduce(r.data(), a);
+    mod.power(r.data(), r.data(), e);
+    buffer_t out(mod.size(), '\0');
+    mod.from_mont(to_ptr(out), r.data());
+    return out;
+}
+
+/// the generic RSA of mbedtls
+buffer_t
+generic_sign(rsa& key, const buffer_t& hvalue, hash_t halgo) {
+    auto&    d = key.context();
+    size_t   olen = 0;
+    buffer_t output(key.max_crypt_size(), '\0');
+    mbedtls_pk_sign(
+        &d.pk_,
+        to_native(halgo),
+        to_const_ptr(hvalue),
+        hvalue.size(),
+        to_ptr(output),
+        &olen,
+        rnd_generator::maker,
+        &d.rnd_);
+    output.resize(olen);
+    return output;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("mont products", "[rsa][tuning]") {
+    using namespace mbedcrypto;
+
+    // the schoolbook, Karatsuba and Toom-3 products must match
+    const mul_crossover basecase{257, 257};
+    const mul_crossover karatsuba{16, 257};
+    const mul_crossover toom3{8, 24};
+
+    rnd_generator rnd;
+    for (size_t bits : {1024, 2112, 4096, 6208, 8192}) {
+        const auto m = make_modulus(rnd, bits);
+        const auto a = rnd.make(bits / 4 - 1); // less than m * R
+        const auto e = rnd.make(40);
+
+        const auto expected = power_of(m, a, e, basecase);
+        REQUIRE(power_of(m, a, e, karatsuba) == expected);
+        REQUIRE(power_of(m, a, e, toom3) == expected);
+    }
+
+    const auto x = measure_mul_crossover();
+    REQUIRE(x.karatsuba >= 8);
+    REQUIRE(x.toom3 >= x.karatsuba);
+}
+
+TEST_CASE("rsa crt", "[pk][rsa]") {
+    using namespace mbedcrypto;
+    if (!supports(features::rsa_keygen))
+        return;
+
+    rsa key;
+    key.generate_key(4096);
+    REQUIRE(key.key_bitlen() == 4096);
+    auto& native = *mbedtls_pk_rsa(key.context().pk_);
+    REQUIRE(mbedtls_rsa_check_privkey(&native) == 0);
+
+    // PKCS#1 v1.5 is deterministic, the same signatures as mbedtls
+    const auto original = tuning::current();
+    auto       small    = original;
+    small.karatsuba_limbs = 8;
+    small.toom3_limbs     = 16;
+    for (const auto& t : {original, small}) {
+        tuning::set_thresholds(t);
+        for (auto halgo : {hash_t::sha1, hash_t::sha256, hash_t::sha512}) {
+            const auto hvalue = hash::make(halgo, "mbedcrypto rsa crt");
+            REQUIRE(rsa_crt::can_sign(native, to_native(halgo), hvalue));
+
+            const auto sig = key.sign(hvalue, halgo);
+            REQUIRE(sig == generic_sign(key, hvalue, halgo));
+            REQUIRE(key.verify(sig, hvalue, halgo));
+
+            auto other = hvalue;
+            other[0] ^= 0x01;
+            REQUIRE_FALSE(key.verify(sig, other, halgo));
+        }
+    }
+    tuning::set_thresholds(original);
+
+    // a hash value of another size, and the smaller keys are left to mbedtls
+    REQUIRE_FALSE(rsa_crt::can_sign(
+        native, MBEDTLS_MD_SHA256, hash::make(hash_t::sha1, "text")));
+    REQUIRE_FALSE(rsa_crt::can_generate(2048, 65537));
+    REQUIRE_FALSE(rsa_crt::can_generate(4097, 65537));
+    REQUIRE_FALSE(rsa_crt::can_generate(4096, 65536));
+
+    rsa legacy;
+    legacy.import_key(test::rsa_private_key());
+    REQUIRE_FALSE(rsa_crt::can_sign(
+        *mbedtls_pk_rsa(legacy.context().pk_),
+        MBEDTLS_MD_SHA256,
+        hash::make(hash_t::sha256, "text")));
+}
+
+TEST_CASE("rsa crt benchmark", "[.][bench][rsa]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+    if (!supports(features::rsa_keygen))
+        return;
+
+    const auto x = tuning::current();
+    std::printf(
+        "rsa, crossovers: karatsuba %zu, toom-3 %zu limbs\n",
+        x.karatsuba_limbs,
+        x.toom3_limbs);
+
+    for (size_t bits : {4096, 8192, 16384}) {
+        rsa  key;
+        auto start = clock_type::now();
+        key.generate_key(bits);
+        const auto keygen = seconds(clock_type::now() - start).count();
+
+        const auto   hvalue = hash::make(hash_t::sha256, "benchmark");
+        const size_t rounds = 32768 / bits;
+        start               = clock_type::now();
+        for (size_t i = 0; i < rounds; ++i)
+            key.sign(hvalue, hash_t::sha256);
+        const auto fast = seconds(clock_type::now() - start).count();
+
+        start = clock_type::now();
+        for (size_t i = 0; i < rounds; ++i)
+            generic_sign(key, hvalue, hash_t::sha256);
+        const auto generic = seconds(clock_type::now() - start).count();
+
+        std::printf(
+            "  %5zu bits: keygen %7.2f s, sign %8.1f ms, mbedtls %8.1f ms\n",
+            bits,
+            keygen,
+            1000 * fast / rounds,
+            1000 * generic / rounds);
+    }
+}
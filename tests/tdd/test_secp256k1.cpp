@@ -0,0 +1,270 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/ecp.hpp"
+#include "mbedcrypto/hash.hpp"
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/secp256k1.hpp"
+#include "mbedcrypto/tcodec.hpp"
+#include "../../src/pk_private.hpp"
+
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+// the samples of BIP340
+struct sample_t {
+    const char* secret_key;
+    const char* public_key;
+    const char* aux_random;
+    const char* message;
+    const char* signature;
+};
+
+const sample_t Samples[] = {
+    {"0000000000000000000000000000000000000000000000000000000000000003",
+     "f9308a019258c31049344f85f89d5229b531c845836f99b08601f113bce036f9",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "e907831f80848d1069a5371b402410364bdf1c5f8307b0084c55f1ce2dca8215"
+     "25f66a4a85ea8b71e482a74f382d2ce5ebeee8fdb2172f477df4900d310536c0"},
+    {"b7e151628aed2a6abf7158809cf4f3c762e7160f38b4da56a784d9045190cfef",
+     "dff1d77f2a671c5f36183726db2341be58feae1da2deced843240f7b502ba659",
+     "0000000000000000000000000000000000000000000000000000000000000001",
+     "243f6a8885a308d313198a2e03707344a4093822299f31d0082efa98ec4e6c89",
+     "6896bd60eeae296db48a229ff71dfe071bde413e6d43f917dc8dcf8c78de3341"
+     "8906d11ac976abccb20b091292bff4ea897efcb639ea871cfa95f6de339e4b0a"},
+};
+
+struct signed_t {
+    buffer_t public_key;
+    buffer_t message;
+    buffer_t signature;
+};
+
+std::vector<signed_t>
+make_signed(rnd_generator& rnd, size_t count) {
+    std::vector<signed_t> result;
+    for (size_t i = 0; i < count; ++i) {
+        auto secret = rnd.make(32);
+        secret[0] &= 0x7f; // less than n
+        auto message = rnd.make(i % 70);
+        result.push_back(
+            {secp256k1::schnorr_public_key(secret),
+             message,
+             secp256k1::schnorr_sign(secret, message, rnd.make(32))});
+    }
+    return result;
+}
+
+std::vector<secp256k1::schnorr_item>
+items_of(const std::vector<signed_t>& all) {
+    std::vector<secp256k1::schnorr_item> items;
+    for (const auto& s : all)
+        items.push_back({s.public_key, s.message, s.signature});
+    return items;
+}
+
+#if defined(MBEDTLS_ECP_C)
+/// the uncompressed SEC1 point of an ec key
+buffer_t
+point_of(const ecp& key) {
+    const auto* ec = mbedtls_pk_ec(key.context().pk_);
+    buffer_t    point(65, '\0');
+    size_t      size = 0;
+    mbedtls_ecp_point_write_binary(
+        &ec->grp,
+        &ec->Q,
+        MBEDTLS_ECP_PF_UNCOMPRESSED,
+        &size,
+        to_ptr(point),
+        point.size());
+    point.resize(size);
+    return point;
+}
+
+/// the generic ECDSA of mbedtls
+bool
+generic_verify(ecp& key, const buffer_t& hvalue, const buffer_t& sig) {
+    return mbedtls_pk_verify(
+               &key.context().pk_,
+               MBEDTLS_MD_SHA256,
+               to_const_ptr(hvalue),
+               hvalue.size(),
+               to_const_ptr(sig),
+               sig.size()) == 0;
+}
+#endif // MBEDTLS_ECP_C
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("secp256k1 schnorr samples", "[secp256k1]") {
+    using namespace mbedcrypto;
+
+    for (const auto& s : Samples) {
+        const auto secret  = from_hex(s.secret_key);
+        const auto pub     = from_hex(s.public_key);
+        const auto message = from_hex(s.message);
+        const auto sig     = from_hex(s.signature);
+
+        REQUIRE(secp256k1::schnorr_public_key(secret) == pub);
+        REQUIRE(
+            secp256k1::schnorr_sign(secret, message, from_hex(s.aux_random)) ==
+            sig);
+        REQUIRE(secp256k1::schnorr_verify(pub, message, sig));
+
+        // a modified R, s or message
+        for (size_t i : {3, 40}) {
+            auto bad = sig;
+            bad[i] ^= 0x01;
+            REQUIRE_FALSE(secp256k1::schnorr_verify(pub, message, bad));
+        }
+        auto other = message;
+        other[0] ^= 0x01;
+        REQUIRE_FALSE(secp256k1::schnorr_verify(pub, other, sig));
+    }
+
+    const auto& s       = Samples[1];
+    const auto  message = from_hex(s.message);
+    const auto  sig     = from_hex(s.signature);
+    // a public key not on the curve
+    REQUIRE_FALSE(secp256k1::schnorr_verify(
+        from_hex("eefdea4cdb677750a420fee807eacf21"
+                 "eb9898ae79b9768766e4faa04a2d4a34"),
+        message,
+        sig));
+    // r = p, s = n
+    auto bad = sig;
+    bad.replace(0, 32, from_hex("ffffffffffffffffffffffffffffffff"
+                                "fffffffffffffffffffffffefffffc2f"));
+    const auto pub = from_hex(s.public_key);
+    REQUIRE_FALSE(secp256k1::schnorr_verify(pub, message, bad));
+    bad = sig;
+    bad.replace(32, 32, from_hex("ffffffffffffffffffffffffffffffff"
+                                 "baaedce6af48a03bbfd25e8cd0364141"));
+    REQUIRE_FALSE(secp256k1::schnorr_verify(pub, message, bad));
+    // sizes
+    REQUIRE_FALSE(secp256k1::schnorr_verify(pub, message, sig.substr(0, 63)));
+    REQUIRE_FALSE(secp256k1::schnorr_verify(pub + "x", message, sig));
+    REQUIRE_THROWS(secp256k1::schnorr_sign(
+        buffer_t(32, '\0'), message, buffer_t(32, '\0')));
+    REQUIRE_THROWS(secp256k1::schnorr_sign(
+        from_hex(s.secret_key), message, buffer_t(31, '\0')));
+}
+
+TEST_CASE("secp256k1 schnorr batches", "[secp256k1]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+    const auto    all   = make_signed(rnd, 150); // more than a chunk
+    auto          items = items_of(all);
+    for (const auto& s : all)
+        REQUIRE(
+            secp256k1::schnorr_verify(s.public_key, s.message, s.signature));
+    REQUIRE(secp256k1::schnorr_verify_batch(items, rnd));
+    REQUIRE(secp256k1::schnorr_verify_batch({}, rnd));
+
+    // a single invalid item fails the batch
+    auto bad = all[137].signature;
+    bad[50] ^= 0x04;
+    items[137].signature = bad;
+    REQUIRE_FALSE(secp256k1::schnorr_verify_batch(items, rnd));
+    items[137].signature = all[137].signature;
+    items[20].message    = all[21].message;
+    REQUIRE_FALSE(secp256k1::schnorr_verify_batch(items, rnd));
+}
+
+TEST_CASE("secp256k1 ecdsa", "[secp256k1]") {
+    using namespace mbedcrypto;
+#if defined(MBEDTLS_ECP_C)
+    if (!supports(features::ec_keygen) || !supports(pk_t::ecdsa))
+        return;
+
+    rnd_generator rnd;
+    for (size_t i = 0; i < 20; ++i) {
+        ecdsa key;
+        key.generate_key(curve_t::secp256k1);
+        const auto hvalue = rnd.make(32);
+        const auto sig    = key.sign(hvalue, hash_t::sha256);
+        const auto point  = point_of(key);
+
+        // the same as the generic mbedtls code
+        REQUIRE(generic_verify(key, hvalue, sig));
+        REQUIRE(key.verify(sig, hvalue, hash_t::sha256));
+        REQUIRE(secp256k1::ecdsa_verify(point, hvalue, sig));
+
+        auto other = hvalue;
+        other[5] ^= 0x01;
+        REQUIRE_FALSE(generic_verify(key, other, sig));
+        REQUIRE_FALSE(key.verify(sig, other, hash_t::sha256));
+
+        auto bad = sig;
+        bad[bad.size() - 3] ^= 0x01;
+        REQUIRE_FALSE(key.verify(bad, hvalue, hash_t::sha256));
+        REQUIRE_FALSE(secp256k1::ecdsa_verify(point, hvalue, sig + "x"));
+        REQUIRE_FALSE(secp256k1::ecdsa_verify(
+            point.substr(0, 33), hvalue, sig)); // not a point encoding
+    }
+#endif // MBEDTLS_ECP_C
+}
+
+TEST_CASE("secp256k1 benchmark", "[.][bench][secp256k1]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    constexpr size_t Count = 2000;
+
+    rnd_generator rnd;
+    const auto    all   = make_signed(rnd, Count);
+    const auto    items = items_of(all);
+
+    auto start = clock_type::now();
+    for (const auto& s : all)
+        secp256k1::schnorr_verify(s.public_key, s.message, s.signature);
+    const auto single = seconds(clock_type::now() - start).count();
+
+    start            = clock_type::now();
+    const bool valid = secp256k1::schnorr_verify_batch(items, rnd);
+    const auto batch = seconds(clock_type::now() - start).count();
+    REQUIRE(valid);
+
+    std::printf(
+        "secp256k1, %zu signatures\n"
+        "  schnorr verify       %8.0f verifies/s\n"
+        "  schnorr batch        %8.0f verifies/s\n",
+        Count,
+        Count / single,
+        Count / batch);
+
+#if defined(MBEDTLS_ECP_C)
+    if (!supports(features::ec_keygen) || !supports(pk_t::ecdsa))
+        return;
+    ecdsa key;
+    key.generate_key(curve_t::secp256k1);
+    const auto hvalue = rnd.make(32);
+    const auto sig    = key.sign(hvalue, hash_t::sha256);
+    const auto point  = point_of(key);
+
+    constexpr size_t Rounds = 500;
+    start                   = clock_type::now();
+    for (size_t i = 0; i < Rounds; ++i)
+        generic_verify(key, hvalue, sig);
+    const auto generic = seconds(clock_type::now() - start).count();
+
+    start = clock_type::now();
+    for (size_t i = 0; i < Rounds; ++i)
+        secp256k1::ecdsa_verify(point, hvalue, sig);
+    const auto fast = seconds(clock_type::now() - start).count();
+
+    std::printf(
+        "  ecdsa, mbedtls       %8.0f verifies/s\n"
+        "  ecdsa, glv           %8.0f verifies/s\n",
+        Rounds / generic,
+        Rounds / fast);
+#endif // MBEDTLS_ECP_C
+}
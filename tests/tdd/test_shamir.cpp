@@ -0,0 +1,222 @@
+#include <catch2/catch.hpp>
+
+#include "mbedcrypto/rnd_generator.hpp"
+#include "mbedcrypto/shamir.hpp"
+#include "src/cpu_features.hpp"
+#include "src/gf256.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+/// the schoolbook product, by the AES polynomial
+uint8_t
+slow_mul(uint8_t a, uint8_t b) {
+    uint8_t r = 0;
+    for (; b != 0; b >>= 1) {
+        if (b & 1)
+            r ^= a;
+        a = static_cast<uint8_t>((a << 1) ^ ((a & 0x80) ? 0x1b : 0));
+    }
+    return r;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("gf256 kernels", "[shamir]") {
+    using namespace mbedcrypto;
+
+    for (int a = 0; a < 256; ++a) {
+        for (int b = 0; b < 256; ++b)
+            REQUIRE(gf256::mul(uint8_t(a), uint8_t(b)) == slow_mul(a, b));
+        if (a != 0)
+            REQUIRE(gf256::mul(uint8_t(a), gf256::inverse(uint8_t(a))) == 1);
+    }
+
+    std::vector<gf256::mul_xor_t> kernels{gf256::mul_xor_portable};
+    if (cpu::has_ssse3())
+        kernels.push_back(gf256::mul_xor_ssse3);
+    if (cpu::has_avx2())
+        kernels.push_back(gf256::mul_xor_avx2);
+
+    rnd_generator rnd;
+    for (size_t n : {0, 1, 7, 8, 15, 16, 17, 33, 64, 65, 1000}) {
+        const auto a = rnd.make(n);
+        const auto b = rnd.make(n);
+        for (int c : {0, 1, 2, 0x53, 0xff}) {
+            buffer_t expected(n, '\0');
+            for (size_t i = 0; i < n; ++i)
+                expected[i] = static_cast<char>(
+                    slow_mul(uint8_t(a[i]), uint8_t(c)) ^ uint8_t(b[i]));
+
+            for (auto kernel : kernels) {
+                buffer_t out(n, '\0');
+                kernel(
+                    to_ptr(out),
+                    to_const_ptr(a),
+                    uint8_t(c),
+                    to_const_ptr(b),
+                    n);
+                REQUIRE(out == expected);
+                // in place
+                out = a;
+                kernel(
+                    to_ptr(out), to_ptr(out), uint8_t(c), to_const_ptr(b), n);
+                REQUIRE(out == expected);
+            }
+        }
+    }
+}
+
+TEST_CASE("shamir secret sharing", "[shamir]") {
+    using namespace mbedcrypto;
+
+    rnd_generator rnd;
+    const auto    secret = rnd.make(33);
+
+    SECTION("split and combine") {
+        for (size_t threshold = 2; threshold <= 5; ++threshold) {
+            auto shares = shamir::split(secret, threshold, 7, rnd);
+            REQUIRE(shares.size() == 7);
+            for (size_t i = 0; i < shares.size(); ++i) {
+                REQUIRE(shares[i].size() == secret.size() + 1);
+                REQUIRE(uint8_t(shares[i][0]) == i + 1);
+            }
+
+            // any threshold (or more) shares, in any order
+            std::reverse(shares.begin(), shares.end());
+            std::vector<buffer_t> some(
+                shares.begin(), shares.begin() + threshold);
+            REQUIRE(shamir::combine(some) == secret);
+            REQUIRE(shamir::combine(shares) == secret);
+
+            // fewer shares give a wrong secret
+            if (threshold > 2) {
+                some.pop_back();
+                REQUIRE(shamir::combine(some) != secret);
+            }
+        }
+
+        // new coefficients per split
+        REQUIRE(shamir::split(secret, 2, 3, rnd) !=
+                shamir::split(secret, 2, 3, rnd));
+    }
+
+    SECTION("batches") {
+        std::vector<buffer_t>      secrets;
+        std::vector<buffer_view_t> views;
+        for (size_t i = 0; i < 40; ++i)
+            secrets.push_back(rnd.make(1 + i % 35));
+        for (const auto& s : secrets)
+            views.emplace_back(s);
+
+        const auto shares = shamir::split_many(views, 3, 5, rnd);
+        REQUIRE(shares.size() == secrets.size());
+
+        std::vector<std::vector<buffer_t>> sets;
+        for (size_t i = 0; i < secrets.size(); ++i) {
+            REQUIRE(shares[i].size() == 5);
+            REQUIRE(shares[i][0].size() == secrets[i].size() + 1);
+            REQUIRE(
+                shamir::combine({shares[i][4], shares[i][0], shares[i][2]}) ==
+                secrets[i]);
+            // the same custodians, except a single set
+            if (i == 7)
+                sets.push_back({shares[i][3], shares[i][1], shares[i][0]});
+            else
+                sets.push_back({shares[i][0], shares[i][1], shares[i][2]});
+        }
+        REQUIRE(shamir::combine_many(sets) == secrets);
+    }
+
+    SECTION("usage errors") {
+        REQUIRE_THROWS(shamir::split(secret, 1, 3, rnd));
+        REQUIRE_THROWS(shamir::split(secret, 4, 3, rnd));
+        REQUIRE_THROWS(shamir::split(secret, 2, 256, rnd));
+        REQUIRE_THROWS(shamir::split(buffer_t{}, 2, 3, rnd));
+
+        const auto shares = shamir::split(secret, 2, 3, rnd);
+        auto       short_share = shares[1];
+        short_share.pop_back();
+        auto zero_x = shares[1];
+        zero_x[0]   = '\0';
+        REQUIRE_THROWS(shamir::combine({shares[0]}));
+        REQUIRE_THROWS(shamir::combine({shares[0], shares[0]}));
+        REQUIRE_THROWS(shamir::combine({shares[0], short_share}));
+        REQUIRE_THROWS(shamir::combine({shares[0], zero_x}));
+        REQUIRE_THROWS(shamir::combine_many({{shares[0], short_share}}));
+    }
+}
+
+TEST_CASE("shamir benchmark", "[.][bench][shamir]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+    using seconds    = std::chrono::duration<double>;
+
+    constexpr size_t Keys = 4096;
+
+    rnd_generator rnd;
+    std::vector<buffer_t> keys;
+    for (size_t i = 0; i < Keys; ++i)
+        keys.push_back(rnd.make(32));
+
+    // the kernels, by a multiply and accumulate of 64KB
+    const auto input = rnd.make(64 * 1024);
+    buffer_t   acc(input.size(), '\0');
+    auto       kernel = [&](const char* name, gf256::mul_xor_t k) {
+        constexpr size_t Rounds = 2000;
+        const auto       start  = clock_type::now();
+        for (size_t i = 0; i < Rounds; ++i)
+            k(to_ptr(acc), to_const_ptr(input), 0x57, to_ptr(acc), acc.size());
+        const auto secs = seconds(clock_type::now() - start).count();
+        std::printf(
+            "  %-20s %8.2f GB/s\n",
+            name,
+            double(Rounds) * input.size() / secs / 1e9);
+    };
+    std::printf("gf(2^8) multiply-xor kernels\n");
+    kernel("portable", gf256::mul_xor_portable);
+    if (cpu::has_ssse3())
+        kernel("ssse3", gf256::mul_xor_ssse3);
+    if (cpu::has_avx2())
+        kernel("avx2", gf256::mul_xor_avx2);
+
+    std::printf("shamir, %zu keys of 32 bytes\n", Keys);
+    for (size_t threshold : {2, 3, 5}) {
+        const size_t count = threshold * 2 - 1;
+
+        auto start = clock_type::now();
+        for (const auto& k : keys)
+            shamir::split(k, threshold, count, rnd);
+        const auto single = seconds(clock_type::now() - start).count();
+
+        std::vector<buffer_view_t> views;
+        for (const auto& k : keys)
+            views.emplace_back(k);
+        start          = clock_type::now();
+        auto shares    = shamir::split_many(views, threshold, count, rnd);
+        const auto bat = seconds(clock_type::now() - start).count();
+
+        std::vector<std::vector<buffer_t>> sets;
+        for (auto& s : shares)
+            sets.emplace_back(s.begin(), s.begin() + threshold);
+        start           = clock_type::now();
+        shamir::combine_many(sets);
+        const auto comb = seconds(clock_type::now() - start).count();
+
+        std::printf(
+            "  %zu of %zu: split %9.0f shares/s, split_many %9.0f shares/s, "
+            "combine_many %8.0f keys/s\n",
+            threshold,
+            count,
+            Keys * count / single,
+            Keys * count / bat,
+            Keys / comb);
+    }
+}
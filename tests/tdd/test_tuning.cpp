@@ -0,0 +1,129 @@
+#include <catch2/catch.hpp>
+
+#include "generator.hpp"
+#include "mbedcrypto/tuning.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+bool
+is_pow2(size_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("tuning thresholds", "[tuning]") {
+    using namespace mbedcrypto;
+
+    // the sections change the thresholds of the process, restored below
+    const auto original      = tuning::current();
+    const auto original_path = tuning::cache_path();
+    const auto cache_file    = std::string{"./tuning_test.cache"};
+    std::remove(cache_file.c_str());
+    tuning::set_cache_path(cache_file);
+    REQUIRE(tuning::cache_path() == cache_file);
+
+    SECTION("defaults") {
+        // neither measured nor written by current()
+        tuning::thresholds loaded;
+        REQUIRE(tuning::current().pool_threads >= 1);
+        REQUIRE_FALSE(tuning::load(cache_file.c_str(), loaded));
+    }
+
+    SECTION("calibration") {
+        auto t = tuning::calibrate();
+        REQUIRE(tuning::origin() == tuning::origin_t::calibration);
+        REQUIRE(tuning::current() == t);
+
+        const size_t hw = std::max(1u, std::thread::hardware_concurrency());
+        REQUIRE(is_pow2(t.segment_size));
+        REQUIRE(t.segment_size <= t.parallel_min_bytes);
+        REQUIRE((is_pow2(t.parallel_min_bytes) || hw == 1));
+        REQUIRE(t.lanes >= 1);
+        REQUIRE(t.lanes <= 16);
+        REQUIRE(t.pool_threads >= 1);
+        REQUIRE(t.pool_threads <= hw);
+        REQUIRE(t.karatsuba_limbs >= 8);
+        REQUIRE(t.toom3_limbs >= t.karatsuba_limbs);
+
+        // persisted
+        tuning::thresholds loaded;
+        REQUIRE(tuning::load(cache_file.c_str(), loaded));
+        REQUIRE(loaded == t);
+    }
+
+    SECTION("save and load") {
+        tuning::thresholds t;
+        t.parallel_min_bytes = 4 * 1024 * 1024;
+        t.segment_size       = 512 * 1024;
+        t.lanes              = 8;
+        t.pool_threads       = 3;
+        t.karatsuba_limbs    = 40;
+        t.toom3_limbs        = 257;
+        tuning::save(cache_file.c_str(), t);
+
+        tuning::thresholds loaded;
+        REQUIRE(tuning::load(cache_file.c_str(), loaded));
+        REQUIRE(loaded == t);
+
+        // another version
+        test::dump_to_file(
+            "version=0\nparallel_min_bytes=1\nsegment_size=1\n"
+            "lanes=1\npool_threads=1\n",
+            cache_file.c_str());
+        REQUIRE_FALSE(tuning::load(cache_file.c_str(), loaded));
+        REQUIRE(loaded == t); // untouched
+
+        test::dump_to_file("not a cache file", cache_file.c_str());
+        REQUIRE_FALSE(tuning::load(cache_file.c_str(), loaded));
+        REQUIRE_FALSE(tuning::load("./no_such_tuning.cache", loaded));
+        REQUIRE_THROWS(tuning::save("", t));
+    }
+
+    SECTION("override") {
+        tuning::thresholds t;
+        t.lanes        = 2;
+        t.pool_threads = 2;
+        tuning::set_thresholds(t, true);
+        REQUIRE(tuning::origin() == tuning::origin_t::user);
+        REQUIRE(tuning::current() == t);
+
+        tuning::thresholds loaded;
+        REQUIRE(tuning::load(cache_file.c_str(), loaded));
+        REQUIRE(loaded == t);
+
+        t.lanes = 0;
+        REQUIRE_THROWS(tuning::set_thresholds(t));
+        REQUIRE(tuning::current().lanes == 2);
+    }
+
+    std::remove(cache_file.c_str());
+    tuning::set_cache_path(original_path);
+    tuning::set_thresholds(original);
+}
+
+TEST_CASE("tuning benchmark", "[.][bench][tuning]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    auto start   = clock_type::now();
+    auto t       = tuning::calibrate(false);
+    auto elapsed = std::chrono::duration<double>(clock_type::now() - start);
+
+    std::printf(
+        "calibration %.1fms: parallel_min_bytes %zu, segment_size %zu, "
+        "lanes %zu, pool_threads %zu\n",
+        elapsed.count() * 1000.,
+        t.parallel_min_bytes,
+        t.segment_size,
+        t.lanes,
+        t.pool_threads);
+}
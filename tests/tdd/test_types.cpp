@@ -2,7 +2,9 @@
 
 #include "generator.hpp"
 #include "mbedcrypto/cipher.hpp"
+#include "mbedcrypto/dhm.hpp"
 #include "mbedcrypto/pk.hpp"
+#include "mbedcrypto/x509.hpp"
 #include "mbedcrypto_mbedtls_config.h"
 
 #include <initializer_list>
@@ -83,6 +85,10 @@ TEST_CASE("mbedcrypto types checkings", "[types]") {
                   << " RSA key generation";
         std::cout << "\n this build " << features::ec_keygen
                   << " EC (elliptic curve) key generation";
+        std::cout << "\n this build " << features::x509
+                  << " X.509 certificates";
+        std::cout << "\n this build " << features::dhm
+                  << " DHE (finite field Diffie-Hellman)";
 
         auto curves = installed_curves();
         std::cout << "\nsupports " << curves.size() << " elliptic curves: ";
@@ -256,6 +262,8 @@ TEST_CASE("mbedcrypto types checkings", "[types]") {
         REQUIRE(supports(features::pk_export) == pk::supports_key_export());
         REQUIRE(supports(features::rsa_keygen) == pk::supports_rsa_keygen());
         REQUIRE(supports(features::ec_keygen) == pk::supports_ec_keygen());
+        REQUIRE(supports(features::x509) == supports_x509());
+        REQUIRE(supports(features::dhm) == supports_dhm());
 
         auto check = pk::supports_key_export();
 #if defined(MBEDTLS_PEM_WRITE_C)
@@ -277,6 +285,20 @@ TEST_CASE("mbedcrypto types checkings", "[types]") {
 #else  // MBEDTLS_ECP_C
         REQUIRE_FALSE(check);
 #endif // MBEDTLS_ECP_C
+
+        check = supports(features::x509);
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+        REQUIRE(check);
+#else  // MBEDTLS_X509_CRT_PARSE_C
+        REQUIRE_FALSE(check);
+#endif // MBEDTLS_X509_CRT_PARSE_C
+
+        check = supports(features::dhm);
+#if defined(MBEDTLS_DHM_C)
+        REQUIRE(check);
+#else  // MBEDTLS_DHM_C
+        REQUIRE_FALSE(check);
+#endif // MBEDTLS_DHM_C
     }
 
     SECTION("curve names") {
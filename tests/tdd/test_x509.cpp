@@ -0,0 +1,255 @@
+#include <catch2/catch.hpp>
+
+#include "generator.hpp"
+#include "mbedcrypto/rsa.hpp"
+#include "mbedcrypto/tcodec.hpp"
+#include "mbedcrypto/x509.hpp"
+#include "mbedcrypto_mbedtls_config.h"
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+#include <chrono>
+#include <cstdio>
+///////////////////////////////////////////////////////////////////////////////
+namespace {
+using namespace mbedcrypto;
+///////////////////////////////////////////////////////////////////////////////
+
+// removes the null terminator of a pem, to concatenate the certificates
+buffer_t
+strip(buffer_t pem) {
+    if (!pem.empty() && pem.back() == '\0')
+        pem.pop_back();
+    return pem;
+}
+
+/// leaf + intermediate, as sent by a server
+x509_cert
+make_chain() {
+    x509_cert chain;
+    chain.import(
+        strip(test::x509_leaf()) + strip(test::x509_intermediate_ca()));
+    return chain;
+}
+
+x509_verifier
+make_verifier(
+    size_t               capacity = 1024,
+    std::chrono::seconds ttl      = std::chrono::seconds{3600}) {
+    x509_verifier verifier{capacity, ttl};
+    verifier.add_trusted(test::x509_root_ca());
+    return verifier;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+} // namespace anon
+///////////////////////////////////////////////////////////////////////////////
+TEST_CASE("x509 certificates", "[x509]") {
+    using namespace mbedcrypto;
+
+    REQUIRE(supports_x509());
+
+    SECTION("parse") {
+        x509_cert empty;
+        REQUIRE(empty.empty());
+        REQUIRE_THROWS(empty.info());
+        REQUIRE_THROWS(empty.import("not a certificate"));
+
+        auto chain = make_chain();
+        REQUIRE(chain.size() == 2);
+        REQUIRE_THROWS(chain.info(2));
+
+        auto leaf = chain.info(0);
+        REQUIRE(leaf.version == 3);
+        REQUIRE(leaf.serial == "03");
+        REQUIRE(leaf.subject == "C=NL, O=mbedcrypto, CN=mbedcrypto.test");
+        REQUIRE(
+            leaf.issuer ==
+            "C=NL, O=mbedcrypto, CN=mbedcrypto test intermediate CA");
+        REQUIRE(leaf.not_before == 1792371060); // 2026-10-19 00:51:00 utc
+        REQUIRE(leaf.not_after == 4816371060);  // 2122-08-17 00:51:00 utc
+        REQUIRE_FALSE(leaf.is_ca);
+        REQUIRE(leaf.key_type == pk_t::rsa);
+        REQUIRE(leaf.key_bitlen == 2048);
+        REQUIRE(leaf.signature_hash == hash_t::sha256);
+
+        auto inter = chain.info(1);
+        REQUIRE(inter.is_ca);
+        REQUIRE(inter.path_length == 0);
+        REQUIRE(inter.subject == leaf.issuer);
+
+        x509_cert root;
+        root.import(test::x509_root_ca()); // null terminated
+        REQUIRE(root.size() == 1);
+        REQUIRE(root.info().is_ca);
+        REQUIRE(root.info().path_length == -1);
+        REQUIRE(root.info().subject == root.info().issuer);
+        REQUIRE_FALSE(root.dump().empty());
+
+        // der round trip
+        auto der = chain.der(0);
+        REQUIRE(der.size() == 924);
+        x509_cert from_der;
+        from_der.import(der);
+        REQUIRE(from_der.size() == 1);
+        REQUIRE(from_der.der() == der);
+    }
+
+    SECTION("fingerprint and public key") {
+        auto chain = make_chain();
+        REQUIRE(
+            to_hex(chain.fingerprint()) ==
+            "81cd211a645762bb6b222cfdb2be70b1"
+            "d793eaa72b26d0ecd31b397f31429267");
+        REQUIRE(chain.fingerprint(0, hash_t::sha1).size() == 20);
+
+        rsa pri;
+        pri.import_key(test::rsa_private_key());
+
+        rsa pub;
+        chain.public_key(pub);
+        REQUIRE_FALSE(pub.has_private_key());
+        REQUIRE(pk::check_pair(pub.context(), pri.context()));
+
+        auto key = chain.public_key();
+        REQUIRE(key->type() == pk_t::rsa);
+        REQUIRE(pk::check_pair(key->context(), pri.context()));
+
+        auto sig = pri.sign_message(test::long_text(), hash_t::sha1);
+        REQUIRE(pub.verify_message(sig, test::long_text(), hash_t::sha1));
+    }
+}
+
+TEST_CASE("x509 chain verification", "[x509]") {
+    using namespace mbedcrypto;
+
+    SECTION("verify") {
+        auto verifier = make_verifier();
+        REQUIRE(verifier.trusted_size() == 1);
+
+        auto chain = make_chain();
+        auto r     = verifier.verify(chain, "mbedcrypto.test");
+        REQUIRE(r);
+        REQUIRE(r.flags == 0);
+        REQUIRE(r.reason().empty());
+        REQUIRE_FALSE(r.from_cache);
+        REQUIRE(r.expires > std::time(nullptr));
+
+        // the intermediate is missing
+        x509_cert leaf;
+        leaf.import(test::x509_leaf());
+        r = verifier.verify(leaf);
+        REQUIRE_FALSE(r);
+        REQUIRE(r.flags != 0);
+        REQUIRE_FALSE(r.reason().empty());
+        REQUIRE(r.expires == 0);
+
+        // wrong expected name
+        r = verifier.verify(chain, "example.com");
+        REQUIRE_FALSE(r);
+
+        // not trusted
+        x509_verifier other;
+        other.add_trusted(test::x509_other_root_ca());
+        REQUIRE_FALSE(other.verify(chain));
+
+        // the intermediate as a trusted certificate
+        x509_verifier by_inter;
+        x509_cert     inter;
+        inter.import(test::x509_intermediate_ca());
+        by_inter.add_trusted(inter);
+        REQUIRE(by_inter.verify(leaf));
+
+        x509_cert empty;
+        REQUIRE_THROWS(verifier.verify(empty));
+    }
+
+    SECTION("verified chain cache") {
+        auto verifier = make_verifier();
+        auto chain    = make_chain();
+
+        auto first = verifier.verify(chain, "mbedcrypto.test");
+        REQUIRE(first);
+        REQUIRE_FALSE(first.from_cache);
+
+        auto second = verifier.verify(chain, "mbedcrypto.test");
+        REQUIRE(second);
+        REQUIRE(second.from_cache);
+        REQUIRE(second.expires == first.expires);
+
+        // the expected name is a part of the cache key
+        REQUIRE_FALSE(verifier.verify(chain).from_cache);
+        REQUIRE_FALSE(verifier.verify(chain, "example.com"));
+
+        // failures are never cached
+        x509_cert leaf;
+        leaf.import(test::x509_leaf());
+        REQUIRE_FALSE(verifier.verify(leaf));
+        REQUIRE_FALSE(verifier.verify(leaf));
+
+        auto s = verifier.stats();
+        REQUIRE(s.hits == 1);
+        REQUIRE(s.misses == 5);
+        REQUIRE(s.size == 2);
+
+        verifier.clear_cache();
+        REQUIRE(verifier.stats().size == 0);
+        REQUIRE_FALSE(verifier.verify(chain, "mbedcrypto.test").from_cache);
+    }
+
+    SECTION("cache expiry and capacity") {
+        auto chain = make_chain();
+
+        // the earliest not_after of the chain (the leaf) limits the ttl
+        auto forever = make_verifier(8, std::chrono::hours{24 * 365 * 200});
+        auto r       = forever.verify(chain);
+        REQUIRE(r);
+        REQUIRE(r.expires == chain.info(0).not_after);
+
+        // zero ttl disables the cache
+        auto no_cache = make_verifier(8, std::chrono::seconds{0});
+        REQUIRE(no_cache.verify(chain));
+        r = no_cache.verify(chain);
+        REQUIRE(r);
+        REQUIRE_FALSE(r.from_cache);
+        REQUIRE(r.expires == 0);
+
+        // least recently used chains are dropped
+        auto tiny = make_verifier(1);
+        REQUIRE(tiny.verify(chain, "mbedcrypto.test"));
+        REQUIRE(tiny.verify(chain));
+        REQUIRE_FALSE(tiny.verify(chain, "mbedcrypto.test").from_cache);
+        REQUIRE(tiny.stats().size == 1);
+        REQUIRE(tiny.stats().evictions == 2);
+    }
+}
+
+TEST_CASE("x509 verification benchmark", "[.][bench][x509]") {
+    using namespace mbedcrypto;
+    using clock_type = std::chrono::steady_clock;
+
+    constexpr size_t Count = 256;
+
+    auto chain   = make_chain();
+    auto seconds = [](clock_type::time_point start) {
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    };
+
+    auto uncached = make_verifier(0);
+    auto start    = clock_type::now();
+    for (size_t i = 0; i < Count; ++i)
+        REQUIRE(uncached.verify(chain));
+    double full = seconds(start);
+
+    auto cached = make_verifier();
+    start       = clock_type::now();
+    for (size_t i = 0; i < Count; ++i)
+        REQUIRE(cached.verify(chain));
+    double hits = seconds(start);
+
+    std::printf(
+        "x509 chain verify: full %.0f chains/sec, cached %.0f chains/sec\n",
+        Count / full,
+        Count / hits);
+}
+///////////////////////////////////////////////////////////////////////////////
+#endif // MBEDTLS_X509_CRT_PARSE_C